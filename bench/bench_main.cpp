@@ -0,0 +1,306 @@
+// Бенчмарки гарячих шляхів прошивки на native симуляторі.
+// Годинник у ручному режимі: кожен прогін бачить ті самі millis(),
+// ті самі входи і той самий обсяг роботи. Міряється реальний час CPU хоста.
+//
+// Результат - JSON у stdout, коротка таблиця - у stderr:
+//   pio run -e native-bench && .pio/build/native-bench/program > bench.json
+
+#include "Arduino.h"
+#include "sim_hal.h"
+#include "config.h"
+#include "control.h"
+#include "display.h"
+#include "storage.h"
+#include "hardware.h"
+
+#if ENABLE_WIFI
+#include "network.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+extern SystemState g_systemState;
+extern PourMode g_pourMode;
+extern uint16_t g_targetVolume;
+extern uint8_t g_selectedShot;
+extern bool g_glassPresent[GLASS_COUNT];
+extern Statistics g_stats;
+extern TFT_eSPI tft;
+
+// Період контурів, у які потрапляє кожен шлях
+#define BENCH_CONTROL_BUDGET_US (1000000 / 100)   // controlTask, 100 Гц
+#define BENCH_UI_BUDGET_US      (1000000 / 20)    // uiTask, 20 FPS
+
+struct BenchResult {
+    std::string name;
+    uint32_t iterations;
+    uint32_t budgetUs;      // 0 - поза періодичним контуром
+    double minNs;
+    double medianNs;
+    double p99Ns;
+    double maxNs;
+    double meanNs;
+    double work;            // Детермінований обсяг роботи на ітерацію
+    const char* workUnit;
+};
+
+struct BenchCase {
+    const char* name;
+    uint32_t iterations;
+    uint32_t budgetUs;
+    const char* workUnit;
+    std::function<void()> prepare;              // Один раз перед прогоном
+    std::function<void(uint32_t i)> step;       // Поза заміром: входи, годинник
+    std::function<void(uint32_t i)> body;       // Те, що міряється
+    std::function<uint64_t()> workCounter;      // Лічильник роботи (може бути пустим)
+};
+
+static inline uint64_t benchNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void benchTick(uint32_t ms) {
+    sim::advanceClock((uint64_t)ms * 1000);
+}
+
+static void benchPlaceGlasses(bool present) {
+    for (uint8_t pin : hw::glassPins) {
+        sim::setPin(pin, present ? HIGH : LOW);
+    }
+}
+
+static void benchResetState(SystemState state) {
+    if (g_systemState == STATE_POURING) stopPour();
+    g_systemState = state;
+    g_pourMode = MODE_MANUAL;
+    g_targetVolume = VOLUME_DEFAULT;
+    g_selectedShot = 1;
+}
+
+static BenchResult runCase(const BenchCase &bc, uint32_t scale) {
+    uint32_t iterations = std::max<uint32_t>(1, bc.iterations * scale / 100);
+    uint32_t warmup = std::max<uint32_t>(1, iterations / 10);
+
+    if (bc.prepare) bc.prepare();
+
+    for (uint32_t i = 0; i < warmup; i++) {
+        if (bc.step) bc.step(i);
+        bc.body(i);
+    }
+
+    std::vector<uint64_t> samples;
+    samples.reserve(iterations);
+    uint64_t workBefore = bc.workCounter ? bc.workCounter() : 0;
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        if (bc.step) bc.step(warmup + i);
+        uint64_t t0 = benchNowNs();
+        bc.body(warmup + i);
+        samples.push_back(benchNowNs() - t0);
+    }
+
+    uint64_t workAfter = bc.workCounter ? bc.workCounter() : 0;
+
+    BenchResult r;
+    r.name = bc.name;
+    r.iterations = iterations;
+    r.budgetUs = bc.budgetUs;
+    r.workUnit = bc.workUnit;
+    r.work = (double)(workAfter - workBefore) / iterations;
+
+    double sum = 0;
+    for (uint64_t s : samples) sum += s;
+    r.meanNs = sum / iterations;
+
+    std::sort(samples.begin(), samples.end());
+    r.minNs = samples.front();
+    r.maxNs = samples.back();
+    r.medianNs = samples[iterations / 2];
+    r.p99Ns = samples[std::min<uint32_t>(iterations - 1, (uint32_t)(iterations * 0.99))];
+    return r;
+}
+
+static std::vector<BenchCase> benchCases() {
+    std::vector<BenchCase> cases;
+
+    // ---- Контур керування (controlTask) ----
+    cases.push_back({"control_tick_idle", 20000, BENCH_CONTROL_BUDGET_US, nullptr,
+        [] { benchResetState(STATE_IDLE); benchPlaceGlasses(true); },
+        [](uint32_t) { benchTick(10); },
+        [](uint32_t) { updateControls(); updatePourState(); },
+        nullptr});
+
+    // Розлив перезапускається поза заміром, завершення потрапляє в p99
+    cases.push_back({"control_tick_pouring", 20000, BENCH_CONTROL_BUDGET_US, nullptr,
+        [] { benchResetState(STATE_IDLE); benchPlaceGlasses(true); },
+        [](uint32_t) {
+            benchTick(10);
+            if (g_systemState != STATE_POURING) startPour();
+        },
+        [](uint32_t) { updateControls(); updatePourState(); },
+        nullptr});
+
+    // Крок енкодера: зміна об'єму + збереження + broadcast
+    cases.push_back({"control_tick_encoder", 2000, BENCH_CONTROL_BUDGET_US, "nvs_writes",
+        [] { benchResetState(STATE_IDLE); },
+        [](uint32_t i) {
+            benchTick(10);
+            sim::encoderStep(ENCODER_CLK, ENCODER_DT, (i & 1) ? -1 : 1);
+        },
+        [](uint32_t) { updateControls(); updatePourState(); },
+        [] { return (uint64_t)sim::nvsWrites(); }});
+
+#if ENABLE_WIFI
+    // ---- Серіалізація стану ----
+    cases.push_back({"broadcast_state", 20000, BENCH_CONTROL_BUDGET_US, nullptr,
+        [] { benchResetState(STATE_POURING); },
+        [](uint32_t i) { g_targetVolume = VOLUME_MIN + (i % 8) * VOLUME_STEP; },
+        [](uint32_t) { broadcastState(); },
+        nullptr});
+#endif
+
+    // ---- Дисплей (uiTask) ----
+    cases.push_back({"display_redraw", 500, BENCH_UI_BUDGET_US, "pixels",
+        [] { benchResetState(STATE_POURING); },
+        [](uint32_t i) { g_targetVolume = VOLUME_MIN + (i & 1) * VOLUME_STEP; },
+        [](uint32_t) {
+            updateDisplay(g_systemState, g_pourMode, g_targetVolume, g_selectedShot, g_glassPresent);
+        },
+        [] { return tft.pixelsWritten(); }});
+
+    cases.push_back({"display_steady", 20000, BENCH_UI_BUDGET_US, "pixels",
+        [] {
+            benchResetState(STATE_IDLE);
+            updateDisplay(g_systemState, g_pourMode, g_targetVolume, g_selectedShot, g_glassPresent);
+        },
+        nullptr,
+        [](uint32_t) {
+            updateDisplay(g_systemState, g_pourMode, g_targetVolume, g_selectedShot, g_glassPresent);
+        },
+        [] { return tft.pixelsWritten(); }});
+
+    // ---- LED ефекти (uiTask) ----
+    static const struct { const char* name; SystemState state; } ledCases[] = {
+        {"led_idle", STATE_IDLE},
+        {"led_moving", STATE_MOVING},
+        {"led_pouring", STATE_POURING},
+        {"led_error", STATE_ERROR},
+    };
+    for (const auto &lc : ledCases) {
+        SystemState state = lc.state;
+        cases.push_back({lc.name, 20000, BENCH_UI_BUDGET_US, nullptr,
+            nullptr,
+            [](uint32_t) { benchTick(50); },   // Обмеження 20 FPS всередині updateLED
+            [state](uint32_t) { updateLED(state, MODE_MANUAL); },
+            nullptr});
+    }
+
+    // ---- Збереження ----
+    cases.push_back({"persist_settings", 1000, 0, "nvs_writes",
+        [] { benchResetState(STATE_IDLE); },
+        [](uint32_t i) { g_targetVolume = VOLUME_MIN + (i & 1) * VOLUME_STEP; },
+        [](uint32_t) { saveSettings(); },
+        [] { return (uint64_t)sim::nvsWrites(); }});
+
+    cases.push_back({"persist_stats_dirty", 1000, 0, "nvs_writes",
+        nullptr,
+        [](uint32_t) { g_stats.totalPours++; markStatisticsDirty(); },
+        [](uint32_t) { saveStatistics(); },
+        [] { return (uint64_t)sim::nvsWrites(); }});
+
+    // Без змін запису бути не повинно
+    cases.push_back({"persist_stats_clean", 20000, BENCH_CONTROL_BUDGET_US, "nvs_writes",
+        [] { saveStatistics(); },
+        nullptr,
+        [](uint32_t) { saveStatistics(); },
+        [] { return (uint64_t)sim::nvsWrites(); }});
+
+    return cases;
+}
+
+static void printJson(const std::vector<BenchResult> &results, uint32_t scale) {
+    printf("{\n  \"firmware\": \"%s\",\n  \"scale\": %u,\n  \"results\": [\n", FIRMWARE_VERSION, scale);
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &r = results[i];
+        printf("    {\"name\": \"%s\", \"iterations\": %u, "
+               "\"min_ns\": %.0f, \"median_ns\": %.0f, \"p99_ns\": %.0f, \"max_ns\": %.0f, \"mean_ns\": %.0f",
+               r.name.c_str(), r.iterations, r.minNs, r.medianNs, r.p99Ns, r.maxNs, r.meanNs);
+        if (r.budgetUs) {
+            printf(", \"budget_us\": %u, \"budget_p99_pct\": %.4f",
+                   r.budgetUs, r.p99Ns / (r.budgetUs * 10.0));
+        }
+        if (r.workUnit) {
+            printf(", \"work\": %.2f, \"work_unit\": \"%s\"", r.work, r.workUnit);
+        }
+        printf("}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+static void printTable(const std::vector<BenchResult> &results) {
+    fprintf(stderr, "%-24s %8s %12s %12s %12s %10s\n", "bench", "iters", "median ns", "p99 ns", "max ns", "work");
+    for (const BenchResult &r : results) {
+        fprintf(stderr, "%-24s %8u %12.0f %12.0f %12.0f", r.name.c_str(), r.iterations, r.medianNs, r.p99Ns, r.maxNs);
+        if (r.workUnit) fprintf(stderr, " %10.2f %s", r.work, r.workUnit);
+        fprintf(stderr, "\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string nvs;
+    uint32_t scale = 100;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--scale" && i + 1 < argc) {
+            scale = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--nvs" && i + 1 < argc) {
+            nvs = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--filter SUBSTR] [--scale PERCENT] [--nvs DIR]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Окремий NVS, щоб не зачепити стан симулятора
+    bool tempNvs = nvs.empty();
+    if (tempNvs) {
+        char dir[] = "/tmp/gyverdrink-bench-XXXXXX";
+        if (!mkdtemp(dir)) {
+            perror("mkdtemp");
+            return 1;
+        }
+        nvs = dir;
+    }
+    sim::setNvsDir(nvs.c_str());
+
+    sim::setManualClock(true);
+    sim::setSerialOutput(false);
+    sim::setIoTrace(false);
+    randomSeed(0);
+
+    initDisplay();
+    initPeripherals();
+    loadSettings();
+
+    std::vector<BenchResult> results;
+    for (const BenchCase &bc : benchCases()) {
+        if (!filter.empty() && std::string(bc.name).find(filter) == std::string::npos) continue;
+        results.push_back(runCase(bc, scale));
+    }
+
+    printJson(results, scale);
+    printTable(results);
+
+    if (tempNvs) std::filesystem::remove_all(nvs);
+    return 0;
+}
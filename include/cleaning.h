@@ -0,0 +1,44 @@
+#ifndef CLEANING_H
+#define CLEANING_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Сервісні цикли в STATE_CLEANING: прокачка трубки і програми промивки.
+// Крокують з controlTask без delay(); stopPour() перериває будь-який
+
+// Програма промивки: над кожною позицією з рюмкою (ємністю) cycles разів
+// помпа onMs з duty, потім пауза offMs
+struct CleanProgram {
+    const char* name;
+    uint16_t onMs;
+    uint16_t offMs;
+    uint8_t cycles;
+    uint8_t duty;
+    const char* description;
+};
+
+// Прокачка над вибраною рюмкою: помпа працює до primeFinish() (рідина дійшла
+// до носика) або PRIME_MAX_TIME. Виміряний об'єм - новий мертвий об'єм трубки
+bool primeStart();
+// false - прокачка не виконується
+bool primeFinish();
+
+// false - невідома програма, немає жодної рюмки або пристрій зайнятий
+bool cleanStart(const char* name);
+
+// З кожного тіку controlTask
+void updateCleaning();
+
+// Трубка заповнена рідиною. Якщо ні - перший розлив доливає мертвий об'єм
+bool tubePrimed();
+void tubeMarkPrimed();
+
+// Мертвий об'єм трубки (мл), 0 - без доливу
+void setPrimeVolume(float ml);
+
+// Поточна програма або "prime"; NULL - нічого не виконується
+const char* cleanProgramName();
+void printCleanPrograms(Print &out);
+
+#endif // CLEANING_H
@@ -0,0 +1,77 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Текстові команди: одна таблиця для Serial, WebSocket і HTTP (POST /api/cmd).
+// Рядок розбивається на токени на місці, у фіксованому буфері - без String і heap
+
+// Звідки прийшла команда
+enum CommandSource : uint8_t {
+    CMD_SRC_SERIAL = 0,
+    CMD_SRC_WS,
+    CMD_SRC_HTTP
+};
+
+enum CommandResult : uint8_t {
+    CMD_OK = 0,
+    CMD_EMPTY,                  // Порожній рядок
+    CMD_UNKNOWN,                // Немає такої команди
+    CMD_BAD_ARGS,               // Кількість або значення аргументів
+    CMD_FAILED                  // Не виконано (черга повна, немає вільної рюмки)
+};
+
+// Розбиття на місці: пробіли -> '\0', "лапки" для значень з пробілами.
+// Кількість токенів або -1: незакриті лапки, більше maxArgs токенів
+int commandTokenize(char *line, char **argv, int maxArgs);
+
+// Виконати рядок (змінюється на місці). Відповідь - в out
+CommandResult commandExecute(char *line, Print &out, CommandSource source);
+CommandResult commandExecuteArgs(int argc, const char* const *argv, Print &out, CommandSource source);
+
+// З loop(): рядки з Serial без блокування, відкладений restart,
+// відкладені volume/mode/shot (не частіше CMD_COALESCE_MS, останнє значення перемагає)
+void updateCommands();
+
+// Застосувати відкладені volume/mode/shot зараз (перед прямою зміною налаштувань)
+void commandFlushSetters();
+
+// Отримано команд volume/mode/shot і скільки з них дійшло до NVS
+uint32_t commandSettersReceived();
+uint32_t commandSettersApplied();
+
+const char* commandResultName(CommandResult result);
+
+// Відповідь у фіксований буфер (WebSocket). Довша за CMD_REPLY_MAX обрізається з "..."
+class CommandReply : public Print {
+public:
+    CommandReply() { clear(); }
+
+    size_t write(uint8_t c) override {
+        if (_truncated) return 0;
+        // Останні байти - під позначку обрізання
+        if (_len + 5 >= sizeof(_buf)) {
+            memcpy(_buf + _len, "...\n", 5);
+            _len += 4;
+            _truncated = true;
+            return 0;
+        }
+        _buf[_len++] = c;
+        _buf[_len] = 0;
+        return 1;
+    }
+    using Print::write;
+
+    void clear() { _len = 0; _buf[0] = 0; _truncated = false; }
+    const char* c_str() const { return _buf; }
+    size_t length() const { return _len; }
+    bool truncated() const { return _truncated; }
+
+private:
+    char _buf[CMD_REPLY_MAX];
+    size_t _len;
+    bool _truncated;
+};
+
+#endif // COMMANDS_H
@@ -29,6 +29,9 @@
 #define COLOR_TEXT      0xFFFF  // Білий
 #define COLOR_GRAY      0x7BEF  // Сірий
 
+// Заставка: анімація в uiTask, старт не чекає на неї (0 - без заставки)
+#define SPLASH_DURATION 1200    // мс
+
 // ========================================
 // 🕹️ УПРАВЛІННЯ
 // ========================================
@@ -39,10 +42,13 @@
 #define ENCODER_SW    0    // GPIO0 (Boot button)
 
 // Кнопка старт/стоп
-#define BUTTON_START  37   // GPIO37 (Input only)
+#define BUTTON_START  19   // GPIO19 (GPIO37 - датчик рюмки 3)
 
-// Debounce
+// Кнопки і датчики рюмок - на перериваннях, фронти з часом у черзі (inputs.h)
 #define DEBOUNCE_MS   50
+#define LONG_PRESS_MS 1000 // Довге натискання кнопки
+#define DOUBLE_PRESS_MS 300 // Друге натискання енкодера в межах - подвійне
+#define INPUT_QUEUE_SIZE 32 // Фронти між тіками controlTask
 
 // ========================================
 // 🔌 ПЕРИФЕРІЯ
@@ -59,12 +65,42 @@
 #define SERVO_MIN_US  500
 #define SERVO_MAX_US  2500
 
-// Датчики рюмок (Input only pins)
-#define GLASS_PIN_1   35   // GPIO35
-#define GLASS_PIN_2   36   // GPIO36
-#define GLASS_PIN_3   37   // GPIO37
-#define GLASS_PIN_4   38   // GPIO38
-#define GLASS_PIN_5   39   // GPIO39
+// Рюмки: кількість задає профіль заліза - датчики і кути серво (hardware.h).
+// Маски рюмок - uint8_t, тому не більше 8
+#ifndef GLASS_COUNT
+#define GLASS_COUNT   5
+#endif
+
+#if GLASS_COUNT == 3
+#define GLASS_PINS    {35, 36, 37}
+#define SHOT_ANGLES   {45, 90, 135}
+#elif GLASS_COUNT == 5
+#define GLASS_PINS    {35, 36, 37, 38, 39}
+#define SHOT_ANGLES   {30, 60, 90, 120, 150}
+#elif GLASS_COUNT == 6
+#define GLASS_PINS    {35, 36, 37, 38, 39, 2}
+#define SHOT_ANGLES   {25, 50, 75, 100, 125, 150}
+#elif GLASS_COUNT == 8
+// Рюмки 7-8 на виводах колектора 4-5: MANIFOLD_CHANNELS до 3, RECIPE_PUMPS до 4
+#define GLASS_PINS    {35, 36, 37, 38, 39, 2, 22, 21}
+#define SHOT_ANGLES   {20, 40, 60, 80, 100, 120, 140, 160}
+#else
+#error "GLASS_COUNT: профілі є для 3, 5, 6 і 8 рюмок"
+#endif
+
+// Аналогові датчики рюмок (відбивні ІЧ): безперервна оцифровка ADC1 через DMA,
+// адаптивна базова лінія і гістерезис замість digitalRead (glass_sensor.h).
+// Усі GLASS_PINS - канали ADC1 (GPIO32-39): профілі на 3 і 5 рюмок
+#ifndef GLASS_SENSOR_ANALOG
+#define GLASS_SENSOR_ANALOG 0
+#endif
+#define GLASS_ADC_SAMPLE_HZ     20000   // Сумарно на всі канали (ESP32 DMA - від 20 кГц)
+#define GLASS_ADC_FRAME         256     // Відліків за переривання DMA (12.8 мс)
+#define GLASS_ADC_ON_DELTA      400     // Вище базової лінії - рюмка є (відліки 0-4095)
+#define GLASS_ADC_OFF_DELTA     200     // Нижче - рюмки немає
+#define GLASS_ADC_HOLD_FRAMES   3       // Кадрів поспіль за порогом до зміни стану
+#define GLASS_ADC_BASELINE_SHIFT 6      // Базова лінія без рюмки: EMA 1/64 за кадр
+#define GLASS_ADC_BASELINE_INIT 600     // Порожнє місце на старті, не вище (рюмка вже стоїть)
 
 // LED стрічка WS2812B
 #define LED_PIN       12   // GPIO12
@@ -73,6 +109,7 @@
 #define LED_ORDER     GRB
 #define LED_BRIGHTNESS 100 // 0-255
 #define LED_COLOR     200  // Hue 0-255
+#define LED_INTRO_STEP 50  // Стартова анімація: мс на світлодіод
 
 // ========================================
 // ⚙️ НАЛАШТУВАННЯ РОЗЛИВУ
@@ -87,13 +124,51 @@
 // Калібрування помпи
 #define PUMP_ML_PER_SEC 10.0  // мл/сек (потрібно калібрувати!)
 #define PUMP_SPEED_DEFAULT 255 // PWM 0-255
+#define PUMP_RATE_MIN   0.5   // Межі калібрування через API (мл/сек)
+#define PUMP_RATE_MAX   100.0
+
+// Прокачка: мертвий об'єм трубки від помпи до носика. Злита трубка (старт, довгий
+// простій) заповнюється першим розливом - до нього додається цей об'єм
+#define PRIME_ML_DEFAULT   4.0      // мл, до першого виміру прокачкою
+#define PRIME_ML_MAX       30.0
+#define PRIME_MAX_TIME     20000    // Прокачка без зупинки користувачем (мс)
+#define PRIME_HOLD_TIME    1800000  // Без роботи помпи трубка вважається злитою (мс)
+
+// Програми промивки (STATE_CLEANING)
+#define CLEAN_MOVE_MS      500      // Рух серво між позиціями (мс)
+
+// Черга замовлень (рюмка + об'єм), виконується по черзі
+#define POUR_QUEUE_SIZE 8
+
+// Колектор: окремий вихід (помпа або клапан) на кожну рюмку 1..MANIFOLD_CHANNELS,
+// кілька розливів одночасно без серво. 0 - одна помпа на PUMP_POWER і серво
+#ifndef MANIFOLD_CHANNELS
+#define MANIFOLD_CHANNELS   0
+#endif
+#define MANIFOLD_PINS       {14, 16, 17, 21, 22}    // Вихід рюмки 1..5
+#define MANIFOLD_LEDC_FIRST 8       // LEDC канали MANIFOLD_LEDC_FIRST..+N-1
+#define MANIFOLD_CHANNEL_MA 700     // Струм одного виходу на повному PWM (мА)
+#ifndef MANIFOLD_BUDGET_MA
+#define MANIFOLD_BUDGET_MA  2000    // Сумарний струм виходів (мА): решта розливів чекає
+#endif
+
+// Коктейлі: у кожній помпі свій інгредієнт, рецепт розливається в одну рюмку.
+// Помпа 1 - основна (PUMP_POWER), 2..RECIPE_PUMPS - на RECIPE_PINS
+#ifndef RECIPE_PUMPS
+#define RECIPE_PUMPS        1
+#endif
+#define RECIPE_PINS         {14, 16, 17, 21}    // Помпи 2..5 (вільні виводи колектора)
+#define RECIPE_LEDC_FIRST   8       // LEDC канали помп 2..RECIPE_PUMPS
+#define RECIPES_MAX         8
+#define RECIPE_STEPS_MAX    5       // Інгредієнтів у рецепті
+#define RECIPE_PARTS_MAX    20      // Частка одного інгредієнта
+#define RECIPE_NAME_LEN     12      // Назва рецепта / інгредієнта разом з '\0'
+
+#if RECIPE_PUMPS > 1 && MANIFOLD_CHANNELS
+#error "RECIPE_PUMPS і MANIFOLD_CHANNELS займають ті самі виводи - лише одне з двох"
+#endif
 
-// Позиції сервопривода (градуси)
-#define POS_SHOT_1    30
-#define POS_SHOT_2    60
-#define POS_SHOT_3    90
-#define POS_SHOT_4    120
-#define POS_SHOT_5    150
+// Позиції сервопривода (градуси), над рюмками - SHOT_ANGLES
 #define POS_PARKING   0    // Паркувальна позиція
 
 // Режими роботи
@@ -106,7 +181,9 @@ enum PourMode {
 // 📡 WI-FI
 // ========================================
 
+#ifndef ENABLE_WIFI
 #define ENABLE_WIFI   1  // 1 = увімкнути, 0 = вимкнути
+#endif
 
 // Access Point (за замовчуванням)
 #define AP_SSID       "Nalivator-Setup"
@@ -116,9 +193,17 @@ enum PourMode {
 #define AP_MAX_CONN   4
 
 // Station Mode (підключення до роутера)
-#define WIFI_SSID     "YourWiFiName"
-#define WIFI_PASS     "YourPassword"
-#define WIFI_TIMEOUT  10000  // ms
+// Дані зберігаються в NVS через /wifi або Serial; тут - значення, якщо NVS порожній
+#define WIFI_SSID     ""
+#define WIFI_PASS     ""
+#define WIFI_TIMEOUT  10000  // ms - спроба підключення, після неї вмикається AP
+#define WIFI_RETRY_INTERVAL  60000  // ms - повторна спроба з режиму AP
+#define WIFI_SSID_LEN 33     // 32 + '\0'
+#define WIFI_PASS_LEN 65     // 64 + '\0'
+#define WIFI_PREFS_NAMESPACE "gd-wifi"
+
+// mDNS: http://gyverdrink.local
+#define MDNS_HOSTNAME "gyverdrink"
 
 // IP адреси
 #define AP_IP         IPAddress(192, 168, 4, 1)
@@ -132,20 +217,115 @@ enum PourMode {
 #define WEB_PORT      80
 #define WS_PORT       81  // WebSocket
 
+// Server-Sent Events (/events): мінімальний інтервал між подіями кожного потоку
+#define SSE_STATE_INTERVAL     200    // state - тільки при змінах (мс)
+#define SSE_PROGRESS_INTERVAL  250    // progress - під час розливу (мс)
+#define SSE_LOG_INTERVAL       500    // log - пачка нових записів (мс)
+#define SSE_RECONNECT          2000   // Підказка браузеру для перепідключення (мс)
+#define SSE_BACKLOG_SIZE       16     // Подій для повтору за Last-Event-ID
+#define SSE_EVENT_LEN          320    // Максимальна довжина даних події
+
+// WebSocket: стан серіалізується раз у спільний буфер. Клієнт з повною чергою
+// не отримує нових кадрів - стан чекає і заміняється новішим
+#define WS_CLIENTS_MAX         8      // Клієнтів одночасно (= DEFAULT_MAX_WS_CLIENTS)
+#define WS_CLIENT_QUEUE_MAX    4      // Кадрів у черзі клієнта, далі - відкладено
+#define WS_STATE_BUFFERS       8      // Буферів стану в обігу (кадри в чергах)
+
+// REST API
+#define API_BODY_MAX           2048   // Максимальний розмір JSON тіла (байт)
+#define API_BATCH_MAX          16     // Команд в одному POST /api/batch
+
+// ========================================
+// 🍸 FLEET (кілька наливаторів в одній мережі)
+// ========================================
+
+// Вмикається в рантаймі (/api/fleet, Serial "fleet on"), працює тільки в режимі STA
+#ifndef ENABLE_FLEET
+#define ENABLE_FLEET  1
+#endif
+#define FLEET_GROUP           IPAddress(239, 255, 68, 71)
+#define FLEET_PORT            4210
+#define FLEET_HEARTBEAT_MS    1000   // Період статусу
+#define FLEET_HEARTBEAT_MIN   100    // Мінімальний інтервал при змінах стану
+#define FLEET_PEER_TIMEOUT    3500   // Вузол зникає без статусів (мс)
+#define FLEET_MAX_PEERS       8
+#define FLEET_RETRY_MS        300    // Повтор замовлення без підтвердження
+#define FLEET_RETRIES         3
+#define FLEET_REROUTES        2      // Спроб іншого вузла, якщо цей не прийняв
+#define FLEET_PENDING_MAX     8      // Замовлень в дорозі
+
 // ========================================
 // 🔄 OTA UPDATE
 // ========================================
 
+// Завантаження прошивки з браузера (/update, POST /api/ota) з відкатом.
+// Потрібна таблиця розділів з двома слотами (min_spiffs.csv)
+#ifndef ENABLE_OTA
 #define ENABLE_OTA    1
-#define OTA_PASSWORD  "admin"
+#endif
+// espota (pio run -t upload -e lilygo-t4-ota)
+#ifndef ENABLE_ARDUINO_OTA
+#define ENABLE_ARDUINO_OTA  ENABLE_OTA
+#endif
+#define OTA_USER      "admin"     // HTTP Basic для POST /api/ota
+// Пароль оновлення - з NVS (Serial: ota password ...). Тут - лише якщо NVS порожній;
+// порожній рядок: оновлення по мережі вимкнене, доки пароль не задано
+#ifndef OTA_PASSWORD
+#define OTA_PASSWORD  ""
+#endif
+#define OTA_PASSWORD_MIN     8
+#define OTA_PASSWORD_LEN     65      // 64 + '\0'
+#define OTA_AUTH_NAMESPACE   "gd-ota-auth"   // Окремо від gd-ota: той стирається після підтвердження
 #define OTA_PORT      3232
+#define OTA_RESTART_DELAY    1000    // Після запису, щоб відповідь дійшла (мс)
+#define OTA_HEALTH_DELAY     30000   // Робота нової прошивки до підтвердження (мс)
+#define OTA_HEALTH_MIN_HEAP  40000   // Мінімум вільної пам'яті для підтвердження
+#define OTA_BOOT_ATTEMPTS    3       // Перезавантажень без підтвердження до відкату
+#define OTA_PREFS_NAMESPACE  "gd-ota"
+
+#if ENABLE_ARDUINO_OTA && !ENABLE_OTA
+#error "ENABLE_ARDUINO_OTA потребує ENABLE_OTA (підтвердження і відкат прошивки)"
+#endif
 
 // ========================================
 // 💾 ЗБЕРІГАННЯ
 // ========================================
 
 #define PREFS_NAMESPACE "gyverdrink"
-#define STATS_SAVE_INTERVAL 30000  // Зберігати статистику кожні 30 сек
+#define STATS_SAVE_INTERVAL 30000  // Зберігати статистику кожні 30 сек (якщо змінена)
+#define STATS_UPTIME_SAVE_INTERVAL 1800000  // Лише час роботи - у flash раз на 30 хв
+#define STATS_MAGIC   0x5354         // "ST" - маркер блобу статистики
+#define STATS_VERSION 1              // Версія формату блобу
+#define RECIPE_MAGIC  0x5243         // "RC" - маркер блобу рецептів
+#define RECIPE_VERSION 1
+#define RECIPE_PREFS_NAMESPACE "gd-recipes"
+
+// ========================================
+// 🔋 ЖИВЛЕННЯ
+// ========================================
+
+// Режим простою: тьмяна підсвітка -> сон (підсвітка, LED і серво вимкнені,
+// нижча частота CPU, light sleep з пробудженням від кнопок і датчиків рюмок)
+#ifndef ENABLE_POWER_SAVE
+#define ENABLE_POWER_SAVE 1
+#endif
+
+#ifndef IDLE_DIM_TIMEOUT
+#define IDLE_DIM_TIMEOUT     60000   // Без дій до тьмяної підсвітки (мс)
+#endif
+#ifndef IDLE_SLEEP_TIMEOUT
+#define IDLE_SLEEP_TIMEOUT   300000  // Без дій до сну (мс)
+#endif
+
+#define BACKLIGHT_CHANNEL    15      // PWM канал підсвітки TFT
+#define BACKLIGHT_FREQ       5000
+#define BACKLIGHT_ON         255     // Яскравість 0-255
+#define BACKLIGHT_DIM        40
+
+#define POWER_CPU_MHZ        240
+#define POWER_SLEEP_CPU_MHZ  80      // Мінімум, з яким працює WiFi
+#define POWER_SLEEP_TICK_MS  50      // Період controlTask у сні - затримка пробудження
+#define POWER_SLEEP_UI_MS    250     // Період uiTask у сні
 
 // ========================================
 // 🧵 MULTITASKING (FreeRTOS)
@@ -155,16 +335,22 @@ enum PourMode {
 #define STACK_SIZE_UI       16384  // UI задача
 #define STACK_SIZE_CONTROL  8192   // Control задача
 #define STACK_SIZE_NETWORK  8192   // Network задача
+#define STACK_SIZE_LOG      3072   // Log задача
+#define STACK_SIZE_GLASS    3072   // Аналогові датчики рюмок (GLASS_SENSOR_ANALOG)
 
 // Пріоритети (0-24, більше = вищий)
 #define PRIORITY_UI         1      // Нижчий
 #define PRIORITY_CONTROL    2      // Вищий
 #define PRIORITY_NETWORK    1      // Нижчий
+#define PRIORITY_LOG        0      // Найнижчий - тільки вивід у Serial
+#define PRIORITY_GLASS      2      // Як Control - кадр DMA не чекає на мережу
 
 // Ядра CPU (0 або 1)
 #define CORE_UI             0      // UI на ядрі 0
 #define CORE_CONTROL        1      // Control на ядрі 1
 #define CORE_NETWORK        0      // Network на ядрі 0
+#define CORE_LOG            0      // Log на ядрі 0 (подалі від Control)
+#define CORE_GLASS          0      // Датчики рюмок на ядрі 0
 
 // ========================================
 // 🐛 DEBUG
@@ -174,23 +360,62 @@ enum PourMode {
 #define DEBUG_ENABLED 0
 #endif
 
-#if DEBUG_ENABLED
-  #define DEBUG_PRINT(x)   Serial.print(x)
-  #define DEBUG_PRINTLN(x) Serial.println(x)
-  #define DEBUG_PRINTF(...)  Serial.printf(__VA_ARGS__)
-#else
-  #define DEBUG_PRINT(x)
-  #define DEBUG_PRINTLN(x)
-  #define DEBUG_PRINTF(...)
+// Рівень логування: 0 = вимк, 1 = ERROR, 2 = WARN, 3 = INFO, 4 = DEBUG
+#ifndef LOG_LEVEL
+  #if DEBUG_ENABLED
+    #define LOG_LEVEL 4
+  #else
+    #define LOG_LEVEL 3
+  #endif
 #endif
 
+#define LOG_RING_SIZE       64     // Записів у кільці (степінь двійки)
+#define LOG_MSG_LEN         96     // Максимальна довжина повідомлення
+#define LOG_DRAIN_INTERVAL  20     // Період виводу в Serial (мс)
+
+#include "logger.h"
+
+// DEBUG_* пишуть у кільце логів, а не напряму в UART
+#define DEBUG_PRINT(x)     LOG_D("%s", x)
+#define DEBUG_PRINTLN(x)   LOG_D("%s", x)
+#define DEBUG_PRINTF(...)  LOG_D(__VA_ARGS__)
+
+// Трасування контурів: TRACE_SCOPE() навколо етапів, експорт у Chrome trace JSON
+#ifndef ENABLE_TRACE
+#define ENABLE_TRACE 1
+#endif
+
+#define TRACE_RING_SIZE     1024   // Подій у кільці (степінь двійки, ~4 с історії)
+
+#include "trace.h"
+
+// Метрики Prometheus: GET /metrics
+#ifndef ENABLE_METRICS
+#define ENABLE_METRICS 1
+#endif
+
+#define METRICS_BUCKETS     8      // Кошиків у гістограмі (без +Inf)
+
+// Текстові команди (Serial, WebSocket, POST /api/cmd)
+#define CMD_LINE_MAX        128    // Довжина рядка разом з '\0'
+#define CMD_ARGS_MAX        6      // Токенів у рядку
+#define CMD_REPLY_MAX       1024   // Відповідь у WebSocket (довша обрізається)
+#define CMD_COALESCE_MS     200    // volume/mode/shot застосовуються не частіше (NVS + розсилка)
+
 // ========================================
 // ⚠️ БЕЗПЕКА
 // ========================================
 
 // Обмеження
 #define MAX_POUR_TIME     30000    // Максимальний час розливу (мс)
-#define WATCHDOG_TIMEOUT  10000    // Watchdog таймаут (мс)
+#define WATCHDOG_TIMEOUT  10000    // Task watchdog: controlTask, uiTask, loop() (мс)
+
+// Апаратна відсічка помпи: таймер перевіряє, що controlTask живий
+#define SAFETY_TIMER_NUM        0       // Апаратний таймер (0-3)
+#define SAFETY_TICK_US          10000   // Період перевірки = тік controlTask
+#define SAFETY_MISSED_TICKS     20      // Тіків без відмітки з увімкненою помпою (200 мс)
+#define SAFETY_POUR_MARGIN      2000    // Запас над MAX_POUR_TIME для відсічки (мс)
+#define SAFETY_PREFS_NAMESPACE  "gd-fault"
 
 // Перезавантаження при критичній помилці
 #define SAFE_RESTART() do { \
@@ -238,7 +463,8 @@ enum SystemState {
     STATE_POURING,        // Розлив
     STATE_PAUSED,         // Пауза
     STATE_ERROR,          // Помилка
-    STATE_CLEANING        // Очищення
+    STATE_CLEANING,       // Очищення
+    STATE_UPDATING        // Оновлення прошивки - розлив заблоковано
 };
 
 // ========================================
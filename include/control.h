@@ -5,6 +5,7 @@
 #include <ESP32Servo.h>
 #include <FastLED.h>
 #include "config.h"
+#include "hardware.h"
 
 // Ініціалізація периферії
 void initPeripherals();
@@ -13,17 +14,63 @@ void initPeripherals();
 void updateControls();
 void updatePourState();
 
-// Управління розливом
-void startPour();
+// Управління розливом. false - відмовлено: не той стан, немає рюмки, інгредієнта
+bool startPour();
+bool startPourTo(uint8_t shot, uint16_t volume);
 void stopPour();
 void completePour();
 
+// Завершений розлив: статистика, метрики, рюмка вважається налитою
+void recordPour(uint8_t shot, uint16_t volume, unsigned long pumpMs);
+
+// Пауза: помпа стоїть, носик лишається над рюмкою, налите не втрачається.
+// resumePour() доливає рівно залишок. false - не в тому стані / немає рюмки
+bool pausePour();
+bool resumePour();
+
+// Поточний розлив: час роботи помпи без пауз, налито і заплановано (мл)
+unsigned long pourElapsedMs();
+uint16_t pourDispensedMl();
+uint16_t pourTargetMl();
+
+// Тривалість розливу з поточним калібруванням
+unsigned long pourDurationMs(uint16_t volume);
+
+// Кут серво над рюмкою 1..GLASS_COUNT, інакше паркінг
+int shotPosition(uint8_t shot);
+
+// Черга замовлень: виконується з контуру керування, коли рюмка на місці.
+// Блок змін під controlMux (див. POST /api/batch) - атомарний для контуру керування
+struct PourOrder {
+    uint8_t shot;
+    uint16_t volume;
+};
+
+extern portMUX_TYPE controlMux;
+
+bool queuePour(uint8_t shot, uint16_t volume);
+void clearPourQueue();
+uint8_t pourQueueLength();
+bool pourQueueAt(uint8_t index, PourOrder &out);
+
+// Вільні рюмки (біт 0 = рюмка 1): стоять, ще не налиті, не в черзі
+uint8_t freeGlassMask();
+// Замовлення в першу вільну рюмку. false - вільних немає або черга повна
+bool queuePourAny(uint16_t volume, uint8_t &shot);
+
 // LED ефекти
 void updateLED(SystemState state, PourMode mode);
 
+// Живлення серво: вимкнено - від'єднане і знеструмлене (режим сну)
+void setServoPower(bool on);
+
 // API функції
 void setTargetVolume(uint16_t vol);
 void setPourMode(PourMode mode);
 void selectShot(uint8_t shot);
+// Серво над рюмкою розливу (рух, розлив, пауза) - вибір рюмки не змінюється.
+// Колектор наливає кожну рюмку своїм виходом - там вибір вільний
+bool shotLocked();
+void setPumpRate(float mlPerSec);
 
 #endif // CONTROL_H
\ No newline at end of file
@@ -3,22 +3,26 @@
 
 #include <TFT_eSPI.h>
 #include "config.h"
+#include "hardware.h"
 
 // Ініціалізація дисплея
 bool initDisplay();
 
-// Показати заставку
+// Показати заставку. Не блокує: анімація і закриття - в updateDisplay()
 void showSplash();
 
 // Оновити дисплей
-void updateDisplay(SystemState state, PourMode mode, uint16_t volume, uint8_t shot, bool glasses[5]);
+void updateDisplay(SystemState state, PourMode mode, uint16_t volume, uint8_t shot, bool glasses[GLASS_COUNT]);
 
 // Малювання компонентів
 void drawStatusBar(SystemState state, PourMode mode);
 void drawVolume(uint16_t volume);
-void drawShotSelector(uint8_t selected, bool glasses[5]);
+void drawShotSelector(uint8_t selected, bool glasses[GLASS_COUNT]);
 void drawProgress(uint8_t percent);
 
+// Підсвітка 0-255 (PWM)
+void setBacklight(uint8_t level);
+
 // Показати помилку
 void showError(const char* message);
 
@@ -0,0 +1,47 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include "config.h"
+
+#if ENABLE_WIFI && ENABLE_FLEET
+
+#include <AsyncUDP.h>
+#include <ArduinoJson.h>
+
+// Флот: наливатори в одній мережі бачать один одного через UDP multicast,
+// а замовлення з будь-якого вузла йде на найменш зайнятий з вільною рюмкою
+
+// Вузол, як його бачить цей пристрій (з останнього статусу)
+struct FleetPeer {
+    uint32_t id;
+    uint32_t ip;
+    char name[16];
+    uint8_t state;              // SystemState
+    uint8_t freeMask;           // Вільні рюмки, біт 0 = рюмка 1
+    uint8_t queueLen;
+    uint8_t queueFree;
+    uint32_t totalPours;
+    unsigned long lastSeen;     // millis() останнього статусу
+};
+
+// Ініціалізація (id вузла, ім'я)
+void setupFleet();
+
+// З loop(): сокет, статуси, повтори замовлень
+void updateFleet();
+
+// Увімкнення флоту (зберігається в NVS)
+void setFleetEnabled(bool enabled);
+bool fleetActive();
+uint32_t fleetNodeId();
+
+// Замовлення у флот. Повертає id вузла, якому воно пішло (може бути цей),
+// або 0 - вільних рюмок немає ніде
+uint32_t fleetOrder(uint16_t volume);
+
+void serializeFleet(JsonDocument &doc);
+void printFleetStatus(Print &out);
+
+#endif // ENABLE_WIFI && ENABLE_FLEET
+
+#endif // FLEET_H
@@ -0,0 +1,40 @@
+#ifndef GLASS_SENSOR_H
+#define GLASS_SENSOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "hardware.h"
+
+// Аналогові датчики рюмок: ADC1 безперервно оцифровує всі GLASS_PINS через DMA,
+// задача прокидається на кожен кадр (без опитування), середнє кадру по каналу йде
+// у фільтр, маска присутності оновлюється для inputs.cpp
+
+// Фільтр одного каналу: базова лінія (порожнє місце під поточним світлом) повільно
+// йде за рівнем, поки рюмки немає; рюмка - рівень вище базової на ON_DELTA,
+// зникла - нижче OFF_DELTA, обидва - GLASS_ADC_HOLD_FRAMES кадрів поспіль
+struct GlassFilter {
+    uint32_t baseline;          // << GLASS_ADC_BASELINE_SHIFT
+    uint16_t level;             // Останнє середнє кадру
+    uint8_t hold;               // Кадрів поспіль за порогом
+    bool present;
+    bool primed;
+};
+
+void glassFilterReset(GlassFilter &filter);
+// Кадр -> стан рюмки. Без заліза: той самий код ганяється на записаних трасах
+bool glassFilterStep(GlassFilter &filter, uint16_t level);
+uint16_t glassFilterBaseline(const GlassFilter &filter);
+
+#if GLASS_SENSOR_ANALOG
+
+// З setupInputs(): DMA ADC і задача датчиків
+void setupGlassSensors();
+
+// Рюмки, що стоять (біт 0 = рюмка 1)
+uint8_t glassSensorMask();
+
+void printGlassSensors(Print &out);
+
+#endif // GLASS_SENSOR_ANALOG
+
+#endif // GLASS_SENSOR_H
@@ -0,0 +1,104 @@
+#ifndef HARDWARE_H
+#define HARDWARE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Профіль заліза: GLASS_COUNT рюмок, їхні датчики, кути серво і сегменти LED.
+// Таблиці constexpr, цикли по рюмках мають сталу межу; конфлікти виводів і
+// неможливі кути ловить static_assert ще на збірці. Прошивка - gnu++11, тому
+// перевірки рекурсивні, без циклів у constexpr
+
+namespace hw {
+
+constexpr uint8_t glassPins[GLASS_COUNT] = GLASS_PINS;
+constexpr uint8_t shotAngles[GLASS_COUNT] = SHOT_ANGLES;
+
+// Решта виводів плати, з якими датчики рюмок не можуть ділити GPIO
+constexpr uint8_t controlPins[] = {
+    ENCODER_CLK, ENCODER_DT, ENCODER_SW, BUTTON_START, PUMP_POWER, SERVO_POWER, SERVO_PIN, LED_PIN
+};
+
+// pin серед pins[from..to)
+template <size_t N>
+constexpr bool hasPin(const uint8_t (&pins)[N], uint8_t pin, size_t from = 0, size_t to = N) {
+    return from < to && from < N && (pins[from] == pin || hasPin(pins, pin, from + 1, to));
+}
+
+template <size_t N>
+constexpr bool pinsUnique(const uint8_t (&pins)[N], size_t i = 0) {
+    return i >= N || (!hasPin(pins, pins[i], i + 1) && pinsUnique(pins, i + 1));
+}
+
+// Перші count виводів a не зустрічаються серед перших limit виводів b
+template <size_t N, size_t M>
+constexpr bool pinsDisjoint(const uint8_t (&a)[N], const uint8_t (&b)[M],
+                            size_t count = N, size_t limit = M, size_t i = 0) {
+    return i >= count || i >= N || (!hasPin(b, a[i], 0, limit) && pinsDisjoint(a, b, count, limit, i + 1));
+}
+
+template <size_t N>
+constexpr bool anglesAscending(const uint8_t (&angles)[N], size_t i = 1) {
+    return i >= N || (angles[i - 1] < angles[i] && anglesAscending(angles, i + 1));
+}
+
+// Канал ADC1 виводу: GPIO36-39 - 0-3, GPIO32-35 - 4-7. 0xFF - не ADC1
+constexpr uint8_t adc1Channel(uint8_t pin) {
+    return pin >= 36 && pin <= 39 ? pin - 36 : pin >= 32 && pin <= 35 ? pin - 28 : 0xFF;
+}
+
+template <size_t N>
+constexpr bool pinsOnAdc1(const uint8_t (&pins)[N], size_t i = 0) {
+    return i >= N || (adc1Channel(pins[i]) != 0xFF && pinsOnAdc1(pins, i + 1));
+}
+
+// Сегмент стрічки над рюмкою shot (1..GLASS_COUNT): LED_COUNT порівну, залишок - останній
+constexpr uint8_t ledSegmentLength(uint8_t shot) {
+    return shot < GLASS_COUNT ? LED_COUNT / GLASS_COUNT : LED_COUNT - (GLASS_COUNT - 1) * (LED_COUNT / GLASS_COUNT);
+}
+
+constexpr uint8_t ledSegmentFirst(uint8_t shot) {
+    return (shot - 1) * (LED_COUNT / GLASS_COUNT);
+}
+
+static_assert(GLASS_COUNT >= 1 && GLASS_COUNT <= 8, "glass masks are uint8_t: 1..8 glasses");
+static_assert(pinsUnique(glassPins), "GLASS_PINS: two glasses on one GPIO");
+static_assert(pinsUnique(controlPins), "encoder, START, pump, servo and LED pins must differ");
+static_assert(pinsDisjoint(glassPins, controlPins), "GLASS_PINS overlap a control pin (e.g. BUTTON_START)");
+static_assert(anglesAscending(shotAngles), "SHOT_ANGLES must be strictly increasing");
+static_assert(shotAngles[0] > POS_PARKING && shotAngles[GLASS_COUNT - 1] <= 180,
+              "SHOT_ANGLES must lie between POS_PARKING and 180 degrees");
+static_assert(LED_COUNT >= GLASS_COUNT, "at least one LED per glass");
+static_assert(ledSegmentFirst(GLASS_COUNT) + ledSegmentLength(GLASS_COUNT) == LED_COUNT,
+              "LED segments must cover the strip");
+
+#if GLASS_SENSOR_ANALOG
+static_assert(pinsOnAdc1(glassPins), "GLASS_SENSOR_ANALOG: every GLASS_PINS must be an ADC1 pin (GPIO32-39)");
+static_assert(GLASS_ADC_OFF_DELTA < GLASS_ADC_ON_DELTA, "hysteresis: OFF threshold below ON");
+#endif
+
+#if defined(TFT_CS) && defined(TFT_DC)
+// Дисплей з build_flags. TFT_MISO не підключений (дисплей лише приймає), TFT_RST буває -1
+constexpr uint8_t displayPins[] = {TFT_MOSI, TFT_SCLK, TFT_CS, TFT_DC, TFT_BL};
+static_assert(pinsDisjoint(glassPins, displayPins) && pinsDisjoint(controlPins, displayPins),
+              "glass or control pins overlap the TFT bus");
+#endif
+
+#if MANIFOLD_CHANNELS
+constexpr uint8_t manifoldOutputs[] = MANIFOLD_PINS;
+static_assert(MANIFOLD_CHANNELS <= GLASS_COUNT, "one manifold output per glass");
+static_assert(pinsDisjoint(manifoldOutputs, glassPins, MANIFOLD_CHANNELS) &&
+              pinsDisjoint(manifoldOutputs, controlPins, MANIFOLD_CHANNELS),
+              "MANIFOLD_PINS overlap glass or control pins");
+#endif
+
+#if RECIPE_PUMPS > 1
+constexpr uint8_t recipeOutputs[] = RECIPE_PINS;
+static_assert(pinsDisjoint(recipeOutputs, glassPins, RECIPE_PUMPS - 1) &&
+              pinsDisjoint(recipeOutputs, controlPins, RECIPE_PUMPS - 1),
+              "RECIPE_PINS overlap glass or control pins");
+#endif
+
+} // namespace hw
+
+#endif // HARDWARE_H
@@ -0,0 +1,53 @@
+#ifndef INPUTS_H
+#define INPUTS_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "hardware.h"
+
+// Кнопки і датчики рюмок на перериваннях: ISR кладе фронт з часом (мкс) у чергу,
+// контур керування розбирає її щотіку. Кнопки - за першим фронтом і DEBOUNCE_MS
+// тиші після нього, датчики - коли рівень простояв DEBOUNCE_MS. Натискання START
+// знеструмлює помпу ще в ISR (safetyHaltISR), не чекаючи тіку controlTask.
+// З GLASS_SENSOR_ANALOG рюмки - не переривання, а маска glass_sensor.h
+
+enum InputId : uint8_t {
+    INPUT_ENCODER_SW = 0,
+    INPUT_START,
+    INPUT_GLASS_FIRST,          // Рюмка N - INPUT_GLASS_FIRST + N - 1
+    INPUT_COUNT = INPUT_GLASS_FIRST + GLASS_COUNT
+};
+
+enum InputEventType : uint8_t {
+    INPUT_DOWN = 0,             // Кнопка натиснута / рюмку поставили
+    INPUT_UP,                   // Відпущена / зняли
+    INPUT_SHORT,                // Коротке: на відпусканні, енкодер - після DOUBLE_PRESS_MS
+    INPUT_LONG,                 // Утримання LONG_PRESS_MS, ще до відпускання
+    INPUT_DOUBLE                // Два коротких енкодера в межах DOUBLE_PRESS_MS
+};
+
+struct InputEvent {
+    uint8_t input;              // InputId
+    InputEventType type;
+    uint32_t us;                // micros() фронту (для SHORT/LONG - моменту розпізнавання)
+};
+
+// З initPeripherals(): піни, переривання, стабільний стан з поточних рівнів
+void setupInputs();
+
+// Наступна подія: черга фронтів, брязкіт, таймери натискань. false - подій немає
+bool inputNext(InputEvent &out);
+
+// Стабільний стан: кнопка натиснута / рюмка стоїть
+bool inputActive(uint8_t input);
+
+// Натискання вже використане (поворот з кнопкою, дія на INPUT_DOWN): без SHORT/LONG/DOUBLE
+void inputConsume(uint8_t input);
+
+// Після light sleep: фронти могли загубитись, стан звірити з рівнями
+void inputsResync();
+
+// Фронтів відкинуто через переповнену чергу
+uint32_t inputsDropped();
+
+#endif // INPUTS_H
@@ -0,0 +1,70 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+
+// Рівні логування (фільтрація на етапі компіляції через LOG_LEVEL)
+#define LOG_LEVEL_NONE    0
+#define LOG_LEVEL_ERROR   1
+#define LOG_LEVEL_WARN    2
+#define LOG_LEVEL_INFO    3
+#define LOG_LEVEL_DEBUG   4
+
+// Розмір кільцевого буфера (степінь двійки) та довжина повідомлення
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE     64
+#endif
+#ifndef LOG_MSG_LEN
+#define LOG_MSG_LEN       96
+#endif
+
+// Копія запису, прочитана з кільця
+struct LogEntry {
+    uint32_t seq;               // Порядковий номер (наскрізний)
+    uint32_t timestamp;         // millis() на момент запису
+    uint8_t level;
+    char msg[LOG_MSG_LEN];
+};
+
+// Ініціалізація - запуск фонової задачі виводу в Serial
+void initLog();
+
+// Запис у кільце. Не блокує: форматування в RAM, без UART
+void logWrite(uint8_t level, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Читання з курсора. Якщо курсор відстав більше ніж на LOG_RING_SIZE -
+// переставляється на найстаріший доступний запис
+bool logRead(uint32_t &cursor, LogEntry &out);
+
+// Наступний номер запису / найстаріший доступний / кількість втрачених
+uint32_t logHead();
+uint32_t logOldest();
+uint32_t logDropped();
+
+const char* logLevelName(uint8_t level);
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+  #define LOG_E(...) logWrite(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+  #define LOG_E(...)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+  #define LOG_W(...) logWrite(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+  #define LOG_W(...)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+  #define LOG_I(...) logWrite(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+  #define LOG_I(...)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+  #define LOG_D(...) logWrite(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+  #define LOG_D(...)
+#endif
+
+#endif // LOGGER_H
@@ -0,0 +1,45 @@
+#ifndef MANIFOLD_H
+#define MANIFOLD_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Колектор: у кожної рюмки 1..MANIFOLD_CHANNELS свій вихід (помпа або клапан) на
+// LEDC каналі MANIFOLD_LEDC_FIRST + (рюмка - 1). Розливи йдуть паралельно і крокують
+// з controlTask; ті, що не влазять у MANIFOLD_BUDGET_MA, чекають, поки звільниться струм
+
+#if MANIFOLD_CHANNELS
+
+// З initPeripherals()
+void setupManifold();
+
+// Розлив у рюмку. false - рюмки немає, вихід зайнятий або пристрій не готовий
+bool manifoldStart(uint8_t shot, uint16_t volume);
+// Всі виходи в нуль, розливи скасовано
+void manifoldStop();
+// false - нічого не ллється / не на паузі
+bool manifoldPause();
+bool manifoldResume();
+
+// З кожного тіку controlTask: завершення, таймаут, старт тих, що чекають
+void updateManifold();
+
+// Рюмки з розливом, що триває або чекає (біт 0 = рюмка 1)
+uint8_t manifoldBusyMask();
+// Сума по всіх розливах, що тривають
+uint16_t manifoldDispensedMl();
+uint16_t manifoldTargetMl();
+
+// Прямий вихід для прокачки і промивки, duty 0 - вимкнено
+void manifoldWrite(uint8_t shot, uint8_t duty);
+
+// Відсічка safety: всі виходи від'єднані від LEDC і в нулі. З ISR
+void manifoldCutoffISR();
+// Після відсічки - виходи знову на LEDC з нульовим duty
+void manifoldReattach();
+
+void printManifoldStatus(Print &out);
+
+#endif // MANIFOLD_CHANNELS
+
+#endif // MANIFOLD_H
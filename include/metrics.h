@@ -0,0 +1,54 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Метрики у текстовому форматі Prometheus (GET /metrics).
+// Лічильники і гістограми оновлюються з контуру керування, експорт - з AsyncTCP.
+// Текст генерується порціями в буфер відповіді, без повного тіла в RAM
+
+#if ENABLE_METRICS
+
+// Гістограма: межі кошиків у власних одиницях (мс, мкс), останній кошик - +Inf
+struct MetricsHistogram {
+    uint32_t buckets[METRICS_BUCKETS + 1];
+    uint32_t count;
+    uint64_t sum;
+};
+
+// Розлив завершено за durationMs
+void metricsPourDone(uint32_t durationMs);
+
+// Початок ітерації controlTask. periodUs - номінальний період контуру
+void metricsControlTick(uint32_t periodUs);
+
+// Послідовний генератор тексту. Знімок значень робиться в конструкторі;
+// read() віддає наступну порцію, 0 - кінець
+class MetricsExporter {
+public:
+    MetricsExporter();
+    size_t read(uint8_t *buf, size_t maxLen);
+
+private:
+    size_t fill();
+    size_t fillHistogram(const char* name, const char* help, const MetricsHistogram &h,
+                         const uint32_t *bounds, uint32_t unitsPerSec);
+
+    MetricsHistogram _pour;
+    MetricsHistogram _jitter;
+    uint8_t _family;
+    uint8_t _bucket;
+    char _line[384];
+    size_t _lineLen;
+    size_t _linePos;
+};
+
+#else
+
+inline void metricsPourDone(uint32_t durationMs) {}
+inline void metricsControlTick(uint32_t periodUs) {}
+
+#endif // ENABLE_METRICS
+
+#endif // METRICS_H
@@ -6,11 +6,12 @@
 #if ENABLE_WIFI
 
 #include <WiFi.h>
+#include <ESPmDNS.h>
 #include <ESPAsyncWebServer.h>
 #include <AsyncTCP.h>
 #include <ArduinoJson.h>
 
-#if ENABLE_OTA
+#if ENABLE_ARDUINO_OTA
 #include <ArduinoOTA.h>
 #endif
 
@@ -25,8 +26,35 @@ void broadcastState();
 
 // Допоміжні функції
 const char* getStateString(SystemState state);
+void serializeState(JsonDocument &doc);
+void serializeLogs(JsonDocument &doc, uint32_t since);
+// Поле форми / URL -> JSON: ціле, дробове або рядок
+void apiFormField(JsonObject obj, const char* name, const char* value);
+
+// WiFi: дані зберігаються в NVS, застосовуються з loop()
+void wifiSetCredentials(const char* ssid, const char* pass);
+void wifiForget();
+const char* wifiStateString();
+void serializeWifi(JsonDocument &doc);
+void printWifiStatus(Print &out);
+
+// Для метрик: клієнти WebSocket і байти, надіслані через WebSocket / SSE
+uint32_t wsClientCount();
+uint32_t wsBytesSent();
+uint32_t sseBytesSent();
+
+// Кадри WebSocket: поставлені в чергу, стани замінені новішими, відкинуті (повна черга)
+uint32_t wsFramesSent();
+uint32_t wsFramesSuperseded();
+uint32_t wsFramesDropped();
+void printWsStatus(Print &out);
+
+#if ENABLE_OTA || ENABLE_ARDUINO_OTA
+// Пароль оновлення прошивки: у NVS і одразу в дію (HTTP і espota)
+bool otaSetPassword(const char* pass);
+#endif
 
-#if ENABLE_OTA
+#if ENABLE_ARDUINO_OTA
 void setupOTA();
 #endif
 
@@ -0,0 +1,41 @@
+#ifndef OTA_H
+#define OTA_H
+
+#include "config.h"
+
+#if ENABLE_WIFI && ENABLE_OTA
+
+#include <ArduinoJson.h>
+
+// Оновлення прошивки через HTTP: потоком у неактивний розділ (A/B) без буферизації,
+// SHA-256 перевіряється до перемикання завантажувального розділу.
+// Нова прошивка підтверджується перевіркою здоров'я, інакше - відкат на попередню
+
+// На старті, до створення задач: облік завантажень непідтвердженої прошивки
+void otaBootCheck();
+
+// З loop(): перезавантаження після запису, перевірка здоров'я
+void updateOta();
+
+// Розлив зупиняється переходом у STATE_UPDATING (HTTP і ArduinoOTA)
+void otaEnterUpdating();
+void otaLeaveUpdating();
+
+// Нову прошивку записано - після перезавантаження чекати підтвердження
+void otaMarkPending();
+
+// Сесія завантаження. owner - запит, якому вона належить: частини інших запитів
+// ігноруються. sha256Hex - очікуваний хеш файлу (64 hex) або порожній рядок
+bool otaBegin(const void *owner, size_t size, const char *sha256Hex);
+bool otaWrite(const void *owner, const uint8_t *data, size_t len);
+bool otaEnd(const void *owner);
+void otaAbort(const void *owner, const char *reason);
+
+// Результат сесії для відповіді: HTTP код і повідомлення
+int otaResult(const void *owner, const char **message);
+
+void serializeOta(JsonDocument &doc);
+
+#endif // ENABLE_WIFI && ENABLE_OTA
+
+#endif // OTA_H
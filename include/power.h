@@ -0,0 +1,35 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Режим простою. Без дій IDLE_DIM_TIMEOUT - тьмяна підсвітка і LED,
+// IDLE_SLEEP_TIMEOUT - підсвітка і LED вимкнені, серво знеструмлене, CPU на
+// POWER_SLEEP_CPU_MHZ, automatic light sleep з пробудженням від кнопок і датчиків.
+// Точка доступу і сервер працюють і в сні
+
+enum PowerLevel : uint8_t {
+    POWER_ACTIVE = 0,
+    POWER_DIM,
+    POWER_SLEEP
+};
+
+// З setup(), до створення задач
+void setupPower();
+
+// Дія користувача (команда, клієнт WebSocket). З будь-якої задачі
+void powerActivity();
+
+// Повне пробудження одразу: серво під живленням після повернення. З будь-якої задачі
+void powerWake();
+
+// З кожного тіку controlTask: зміни входів і стану, таймери простою
+void updatePower();
+
+PowerLevel powerLevel();
+uint32_t powerIdleMs();
+const char* powerLevelName(PowerLevel level);
+void printPowerStatus(Print &out);
+
+#endif // POWER_H
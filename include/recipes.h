@@ -0,0 +1,89 @@
+#ifndef RECIPES_H
+#define RECIPES_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Коктейлі: рецепт - частки інгредієнтів, інгредієнт шукається серед заправлених
+// помп за назвою. Етапи йдуть по черзі, інгредієнти одного етапу - паралельно.
+// Розлив коктейлю - звичайний розлив у вибрану рюмку (startPour, пауза, відсічка),
+// помпи вмикає розклад від часу розливу
+
+// Помпа: що в ній і власне калібрування (сиропи течуть повільніше)
+struct PumpSlot {
+    char ingredient[RECIPE_NAME_LEN];
+    float rate;                 // мл/с, 0 - калібрування основної помпи
+};
+
+struct RecipeStep {
+    char ingredient[RECIPE_NAME_LEN];
+    uint8_t parts;              // Частка в об'ємі
+    uint8_t stage;              // 0.. - етапи по черзі, один етап - разом
+};
+
+struct Recipe {
+    char name[RECIPE_NAME_LEN];
+    uint8_t steps;
+    RecipeStep step[RECIPE_STEPS_MAX];
+};
+
+// Блоб у NVS (RECIPE_PREFS_NAMESPACE)
+struct RecipeBook {
+    uint16_t magic;
+    uint16_t version;
+    PumpSlot pumps[RECIPE_PUMPS];
+    uint8_t count;
+    Recipe recipes[RECIPES_MAX];
+};
+
+// З setup(): книга рецептів з NVS або стандартна
+void loadRecipes();
+
+#if RECIPE_PUMPS > 1
+// З initPeripherals(): помпи 2..RECIPE_PUMPS на LEDC з нульовим duty
+void setupRecipePumps();
+// Відсічка safety: виходи від'єднані від LEDC і в нулі. З ISR
+void recipeCutoffISR();
+void recipeReattach();
+#endif
+
+// Вибір: 0 - звичайний розлив основною помпою, 1..recipeCount() - коктейль
+uint8_t recipeCount();
+const Recipe* recipeAt(uint8_t index);
+bool recipeSelect(uint8_t index);
+// За назвою або номером, "off" - без коктейлю. recipeIndex: -1 - немає такого
+int recipeIndex(const char* name);
+bool recipeSelectName(const char* name);
+// Енкодер: наступний рецепт, для якого заправлені всі інгредієнти
+void recipeSelectNext(int dir);
+const char* recipeSelectedName();
+// Є помпа з кожним інгредієнтом рецепта; missing - перший відсутній
+bool recipeAvailable(const Recipe &recipe, const char **missing = NULL);
+
+// "gin:2,tonic:3/lime:1": ',' - той самий етап, '/' - наступний. Без ":N" - 1 частка
+bool recipeParse(const char* spec, Recipe &out);
+void recipeFormat(const Recipe &recipe, char *buf, size_t len);
+// Новий або заміна з тією ж назвою. false - книга повна
+bool recipeSave(const Recipe &recipe);
+bool recipeDelete(const char* name);
+
+// Помпа 1..RECIPE_PUMPS: інгредієнт і калібрування (0 - як основна помпа)
+bool pumpLoad(uint8_t pump, const char* ingredient, float rate);
+const PumpSlot* pumpSlot(uint8_t pump);
+float pumpRate(uint8_t pump);
+
+// Розклад розливу вибраного коктейлю. false - немає інгредієнта або довше MAX_POUR_TIME.
+// primed - трубки заповнені, інакше кожна спершу доливає мертвий об'єм
+bool recipePlan(uint16_t volume, bool primed);
+bool recipeActive();
+unsigned long recipeTotalMs();
+// Помпи за розкладом на момент elapsed (час роботи без пауз)
+void recipeApply(unsigned long elapsed);
+void recipeOutputsOff();
+uint16_t recipeDispensedMl(unsigned long elapsed);
+// Всі помпи вимкнено, розклад скинуто
+void recipeEnd();
+
+void printRecipes(Print &out);
+
+#endif // RECIPES_H
@@ -0,0 +1,66 @@
+#ifndef SAFETY_H
+#define SAFETY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Захист від переливу незалежно від контуру керування:
+// - task watchdog для controlTask, uiTask і loop() (мережа)
+// - апаратний таймер вимикає помпу, якщо controlTask не відмічався
+//   SAFETY_MISSED_TICKS тіків або помпа працює довше MAX_POUR_TIME + запас
+// - запис про збій переживає перезавантаження (RTC, потім NVS)
+
+enum SafetyFaultReason : uint8_t {
+    FAULT_NONE = 0,
+    FAULT_CONTROL_STALL,        // Контур керування завис з увімкненою помпою
+    FAULT_POUR_TIMEOUT,         // Помпа довше MAX_POUR_TIME + SAFETY_POUR_MARGIN
+    FAULT_TASK_WDT,             // Перезавантаження task watchdog
+    FAULT_INT_WDT,              // Перезавантаження interrupt watchdog
+    FAULT_PANIC,                // Виняток / abort()
+    FAULT_BROWNOUT              // Просідання живлення
+};
+
+struct SafetyFault {
+    uint8_t reason;             // SafetyFaultReason
+    uint8_t state;              // SystemState на момент збою
+    uint8_t pumping;            // Помпа була увімкнена
+    uint8_t reserved;
+    uint32_t uptime;            // millis() на момент збою (0 - невідомо)
+    uint32_t pumpMs;            // Скільки працювала помпа
+};
+
+// На старті, після loadSettings(): причина скидання і запис з RTC -> NVS
+void safetyBootCheck();
+
+// Одразу після створення задач, до мережі: watchdog і таймер відсічки. Викликати з setup()
+void setupSafety(TaskHandle_t uiTask, TaskHandle_t controlTask);
+
+// З кожного тіку controlTask
+void safetyFeed();
+
+// Помпа увімкнена/вимкнена - таймер відсічки зведений лише з увімкненою помпою.
+// since - коли увімкнено вихід, що працює найдовше (колектор, кілька виходів)
+void safetyPumpOn();
+void safetyPumpOn(unsigned long since);
+void safetyPumpOff();
+
+// Швидкий стоп з ISR кнопки START: помпи знеструмлені одразу, до тіку controlTask.
+// Відпускають лише пауза, стоп і завершення розливу чи промивки - після того, як
+// облікували зупинку; safetyRelease() повертає виходи на LEDC
+void safetyHaltISR();
+void safetyRelease();
+// millis() швидкого стопу, що ще не відпущений. 0 - не було
+unsigned long safetyHaltMs();
+
+// З loop(): watchdog loop() і обробка відсічки (стоп, STATE_ERROR, запис)
+void updateSafety();
+
+// Останній збій і кількість з NVS
+bool safetyLastFault(SafetyFault &out);
+uint32_t safetyFaultCount();
+void safetyClearFaults();
+
+const char* safetyFaultName(uint8_t reason);
+void printSafetyStatus(Print &out);
+
+#endif // SAFETY_H
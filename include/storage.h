@@ -4,14 +4,41 @@
 #include <Arduino.h>
 #include <Preferences.h>
 #include "config.h"
+#include "safety.h"
+#include "recipes.h"
 
 // Завантаження/збереження налаштувань
 void loadSettings();
 void saveSettings();
 
 // Статистика
+// Зберігається одним блобом з CRC у двох слотах (A/B), пишеться тільки при змінах.
+// Час роботи сам по собі - раз на STATS_UPTIME_SAVE_INTERVAL
 void saveStatistics();
+void markStatisticsDirty();
+void updateUptime();
 void resetStatistics();
 void resetSettings();
 
+// Облікові дані WiFi (окремий простір NVS - не стираються resetSettings)
+bool loadWifiCredentials(char *ssid, size_t ssidLen, char *pass, size_t passLen);
+bool saveWifiCredentials(const char* ssid, const char* pass);
+void clearWifiCredentials();
+
+// Пароль оновлення прошивки: NVS, інакше OTA_PASSWORD. false - не задано
+bool loadOtaPassword(char *pass, size_t passLen);
+bool saveOtaPassword(const char* pass);
+
+// Журнал збоїв (окремий простір NVS): останній збій і їх кількість
+bool loadFaultRecord(SafetyFault &fault, uint32_t &count);
+void saveFaultRecord(const SafetyFault &fault);
+void clearFaultRecords();
+
+// Книга рецептів і помпи (окремий простір NVS). false - порожньо або інший формат
+bool loadRecipeBook(RecipeBook &book);
+void saveRecipeBook(const RecipeBook &book);
+
+// Кількість записів у NVS з моменту старту (для метрик)
+uint32_t storageWriteCount();
+
 #endif // STORAGE_H
\ No newline at end of file
@@ -0,0 +1,118 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+
+// Точки трасування контурів керування та UI.
+// Початок - esp_timer (спільний для обох ядер), тривалість - лічильник тактів ядра.
+// Частота ядра змінюється (power.cpp: 240/80 МГц) - пишеться з кожною подією
+
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE   512
+#endif
+
+enum TracePoint : uint8_t {
+    TRACE_CONTROL_LOOP = 0,     // Ітерація controlTask
+    TRACE_CONTROLS,             // updateControls()
+    TRACE_POUR_STATE,           // updatePourState()
+    TRACE_LED,                  // updateLED()
+    TRACE_LED_SHOW,             // FastLED.show()
+    TRACE_UI_LOOP,              // Ітерація uiTask
+    TRACE_DISPLAY,              // updateDisplay()
+    TRACE_SAVE_SETTINGS,        // saveSettings()
+    TRACE_SAVE_STATS,           // saveStatistics() з записом у NVS
+    TRACE_BROADCAST,            // broadcastState()
+    TRACE_MISS_CONTROL,         // Пропущений дедлайн controlTask (миттєва подія)
+    TRACE_MISS_UI,              // Пропущений дедлайн uiTask (миттєва подія)
+    TRACE_POINT_COUNT
+};
+
+// Контури з перевіркою дедлайну
+enum TraceLoop : uint8_t {
+    TRACE_LOOP_CONTROL = 0,
+    TRACE_LOOP_UI,
+    TRACE_LOOP_COUNT
+};
+
+// Подія, прочитана з буфера
+struct TraceEvent {
+    uint32_t startUs;           // micros() на початку
+    uint32_t cycles;            // Тривалість у тактах (0 для миттєвих подій)
+    uint8_t point;
+    uint8_t core;
+    uint8_t task;               // 0 = інша, 1 = Control, 2 = UI
+    uint8_t mhz;                // Частота ядра на момент запису: такти -> мкс
+    uint16_t arg;               // Для пропущених дедлайнів - запізнення, мс
+};
+
+#if ENABLE_TRACE
+
+// Запис у кільце. Без блокувань, безпечно з обох ядер
+void traceRecord(uint8_t point, uint32_t startUs, uint32_t cycles, uint16_t arg = 0);
+
+// Перевірка дедлайну перед vTaskDelayUntil: наступне пробудження вже мало настати
+void traceDeadline(uint8_t loop, TickType_t lastWakeTime, TickType_t period);
+
+uint32_t traceLoops(uint8_t loop);
+uint32_t traceMisses(uint8_t loop);
+uint32_t traceMaxUs(uint8_t point);
+void traceClear();
+
+const char* tracePointName(uint8_t point);
+
+// Знімок буфера, від найстарішої події. Повертає кількість
+size_t traceSnapshot(TraceEvent *out, size_t maxEvents);
+
+// Послідовний генератор Chrome trace-event JSON (chrome://tracing, Perfetto).
+// Знімок робиться в конструкторі; read() віддає наступну порцію тексту, 0 - кінець
+class TraceExporter {
+public:
+    TraceExporter();
+    ~TraceExporter();
+    size_t read(uint8_t *buf, size_t maxLen);
+
+private:
+    size_t fill();
+
+    TraceEvent *_events;
+    size_t _count;
+    size_t _next;
+    uint8_t _stage;
+    uint32_t _baseUs;
+    uint32_t _cpuMhz;
+    char _line[192];
+    size_t _lineLen;
+    size_t _linePos;
+};
+
+// Вивід усього JSON у Serial (або будь-який Print)
+void traceDump(Print &out);
+
+// Замір області видимості: конструктор - початок, деструктор - запис
+class TraceScope {
+public:
+    explicit TraceScope(uint8_t point)
+        : _point(point), _startUs(micros()), _startCycles(ESP.getCycleCount()) {}
+    ~TraceScope() {
+        traceRecord(_point, _startUs, ESP.getCycleCount() - _startCycles);
+    }
+
+private:
+    uint8_t _point;
+    uint32_t _startUs;
+    uint32_t _startCycles;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(point) TraceScope TRACE_CONCAT(_traceScope, __LINE__)(point)
+#define TRACE_DEADLINE(loop, lastWake, period) traceDeadline(loop, lastWake, period)
+
+#else
+
+#define TRACE_SCOPE(point)
+#define TRACE_DEADLINE(loop, lastWake, period)
+
+#endif // ENABLE_TRACE
+
+#endif // TRACE_H
@@ -0,0 +1,605 @@
+// Навантажувальний тест мережевої частини на native симуляторі: "20 гостей відкрили сторінку".
+// Прошивка (setup()/loop() з src/) працює в дочірньому процесі - її купа не змішується
+// з клієнтами. Батьківський процес запускає N клієнтів WebSocket і M клієнтів HTTP
+// з типовою сумішшю команд і міряє пропускну здатність, затримку команда -> розсилка стану
+// та мінімум вільної купи пристрою (з /metrics).
+//
+// Результат - JSON у stdout, коротка таблиця - у stderr:
+//   pio run -e native-load && .pio/build/native-load/program --ws 20 --http 4 --duration 30 > load.json
+//   .pio/build/native-load/program --target 192.168.4.1:80     # справжній пристрій
+
+#include "Arduino.h"
+#include "sim_hal.h"
+#include "config.h"
+#include "hardware.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+void setup();
+void loop();
+
+struct LoadOptions {
+    std::string host = "127.0.0.1";
+    uint16_t port = 18080;
+    bool external = false;          // --target: без дочірньої прошивки
+    uint32_t wsClients = 20;
+    uint32_t httpClients = 4;
+    uint32_t durationS = 10;
+    uint32_t dragMs = 50;           // Крок слайдера (oninput без throttle - найгірший випадок)
+    uint32_t seed = 1;
+};
+
+struct LoadStats {
+    std::atomic<uint64_t> wsConnected{0};
+    std::atomic<uint64_t> wsFailures{0};       // Не підключився (немає 101)
+    std::atomic<uint64_t> wsClosed{0};         // Пристрій закрив з'єднання до кінця тесту
+    std::atomic<uint64_t> commands{0};
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> stateFrames{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> coalesced{0};        // volume, замінений новішим до розсилки
+    std::atomic<uint64_t> unanswered{0};       // volume без розсилки до кінця тесту
+    std::atomic<uint64_t> httpRequests{0};
+    std::atomic<uint64_t> httpErrors{0};
+
+    std::mutex lock;
+    std::vector<uint64_t> latencyNs;           // Команда volume -> стан з цим об'ємом
+    std::vector<uint64_t> httpNs;
+};
+
+static LoadOptions opts;
+static LoadStats stats;
+
+static inline uint64_t loadNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void loadSleepMs(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static double percentileMs(std::vector<uint64_t> samples, double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    size_t i = std::min(samples.size() - 1, (size_t)(samples.size() * p));
+    return samples[i] / 1e6;
+}
+
+// ========================================
+// TCP / HTTP / WEBSOCKET
+// ========================================
+
+static int tcpConnect() {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *res = NULL;
+    if (getaddrinfo(opts.host.c_str(), std::to_string(opts.port).c_str(), &hints, &res) != 0) return -1;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) return -1;
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    timeval tv = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+static bool writeAll(int fd, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t*)data;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool readAll(int fd, void *data, size_t len) {
+    uint8_t *p = (uint8_t*)data;
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Тіло з Transfer-Encoding: chunked (/metrics) - без розмірів порцій
+static std::string dechunk(const std::string &body) {
+    std::string out;
+    size_t pos = 0;
+    while (pos < body.size()) {
+        size_t eol = body.find("\r\n", pos);
+        if (eol == std::string::npos) break;
+        size_t len = strtoul(body.c_str() + pos, NULL, 16);
+        if (len == 0) break;
+        out.append(body, eol + 2, len);
+        pos = eol + 2 + len + 2;
+    }
+    return out;
+}
+
+// Connection: close - тіло до кінця з'єднання. Код статусу або -1, response - лише тіло
+static int httpRequest(const char* method, const char* path, const std::string &body, std::string &response) {
+    int fd = tcpConnect();
+    if (fd < 0) return -1;
+
+    char head[256];
+    snprintf(head, sizeof(head),
+             "%s %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\nContent-Type: text/plain\r\nContent-Length: %zu\r\n\r\n",
+             method, path, opts.host.c_str(), body.size());
+    if (!writeAll(fd, head, strlen(head)) || !writeAll(fd, body.data(), body.size())) {
+        close(fd);
+        return -1;
+    }
+
+    response.clear();
+    char buf[4096];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) response.append(buf, n);
+    close(fd);
+
+    int code = -1;
+    size_t bodyAt = response.find("\r\n\r\n");
+    if (bodyAt == std::string::npos || sscanf(response.c_str(), "HTTP/1.%*d %d", &code) != 1) return -1;
+
+    bool chunked = response.find("Transfer-Encoding: chunked") < bodyAt;
+    response = chunked ? dechunk(response.substr(bodyAt + 4)) : response.substr(bodyAt + 4);
+    return code;
+}
+
+static int wsConnect() {
+    int fd = tcpConnect();
+    if (fd < 0) return -1;
+
+    // Ключ не перевіряється: нам потрібен лише 101
+    const char* req = "GET /ws HTTP/1.1\r\nHost: load\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                      "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    if (!writeAll(fd, req, strlen(req))) {
+        close(fd);
+        return -1;
+    }
+
+    std::string head;
+    char c;
+    while (head.size() < 1024 && head.find("\r\n\r\n") == std::string::npos) {
+        if (recv(fd, &c, 1, 0) != 1) break;
+        head += c;
+    }
+    if (head.compare(0, 12, "HTTP/1.1 101") != 0) {
+        close(fd);
+        return -1;
+    }
+
+    // Читач чекає кадрів скільки завгодно - кінець тесту закриває сокет
+    timeval tv = {0, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+// Кадр клієнта завжди маскований
+static bool wsSendText(int fd, const std::string &text) {
+    uint8_t frame[8 + 256];
+    size_t len = std::min<size_t>(text.size(), 256);
+    size_t pos = 0;
+    frame[pos++] = 0x81;
+    if (len < 126) {
+        frame[pos++] = 0x80 | len;
+    } else {
+        frame[pos++] = 0x80 | 126;
+        frame[pos++] = len >> 8;
+        frame[pos++] = len;
+    }
+    const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+    memcpy(frame + pos, mask, 4);
+    pos += 4;
+    for (size_t i = 0; i < len; i++) frame[pos++] = text[i] ^ mask[i & 3];
+    return writeAll(fd, frame, pos);
+}
+
+static bool wsReadFrame(int fd, uint8_t &opcode, std::string &payload) {
+    uint8_t head[2];
+    if (!readAll(fd, head, 2)) return false;
+    opcode = head[0] & 0x0F;
+    uint64_t len = head[1] & 0x7F;
+    if (len == 126) {
+        uint8_t ext[2];
+        if (!readAll(fd, ext, 2)) return false;
+        len = (ext[0] << 8) | ext[1];
+    } else if (len == 127) {
+        uint8_t ext[8];
+        if (!readAll(fd, ext, 8)) return false;
+        len = 0;
+        for (int i = 0; i < 8; i++) len = (len << 8) | ext[i];
+    }
+    payload.resize(len);
+    return len == 0 || readAll(fd, &payload[0], len);
+}
+
+// ========================================
+// КЛІЄНТИ
+// ========================================
+
+struct PendingVolume {
+    int volume;
+    uint64_t sentNs;
+};
+
+// Вкладка браузера: тягне слайдер, вибирає рюмку, стартує/зупиняє, іноді просить логи
+static void wsClient(uint32_t index, uint64_t deadlineNs) {
+    int fd = wsConnect();
+    if (fd < 0) {
+        stats.wsFailures++;
+        return;
+    }
+    stats.wsConnected++;
+
+    std::mutex pendingLock;
+    std::vector<PendingVolume> pending;
+    std::atomic<bool> closing(false);
+
+    std::thread reader([&] {
+        uint8_t opcode;
+        std::string payload;
+        while (wsReadFrame(fd, opcode, payload)) {
+            if (opcode == 0x08) break;
+            if (opcode != 0x01) continue;
+            stats.frames++;
+            stats.bytes += payload.size();
+            if (payload.compare(0, 10, "{\"status\":") != 0) continue;
+            stats.stateFrames++;
+
+            size_t at = payload.find("\"volume\":");
+            if (at == std::string::npos) continue;
+            int volume = atoi(payload.c_str() + at + 9);
+            uint64_t now = loadNowNs();
+
+            // Старіші значення перед знайденим уже не прийдуть - їх замінило новіше
+            std::lock_guard<std::mutex> lock(pendingLock);
+            for (size_t i = 0; i < pending.size(); i++) {
+                if (pending[i].volume != volume) continue;
+                {
+                    std::lock_guard<std::mutex> statsLock(stats.lock);
+                    stats.latencyNs.push_back(now - pending[i].sentNs);
+                }
+                stats.coalesced += i;
+                pending.erase(pending.begin(), pending.begin() + i + 1);
+                break;
+            }
+        }
+        if (!closing) stats.wsClosed++;
+    });
+
+    std::mt19937 rng(opts.seed * 1000 + index);
+    auto rnd = [&rng](uint32_t lo, uint32_t hi) { return (uint32_t)(lo + rng() % (hi - lo + 1)); };
+
+    // Кожен клієнт тягне по своїй сітці значень: розсилку свого об'єму не сплутати з чужим
+    int stride = std::max<int>(VOLUME_STEP, std::min<int>(opts.wsClients, (VOLUME_MAX - VOLUME_MIN) / 4));
+    int volume = VOLUME_MIN + index % stride + stride * rnd(0, (VOLUME_MAX - VOLUME_MIN) / stride - 1);
+    char text[64];
+    bool ok = true;
+
+    while (ok && loadNowNs() < deadlineNs) {
+        uint32_t action = rnd(0, 99);
+
+        if (action < 55) {
+            // Перетягування слайдера
+            int dir = rnd(0, 1) ? 1 : -1;
+            uint32_t steps = rnd(5, 20);
+            for (uint32_t i = 0; ok && i < steps; i++) {
+                volume += dir * stride;
+                if (volume > VOLUME_MAX || volume < VOLUME_MIN) {
+                    dir = -dir;
+                    volume += 2 * dir * stride;
+                }
+                snprintf(text, sizeof(text), "{\"cmd\":\"volume\",\"value\":%d}", volume);
+                {
+                    // Повтор значення (слайдер назад): міряється від останньої відправки
+                    std::lock_guard<std::mutex> lock(pendingLock);
+                    for (size_t j = 0; j < pending.size(); j++) {
+                        if (pending[j].volume != volume) continue;
+                        pending.erase(pending.begin() + j);
+                        stats.coalesced++;
+                        break;
+                    }
+                    pending.push_back({volume, loadNowNs()});
+                }
+                ok = wsSendText(fd, text);
+                stats.commands++;
+                loadSleepMs(opts.dragMs);
+            }
+        } else if (action < 70) {
+            snprintf(text, sizeof(text), "{\"cmd\":\"shot\",\"value\":%u}", rnd(1, 5));
+            ok = wsSendText(fd, text);
+            stats.commands++;
+        } else if (action < 80) {
+            ok = wsSendText(fd, "{\"cmd\":\"start\"}");
+            loadSleepMs(rnd(200, 800));
+            ok = ok && wsSendText(fd, "{\"cmd\":\"stop\"}");
+            stats.commands += 2;
+        } else if (action < 90) {
+            ok = wsSendText(fd, "{\"cmd\":\"logs\"}");
+            stats.commands++;
+        } else {
+            ok = wsSendText(fd, "stats");
+            stats.commands++;
+        }
+
+        loadSleepMs(rnd(200, 1000));
+    }
+
+    // Дати останнім розсилкам дійти
+    loadSleepMs(500);
+    closing = true;
+    const uint8_t closeFrame[6] = {0x88, 0x80, 0, 0, 0, 0};
+    writeAll(fd, closeFrame, sizeof(closeFrame));
+    shutdown(fd, SHUT_RDWR);
+    reader.join();
+    close(fd);
+
+    stats.unanswered += pending.size();
+}
+
+// Опитування статусу і метрик, текстові команди через POST /api/cmd
+static void httpClient(uint32_t index, uint64_t deadlineNs) {
+    std::mt19937 rng(opts.seed * 1000 + 500 + index);
+    std::string response;
+
+    while (loadNowNs() < deadlineNs) {
+        uint32_t action = rng() % 100;
+        uint64_t t0 = loadNowNs();
+        int code;
+        if (action < 60) code = httpRequest("GET", "/api/status", "", response);
+        else if (action < 80) code = httpRequest("GET", "/metrics", "", response);
+        else if (action < 90) code = httpRequest("GET", "/api/queue", "", response);
+        else code = httpRequest("POST", "/api/cmd", "stats", response);
+        uint64_t elapsed = loadNowNs() - t0;
+
+        stats.httpRequests++;
+        if (code != 200) stats.httpErrors++;
+        {
+            std::lock_guard<std::mutex> lock(stats.lock);
+            stats.httpNs.push_back(elapsed);
+        }
+        loadSleepMs(200 + rng() % 400);
+    }
+}
+
+// ========================================
+// ПРИСТРІЙ
+// ========================================
+
+// Значення рядка метрики з точним префіксом (ім'я з мітками + пробіл)
+static uint64_t metricValue(const std::string &text, const char* key) {
+    std::string prefix = std::string("\n") + key + " ";
+    size_t at = ("\n" + text).find(prefix);
+    if (at == std::string::npos) return 0;
+    return strtoull(text.c_str() + at + prefix.size() - 1, NULL, 10);
+}
+
+static bool fetchMetrics(std::string &text) {
+    return httpRequest("GET", "/metrics", "", text) == 200;
+}
+
+// Прошивка в окремому процесі: купа пристрою (модель симулятора) рахує лише її
+static pid_t startFirmware(const std::string &nvs) {
+    pid_t pid = fork();
+    if (pid != 0) return pid;
+
+    int devnull = open("/dev/null", O_RDWR);
+    dup2(devnull, STDIN_FILENO);
+    dup2(devnull, STDOUT_FILENO);
+
+    sim::setNvsDir(nvs.c_str());
+    sim::setHttpPort(opts.port);
+    sim::setSerialOutput(false);
+    sim::setIoTrace(false);
+
+    // Рюмки стоять - start справді наливає
+    for (uint8_t pin : hw::glassPins) {
+        sim::setPin(pin, HIGH);
+    }
+
+    setup();
+    while (true) loop();
+}
+
+static bool waitForDevice(pid_t child) {
+    for (int i = 0; i < 100; i++) {
+        if (child > 0 && waitpid(child, NULL, WNOHANG) == child) return false;
+        int fd = tcpConnect();
+        if (fd >= 0) {
+            close(fd);
+            return true;
+        }
+        loadSleepMs(50);
+    }
+    return false;
+}
+
+// ========================================
+// ЗВІТ
+// ========================================
+
+struct DeviceReport {
+    uint64_t heapStart;
+    uint64_t heapMin;
+    uint64_t wsSent;
+    uint64_t wsSuperseded;
+    uint64_t wsDropped;
+    uint64_t settersReceived;
+    uint64_t settersApplied;
+    int exitStatus;             // -1 - працює до кінця тесту
+};
+
+static void printJson(const DeviceReport &dev, double seconds) {
+    printf("{\n  \"firmware\": \"%s\",\n  \"ws_clients\": %u,\n  \"http_clients\": %u,\n  \"duration_s\": %.1f,\n",
+           FIRMWARE_VERSION, opts.wsClients, opts.httpClients, seconds);
+    printf("  \"ws\": {\"connected\": %llu, \"failures\": %llu, \"closed_by_device\": %llu, \"commands\": %llu, "
+           "\"frames\": %llu, \"state_frames\": %llu, \"bytes\": %llu, \"commands_per_s\": %.1f, \"frames_per_s\": %.1f},\n",
+           (unsigned long long)stats.wsConnected, (unsigned long long)stats.wsFailures, (unsigned long long)stats.wsClosed,
+           (unsigned long long)stats.commands, (unsigned long long)stats.frames,
+           (unsigned long long)stats.stateFrames, (unsigned long long)stats.bytes,
+           stats.commands / seconds, stats.frames / seconds);
+    printf("  \"latency_ms\": {\"samples\": %zu, \"p50\": %.2f, \"p99\": %.2f, \"max\": %.2f, "
+           "\"coalesced\": %llu, \"unanswered\": %llu},\n",
+           stats.latencyNs.size(), percentileMs(stats.latencyNs, 0.5), percentileMs(stats.latencyNs, 0.99),
+           percentileMs(stats.latencyNs, 1.0), (unsigned long long)stats.coalesced,
+           (unsigned long long)stats.unanswered);
+    printf("  \"http\": {\"requests\": %llu, \"errors\": %llu, \"per_s\": %.1f, \"p50_ms\": %.2f, \"p99_ms\": %.2f},\n",
+           (unsigned long long)stats.httpRequests, (unsigned long long)stats.httpErrors,
+           stats.httpRequests / seconds, percentileMs(stats.httpNs, 0.5), percentileMs(stats.httpNs, 0.99));
+    printf("  \"device\": {\"heap_free_start\": %llu, \"heap_min_free\": %llu, \"ws_frames_sent\": %llu, "
+           "\"ws_frames_superseded\": %llu, \"ws_frames_dropped\": %llu, \"setters_received\": %llu, "
+           "\"setters_applied\": %llu, \"exit_status\": %d}\n}\n",
+           (unsigned long long)dev.heapStart, (unsigned long long)dev.heapMin, (unsigned long long)dev.wsSent,
+           (unsigned long long)dev.wsSuperseded, (unsigned long long)dev.wsDropped,
+           (unsigned long long)dev.settersReceived, (unsigned long long)dev.settersApplied, dev.exitStatus);
+}
+
+static void printTable(const DeviceReport &dev, double seconds) {
+    fprintf(stderr, "ws clients      %llu/%u connected, %llu failed, %llu closed by device\n",
+            (unsigned long long)stats.wsConnected, opts.wsClients, (unsigned long long)stats.wsFailures,
+            (unsigned long long)stats.wsClosed);
+    fprintf(stderr, "commands        %llu (%.1f/s)\n", (unsigned long long)stats.commands, stats.commands / seconds);
+    fprintf(stderr, "frames          %llu (%.1f/s), %llu state\n", (unsigned long long)stats.frames,
+            stats.frames / seconds, (unsigned long long)stats.stateFrames);
+    fprintf(stderr, "cmd->broadcast  p50 %.2f ms, p99 %.2f ms, max %.2f ms (%zu samples, %llu coalesced)\n",
+            percentileMs(stats.latencyNs, 0.5), percentileMs(stats.latencyNs, 0.99),
+            percentileMs(stats.latencyNs, 1.0), stats.latencyNs.size(), (unsigned long long)stats.coalesced);
+    fprintf(stderr, "http            %llu requests (%.1f/s), %llu errors, p99 %.2f ms\n",
+            (unsigned long long)stats.httpRequests, stats.httpRequests / seconds,
+            (unsigned long long)stats.httpErrors, percentileMs(stats.httpNs, 0.99));
+    fprintf(stderr, "device heap     %llu free at start, %llu min free\n",
+            (unsigned long long)dev.heapStart, (unsigned long long)dev.heapMin);
+    fprintf(stderr, "device ws       %llu sent, %llu superseded, %llu dropped\n",
+            (unsigned long long)dev.wsSent, (unsigned long long)dev.wsSuperseded, (unsigned long long)dev.wsDropped);
+    if (dev.exitStatus >= 0) fprintf(stderr, "FIRMWARE EXITED with status %d\n", dev.exitStatus);
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "Usage: %s [--ws N] [--http N] [--duration S] [--drag-ms MS] [--seed N]\n"
+                    "          [--port P | --target HOST:PORT]\n", name);
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--ws" && hasValue) {
+            opts.wsClients = atoi(argv[++i]);
+        } else if (arg == "--http" && hasValue) {
+            opts.httpClients = atoi(argv[++i]);
+        } else if (arg == "--duration" && hasValue) {
+            opts.durationS = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--drag-ms" && hasValue) {
+            opts.dragMs = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--seed" && hasValue) {
+            opts.seed = atoi(argv[++i]);
+        } else if (arg == "--port" && hasValue) {
+            opts.port = atoi(argv[++i]);
+        } else if (arg == "--target" && hasValue) {
+            std::string target = argv[++i];
+            size_t colon = target.rfind(':');
+            opts.host = target.substr(0, colon);
+            if (colon != std::string::npos) opts.port = atoi(target.c_str() + colon + 1);
+            opts.external = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // fork() - до першого потоку в цьому процесі
+    std::string nvs;
+    pid_t child = 0;
+    if (!opts.external) {
+        char dir[] = "/tmp/gyverdrink-load-XXXXXX";
+        if (!mkdtemp(dir)) {
+            perror("mkdtemp");
+            return 1;
+        }
+        nvs = dir;
+        child = startFirmware(nvs);
+        if (child < 0) {
+            perror("fork");
+            return 1;
+        }
+    }
+
+    DeviceReport dev = {};
+    dev.exitStatus = -1;
+    std::string metrics;
+
+    if (!waitForDevice(child) || !fetchMetrics(metrics)) {
+        fprintf(stderr, "Device at %s:%u not reachable\n", opts.host.c_str(), opts.port);
+        if (child > 0) kill(child, SIGKILL);
+        return 1;
+    }
+    dev.heapStart = metricValue(metrics, "gyverdrink_heap_bytes{kind=\"free\"}");
+
+    uint64_t startNs = loadNowNs();
+    uint64_t deadlineNs = startNs + (uint64_t)opts.durationS * 1000000000ull;
+
+    std::vector<std::thread> clients;
+    for (uint32_t i = 0; i < opts.wsClients; i++) {
+        clients.emplace_back(wsClient, i, deadlineNs);
+        loadSleepMs(10);    // Гості відкривають сторінку майже одночасно
+    }
+    for (uint32_t i = 0; i < opts.httpClients; i++) {
+        clients.emplace_back(httpClient, i, deadlineNs);
+    }
+    for (std::thread &t : clients) t.join();
+    double seconds = (loadNowNs() - startNs) / 1e9;
+
+    int status;
+    if (child > 0 && waitpid(child, &status, WNOHANG) == child) {
+        dev.exitStatus = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    } else if (fetchMetrics(metrics)) {
+        dev.heapMin = metricValue(metrics, "gyverdrink_heap_bytes{kind=\"min_free\"}");
+        dev.wsSent = metricValue(metrics, "gyverdrink_ws_frames_total{result=\"sent\"}");
+        dev.wsSuperseded = metricValue(metrics, "gyverdrink_ws_frames_total{result=\"superseded\"}");
+        dev.wsDropped = metricValue(metrics, "gyverdrink_ws_frames_total{result=\"dropped\"}");
+        dev.settersReceived = metricValue(metrics, "gyverdrink_setter_commands_total{result=\"received\"}");
+        dev.settersApplied = metricValue(metrics, "gyverdrink_setter_commands_total{result=\"applied\"}");
+    }
+
+    if (child > 0) {
+        kill(child, SIGKILL);
+        waitpid(child, NULL, 0);
+        std::filesystem::remove_all(nvs);
+    }
+
+    printJson(dev, seconds);
+    printTable(dev, seconds);
+    // Ненульовий код - прошивка впала або клієнти не дістали з'єднання
+    return dev.exitStatus >= 0 || stats.wsFailures + stats.wsClosed > 0 ? 2 : 0;
+}
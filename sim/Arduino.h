@@ -0,0 +1,162 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// Мінімальне Arduino-ESP32 API для native симулятора.
+// Реалізація: sim/sim_core.cpp, sim/sim_freertos.cpp
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "Printable.h"
+#include "IPAddress.h"
+#include "freertos_sim.h"
+
+using std::min;
+using std::max;
+
+// newlib на ESP32 має strlcpy, glibc - тільки з 2.38
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = 0;
+    }
+    return len;
+}
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT          0x01
+#define OUTPUT         0x03
+#define PULLUP         0x04
+#define INPUT_PULLUP   0x05
+#define PULLDOWN       0x08
+#define INPUT_PULLDOWN 0x09
+
+#define RISING    0x01
+#define FALLING   0x02
+#define CHANGE    0x03
+#define ONLOW     0x04
+#define ONHIGH    0x05
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+
+#define digitalPinToInterrupt(p) (p)
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+// ---- Час ----
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// ---- GPIO ----
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+// ---- LEDC PWM ----
+uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolution_bits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcDetachPin(uint8_t pin);
+void ledcWrite(uint8_t channel, uint32_t duty);
+uint32_t ledcRead(uint8_t channel);
+
+// ---- Апаратний таймер ----
+// ISR викликається з окремого потоку. З ручним годинником таймер не працює
+typedef struct SimHwTimer hw_timer_t;
+
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerEnd(hw_timer_t* timer);
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(void), bool edge);
+void timerDetachInterrupt(hw_timer_t* timer);
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoreload);
+void timerAlarmEnable(hw_timer_t* timer);
+void timerAlarmDisable(hw_timer_t* timer);
+
+// ---- Random ----
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+// ---- Serial (stdin/stdout) ----
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    using Print::write;
+    int availableForWrite() override { return 128; }
+    void flush() override;
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// ---- ESP ----
+class EspClass {
+public:
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getHeapSize();
+    uint32_t getMaxAllocHeap();
+    uint32_t getPsramSize() { return 0; }
+    const char* getChipModel() { return "ESP32-SIM"; }
+    uint8_t getChipRevision() { return 0; }
+    uint8_t getChipCores() { return 2; }
+    uint32_t getCpuFreqMHz();
+    uint32_t getCycleCount();
+    uint64_t getEfuseMac();
+    const char* getSdkVersion() { return "native-sim"; }
+    uint32_t getFlashChipSize() { return 4 * 1024 * 1024; }
+    void restart();
+};
+
+extern EspClass ESP;
+
+void esp_restart();
+int64_t esp_timer_get_time();
+
+// Частота CPU: 240/160/80 МГц (такти getCycleCount() рахуються від неї)
+bool setCpuFrequencyMhz(uint32_t mhz);
+uint32_t getCpuFrequencyMhz();
+uint32_t esp_random();
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,8 @@
+#ifndef SIM_ASYNCTCP_H
+#define SIM_ASYNCTCP_H
+
+// TCP-транспорт симулятора реалізовано в sim_webserver.cpp
+
+#include "Arduino.h"
+
+#endif // SIM_ASYNCTCP_H
@@ -0,0 +1,52 @@
+#ifndef SIM_ASYNCUDP_H
+#define SIM_ASYNCUDP_H
+
+// AsyncUDP для native симулятора: справжній UDP сокет, прийом у власному потоці
+// (як задача async_udp на ESP32). Multicast ходить через loopback -
+// кілька екземплярів на одному хості бачать один одного
+
+#include "Arduino.h"
+#include <atomic>
+#include <functional>
+#include <thread>
+
+class AsyncUDPPacket {
+public:
+    AsyncUDPPacket(const uint8_t* data, size_t len, IPAddress remoteIP, uint16_t remotePort)
+        : _data(data), _len(len), _remoteIP(remoteIP), _remotePort(remotePort) {}
+
+    const uint8_t* data() const { return _data; }
+    size_t length() const { return _len; }
+    IPAddress remoteIP() const { return _remoteIP; }
+    uint16_t remotePort() const { return _remotePort; }
+
+private:
+    const uint8_t* _data;
+    size_t _len;
+    IPAddress _remoteIP;
+    uint16_t _remotePort;
+};
+
+typedef std::function<void(AsyncUDPPacket& packet)> AuPacketHandlerFunction;
+
+class AsyncUDP {
+public:
+    AsyncUDP() {}
+    ~AsyncUDP() { close(); }
+
+    bool listenMulticast(const IPAddress addr, uint16_t port, uint8_t ttl = 1);
+    void onPacket(AuPacketHandlerFunction cb) { _handler = cb; }
+    size_t writeTo(const uint8_t* data, size_t len, const IPAddress addr, uint16_t port);
+    void close();
+    bool connected() const { return _fd >= 0; }
+
+private:
+    void receiveLoop();
+
+    int _fd = -1;
+    std::atomic<bool> _running{false};
+    std::thread _thread;
+    AuPacketHandlerFunction _handler;
+};
+
+#endif // SIM_ASYNCUDP_H
@@ -0,0 +1,27 @@
+#ifndef SIM_ESP32SERVO_H
+#define SIM_ESP32SERVO_H
+
+// Серво для native симулятора: кут запам'ятовується, читається через sim::servoAngle()
+
+#include "Arduino.h"
+
+class Servo {
+public:
+    int attach(int pin, int minUs = 544, int maxUs = 2400);
+    void detach();
+    bool attached() const { return _pin >= 0; }
+    void write(int value);
+    void writeMicroseconds(int us);
+    int read() const { return _angle; }
+    int readMicroseconds() const;
+    void setPeriodHertz(int hz) { _hz = hz; }
+
+private:
+    int _pin = -1;
+    int _minUs = 544;
+    int _maxUs = 2400;
+    int _angle = 0;
+    int _hz = 50;
+};
+
+#endif // SIM_ESP32SERVO_H
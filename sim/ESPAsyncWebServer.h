@@ -0,0 +1,492 @@
+#ifndef SIM_ESPASYNCWEBSERVER_H
+#define SIM_ESPASYNCWEBSERVER_H
+
+// ESPAsyncWebServer для native симулятора: HTTP/1.1, WebSocket і SSE
+// на POSIX-сокетах localhost. Усі колбеки прошивки виконуються під одним
+// глобальним м'ютексом - як у справжньому AsyncTCP, де вони йдуть з однієї задачі.
+
+#include "Arduino.h"
+#include "AsyncTCP.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifndef WS_MAX_QUEUED_MESSAGES
+#define WS_MAX_QUEUED_MESSAGES 32
+#endif
+#ifndef DEFAULT_MAX_WS_CLIENTS
+#define DEFAULT_MAX_WS_CLIENTS 8
+#endif
+#ifndef SSE_MAX_QUEUED_MESSAGES
+#define SSE_MAX_QUEUED_MESSAGES 32
+#endif
+
+typedef enum {
+    HTTP_GET     = 0b00000001,
+    HTTP_POST    = 0b00000010,
+    HTTP_DELETE  = 0b00000100,
+    HTTP_PUT     = 0b00001000,
+    HTTP_PATCH   = 0b00010000,
+    HTTP_HEAD    = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY     = 0b01111111,
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+class AsyncWebSocket;
+class AsyncWebSocketClient;
+class AsyncEventSource;
+class AsyncEventSourceClient;
+
+// Глобальний "контекст AsyncTCP"
+std::recursive_mutex& simAsyncLock();
+
+// ========================================
+// ПАРАМЕТРИ ТА ЗАГОЛОВКИ
+// ========================================
+
+class AsyncWebParameter {
+public:
+    AsyncWebParameter(const String& name, const String& value, bool form = false, bool file = false, size_t size = 0)
+        : _name(name), _value(value), _size(size), _isForm(form), _isFile(file) {}
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+    size_t size() const { return _size; }
+    bool isPost() const { return _isForm; }
+    bool isFile() const { return _isFile; }
+
+private:
+    String _name, _value;
+    size_t _size;
+    bool _isForm, _isFile;
+};
+
+class AsyncWebHeader {
+public:
+    AsyncWebHeader(const String& name, const String& value) : _name(name), _value(value) {}
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+
+private:
+    String _name, _value;
+};
+
+class AsyncClient {
+public:
+    IPAddress remoteIP() const { return _ip; }
+    uint16_t remotePort() const { return _port; }
+    IPAddress _ip;
+    uint16_t _port = 0;
+};
+
+// ========================================
+// ВІДПОВІДІ
+// ========================================
+
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+class AsyncWebServerResponse {
+public:
+    AsyncWebServerResponse(int code = 200, const String& contentType = String())
+        : _code(code), _contentType(contentType) {}
+    virtual ~AsyncWebServerResponse() {}
+
+    void setCode(int code) { _code = code; }
+    void setContentType(const String& type) { _contentType = type; }
+    void setContentLength(size_t len) { (void)len; }
+    void addHeader(const String& name, const String& value) { _headers.emplace_back(name, value); }
+    int code() const { return _code; }
+
+    // Симулятор: записати відповідь у сокет
+    virtual bool simWrite(int fd);
+
+protected:
+    bool simWriteHead(int fd, long contentLength);
+
+    int _code;
+    String _contentType;
+    std::vector<AsyncWebHeader> _headers;
+    std::string _body;
+    friend class AsyncWebServerRequest;
+    friend class AsyncWebServer;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+public:
+    AsyncResponseStream(const String& contentType, size_t bufferSize)
+        : AsyncWebServerResponse(200, contentType) { _body.reserve(bufferSize); }
+    size_t write(uint8_t c) override { _body.push_back((char)c); return 1; }
+    size_t write(const uint8_t* data, size_t len) override { _body.append((const char*)data, len); return len; }
+    using Print::write;
+};
+
+class AsyncChunkedResponse : public AsyncWebServerResponse {
+public:
+    AsyncChunkedResponse(const String& contentType, AwsResponseFiller filler)
+        : AsyncWebServerResponse(200, contentType), _filler(filler) {}
+    bool simWrite(int fd) override;
+
+private:
+    AwsResponseFiller _filler;
+};
+
+// ========================================
+// ЗАПИТ
+// ========================================
+
+class AsyncWebServerRequest {
+public:
+    WebRequestMethodComposite method() const { return _method; }
+    const char* methodToString() const;
+    const String& url() const { return _url; }
+    const String& host() const { return _host; }
+    const String& contentType() const { return _contentType; }
+    size_t contentLength() const { return _contentLength; }
+    AsyncClient* client() { return &_client; }
+
+    size_t params() const { return _params.size(); }
+    AsyncWebParameter* getParam(size_t index) const;
+    bool hasParam(const String& name, bool post = false, bool file = false) const;
+    AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) const;
+    bool hasArg(const char* name) const;
+    const String& arg(const String& name) const;
+
+    size_t headers() const { return _headers.size(); }
+    bool hasHeader(const String& name) const;
+    AsyncWebHeader* getHeader(const String& name) const;
+    const String& header(const char* name) const;
+
+    void send(int code, const String& contentType = String(), const String& content = String());
+    void send_P(int code, const String& contentType, const char* content);
+    void send(AsyncWebServerResponse* response);
+    void redirect(const String& url);
+
+    AsyncWebServerResponse* beginResponse(int code, const String& contentType = String(), const String& content = String());
+    AsyncResponseStream* beginResponseStream(const String& contentType, size_t bufferSize = 1460);
+    AsyncWebServerResponse* beginChunkedResponse(const String& contentType, AwsResponseFiller callback);
+
+    void onDisconnect(std::function<void()> fn) { _onDisconnect = fn; }
+
+    // Лише Basic: Digest симулятор не перевіряє
+    bool authenticate(const char* username, const char* password, const char* realm = NULL, bool passwordIsHash = false) const;
+    void requestAuthentication(const char* realm = NULL, bool isDigest = true);
+
+    void* _tempObject = nullptr;
+
+    // ---- Симулятор ----
+    ~AsyncWebServerRequest();
+    bool simParse(const std::string& head);
+    void simParseForm(const std::string& body, bool post);
+    std::unique_ptr<AsyncWebServerResponse> _response;
+    std::function<void()> _onDisconnect;
+    std::string _body;
+
+private:
+    WebRequestMethodComposite _method = HTTP_GET;
+    String _url, _host, _contentType;
+    size_t _contentLength = 0;
+    AsyncClient _client;
+    std::vector<std::unique_ptr<AsyncWebParameter>> _params;
+    std::vector<std::unique_ptr<AsyncWebHeader>> _headers;
+    friend class AsyncWebServer;
+};
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename, size_t index,
+                           uint8_t* data, size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                           size_t index, size_t total)> ArBodyHandlerFunction;
+
+// ========================================
+// ОБРОБНИКИ
+// ========================================
+
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() {}
+    virtual bool canHandle(AsyncWebServerRequest* request) { (void)request; return false; }
+    virtual void handleRequest(AsyncWebServerRequest* request) { (void)request; }
+    virtual void handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index,
+                              uint8_t* data, size_t len, bool final) {
+        (void)request; (void)filename; (void)index; (void)data; (void)len; (void)final;
+    }
+    virtual void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+        (void)request; (void)data; (void)len; (void)index; (void)total;
+    }
+
+    // Симулятор: забрати сокет собі (WebSocket, SSE). true - сокет більше не закривати
+    virtual bool simTakeConnection(AsyncWebServerRequest* request, int fd) { (void)request; (void)fd; return false; }
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+public:
+    AsyncCallbackWebHandler(const String& uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                            ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody)
+        : _uri(uri), _method(method), _onRequest(onRequest), _onUpload(onUpload), _onBody(onBody) {}
+
+    bool canHandle(AsyncWebServerRequest* request) override;
+    void handleRequest(AsyncWebServerRequest* request) override;
+    void handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index,
+                      uint8_t* data, size_t len, bool final) override;
+    void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) override;
+
+private:
+    String _uri;
+    WebRequestMethodComposite _method;
+    ArRequestHandlerFunction _onRequest;
+    ArUploadHandlerFunction _onUpload;
+    ArBodyHandlerFunction _onBody;
+};
+
+// ========================================
+// WEBSOCKET
+// ========================================
+
+typedef enum { WS_CONTINUATION, WS_TEXT, WS_BINARY, WS_DISCONNECT = 0x08, WS_PING, WS_PONG } AwsFrameType;
+typedef enum { WS_DISCONNECTED, WS_CONNECTED, WS_DISCONNECTING } AwsClientStatus;
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+
+typedef struct {
+    uint8_t message_opcode;
+    uint32_t num;
+    uint8_t final;
+    uint8_t masked;
+    uint8_t opcode;
+    uint64_t len;
+    uint8_t mask[4];
+    uint64_t index;
+} AwsFrameInfo;
+
+typedef std::function<void(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type,
+                           void* arg, uint8_t* data, size_t len)> AwsEventHandler;
+
+// Спільний буфер повідомлення: один блок на всіх клієнтів, count() - кадри з ним у чергах
+class AsyncWebSocketMessageBuffer {
+public:
+    AsyncWebSocketMessageBuffer() {}
+    explicit AsyncWebSocketMessageBuffer(size_t size) { reserve(size); }
+    AsyncWebSocketMessageBuffer(uint8_t* data, size_t size) {
+        reserve(size);
+        if (data && size) memcpy(_data.data(), data, size);
+    }
+
+    // +1 байт під '\0', як у бібліотеці
+    bool reserve(size_t size) {
+        _data.assign(size + 1, 0);
+        _len = size;
+        return true;
+    }
+    uint8_t* get() { return _data.data(); }
+    size_t length() const { return _len; }
+    uint32_t count() const { return _count; }
+    bool canDelete() const { return _count == 0 && !_lock; }
+    void lock() { _lock = true; }
+    void unlock() { _lock = false; }
+    void operator++(int) { _count++; }
+    void operator--(int) { if (_count > 0) _count--; }
+
+private:
+    std::vector<uint8_t> _data;
+    size_t _len = 0;
+    std::atomic<uint32_t> _count{0};
+    std::atomic<bool> _lock{false};
+};
+
+class AsyncWebSocketClient {
+public:
+    AsyncWebSocketClient(AsyncWebSocket* server, int fd, uint32_t id, IPAddress ip);
+    ~AsyncWebSocketClient();
+
+    uint32_t id() const { return _id; }
+    AwsClientStatus status() const { return _status; }
+    IPAddress remoteIP() const { return _ip; }
+    uint16_t remotePort() const { return 0; }
+    AsyncWebSocket* server() { return _server; }
+
+    void text(const char* message, size_t len);
+    void text(const char* message) { text(message, strlen(message)); }
+    void text(const String& message) { text(message.c_str(), message.length()); }
+    void text(AsyncWebSocketMessageBuffer* buffer);
+    void binary(const uint8_t* data, size_t len);
+    void ping(const uint8_t* data = NULL, size_t len = 0);
+    void close(uint16_t code = 0, const char* message = NULL);
+
+    size_t queueLen();
+    bool queueIsFull();
+    bool canSend() { return !queueIsFull(); }
+
+    // ---- Симулятор ----
+    void simRun();
+
+private:
+    struct Message {
+        uint8_t opcode;
+        std::string data;
+        AsyncWebSocketMessageBuffer* shared;    // Замість data, якщо не NULL
+    };
+
+    void enqueue(uint8_t opcode, const uint8_t* data, size_t len, AsyncWebSocketMessageBuffer* shared = NULL);
+    void releaseQueue();
+    void writerLoop();
+    bool sendFrame(uint8_t opcode, const uint8_t* data, size_t len);
+
+    AsyncWebSocket* _server;
+    int _fd;
+    uint32_t _id;
+    IPAddress _ip;
+    std::atomic<AwsClientStatus> _status;
+    std::mutex _queueLock;
+    std::condition_variable _queueChanged;
+    std::deque<Message> _queue;
+    std::mutex _sendLock;
+};
+
+class AsyncWebSocket : public AsyncWebHandler {
+public:
+    explicit AsyncWebSocket(const String& url) : _url(url) {}
+
+    void onEvent(AwsEventHandler handler) { _handler = handler; }
+    void enable(bool e) { _enabled = e; }
+    bool enabled() const { return _enabled; }
+    const char* url() const { return _url.c_str(); }
+
+    size_t count();
+    AsyncWebSocketClient* client(uint32_t id);
+    bool hasClient(uint32_t id) { return client(id) != NULL; }
+    void cleanupClients(uint16_t maxClients = DEFAULT_MAX_WS_CLIENTS);
+    void closeAll(uint16_t code = 0, const char* message = NULL);
+
+    void text(uint32_t id, const char* message, size_t len);
+    void text(uint32_t id, const String& message) { text(id, message.c_str(), message.length()); }
+    void textAll(const char* message, size_t len);
+    void textAll(const char* message) { textAll(message, strlen(message)); }
+    void textAll(const String& message) { textAll(message.c_str(), message.length()); }
+    void textAll(AsyncWebSocketMessageBuffer* buffer);
+    bool availableForWriteAll();
+
+    // Буфер належить серверу: видаляється після textAll(buffer), коли більше не в черзі
+    AsyncWebSocketMessageBuffer* makeBuffer(size_t size = 0);
+    AsyncWebSocketMessageBuffer* makeBuffer(uint8_t* data, size_t size);
+
+    bool canHandle(AsyncWebServerRequest* request) override;
+    bool simTakeConnection(AsyncWebServerRequest* request, int fd) override;
+
+    // ---- Симулятор ----
+    void simEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
+    void simRemove(AsyncWebSocketClient* client);
+
+private:
+    String _url;
+    bool _enabled = true;
+    AwsEventHandler _handler;
+    std::mutex _clientsLock;
+    std::list<std::shared_ptr<AsyncWebSocketClient>> _clients;
+    std::list<AsyncWebSocketMessageBuffer*> _buffers;
+    std::atomic<uint32_t> _nextId{1};
+
+    void cleanBuffers();
+};
+
+// ========================================
+// SERVER-SENT EVENTS
+// ========================================
+
+typedef std::function<void(AsyncEventSourceClient* client)> ArEventHandlerFunction;
+
+class AsyncEventSourceClient {
+public:
+    AsyncEventSourceClient(AsyncEventSource* server, int fd, uint32_t lastId);
+    ~AsyncEventSourceClient();
+
+    void send(const char* message, const char* event = NULL, uint32_t id = 0, uint32_t reconnect = 0);
+    void close();
+    bool connected() const { return _connected; }
+    uint32_t lastId() const { return _lastId; }
+    size_t packetsWaiting();
+
+    // ---- Симулятор ----
+    void simRun();
+
+private:
+    void write(const std::string& data);
+
+    AsyncEventSource* _server;
+    int _fd;
+    uint32_t _lastId;
+    std::atomic<bool> _connected{true};
+    std::mutex _queueLock;
+    std::condition_variable _queueChanged;
+    std::deque<std::string> _queue;
+};
+
+class AsyncEventSource : public AsyncWebHandler {
+public:
+    explicit AsyncEventSource(const String& url) : _url(url) {}
+
+    const char* url() const { return _url.c_str(); }
+    void onConnect(ArEventHandlerFunction cb) { _connectCb = cb; }
+    void close();
+    void send(const char* message, const char* event = NULL, uint32_t id = 0, uint32_t reconnect = 0);
+    size_t count();
+    size_t avgPacketsWaiting();
+
+    bool canHandle(AsyncWebServerRequest* request) override;
+    bool simTakeConnection(AsyncWebServerRequest* request, int fd) override;
+
+    // ---- Симулятор ----
+    void simRemove(AsyncEventSourceClient* client);
+
+private:
+    String _url;
+    ArEventHandlerFunction _connectCb;
+    std::mutex _clientsLock;
+    std::list<std::shared_ptr<AsyncEventSourceClient>> _clients;
+};
+
+// ========================================
+// СЕРВЕР
+// ========================================
+
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t port) : _port(port) {}
+    ~AsyncWebServer();
+
+    void begin();
+    void end();
+
+    AsyncCallbackWebHandler& on(const char* uri, ArRequestHandlerFunction onRequest);
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                ArUploadHandlerFunction onUpload);
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody);
+
+    AsyncWebHandler& addHandler(AsyncWebHandler* handler);
+    void onNotFound(ArRequestHandlerFunction fn) { _notFound = fn; }
+    void onRequestBody(ArBodyHandlerFunction fn) { _onBody = fn; }
+
+private:
+    void acceptLoop();
+    void handleConnection(int fd, IPAddress ip, uint16_t port);
+
+    uint16_t _port;
+    int _listenFd = -1;
+    std::atomic<bool> _running{false};
+    std::vector<AsyncWebHandler*> _handlers;
+    std::vector<std::unique_ptr<AsyncCallbackWebHandler>> _ownedHandlers;
+    ArRequestHandlerFunction _notFound;
+    ArBodyHandlerFunction _onBody;
+};
+
+#endif // SIM_ESPASYNCWEBSERVER_H
@@ -0,0 +1,28 @@
+#ifndef SIM_ESPMDNS_H
+#define SIM_ESPMDNS_H
+
+// mDNS для native симулятора: оголошення лише друкуються
+
+#include "Arduino.h"
+
+class MDNSResponder {
+public:
+    bool begin(const char* hostName) {
+        printf("[sim] mDNS: %s.local\n", hostName);
+        return true;
+    }
+    void end() {}
+    void setInstanceName(const char* name) { (void)name; }
+    bool addService(const char* service, const char* proto, uint16_t port) {
+        printf("[sim] mDNS service _%s._%s port %u\n", service, proto, port);
+        return true;
+    }
+    bool addServiceTxt(const char* service, const char* proto, const char* key, const char* value) {
+        (void)service; (void)proto; (void)key; (void)value;
+        return true;
+    }
+};
+
+extern MDNSResponder MDNS;
+
+#endif // SIM_ESPMDNS_H
@@ -0,0 +1,94 @@
+#ifndef SIM_FASTLED_H
+#define SIM_FASTLED_H
+
+// Підмножина FastLED для native симулятора: кольори, хвилі, буфер без виводу
+
+#include "Arduino.h"
+
+struct CHSV {
+    uint8_t h, s, v;
+    CHSV() : h(0), s(0), v(0) {}
+    CHSV(uint8_t hue, uint8_t sat, uint8_t val) : h(hue), s(sat), v(val) {}
+};
+
+struct CRGB {
+    uint8_t r, g, b;
+
+    enum HTMLColorCode {
+        Black = 0x000000,
+        White = 0xFFFFFF,
+        Red = 0xFF0000,
+        Green = 0x008000,
+        Blue = 0x0000FF,
+        Yellow = 0xFFFF00,
+        Orange = 0xFFA500,
+    };
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+    CRGB(uint32_t code) : r((code >> 16) & 0xFF), g((code >> 8) & 0xFF), b(code & 0xFF) {}
+    CRGB(HTMLColorCode code) : CRGB((uint32_t)code) {}
+    CRGB(const CHSV& hsv);
+    CRGB& operator=(const CHSV& hsv);
+    bool operator==(const CRGB& o) const { return r == o.r && g == o.g && b == o.b; }
+    bool operator!=(const CRGB& o) const { return !(*this == o); }
+};
+
+// Типи стрічок / порядок кольорів - лише для сумісності шаблону addLeds
+struct WS2812B {};
+struct WS2812 {};
+struct NEOPIXEL {};
+enum EOrder { RGB = 0012, RBG = 0021, GRB = 0102, GBR = 0120, BRG = 0201, BGR = 0210 };
+
+inline uint8_t scale8(uint8_t i, uint8_t scale) {
+    return ((uint16_t)i * (1 + (uint16_t)scale)) >> 8;
+}
+
+inline uint8_t qadd8(uint8_t a, uint8_t b) {
+    unsigned t = a + b;
+    return t > 255 ? 255 : t;
+}
+
+inline uint8_t qsub8(uint8_t a, uint8_t b) {
+    return a > b ? a - b : 0;
+}
+
+void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb);
+void fill_solid(CRGB* leds, int count, const CRGB& color);
+void fill_solid(CRGB* leds, int count, const CHSV& color);
+uint8_t sin8(uint8_t theta);
+uint8_t cubicwave8(uint8_t in);
+uint16_t beat16(uint16_t bpm, uint32_t timebase = 0);
+uint8_t beat8(uint16_t bpm, uint32_t timebase = 0);
+uint8_t beatsin8(uint16_t bpm, uint8_t lowest = 0, uint8_t highest = 255,
+                 uint32_t timebase = 0, uint8_t phase = 0);
+
+class CFastLED {
+public:
+    template <typename CHIPSET, uint8_t PIN, EOrder ORDER>
+    CFastLED& addLeds(CRGB* leds, int count) {
+        _leds = leds;
+        _count = count;
+        return *this;
+    }
+
+    void setBrightness(uint8_t brightness) { _brightness = brightness; }
+    uint8_t getBrightness() const { return _brightness; }
+    void show();
+    void clear(bool write = false);
+
+    // Симулятор: буфер останнього show() та лічильник кадрів
+    const CRGB* leds() const { return _leds; }
+    int size() const { return _count; }
+    uint32_t shows() const { return _shows; }
+
+private:
+    CRGB* _leds = nullptr;
+    int _count = 0;
+    uint8_t _brightness = 255;
+    uint32_t _shows = 0;
+};
+
+extern CFastLED FastLED;
+
+#endif // SIM_FASTLED_H
@@ -0,0 +1,41 @@
+#ifndef SIM_IPADDRESS_H
+#define SIM_IPADDRESS_H
+
+#include "Print.h"
+
+class IPAddress : public Printable {
+public:
+    IPAddress() : _addr{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _addr{a, b, c, d} {}
+    explicit IPAddress(uint32_t raw) {
+        for (int i = 0; i < 4; i++) _addr[i] = (raw >> (8 * i)) & 0xFF;
+    }
+
+    operator uint32_t() const {
+        return _addr[0] | (_addr[1] << 8) | (_addr[2] << 16) | ((uint32_t)_addr[3] << 24);
+    }
+    uint8_t operator[](int i) const { return _addr[i]; }
+    uint8_t& operator[](int i) { return _addr[i]; }
+    bool operator==(const IPAddress& o) const { return (uint32_t)*this == (uint32_t)o; }
+    bool operator!=(const IPAddress& o) const { return !(*this == o); }
+
+    bool fromString(const char* s) {
+        unsigned a, b, c, d;
+        if (sscanf(s, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) return false;
+        _addr[0] = a; _addr[1] = b; _addr[2] = c; _addr[3] = d;
+        return true;
+    }
+
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _addr[0], _addr[1], _addr[2], _addr[3]);
+        return String(buf);
+    }
+
+    size_t printTo(Print& p) const override { return p.print(toString()); }
+
+private:
+    uint8_t _addr[4];
+};
+
+#endif // SIM_IPADDRESS_H
@@ -0,0 +1,73 @@
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+// NVS Preferences з файловим сховищем: <nvsDir>/<namespace>.nvs
+// Кожен put* одразу записує файл (як commit у NVS)
+
+#include "Arduino.h"
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partition = NULL);
+    void end();
+
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putChar(const char* key, int8_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putUChar(const char* key, uint8_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putShort(const char* key, int16_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putUShort(const char* key, uint16_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putInt(const char* key, int32_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putUInt(const char* key, uint32_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putLong(const char* key, int32_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putULong(const char* key, uint32_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putFloat(const char* key, float value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putBool(const char* key, bool value) { uint8_t v = value; return putRaw(key, &v, 1); }
+    size_t putString(const char* key, const char* value) { return putRaw(key, value, strlen(value)); }
+    size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+    size_t putBytes(const char* key, const void* value, size_t len) { return putRaw(key, value, len); }
+
+    int8_t getChar(const char* key, int8_t def = 0) { return getScalar(key, def); }
+    uint8_t getUChar(const char* key, uint8_t def = 0) { return getScalar(key, def); }
+    int16_t getShort(const char* key, int16_t def = 0) { return getScalar(key, def); }
+    uint16_t getUShort(const char* key, uint16_t def = 0) { return getScalar(key, def); }
+    int32_t getInt(const char* key, int32_t def = 0) { return getScalar(key, def); }
+    uint32_t getUInt(const char* key, uint32_t def = 0) { return getScalar(key, def); }
+    int32_t getLong(const char* key, int32_t def = 0) { return getScalar(key, def); }
+    uint32_t getULong(const char* key, uint32_t def = 0) { return getScalar(key, def); }
+    float getFloat(const char* key, float def = NAN) { return getScalar(key, def); }
+    bool getBool(const char* key, bool def = false) { return getScalar<uint8_t>(key, def) != 0; }
+    String getString(const char* key, const String& def = String());
+    size_t getString(const char* key, char* value, size_t maxLen);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+    size_t freeEntries();
+
+private:
+    size_t putRaw(const char* key, const void* value, size_t len);
+    bool findRaw(const char* key, std::vector<uint8_t>& out);
+    void load();
+    bool store();
+
+    template <typename T> T getScalar(const char* key, T def) {
+        std::vector<uint8_t> v;
+        if (!findRaw(key, v) || v.size() != sizeof(T)) return def;
+        T out;
+        memcpy(&out, v.data(), sizeof(T));
+        return out;
+    }
+
+    bool _started = false;
+    bool _readOnly = false;
+    std::string _path;
+    // Спільний для всіх об'єктів з тим самим namespace (як і справжній NVS)
+    std::map<std::string, std::vector<uint8_t>>* _entries = nullptr;
+};
+
+#endif // SIM_PREFERENCES_H
@@ -0,0 +1,75 @@
+#ifndef SIM_PRINT_H
+#define SIM_PRINT_H
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstddef>
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buf++);
+        return n;
+    }
+    size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+    size_t write(const char* buf, size_t size) { return write((const uint8_t*)buf, size); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char local[128];
+        va_list args;
+        va_start(args, fmt);
+        va_list copy;
+        va_copy(copy, args);
+        int len = vsnprintf(local, sizeof(local), fmt, copy);
+        va_end(copy);
+        if (len < 0) { va_end(args); return 0; }
+        size_t n;
+        if ((size_t)len < sizeof(local)) {
+            n = write((const uint8_t*)local, len);
+        } else {
+            std::string big(len + 1, 0);
+            vsnprintf(&big[0], len + 1, fmt, args);
+            n = write((const uint8_t*)big.data(), len);
+        }
+        va_end(args);
+        return n;
+    }
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char v, int base = DEC) { return print(String(v, base)); }
+    size_t print(int v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned int v, int base = DEC) { return print(String(v, base)); }
+    size_t print(long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(long long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned long long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(double v, int digits = 2) { return print(String(v, (unsigned)digits)); }
+    size_t print(const Printable& p) { return p.printTo(*this); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(const T& v, int base) { size_t n = print(v, base); return n + println(); }
+};
+
+#endif // SIM_PRINT_H
@@ -0,0 +1,7 @@
+#ifndef SIM_PRINTABLE_H
+#define SIM_PRINTABLE_H
+
+// Printable оголошено в Print.h (як і в ядрі ESP32)
+#include "Print.h"
+
+#endif // SIM_PRINTABLE_H
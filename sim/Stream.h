@@ -0,0 +1,38 @@
+#ifndef SIM_STREAM_H
+#define SIM_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    unsigned long getTimeout() const { return _timeout; }
+
+    size_t readBytes(char* buffer, size_t length) {
+        size_t n = 0;
+        while (n < length) {
+            int c = timedRead();
+            if (c < 0) break;
+            buffer[n++] = (char)c;
+        }
+        return n;
+    }
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+
+    String readStringUntil(char terminator) {
+        String s;
+        int c;
+        while ((c = timedRead()) >= 0 && c != terminator) s += (char)c;
+        return s;
+    }
+
+protected:
+    int timedRead();
+    unsigned long _timeout = 1000;
+};
+
+#endif // SIM_STREAM_H
@@ -0,0 +1,88 @@
+#ifndef SIM_TFT_ESPI_H
+#define SIM_TFT_ESPI_H
+
+// TFT_eSPI з кадровим буфером у RAM (native симулятор)
+
+#include "Arduino.h"
+#include <vector>
+
+#ifndef TFT_WIDTH
+#define TFT_WIDTH  240
+#endif
+#ifndef TFT_HEIGHT
+#define TFT_HEIGHT 320
+#endif
+#ifndef TFT_BL
+#define TFT_BL     4
+#endif
+
+#define TFT_BLACK       0x0000
+#define TFT_NAVY        0x000F
+#define TFT_BLUE        0x001F
+#define TFT_GREEN       0x07E0
+#define TFT_CYAN        0x07FF
+#define TFT_RED         0xF800
+#define TFT_MAGENTA     0xF81F
+#define TFT_YELLOW      0xFFE0
+#define TFT_ORANGE      0xFDA0
+#define TFT_WHITE       0xFFFF
+#define TFT_DARKGREY    0x7BEF
+
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define MC_DATUM 4
+
+class TFT_eSPI : public Print {
+public:
+    TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+
+    void init(uint8_t tc = 0);
+    void begin(uint8_t tc = 0) { init(tc); }
+    void setRotation(uint8_t r);
+    uint8_t getRotation() const { return _rotation; }
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+    void fillScreen(uint32_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawPixel(int32_t x, int32_t y, uint32_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+    void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+
+    void setTextColor(uint16_t color) { _textColor = color; }
+    void setTextColor(uint16_t fg, uint16_t bg) { _textColor = fg; _textBg = bg; }
+    void setTextSize(uint8_t size) { _textSize = size ? size : 1; }
+    void setTextDatum(uint8_t datum) { _datum = datum; }
+    void setCursor(int16_t x, int16_t y) { _cursorX = x; _cursorY = y; }
+    int16_t getCursorX() const { return _cursorX; }
+    int16_t getCursorY() const { return _cursorY; }
+    int16_t textWidth(const char* s);
+    int16_t fontHeight() const { return 8 * _textSize; }
+    int16_t drawString(const char* s, int32_t x, int32_t y);
+    int16_t drawString(const String& s, int32_t x, int32_t y) { return drawString(s.c_str(), x, y); }
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    // Симулятор: доступ до кадрового буфера
+    uint16_t readPixel(int32_t x, int32_t y) const;
+    const uint16_t* frameBuffer() const { return _fb.data(); }
+    uint64_t pixelsWritten() const { return _pixels; }
+
+private:
+    int16_t _initWidth, _initHeight;
+    int16_t _width, _height;
+    uint8_t _rotation = 0;
+    std::vector<uint16_t> _fb;
+    uint64_t _pixels = 0;
+
+    int16_t _cursorX = 0, _cursorY = 0;
+    uint16_t _textColor = TFT_WHITE, _textBg = TFT_BLACK;
+    uint8_t _textSize = 1;
+    uint8_t _datum = TL_DATUM;
+};
+
+#endif // SIM_TFT_ESPI_H
@@ -0,0 +1,151 @@
+#ifndef SIM_WSTRING_H
+#define SIM_WSTRING_H
+
+// Arduino String поверх std::string (native симулятор)
+
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+#include <algorithm>
+
+class String {
+public:
+    String() {}
+    String(const char* s) : _s(s ? s : "") {}
+    String(const char* s, size_t len) : _s(s ? std::string(s, len) : std::string()) {}
+    String(const std::string& s) : _s(s) {}
+    String(const String& s) = default;
+    String(String&& s) = default;
+    explicit String(char c) : _s(1, c) {}
+    explicit String(unsigned char v, unsigned char base = 10) { fromUnsigned(v, base); }
+    explicit String(int v, unsigned char base = 10) { fromSigned(v, base); }
+    explicit String(unsigned int v, unsigned char base = 10) { fromUnsigned(v, base); }
+    explicit String(long v, unsigned char base = 10) { fromSigned(v, base); }
+    explicit String(unsigned long v, unsigned char base = 10) { fromUnsigned(v, base); }
+    explicit String(long long v, unsigned char base = 10) { fromSigned(v, base); }
+    explicit String(unsigned long long v, unsigned char base = 10) { fromUnsigned(v, base); }
+    explicit String(float v, unsigned int decimals = 2) { fromDouble(v, decimals); }
+    explicit String(double v, unsigned int decimals = 2) { fromDouble(v, decimals); }
+
+    String& operator=(const String& s) = default;
+    String& operator=(String&& s) = default;
+    String& operator=(const char* s) { _s = s ? s : ""; return *this; }
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.length(); }
+    bool isEmpty() const { return _s.empty(); }
+    bool reserve(unsigned int size) { _s.reserve(size); return true; }
+    const std::string& str() const { return _s; }
+
+    bool concat(const String& s) { _s += s._s; return true; }
+    bool concat(const char* s) { if (s) _s += s; return true; }
+    bool concat(const char* s, unsigned int len) { if (s) _s.append(s, len); return true; }
+    bool concat(char c) { _s += c; return true; }
+    bool concat(int v) { return concat(String(v)); }
+    bool concat(unsigned int v) { return concat(String(v)); }
+    bool concat(long v) { return concat(String(v)); }
+    bool concat(unsigned long v) { return concat(String(v)); }
+    bool concat(double v) { return concat(String(v)); }
+
+    template <typename T> String& operator+=(const T& v) { concat(v); return *this; }
+
+    friend String operator+(const String& a, const String& b) { String r(a); r.concat(b); return r; }
+    friend String operator+(const String& a, const char* b) { String r(a); r.concat(b); return r; }
+    friend String operator+(const char* a, const String& b) { String r(a); r.concat(b); return r; }
+    friend String operator+(const String& a, char b) { String r(a); r.concat(b); return r; }
+    friend String operator+(const String& a, int b) { String r(a); r.concat(b); return r; }
+    friend String operator+(const String& a, unsigned int b) { String r(a); r.concat(b); return r; }
+    friend String operator+(const String& a, long b) { String r(a); r.concat(b); return r; }
+    friend String operator+(const String& a, unsigned long b) { String r(a); r.concat(b); return r; }
+
+    bool equals(const String& s) const { return _s == s._s; }
+    bool equals(const char* s) const { return _s == (s ? s : ""); }
+    bool equalsIgnoreCase(const String& s) const {
+        if (_s.size() != s._s.size()) return false;
+        for (size_t i = 0; i < _s.size(); i++) {
+            if (tolower((unsigned char)_s[i]) != tolower((unsigned char)s._s[i])) return false;
+        }
+        return true;
+    }
+    bool operator==(const String& s) const { return equals(s); }
+    bool operator==(const char* s) const { return equals(s); }
+    bool operator!=(const String& s) const { return !equals(s); }
+    bool operator!=(const char* s) const { return !equals(s); }
+    bool operator<(const String& s) const { return _s < s._s; }
+
+    char charAt(unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    char& operator[](unsigned int i) { return _s[i]; }
+
+    bool startsWith(const String& p) const { return _s.compare(0, p._s.size(), p._s) == 0; }
+    bool endsWith(const String& p) const {
+        return _s.size() >= p._s.size() && _s.compare(_s.size() - p._s.size(), p._s.size(), p._s) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return npos(_s.find(c, from)); }
+    int indexOf(const String& s, unsigned int from = 0) const { return npos(_s.find(s._s, from)); }
+    int lastIndexOf(char c) const { return npos(_s.rfind(c)); }
+
+    String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= _s.size()) return String();
+        return String(_s.substr(from, to - from));
+    }
+
+    void trim() {
+        size_t b = 0, e = _s.size();
+        while (b < e && isspace((unsigned char)_s[b])) b++;
+        while (e > b && isspace((unsigned char)_s[e - 1])) e--;
+        _s = _s.substr(b, e - b);
+    }
+    void toLowerCase() { for (auto& c : _s) c = tolower((unsigned char)c); }
+    void toUpperCase() { for (auto& c : _s) c = toupper((unsigned char)c); }
+    void replace(const String& from, const String& to) {
+        if (from._s.empty()) return;
+        size_t pos = 0;
+        while ((pos = _s.find(from._s, pos)) != std::string::npos) {
+            _s.replace(pos, from._s.size(), to._s);
+            pos += to._s.size();
+        }
+    }
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1) {
+        if (index < _s.size()) _s.erase(index, count);
+    }
+
+    long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(_s.c_str(), nullptr); }
+    double toDouble() const { return strtod(_s.c_str(), nullptr); }
+
+private:
+    static int npos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+
+    void fromSigned(long long v, unsigned char base) {
+        if (v < 0 && base == 10) { _s = "-"; fromUnsignedAppend((unsigned long long)(-v), base); }
+        else fromUnsigned((unsigned long long)v, base);
+    }
+    void fromUnsigned(unsigned long long v, unsigned char base) { _s.clear(); fromUnsignedAppend(v, base); }
+    void fromUnsignedAppend(unsigned long long v, unsigned char base) {
+        char buf[66];
+        int i = 65;
+        buf[i] = 0;
+        if (base < 2) base = 10;
+        do {
+            int d = v % base;
+            buf[--i] = d < 10 ? '0' + d : 'a' + d - 10;
+            v /= base;
+        } while (v);
+        _s += &buf[i];
+    }
+    void fromDouble(double v, unsigned int decimals) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+        _s = buf;
+    }
+
+    std::string _s;
+};
+
+#endif // SIM_WSTRING_H
@@ -0,0 +1,77 @@
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+// WiFi для native симулятора: мережа хоста вважається підключеною,
+// усі адреси - localhost
+
+#include "Arduino.h"
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+public:
+    bool mode(wifi_mode_t m) { _mode = m; return true; }
+    wifi_mode_t getMode() const { return _mode; }
+
+    bool softAPConfig(IPAddress ip, IPAddress gateway, IPAddress subnet) {
+        (void)gateway; (void)subnet;
+        _apIP = ip;
+        return true;
+    }
+    bool softAP(const char* ssid, const char* pass = NULL, int channel = 1, int hidden = 0, int maxConn = 4) {
+        (void)pass; (void)channel; (void)hidden; (void)maxConn;
+        _apSSID = ssid;
+        return true;
+    }
+    bool softAPdisconnect(bool wifiOff = false) { (void)wifiOff; return true; }
+    IPAddress softAPIP() const { return IPAddress(127, 0, 0, 1); }
+    uint8_t softAPgetStationNum() const { return 0; }
+
+    wl_status_t begin(const char* ssid, const char* pass = NULL) {
+        (void)pass;
+        _ssid = ssid ? ssid : "";
+        _status = _ssid.length() ? WL_CONNECTED : WL_NO_SSID_AVAIL;
+        return _status;
+    }
+    bool disconnect(bool wifiOff = false) { (void)wifiOff; _status = WL_DISCONNECTED; return true; }
+    bool reconnect() { return begin(_ssid.c_str()) == WL_CONNECTED; }
+    bool setAutoReconnect(bool enable) { (void)enable; return true; }
+    void persistent(bool enable) { (void)enable; }
+    bool setHostname(const char* name) { _hostname = name; return true; }
+    const char* getHostname() const { return _hostname.c_str(); }
+    bool setSleep(bool enable) { (void)enable; return true; }
+
+    wl_status_t status() const { return _status; }
+    bool isConnected() const { return _status == WL_CONNECTED; }
+    IPAddress localIP() const { return _status == WL_CONNECTED ? IPAddress(127, 0, 0, 1) : IPAddress(); }
+    String SSID() const { return _ssid; }
+    int8_t RSSI() const { return _status == WL_CONNECTED ? -50 : 0; }
+    String macAddress() const { return String("02:00:00:00:00:01"); }
+
+private:
+    wifi_mode_t _mode = WIFI_OFF;
+    wl_status_t _status = WL_IDLE_STATUS;
+    IPAddress _apIP;
+    String _apSSID;
+    String _ssid;
+    String _hostname = "esp32-sim";
+};
+
+extern WiFiClass WiFi;
+
+#endif // SIM_WIFI_H
@@ -0,0 +1,75 @@
+#ifndef SIM_DRIVER_ADC_H
+#define SIM_DRIVER_ADC_H
+
+// Драйвер ADC ESP-IDF 4.4 (DMA, лише ADC1) для native симулятора: кадри складаються
+// з аналогових рівнів пінів (sim::setAnalog) з невеликим шумом, темп - sample_freq_hz
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define SOC_ADC_DIGI_RESULT_BYTES       2
+#define SOC_ADC_DIGI_MAX_BITWIDTH       12
+#define ADC_MAX_DELAY                   UINT32_MAX
+
+typedef enum {
+    ADC_ATTEN_DB_0 = 0,
+    ADC_ATTEN_DB_2_5,
+    ADC_ATTEN_DB_6,
+    ADC_ATTEN_DB_11
+} adc_atten_t;
+
+typedef enum {
+    ADC_CONV_SINGLE_UNIT_1 = 1,
+    ADC_CONV_SINGLE_UNIT_2 = 2,
+    ADC_CONV_BOTH_UNIT = 3,
+    ADC_CONV_ALTER_UNIT = 7
+} adc_digi_convert_mode_t;
+
+typedef enum {
+    ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    ADC_DIGI_OUTPUT_FORMAT_TYPE2
+} adc_digi_output_format_t;
+
+typedef struct {
+    uint32_t max_store_buf_size;
+    uint32_t conv_num_each_intr;
+    uint32_t adc1_chan_mask;
+    uint32_t adc2_chan_mask;
+} adc_digi_init_config_t;
+
+typedef struct {
+    uint8_t atten;
+    uint8_t channel;
+    uint8_t unit;
+    uint8_t bit_width;
+} adc_digi_pattern_config_t;
+
+typedef struct {
+    bool conv_limit_en;
+    uint32_t conv_limit_num;
+    uint32_t pattern_num;
+    adc_digi_pattern_config_t *adc_pattern;
+    uint32_t sample_freq_hz;
+    adc_digi_convert_mode_t conv_mode;
+    adc_digi_output_format_t format;
+} adc_digi_configuration_t;
+
+typedef struct {
+    union {
+        struct {
+            uint16_t data:     12;
+            uint16_t channel:   4;
+        } type1;
+        uint16_t val;
+    };
+} adc_digi_output_data_t;
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t *init_config);
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t *config);
+esp_err_t adc_digi_start(void);
+esp_err_t adc_digi_stop(void);
+// Блокує до повного кадру (conv_num_each_intr байт), як DMA на залізі
+esp_err_t adc_digi_read_bytes(uint8_t *buf, uint32_t length_max, uint32_t *out_length, uint32_t timeout_ms);
+esp_err_t adc_digi_deinitialize(void);
+
+#endif // SIM_DRIVER_ADC_H
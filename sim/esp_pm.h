@@ -0,0 +1,18 @@
+#ifndef SIM_ESP_PM_H
+#define SIM_ESP_PM_H
+
+// Керування живленням ESP-IDF для native симулятора.
+// Як Arduino-ESP32 без CONFIG_PM_ENABLE: esp_pm_configure() не підтримується,
+// прошивка переходить на setCpuFrequencyMhz(). Реалізація: sim/sim_system.cpp
+
+#include "esp_err.h"
+
+typedef struct {
+    int max_freq_mhz;
+    int min_freq_mhz;
+    bool light_sleep_enable;
+} esp_pm_config_esp32_t;
+
+esp_err_t esp_pm_configure(const void* config);
+
+#endif // SIM_ESP_PM_H
@@ -0,0 +1,10 @@
+#ifndef SIM_ESP_SLEEP_H
+#define SIM_ESP_SLEEP_H
+
+// Джерела пробудження для native симулятора: сну немає, виклики лише приймаються
+
+#include "esp_err.h"
+
+esp_err_t esp_sleep_enable_gpio_wakeup();
+
+#endif // SIM_ESP_SLEEP_H
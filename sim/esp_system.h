@@ -0,0 +1,24 @@
+#ifndef SIM_ESP_SYSTEM_H
+#define SIM_ESP_SYSTEM_H
+
+// Причина скидання для native симулятора: попередній процес записує її
+// у файл reset_reason в каталозі NVS (esp_restart, task watchdog).
+// Немає файлу - "увімкнення живлення". Реалізація: sim/sim_system.cpp
+
+typedef enum {
+    ESP_RST_UNKNOWN = 0,
+    ESP_RST_POWERON,
+    ESP_RST_EXT,
+    ESP_RST_SW,
+    ESP_RST_PANIC,
+    ESP_RST_INT_WDT,
+    ESP_RST_TASK_WDT,
+    ESP_RST_WDT,
+    ESP_RST_DEEPSLEEP,
+    ESP_RST_BROWNOUT,
+    ESP_RST_SDIO
+} esp_reset_reason_t;
+
+esp_reset_reason_t esp_reset_reason();
+
+#endif // SIM_ESP_SYSTEM_H
@@ -0,0 +1,16 @@
+#ifndef SIM_ESP_TASK_WDT_H
+#define SIM_ESP_TASK_WDT_H
+
+// Task watchdog для native симулятора: окремий потік перевіряє відмітки
+// підписаних задач і завершує процес як перезавантаження з ESP_RST_TASK_WDT.
+// Реалізація: sim/sim_system.cpp
+
+#include "esp_err.h"
+#include "freertos_sim.h"
+
+esp_err_t esp_task_wdt_init(uint32_t timeout_s, bool panic);
+esp_err_t esp_task_wdt_add(TaskHandle_t task);
+esp_err_t esp_task_wdt_delete(TaskHandle_t task);
+esp_err_t esp_task_wdt_reset();
+
+#endif // SIM_ESP_TASK_WDT_H
@@ -0,0 +1,105 @@
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+
+// FreeRTOS поверх std::thread (native симулятор).
+// Тік = 1 мс, "ядро" задачі лише запам'ятовується.
+
+#include <cstdint>
+#include <cstddef>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void (*TaskFunction_t)(void*);
+
+typedef struct SimTask* TaskHandle_t;
+typedef struct SimQueue* QueueHandle_t;
+typedef struct SimQueue* SemaphoreHandle_t;
+
+#define configTICK_RATE_HZ      1000
+#define portTICK_PERIOD_MS      1
+#define portTICK_RATE_MS        portTICK_PERIOD_MS
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define pdTICKS_TO_MS(t)        ((uint32_t)(t))
+#define portMAX_DELAY           ((TickType_t)0xFFFFFFFF)
+#define portYIELD_FROM_ISR(...)
+#define portNUM_PROCESSORS      2
+
+#define pdFALSE   0
+#define pdTRUE    1
+#define pdPASS    pdTRUE
+#define pdFAIL    pdFALSE
+#define errQUEUE_FULL  0
+#define errQUEUE_EMPTY 0
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define tskIDLE_PRIORITY 0
+
+// ---- Задачі ----
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* param, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t coreId);
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                       void* param, UBaseType_t priority, TaskHandle_t* handle);
+void vTaskDelete(TaskHandle_t task);
+void vTaskSuspend(TaskHandle_t task);
+void vTaskResume(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment);
+BaseType_t xTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment);
+TickType_t xTaskGetTickCount();
+TickType_t xTaskGetTickCountFromISR();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+const char* pcTaskGetName(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+UBaseType_t uxTaskGetNumberOfTasks();
+BaseType_t xPortGetCoreID();
+void taskYIELD();
+
+// ---- Черги ----
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait);
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t wait);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken);
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait);
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void* item, BaseType_t* woken);
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+BaseType_t xQueueReset(QueueHandle_t queue);
+
+// ---- Семафори (черга з нульовим розміром елемента) ----
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex();
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t wait);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* woken);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+// ---- Критичні секції (spinlock) ----
+// Як у ESP-IDF: власник може входити повторно
+typedef struct {
+    volatile int locked;
+    volatile unsigned long owner;
+    int count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0, 0, 0 }
+
+void simMuxLock(portMUX_TYPE* mux);
+void simMuxUnlock(portMUX_TYPE* mux);
+
+#define portENTER_CRITICAL(mux)      simMuxLock(mux)
+#define portEXIT_CRITICAL(mux)       simMuxUnlock(mux)
+#define portENTER_CRITICAL_ISR(mux)  simMuxLock(mux)
+#define portEXIT_CRITICAL_ISR(mux)   simMuxUnlock(mux)
+#define taskENTER_CRITICAL(mux)      simMuxLock(mux)
+#define taskEXIT_CRITICAL(mux)       simMuxUnlock(mux)
+
+#endif // SIM_FREERTOS_H
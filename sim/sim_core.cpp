@@ -0,0 +1,522 @@
+// Ядро native симулятора: годинник, GPIO, LEDC, Serial, ESP
+
+#include "Arduino.h"
+#include "sim_hal.h"
+#include "esp_system.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <malloc.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <random>
+#include <unistd.h>
+
+#define SIM_PIN_COUNT      64
+#define SIM_LEDC_CHANNELS  16
+#define SIM_HEAP_SIZE      327680
+
+namespace {
+
+// ---- Годинник ----
+std::atomic<bool> manualClock(false);
+std::atomic<uint64_t> manualMicros(0);
+const auto bootTime = std::chrono::steady_clock::now();
+
+// ---- GPIO ----
+struct PinState {
+    int level = LOW;
+    int mode = 0;
+    void (*isr)(void) = nullptr;
+    void (*isrArg)(void*) = nullptr;
+    void* arg = nullptr;
+    int isrMode = 0;
+    int analog = -1;
+};
+
+PinState pins[SIM_PIN_COUNT];
+std::recursive_mutex gpioLock;
+
+// ---- LEDC ----
+struct LedcChannel {
+    uint32_t freq = 0;
+    uint8_t resolution = 8;
+    uint32_t duty = 0;
+    uint8_t pins = 0;           // Під'єднані піни: без них вихід у нулі
+    uint64_t lastChange = 0;
+    double dutySeconds = 0;
+};
+
+LedcChannel ledc[SIM_LEDC_CHANNELS];
+int8_t pinChannel[SIM_PIN_COUNT];
+std::mutex ledcLock;
+std::once_flag pinChannelInit;
+
+// ---- Консоль / Serial ----
+std::mutex rxLock;
+std::deque<char> rxBuffer;
+std::mutex txLock;
+std::function<void(const char*)> consoleHandler;
+std::atomic<bool> serialOutput(true);
+std::once_flag consoleStart;
+
+bool ioTraceEnabled = true;
+uint32_t minFreeHeap = SIM_HEAP_SIZE;
+size_t heapBaseline = 0;
+
+std::mt19937 rng(0);
+
+void consoleThread() {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line[0] == '!') {
+            if (consoleHandler) consoleHandler(line.c_str() + 1);
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(rxLock);
+        rxBuffer.insert(rxBuffer.end(), line.begin(), line.end());
+        rxBuffer.push_back('\n');
+    }
+}
+
+void startConsole() {
+    std::call_once(consoleStart, [] {
+        std::thread(consoleThread).detach();
+    });
+}
+
+void fireIsr(PinState& p, int oldLevel, int newLevel) {
+    if (oldLevel == newLevel) return;
+    bool fire = false;
+    switch (p.isrMode) {
+        case RISING: fire = newLevel == HIGH; break;
+        case FALLING: fire = newLevel == LOW; break;
+        case CHANGE: fire = true; break;
+        case ONHIGH: fire = newLevel == HIGH; break;
+        case ONLOW: fire = newLevel == LOW; break;
+    }
+    if (!fire) return;
+    if (p.isr) p.isr();
+    if (p.isrArg) p.isrArg(p.arg);
+}
+
+uint64_t realMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+// Накопичити duty*час для каналу (викликати під ledcLock)
+void ledcAccumulate(LedcChannel& ch, uint64_t now) {
+    uint32_t maxDuty = (1u << ch.resolution) - 1;
+    if (maxDuty && ch.duty && ch.pins) {
+        ch.dutySeconds += (double)ch.duty / maxDuty * (now - ch.lastChange) / 1e6;
+    }
+    ch.lastChange = now;
+}
+
+} // namespace
+
+// ========================================
+// HAL
+// ========================================
+
+namespace sim {
+
+void setManualClock(bool manual) {
+    if (manual && !manualClock) manualMicros = realMicros();
+    manualClock = manual;
+}
+
+bool isManualClock() {
+    return manualClock;
+}
+
+void advanceClock(uint64_t us) {
+    manualMicros += us;
+}
+
+uint64_t nowMicros() {
+    return manualClock ? manualMicros.load() : realMicros();
+}
+
+void setPin(uint8_t pin, int level) {
+    if (pin >= SIM_PIN_COUNT) return;
+    std::lock_guard<std::recursive_mutex> lock(gpioLock);
+    PinState& p = pins[pin];
+    int old = p.level;
+    p.level = level ? HIGH : LOW;
+    fireIsr(p, old, p.level);
+}
+
+int getPin(uint8_t pin) {
+    if (pin >= SIM_PIN_COUNT) return LOW;
+    std::lock_guard<std::recursive_mutex> lock(gpioLock);
+    return pins[pin].level;
+}
+
+void setAnalog(uint8_t pin, int level) {
+    if (pin >= SIM_PIN_COUNT) return;
+    std::lock_guard<std::recursive_mutex> lock(gpioLock);
+    pins[pin].analog = level < 0 ? -1 : level > 4095 ? 4095 : level;
+}
+
+int getAnalog(uint8_t pin) {
+    if (pin >= SIM_PIN_COUNT) return 0;
+    std::lock_guard<std::recursive_mutex> lock(gpioLock);
+    const PinState& p = pins[pin];
+    return p.analog >= 0 ? p.analog : p.level ? 4095 : 0;
+}
+
+int pinModeOf(uint8_t pin) {
+    if (pin >= SIM_PIN_COUNT) return 0;
+    std::lock_guard<std::recursive_mutex> lock(gpioLock);
+    return pins[pin].mode;
+}
+
+void encoderStep(uint8_t pinClk, uint8_t pinDt, int dir) {
+    std::lock_guard<std::recursive_mutex> lock(gpioLock);
+    int clk = pins[pinClk].level ? LOW : HIGH;
+    // Енкодер: CLK != DT - за годинниковою стрілкою
+    pins[pinDt].level = dir > 0 ? (clk ? LOW : HIGH) : clk;
+    setPin(pinClk, clk);
+}
+
+uint32_t ledcDuty(uint8_t channel) {
+    if (channel >= SIM_LEDC_CHANNELS) return 0;
+    std::lock_guard<std::mutex> lock(ledcLock);
+    return ledc[channel].pins ? ledc[channel].duty : 0;
+}
+
+uint8_t ledcResolution(uint8_t channel) {
+    if (channel >= SIM_LEDC_CHANNELS) return 0;
+    std::lock_guard<std::mutex> lock(ledcLock);
+    return ledc[channel].resolution;
+}
+
+double ledcDutySeconds(uint8_t channel) {
+    if (channel >= SIM_LEDC_CHANNELS) return 0;
+    std::lock_guard<std::mutex> lock(ledcLock);
+    ledcAccumulate(ledc[channel], nowMicros());
+    return ledc[channel].dutySeconds;
+}
+
+uint32_t heapSize() {
+    return SIM_HEAP_SIZE;
+}
+
+void setConsoleHandler(std::function<void(const char*)> handler) {
+    consoleHandler = handler;
+    startConsole();
+}
+
+void setSerialOutput(bool enabled) {
+    serialOutput = enabled;
+}
+
+void setIoTrace(bool enabled) {
+    ioTraceEnabled = enabled;
+}
+
+bool ioTrace() {
+    return ioTraceEnabled;
+}
+
+void trace(const char* fmt, ...) {
+    if (!ioTraceEnabled) return;
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    fprintf(stderr, "[SIM %8lu] %s\n", millis(), buf);
+}
+
+} // namespace sim
+
+// ========================================
+// ЧАС
+// ========================================
+
+unsigned long millis() {
+    return (unsigned long)(sim::nowMicros() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)sim::nowMicros();
+}
+
+void delay(uint32_t ms) {
+    if (manualClock) {
+        manualMicros += (uint64_t)ms * 1000;
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+    if (manualClock) {
+        manualMicros += us;
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)sim::nowMicros();
+}
+
+// ========================================
+// GPIO
+// ========================================
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin >= SIM_PIN_COUNT) return;
+    std::lock_guard<std::recursive_mutex> lock(gpioLock);
+    pins[pin].mode = mode;
+    if (mode == INPUT_PULLUP) pins[pin].level = HIGH;
+    if (mode == INPUT_PULLDOWN) pins[pin].level = LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin >= SIM_PIN_COUNT) return;
+    std::lock_guard<std::recursive_mutex> lock(gpioLock);
+    if (pins[pin].level != (val ? HIGH : LOW)) {
+        sim::trace("gpio %u -> %u", pin, val ? 1 : 0);
+    }
+    pins[pin].level = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+    return sim::getPin(pin);
+}
+
+uint16_t analogRead(uint8_t pin) {
+    return sim::getAnalog(pin);
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+    if (pin >= SIM_PIN_COUNT) return;
+    std::lock_guard<std::recursive_mutex> lock(gpioLock);
+    pins[pin].isr = isr;
+    pins[pin].isrArg = nullptr;
+    pins[pin].isrMode = mode;
+}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode) {
+    if (pin >= SIM_PIN_COUNT) return;
+    std::lock_guard<std::recursive_mutex> lock(gpioLock);
+    pins[pin].isr = nullptr;
+    pins[pin].isrArg = isr;
+    pins[pin].arg = arg;
+    pins[pin].isrMode = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (pin >= SIM_PIN_COUNT) return;
+    std::lock_guard<std::recursive_mutex> lock(gpioLock);
+    pins[pin].isr = nullptr;
+    pins[pin].isrArg = nullptr;
+    pins[pin].isrMode = 0;
+}
+
+// ========================================
+// LEDC
+// ========================================
+
+uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolution_bits) {
+    if (channel >= SIM_LEDC_CHANNELS) return 0;
+    std::lock_guard<std::mutex> lock(ledcLock);
+    ledc[channel].freq = freq;
+    ledc[channel].resolution = resolution_bits;
+    ledc[channel].lastChange = sim::nowMicros();
+    return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) {
+    std::call_once(pinChannelInit, [] { memset(pinChannel, -1, sizeof(pinChannel)); });
+    if (pin >= SIM_PIN_COUNT || channel >= SIM_LEDC_CHANNELS) return;
+    std::lock_guard<std::mutex> lock(ledcLock);
+    if (pinChannel[pin] == channel) return;
+    if (pinChannel[pin] >= 0) {
+        ledcAccumulate(ledc[pinChannel[pin]], sim::nowMicros());
+        ledc[pinChannel[pin]].pins--;
+    }
+    ledcAccumulate(ledc[channel], sim::nowMicros());
+    ledc[channel].pins++;
+    pinChannel[pin] = channel;
+    sim::trace("ledc ch%u attached to gpio %u", channel, pin);
+}
+
+void ledcDetachPin(uint8_t pin) {
+    std::call_once(pinChannelInit, [] { memset(pinChannel, -1, sizeof(pinChannel)); });
+    if (pin >= SIM_PIN_COUNT) return;
+    std::lock_guard<std::mutex> lock(ledcLock);
+    if (pinChannel[pin] < 0) return;
+    LedcChannel& ch = ledc[pinChannel[pin]];
+    ledcAccumulate(ch, sim::nowMicros());
+    ch.pins--;
+    sim::trace("ledc ch%u detached from gpio %u", pinChannel[pin], pin);
+    pinChannel[pin] = -1;
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+    if (channel >= SIM_LEDC_CHANNELS) return;
+    std::lock_guard<std::mutex> lock(ledcLock);
+    LedcChannel& ch = ledc[channel];
+    ledcAccumulate(ch, sim::nowMicros());
+    if (ch.duty != duty) {
+        sim::trace("ledc ch%u duty %u", channel, duty);
+    }
+    ch.duty = duty;
+}
+
+uint32_t ledcRead(uint8_t channel) {
+    return sim::ledcDuty(channel);
+}
+
+// ========================================
+// RANDOM / MATH
+// ========================================
+
+long random(long max) {
+    if (max <= 0) return 0;
+    return std::uniform_int_distribution<long>(0, max - 1)(rng);
+}
+
+long random(long min, long max) {
+    if (min >= max) return min;
+    return min + random(max - min);
+}
+
+void randomSeed(unsigned long seed) {
+    rng.seed(seed);
+}
+
+uint32_t esp_random() {
+    return (uint32_t)rng();
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    if (in_max == in_min) return out_min;
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// ========================================
+// SERIAL
+// ========================================
+
+HardwareSerial Serial;
+
+int Stream::timedRead() {
+    unsigned long start = millis();
+    do {
+        int c = read();
+        if (c >= 0) return c;
+        if (manualClock) return -1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    } while (millis() - start < _timeout);
+    return -1;
+}
+
+int HardwareSerial::available() {
+    startConsole();
+    std::lock_guard<std::mutex> lock(rxLock);
+    return rxBuffer.size();
+}
+
+int HardwareSerial::read() {
+    startConsole();
+    std::lock_guard<std::mutex> lock(rxLock);
+    if (rxBuffer.empty()) return -1;
+    char c = rxBuffer.front();
+    rxBuffer.pop_front();
+    return (uint8_t)c;
+}
+
+int HardwareSerial::peek() {
+    std::lock_guard<std::mutex> lock(rxLock);
+    return rxBuffer.empty() ? -1 : (uint8_t)rxBuffer.front();
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (!serialOutput) return 1;
+    std::lock_guard<std::mutex> lock(txLock);
+    fputc(c, stdout);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t size) {
+    if (!serialOutput) return size;
+    std::lock_guard<std::mutex> lock(txLock);
+    return fwrite(buf, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+    std::lock_guard<std::mutex> lock(txLock);
+    fflush(stdout);
+}
+
+// ========================================
+// ESP
+// ========================================
+
+EspClass ESP;
+
+// Модель купи: фіксований розмір мінус те, що виділено з моменту старту
+uint32_t EspClass::getFreeHeap() {
+    struct mallinfo2 info = mallinfo2();
+    if (heapBaseline == 0) heapBaseline = info.uordblks;
+    long used = (long)info.uordblks - (long)heapBaseline;
+    if (used < 0) used = 0;
+    uint32_t freeHeap = used >= SIM_HEAP_SIZE ? 0 : SIM_HEAP_SIZE - used;
+    if (freeHeap < minFreeHeap) minFreeHeap = freeHeap;
+    return freeHeap;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    getFreeHeap();
+    return minFreeHeap;
+}
+
+uint32_t EspClass::getHeapSize() {
+    return SIM_HEAP_SIZE;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+    return getFreeHeap();
+}
+
+// 240 МГц "тактів" з реального годинника - навіть у ручному режимі,
+// щоб заміри вартості коду залишались справжніми
+uint32_t EspClass::getCycleCount() {
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+    return (uint32_t)(ns * getCpuFrequencyMhz() / 1000);
+}
+
+uint32_t EspClass::getCpuFreqMHz() {
+    return getCpuFrequencyMhz();
+}
+
+// MAC залежить від HTTP порту - кілька екземплярів на одному хості різні вузли
+uint64_t EspClass::getEfuseMac() {
+    return 0x0100000000F2ULL | ((uint64_t)sim::httpPort() << 32);
+}
+
+void EspClass::restart() {
+    esp_restart();
+}
+
+void esp_restart() {
+    fflush(stdout);
+    fprintf(stderr, "[SIM] esp_restart()\n");
+    sim::setResetReason(ESP_RST_SW);
+    _exit(3);
+}
@@ -0,0 +1,314 @@
+// Серво, світлодіоди та дисплей (native симулятор)
+
+#include "ESP32Servo.h"
+#include "FastLED.h"
+#include "TFT_eSPI.h"
+#include "WiFi.h"
+#include "ESPmDNS.h"
+#include "sim_hal.h"
+
+#include <mutex>
+
+#define SIM_SERVO_PINS 64
+
+namespace {
+
+std::mutex servoLock;
+int servoAngles[SIM_SERVO_PINS];
+bool servoOn[SIM_SERVO_PINS];
+
+} // namespace
+
+// ========================================
+// СЕРВО
+// ========================================
+
+namespace sim {
+
+int servoAngle(uint8_t pin) {
+    if (pin >= SIM_SERVO_PINS) return 0;
+    std::lock_guard<std::mutex> lock(servoLock);
+    return servoAngles[pin];
+}
+
+bool servoAttached(uint8_t pin) {
+    if (pin >= SIM_SERVO_PINS) return false;
+    std::lock_guard<std::mutex> lock(servoLock);
+    return servoOn[pin];
+}
+
+} // namespace sim
+
+int Servo::attach(int pin, int minUs, int maxUs) {
+    if (pin < 0 || pin >= SIM_SERVO_PINS) return 0;
+    _pin = pin;
+    _minUs = minUs;
+    _maxUs = maxUs;
+    
+    std::lock_guard<std::mutex> lock(servoLock);
+    servoOn[pin] = true;
+    sim::trace("servo gpio %d attached", pin);
+    return 1;
+}
+
+void Servo::detach() {
+    if (_pin < 0) return;
+    std::lock_guard<std::mutex> lock(servoLock);
+    servoOn[_pin] = false;
+    sim::trace("servo gpio %d detached", _pin);
+    _pin = -1;
+}
+
+void Servo::write(int value) {
+    // Як і ESP32Servo: значення < MIN_PULSE - кут, інакше мікросекунди
+    if (value >= 500) {
+        writeMicroseconds(value);
+        return;
+    }
+    _angle = constrain(value, 0, 180);
+    if (_pin < 0) return;
+    
+    std::lock_guard<std::mutex> lock(servoLock);
+    if (servoAngles[_pin] != _angle) {
+        sim::trace("servo gpio %d -> %d deg", _pin, _angle);
+    }
+    servoAngles[_pin] = _angle;
+}
+
+void Servo::writeMicroseconds(int us) {
+    us = constrain(us, _minUs, _maxUs);
+    write((int)map(us, _minUs, _maxUs, 0, 180));
+}
+
+int Servo::readMicroseconds() const {
+    return (int)map(_angle, 0, 180, _minUs, _maxUs);
+}
+
+// ========================================
+// FASTLED
+// ========================================
+
+CFastLED FastLED;
+
+CRGB::CRGB(const CHSV& hsv) {
+    hsv2rgb_rainbow(hsv, *this);
+}
+
+CRGB& CRGB::operator=(const CHSV& hsv) {
+    hsv2rgb_rainbow(hsv, *this);
+    return *this;
+}
+
+// Спрощена "веселка" FastLED: 8 секторів по 32 значення hue
+void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb) {
+    uint8_t hue = hsv.h;
+    uint8_t offset8 = (hue & 0x1F) << 3;
+    uint8_t third = scale8(offset8, 85);
+    uint8_t twothirds = scale8(offset8, 170);
+    uint8_t r, g, b;
+    
+    switch (hue >> 5) {
+        case 0: r = 255 - third; g = third; b = 0; break;
+        case 1: r = 171; g = 85 + third; b = 0; break;
+        case 2: r = 171 - twothirds; g = 170 + third; b = 0; break;
+        case 3: r = 0; g = 255 - third; b = third; break;
+        case 4: r = 0; g = 171 - twothirds; b = 85 + twothirds; break;
+        case 5: r = third; g = 0; b = 255 - third; break;
+        case 6: r = 85 + third; g = 0; b = 171 - third; break;
+        default: r = 170 + third; g = 0; b = 85 - third; break;
+    }
+    
+    // Насиченість
+    if (hsv.s != 255) {
+        uint8_t desat = 255 - hsv.s;
+        desat = scale8(desat, desat);
+        uint8_t satscale = 255 - desat;
+        r = scale8(r, satscale) + desat;
+        g = scale8(g, satscale) + desat;
+        b = scale8(b, satscale) + desat;
+    }
+    
+    // Яскравість
+    if (hsv.v != 255) {
+        uint8_t val = scale8(hsv.v, hsv.v);
+        r = scale8(r, val);
+        g = scale8(g, val);
+        b = scale8(b, val);
+    }
+    
+    rgb.r = r;
+    rgb.g = g;
+    rgb.b = b;
+}
+
+void fill_solid(CRGB* leds, int count, const CRGB& color) {
+    for (int i = 0; i < count; i++) leds[i] = color;
+}
+
+void fill_solid(CRGB* leds, int count, const CHSV& color) {
+    fill_solid(leds, count, CRGB(color));
+}
+
+uint8_t sin8(uint8_t theta) {
+    // Табличний синус з FastLED (sin8_C)
+    static const uint8_t b_m16_interleave[] = {0, 49, 49, 41, 90, 27, 117, 10};
+    uint8_t offset = theta;
+    if (theta & 0x40) offset = 255 - offset;
+    offset &= 0x3F;
+    uint8_t secoffset = offset & 0x0F;
+    if (theta & 0x40) secoffset++;
+    uint8_t section = offset >> 4;
+    uint8_t s2 = section * 2;
+    const uint8_t* p = b_m16_interleave + s2;
+    uint8_t b = p[0];
+    uint8_t m16 = p[1];
+    uint8_t mx = (m16 * secoffset) >> 4;
+    int8_t y = mx + b;
+    if (theta & 0x80) y = -y;
+    return (uint8_t)(y + 128);
+}
+
+uint8_t cubicwave8(uint8_t in) {
+    // triwave8 + ease8InOutCubic
+    if (in & 0x80) in = 255 - in;
+    uint8_t i = in << 1;
+    uint8_t ii = scale8(i, i);
+    uint8_t iii = scale8(ii, i);
+    uint16_t r1 = (3 * (uint16_t)ii) - (2 * (uint16_t)iii);
+    if (r1 & 0x100) return 255;
+    return (uint8_t)r1;
+}
+
+uint16_t beat16(uint16_t bpm, uint32_t timebase) {
+    uint32_t bpm88 = bpm < 256 ? (uint32_t)bpm << 8 : bpm;
+    return (uint16_t)(((millis() - timebase) * bpm88 * 280) >> 16);
+}
+
+uint8_t beat8(uint16_t bpm, uint32_t timebase) {
+    return beat16(bpm, timebase) >> 8;
+}
+
+uint8_t beatsin8(uint16_t bpm, uint8_t lowest, uint8_t highest, uint32_t timebase, uint8_t phase) {
+    uint8_t beat = beat8(bpm, timebase);
+    uint8_t value = sin8(beat + phase);
+    uint8_t range = highest - lowest;
+    return lowest + scale8(value, range);
+}
+
+void CFastLED::show() {
+    _shows++;
+}
+
+void CFastLED::clear(bool write) {
+    if (_leds) fill_solid(_leds, _count, CRGB::Black);
+    if (write) show();
+}
+
+// ========================================
+// WIFI
+// ========================================
+
+WiFiClass WiFi;
+MDNSResponder MDNS;
+
+// ========================================
+// ДИСПЛЕЙ
+// ========================================
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h) : _initWidth(w), _initHeight(h), _width(w), _height(h) {
+    _fb.assign((size_t)w * h, 0);
+}
+
+void TFT_eSPI::init(uint8_t) {
+    _fb.assign((size_t)_initWidth * _initHeight, 0);
+    sim::trace("tft init %dx%d", _initWidth, _initHeight);
+}
+
+void TFT_eSPI::setRotation(uint8_t r) {
+    _rotation = r & 3;
+    bool swap = _rotation & 1;
+    _width = swap ? _initHeight : _initWidth;
+    _height = swap ? _initWidth : _initHeight;
+}
+
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y) const {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+    return _fb[(size_t)y * _width + x];
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color) {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) return;
+    _fb[(size_t)y * _width + x] = color;
+    _pixels++;
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    int32_t x0 = max<int32_t>(x, 0), y0 = max<int32_t>(y, 0);
+    int32_t x1 = min<int32_t>(x + w, _width), y1 = min<int32_t>(y + h, _height);
+    for (int32_t yy = y0; yy < y1; yy++) {
+        uint16_t* row = &_fb[(size_t)yy * _width];
+        for (int32_t xx = x0; xx < x1; xx++) row[xx] = color;
+    }
+    if (x1 > x0 && y1 > y0) _pixels += (uint64_t)(x1 - x0) * (y1 - y0);
+}
+
+void TFT_eSPI::fillScreen(uint32_t color) {
+    fillRect(0, 0, _width, _height, color);
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) {
+    fillRect(x, y, w, 1, color);
+}
+
+void TFT_eSPI::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) {
+    fillRect(x, y, 1, h, color);
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+}
+
+void TFT_eSPI::fillCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color) {
+    for (int32_t dy = -r; dy <= r; dy++) {
+        int32_t dx = (int32_t)sqrt((double)(r * r - dy * dy));
+        drawFastHLine(x0 - dx, y0 + dy, 2 * dx + 1, color);
+    }
+}
+
+void TFT_eSPI::drawCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color) {
+    for (int32_t dy = -r; dy <= r; dy++) {
+        int32_t dx = (int32_t)sqrt((double)(r * r - dy * dy));
+        drawPixel(x0 - dx, y0 + dy, color);
+        drawPixel(x0 + dx, y0 + dy, color);
+    }
+}
+
+// Символ 6x8 * size як заповнений прямокутник (гліфи не потрібні для симуляції)
+size_t TFT_eSPI::write(uint8_t c) {
+    int32_t cw = 6 * _textSize, ch = 8 * _textSize;
+    if (c == '\n') {
+        _cursorX = 0;
+        _cursorY += ch;
+        return 1;
+    }
+    if (c == '\r') return 1;
+    
+    if (c != ' ') {
+        fillRect(_cursorX, _cursorY, cw - _textSize, ch - _textSize, _textColor);
+    }
+    _cursorX += cw;
+    return 1;
+}
+
+int16_t TFT_eSPI::textWidth(const char* s) {
+    return strlen(s) * 6 * _textSize;
+}
+
+int16_t TFT_eSPI::drawString(const char* s, int32_t x, int32_t y) {
+    setCursor(x, y);
+    print(s);
+    return textWidth(s);
+}
@@ -0,0 +1,395 @@
+// FreeRTOS поверх std::thread (native симулятор)
+
+#include "Arduino.h"
+#include "sim_hal.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SimTask {
+    std::string name;
+    TaskFunction_t fn;
+    void* param;
+    UBaseType_t priority;
+    BaseType_t core;
+    uint32_t stackDepth;
+    std::atomic<bool> deleted{false};
+    std::atomic<bool> suspended{false};
+};
+
+struct SimQueue {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    // Семафори/м'ютекси
+    bool isMutex = false;
+    bool recursive = false;
+    std::thread::id owner;
+    int depth = 0;
+};
+
+namespace {
+
+std::mutex taskListLock;
+std::vector<SimTask*> taskList;
+thread_local SimTask* currentTask = nullptr;
+
+// Задача, видалена ззовні, завершується на найближчій точці очікування
+void checkDeleted() {
+    if (currentTask && currentTask->deleted) {
+        pthread_exit(nullptr);
+    }
+    while (currentTask && currentTask->suspended && !currentTask->deleted) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void sleepTicks(TickType_t ticks) {
+    if (sim::isManualClock()) {
+        sim::advanceClock((uint64_t)ticks * 1000);
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+template <typename Pred>
+bool waitFor(SimQueue* q, std::unique_lock<std::mutex>& lock, TickType_t wait, Pred pred) {
+    if (pred()) return true;
+    if (wait == 0) return false;
+    if (wait == portMAX_DELAY) {
+        q->changed.wait(lock, pred);
+        return true;
+    }
+    return q->changed.wait_for(lock, std::chrono::milliseconds(wait), pred);
+}
+
+} // namespace
+
+// ========================================
+// ЗАДАЧІ
+// ========================================
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* param, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t coreId) {
+    SimTask* task = new SimTask();
+    task->name = name ? name : "";
+    task->fn = fn;
+    task->param = param;
+    task->priority = priority;
+    task->core = coreId;
+    task->stackDepth = stackDepth;
+    
+    {
+        std::lock_guard<std::mutex> lock(taskListLock);
+        taskList.push_back(task);
+    }
+    
+    if (handle) *handle = task;
+    
+    std::thread([task] {
+        currentTask = task;
+        pthread_setname_np(pthread_self(), task->name.substr(0, 15).c_str());
+        task->fn(task->param);
+    }).detach();
+    
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                       void* param, UBaseType_t priority, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL) task = currentTask;
+    if (task == NULL) return;
+    
+    task->deleted = true;
+    {
+        std::lock_guard<std::mutex> lock(taskListLock);
+        taskList.erase(std::remove(taskList.begin(), taskList.end(), task), taskList.end());
+    }
+    if (task == currentTask) {
+        pthread_exit(nullptr);
+    }
+}
+
+void vTaskSuspend(TaskHandle_t task) {
+    if (task == NULL) task = currentTask;
+    if (task) task->suspended = true;
+    checkDeleted();
+}
+
+void vTaskResume(TaskHandle_t task) {
+    if (task) task->suspended = false;
+}
+
+namespace sim {
+
+bool stallTask(const char* name, uint32_t ms) {
+    SimTask* task = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(taskListLock);
+        for (SimTask* t : taskList) {
+            if (t->name == name) task = t;
+        }
+    }
+    if (!task) return false;
+    
+    // Задача зупиниться на найближчій точці очікування
+    task->suspended = true;
+    std::thread([task, ms] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        task->suspended = false;
+    }).detach();
+    return true;
+}
+
+} // namespace sim
+
+void vTaskDelay(TickType_t ticks) {
+    checkDeleted();
+    sleepTicks(ticks);
+    checkDeleted();
+}
+
+BaseType_t xTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment) {
+    checkDeleted();
+    TickType_t wake = *previousWakeTime + increment;
+    TickType_t now = xTaskGetTickCount();
+    *previousWakeTime = wake;
+    
+    // Дедлайн уже пропущено - як і FreeRTOS, не чекати
+    if ((int32_t)(wake - now) <= 0) return pdFALSE;
+    
+    sleepTicks(wake - now);
+    checkDeleted();
+    return pdTRUE;
+}
+
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment) {
+    xTaskDelayUntil(previousWakeTime, increment);
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+TickType_t xTaskGetTickCountFromISR() {
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return currentTask;
+}
+
+const char* pcTaskGetName(TaskHandle_t task) {
+    if (task == NULL) task = currentTask;
+    return task ? task->name.c_str() : "loopTask";
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    // Стек у симуляторі не обмежений - повернути заявлений розмір
+    if (task == NULL) task = currentTask;
+    return task ? task->stackDepth : 8192;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks() {
+    std::lock_guard<std::mutex> lock(taskListLock);
+    return taskList.size() + 1;
+}
+
+// loop() у Arduino-ESP32 працює на ядрі 1
+BaseType_t xPortGetCoreID() {
+    if (currentTask && currentTask->core != tskNO_AFFINITY) return currentTask->core;
+    return 1;
+}
+
+void taskYIELD() {
+    std::this_thread::yield();
+}
+
+// ========================================
+// ЧЕРГИ
+// ========================================
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    SimQueue* q = new SimQueue();
+    q->length = length;
+    q->itemSize = itemSize;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait) {
+    std::unique_lock<std::mutex> lock(q->lock);
+    if (!waitFor(q, lock, wait, [q] { return q->items.size() < q->length; })) return errQUEUE_FULL;
+    const uint8_t* p = (const uint8_t*)item;
+    q->items.emplace_back(p, p + q->itemSize);
+    q->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t q, const void* item, TickType_t wait) {
+    return xQueueSend(q, item, wait);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void* item, BaseType_t* woken) {
+    if (woken) *woken = pdFALSE;
+    return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void* item) {
+    std::lock_guard<std::mutex> lock(q->lock);
+    q->items.clear();
+    const uint8_t* p = (const uint8_t*)item;
+    q->items.emplace_back(p, p + q->itemSize);
+    q->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t wait) {
+    std::unique_lock<std::mutex> lock(q->lock);
+    if (!waitFor(q, lock, wait, [q] { return !q->items.empty(); })) return pdFALSE;
+    if (item && q->itemSize) memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    q->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t q, void* item, BaseType_t* woken) {
+    if (woken) *woken = pdFALSE;
+    return xQueueReceive(q, item, 0);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t q, void* item, TickType_t wait) {
+    std::unique_lock<std::mutex> lock(q->lock);
+    if (!waitFor(q, lock, wait, [q] { return !q->items.empty(); })) return pdFALSE;
+    if (item && q->itemSize) memcpy(item, q->items.front().data(), q->itemSize);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    std::lock_guard<std::mutex> lock(q->lock);
+    return q->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q) {
+    std::lock_guard<std::mutex> lock(q->lock);
+    return q->length - q->items.size();
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+    std::lock_guard<std::mutex> lock(q->lock);
+    q->items.clear();
+    q->changed.notify_all();
+    return pdPASS;
+}
+
+// ========================================
+// СЕМАФОРИ
+// ========================================
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    SimQueue* q = xQueueCreate(1, 0);
+    q->isMutex = true;
+    q->items.emplace_back();
+    return q;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+    SimQueue* q = xSemaphoreCreateMutex();
+    q->recursive = true;
+    return q;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount) {
+    SimQueue* q = xQueueCreate(maxCount, 0);
+    for (UBaseType_t i = 0; i < initialCount; i++) q->items.emplace_back();
+    return q;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait) {
+    if (sem->recursive) {
+        std::unique_lock<std::mutex> lock(sem->lock);
+        if (sem->depth > 0 && sem->owner == std::this_thread::get_id()) {
+            sem->depth++;
+            return pdTRUE;
+        }
+        if (!waitFor(sem, lock, wait, [sem] { return !sem->items.empty(); })) return pdFALSE;
+        sem->items.pop_front();
+        sem->owner = std::this_thread::get_id();
+        sem->depth = 1;
+        return pdTRUE;
+    }
+    return xQueueReceive(sem, NULL, wait);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    std::lock_guard<std::mutex> lock(sem->lock);
+    if (sem->recursive) {
+        if (sem->depth == 0 || sem->owner != std::this_thread::get_id()) return pdFALSE;
+        if (--sem->depth > 0) return pdTRUE;
+    }
+    if (sem->items.size() >= sem->length) return pdFALSE;
+    sem->items.emplace_back();
+    sem->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t wait) {
+    return xSemaphoreTake(sem, wait);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem) {
+    return xSemaphoreGive(sem);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* woken) {
+    if (woken) *woken = pdFALSE;
+    return xSemaphoreGive(sem);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    delete sem;
+}
+
+// ========================================
+// КРИТИЧНІ СЕКЦІЇ
+// ========================================
+
+void simMuxLock(portMUX_TYPE* mux) {
+    unsigned long self = (unsigned long)pthread_self();
+    if (__atomic_load_n(&mux->owner, __ATOMIC_RELAXED) == self) {
+        mux->count++;
+        return;
+    }
+    while (__atomic_exchange_n(&mux->locked, 1, __ATOMIC_ACQUIRE)) {
+        std::this_thread::yield();
+    }
+    __atomic_store_n(&mux->owner, self, __ATOMIC_RELAXED);
+    mux->count = 1;
+}
+
+void simMuxUnlock(portMUX_TYPE* mux) {
+    if (--mux->count > 0) return;
+    __atomic_store_n(&mux->owner, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&mux->locked, 0, __ATOMIC_RELEASE);
+}
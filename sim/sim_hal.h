@@ -0,0 +1,78 @@
+#ifndef SIM_HAL_H
+#define SIM_HAL_H
+
+// Шар апаратної абстракції для native симулятора.
+// Прошивка бачить звичайні Arduino API, а цей інтерфейс
+// керує "залізом" ззовні: кнопки, датчики, годинник, помпа.
+
+#include <cstdint>
+#include <functional>
+
+namespace sim {
+
+// ---- Годинник ----
+// Ручний режим: час стоїть, delay()/vTaskDelay() його просувають.
+// Використовується для детермінованих прогонів у одному потоці.
+void setManualClock(bool manual);
+bool isManualClock();
+void advanceClock(uint64_t us);
+uint64_t nowMicros();
+
+// ---- GPIO ----
+// Рівень "зовнішнього" сигналу на піні. Викликає ISR, якщо фронт збігається
+void setPin(uint8_t pin, int level);
+int getPin(uint8_t pin);
+int pinModeOf(uint8_t pin);
+// Аналоговий рівень піна (0..4095) для analogRead і DMA ADC. -1 - за цифровим: 0 або 4095
+void setAnalog(uint8_t pin, int level);
+int getAnalog(uint8_t pin);
+
+// Крок енкодера (+1 / -1): виставляє CLK/DT і викликає ISR
+void encoderStep(uint8_t pinClk, uint8_t pinDt, int dir);
+
+// ---- PWM (LEDC) ----
+uint32_t ledcDuty(uint8_t channel);
+uint8_t ledcResolution(uint8_t channel);
+// Інтеграл duty/max за часом (секунди повної потужності)
+double ledcDutySeconds(uint8_t channel);
+
+// ---- Серво ----
+int servoAngle(uint8_t pin);
+bool servoAttached(uint8_t pin);
+
+// ---- Задачі ----
+// Призупинити задачу FreeRTOS на ms (імітація зависання). false - немає такої задачі
+bool stallTask(const char* name, uint32_t ms);
+
+// ---- Скидання ----
+// Причина для наступного запуску (esp_reset_reason_t), файл reset_reason у каталозі NVS
+void setResetReason(int reason);
+
+// ---- NVS ----
+void setNvsDir(const char* dir);
+const char* nvsDir();
+uint32_t nvsWrites();
+
+// ---- HTTP ----
+// 0 = використати порт, переданий у AsyncWebServer
+void setHttpPort(uint16_t port);
+uint16_t httpPort();
+
+// ---- Пам'ять ----
+uint32_t heapSize();
+
+// ---- Консоль ----
+// Рядки stdin, що починаються з '!', йдуть у цей обробник, а не в Serial
+void setConsoleHandler(std::function<void(const char* line)> handler);
+// Вимкнути вивід Serial у stdout (бенчмарки пишуть туди результати)
+void setSerialOutput(bool enabled);
+
+// ---- Трасування ----
+// Друк змін помпи/серво/пінів у stderr
+void setIoTrace(bool enabled);
+bool ioTrace();
+void trace(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+} // namespace sim
+
+#endif // SIM_HAL_H
@@ -0,0 +1,174 @@
+// Точка входу native симулятора: setup() + loop() як у Arduino-ESP32,
+// плюс консоль керування "залізом" (рядки stdin, що починаються з '!')
+
+#include "Arduino.h"
+#include "sim_hal.h"
+#include "config.h"
+#include "control.h"
+
+#include <string>
+#include <thread>
+#include <chrono>
+
+void setup();
+void loop();
+void serialEvent() __attribute__((weak));
+
+extern SystemState g_systemState;
+extern uint16_t g_targetVolume;
+extern Statistics g_stats;
+
+static void simSleep(uint32_t ms) {
+    if (sim::isManualClock()) sim::advanceClock((uint64_t)ms * 1000);
+    else std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Натискання кнопки: рівень active на holdMs, потім відпускання
+static void simPress(uint8_t pin, int active, uint32_t holdMs) {
+    sim::setPin(pin, active);
+    simSleep(holdMs);
+    sim::setPin(pin, !active);
+}
+
+static void simStatus() {
+    double ml = sim::ledcDutySeconds(PUMP_CHANNEL) * PUMP_ML_PER_SEC;
+    fprintf(stderr, "[SIM] pump duty %u, dispensed %.1f ml, servo %d deg, glasses",
+            sim::ledcDuty(PUMP_CHANNEL), ml, sim::servoAngle(SERVO_PIN));
+    for (uint8_t pin : hw::glassPins) fprintf(stderr, " %d", sim::getPin(pin));
+    fprintf(stderr, "\n");
+#if MANIFOLD_CHANNELS
+    fprintf(stderr, "[SIM] manifold dispensed");
+    for (int i = 0; i < MANIFOLD_CHANNELS; i++) {
+        fprintf(stderr, " %.1f", sim::ledcDutySeconds(MANIFOLD_LEDC_FIRST + i) * PUMP_ML_PER_SEC);
+    }
+    fprintf(stderr, " ml\n");
+#endif
+#if RECIPE_PUMPS > 1
+    fprintf(stderr, "[SIM] recipe pumps dispensed");
+    for (int i = 0; i < RECIPE_PUMPS - 1; i++) {
+        fprintf(stderr, " %.1f", sim::ledcDutySeconds(RECIPE_LEDC_FIRST + i) * PUMP_ML_PER_SEC);
+    }
+    fprintf(stderr, " ml (pumps 2-%d)\n", RECIPE_PUMPS);
+#endif
+}
+
+// Раунд на всі рюмки профілю: зняти і поставити всі, розливи - через чергу.
+// Час - до останнього завершеного розливу
+static void simRound(uint16_t ml) {
+    if (g_systemState != STATE_IDLE && g_systemState != STATE_READY) {
+        fprintf(stderr, "[SIM] round: device busy\n");
+        return;
+    }
+    
+    for (uint8_t pin : hw::glassPins) sim::setPin(pin, LOW);
+    simSleep(100);
+    
+    g_targetVolume = ml;
+    uint32_t poursBefore = g_stats.totalPours;
+    uint64_t start = sim::nowMicros();
+    for (uint8_t pin : hw::glassPins) sim::setPin(pin, HIGH);
+    simSleep(50);
+    
+    uint8_t shot;
+    while (queuePourAny(ml, shot)) {}
+    
+    uint64_t deadline = start + 120 * 1000000ULL;
+    while (g_stats.totalPours - poursBefore < GLASS_COUNT && sim::nowMicros() < deadline) {
+        if (g_systemState == STATE_ERROR) break;
+        simSleep(10);
+    }
+    
+    uint32_t poured = g_stats.totalPours - poursBefore;
+#if MANIFOLD_CHANNELS
+    const char* path = "manifold";
+#else
+    const char* path = "serial servo";
+#endif
+    fprintf(stderr, "[SIM] round: %u of %d glasses x %u ml in %llu ms (%s)\n", poured, GLASS_COUNT, ml,
+            (unsigned long long)((sim::nowMicros() - start) / 1000), path);
+}
+
+static void simHelp() {
+    fprintf(stderr,
+        "[SIM] Console commands:\n"
+        "  !glass N 0|1   - remove/place glass N (1..GLASS_COUNT)\n"
+        "  !start [ms]    - press START button\n"
+        "  !btn [ms]      - press encoder button\n"
+        "  !enc N         - rotate encoder N steps (negative = back)\n"
+        "  !pin P 0|1     - drive GPIO P\n"
+        "  !adc P V       - analog level of GPIO P (0..4095, -1 = follow !pin/!glass)\n"
+        "  !status        - pump, servo, glasses\n"
+        "  !round [ml]    - pour every glass, print round time\n"
+        "  !stall [ms]    - freeze control task (safety cutoff test)\n"
+        "  !trace 0|1     - IO trace on/off\n"
+        "  !quit          - exit\n");
+}
+
+static void simConsole(const char* line) {
+    char cmd[16] = {0};
+    int a = 0, b = 0;
+    int n = sscanf(line, "%15s %d %d", cmd, &a, &b);
+    if (n < 1) return;
+    std::string c(cmd);
+    
+    if (c == "glass" && n == 3 && a >= 1 && a <= GLASS_COUNT) {
+        sim::setPin(hw::glassPins[a - 1], b ? HIGH : LOW);
+    } else if (c == "start") {
+        simPress(BUTTON_START, HIGH, n >= 2 ? a : 100);
+    } else if (c == "btn") {
+        simPress(ENCODER_SW, LOW, n >= 2 ? a : 100);
+    } else if (c == "enc" && n >= 2) {
+        int dir = a > 0 ? 1 : -1;
+        for (int i = 0; i < abs(a); i++) {
+            sim::encoderStep(ENCODER_CLK, ENCODER_DT, dir);
+            simSleep(6);   // Більше за debounce у ISR
+        }
+    } else if (c == "pin" && n == 3) {
+        sim::setPin(a, b);
+    } else if (c == "adc" && n == 3) {
+        sim::setAnalog(a, b);
+    } else if (c == "status") {
+        simStatus();
+    } else if (c == "round") {
+        uint16_t ml = n >= 2 ? a : VOLUME_DEFAULT;
+        std::thread([ml] { simRound(ml); }).detach();
+    } else if (c == "stall") {
+        if (!sim::stallTask("Control_Task", n >= 2 ? a : 1000)) {
+            fprintf(stderr, "[SIM] Control_Task not running\n");
+        }
+    } else if (c == "trace" && n >= 2) {
+        sim::setIoTrace(a != 0);
+    } else if (c == "quit") {
+        fflush(stdout);
+        exit(0);
+    } else {
+        simHelp();
+    }
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) {
+            sim::setHttpPort(atoi(argv[++i]));
+        } else if (arg == "--nvs" && i + 1 < argc) {
+            sim::setNvsDir(argv[++i]);
+        } else if (arg == "--quiet") {
+            sim::setIoTrace(false);
+        } else {
+            fprintf(stderr, "Usage: %s [--port N] [--nvs DIR] [--quiet]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    if (!sim::httpPort()) sim::setHttpPort(8080);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    sim::setConsoleHandler(simConsole);
+    
+    setup();
+    
+    while (true) {
+        loop();
+        if (serialEvent && Serial.available()) serialEvent();
+    }
+}
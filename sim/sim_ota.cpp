@@ -0,0 +1,332 @@
+// OTA розділи та SHA-256 для native симулятора
+
+#include "esp_ota_ops.h"
+#include "mbedtls/sha256.h"
+#include "Arduino.h"
+#include "sim_hal.h"
+
+#include <string>
+
+#define SIM_OTA_SLOT_SIZE   0x1E0000    // min_spiffs.csv: 2 x 1.875 МБ
+#define SIM_IMAGE_MAGIC     0xE9
+
+// ========================================
+// SHA-256
+// ========================================
+
+static const uint32_t sha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static uint32_t sha256Rotr(uint32_t v, int n) {
+    return (v >> n) | (v << (32 - n));
+}
+
+static void sha256Block(mbedtls_sha256_context* ctx, const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[i * 4] << 24 | block[i * 4 + 1] << 16 | block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = sha256Rotr(w[i - 15], 7) ^ sha256Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = sha256Rotr(w[i - 2], 17) ^ sha256Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    
+    uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3];
+    uint32_t e = ctx->state[4], f = ctx->state[5], g = ctx->state[6], h = ctx->state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (sha256Rotr(e, 6) ^ sha256Rotr(e, 11) ^ sha256Rotr(e, 25)) + ((e & f) ^ (~e & g)) + sha256K[i] + w[i];
+        uint32_t t2 = (sha256Rotr(a, 2) ^ sha256Rotr(a, 13) ^ sha256Rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    
+    ctx->state[0] += a; ctx->state[1] += b; ctx->state[2] += c; ctx->state[3] += d;
+    ctx->state[4] += e; ctx->state[5] += f; ctx->state[6] += g; ctx->state[7] += h;
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context* ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context* ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_sha256_starts(mbedtls_sha256_context* ctx, int is224) {
+    static const uint32_t init[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    if (is224) return -1;
+    memcpy(ctx->state, init, sizeof(init));
+    ctx->total = 0;
+    return 0;
+}
+
+int mbedtls_sha256_update(mbedtls_sha256_context* ctx, const unsigned char* input, size_t ilen) {
+    size_t fill = ctx->total % 64;
+    ctx->total += ilen;
+    
+    while (ilen > 0) {
+        size_t n = std::min(ilen, (size_t)64 - fill);
+        memcpy(ctx->buffer + fill, input, n);
+        fill += n;
+        input += n;
+        ilen -= n;
+        if (fill == 64) {
+            sha256Block(ctx, ctx->buffer);
+            fill = 0;
+        }
+    }
+    return 0;
+}
+
+int mbedtls_sha256_finish(mbedtls_sha256_context* ctx, unsigned char output[32]) {
+    uint64_t bits = ctx->total * 8;
+    uint8_t pad[72] = {0x80};
+    size_t fill = ctx->total % 64;
+    size_t padLen = fill < 56 ? 56 - fill : 120 - fill;
+    for (int i = 0; i < 8; i++) pad[padLen + i] = bits >> (56 - i * 8);
+    mbedtls_sha256_update(ctx, pad, padLen + 8);
+    
+    for (int i = 0; i < 8; i++) {
+        output[i * 4] = ctx->state[i] >> 24;
+        output[i * 4 + 1] = ctx->state[i] >> 16;
+        output[i * 4 + 2] = ctx->state[i] >> 8;
+        output[i * 4 + 3] = ctx->state[i];
+    }
+    return 0;
+}
+
+// ========================================
+// РОЗДІЛИ
+// ========================================
+
+namespace {
+
+const esp_partition_t simSlots[2] = {
+    {0x10000, SIM_OTA_SLOT_SIZE, "app0"},
+    {0x10000 + SIM_OTA_SLOT_SIZE, SIM_OTA_SLOT_SIZE, "app1"},
+};
+
+// otadata: завантажувальний слот і стан кожного образу
+struct SimOtaData {
+    bool loaded = false;
+    int boot = 0;
+    int running = 0;
+    uint32_t state[2] = {ESP_OTA_IMG_VALID, ESP_OTA_IMG_VALID};
+};
+
+SimOtaData otaData;
+
+FILE* writeFile = nullptr;
+int writeSlot = -1;
+size_t writeSize = 0;
+bool writeFailed = false;
+
+std::string simOtaPath(const char* name) {
+    return std::string(sim::nvsDir()) + "/" + name;
+}
+
+void simOtaSave() {
+    FILE* f = fopen(simOtaPath("otadata").c_str(), "w");
+    if (!f) return;
+    fprintf(f, "%d %u %u\n", otaData.boot, otaData.state[0], otaData.state[1]);
+    fclose(f);
+}
+
+// Перший доступ - "завантажувач": NEW стає PENDING_VERIFY, а PENDING_VERIFY,
+// що не підтвердився минулого разу, - ABORTED з поверненням на інший слот
+SimOtaData& simOta() {
+    if (otaData.loaded) return otaData;
+    otaData.loaded = true;
+    
+    FILE* f = fopen(simOtaPath("otadata").c_str(), "r");
+    if (f) {
+        int boot = 0;
+        unsigned s0 = ESP_OTA_IMG_VALID, s1 = ESP_OTA_IMG_VALID;
+        if (fscanf(f, "%d %u %u", &boot, &s0, &s1) == 3 && (boot == 0 || boot == 1)) {
+            otaData.boot = boot;
+            otaData.state[0] = s0;
+            otaData.state[1] = s1;
+        }
+        fclose(f);
+    }
+    
+    uint32_t& state = otaData.state[otaData.boot];
+    if (state == ESP_OTA_IMG_NEW) {
+        state = ESP_OTA_IMG_PENDING_VERIFY;
+    } else if (state == ESP_OTA_IMG_PENDING_VERIFY) {
+        fprintf(stderr, "[SIM] bootloader: %s not confirmed, rollback\n", simSlots[otaData.boot].label);
+        state = ESP_OTA_IMG_ABORTED;
+        otaData.boot ^= 1;
+    }
+    otaData.running = otaData.boot;
+    simOtaSave();
+    
+    fprintf(stderr, "[SIM] running from %s\n", simSlots[otaData.running].label);
+    return otaData;
+}
+
+int simSlotOf(const esp_partition_t* partition) {
+    if (partition == &simSlots[0]) return 0;
+    if (partition == &simSlots[1]) return 1;
+    return -1;
+}
+
+// Образ "з прикладеним хешем": магічний байт, останні 32 байти - SHA-256 решти
+bool simVerifyImage(int slot) {
+    FILE* f = fopen(simOtaPath(slot ? "ota_1.bin" : "ota_0.bin").c_str(), "rb");
+    if (!f) return false;
+    
+    std::string data;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.append(buf, n);
+    fclose(f);
+    
+    if (data.size() < 64 || (uint8_t)data[0] != SIM_IMAGE_MAGIC) return false;
+    
+    uint8_t digest[32];
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, (const uint8_t*)data.data(), data.size() - 32);
+    mbedtls_sha256_finish(&ctx, digest);
+    return memcmp(digest, data.data() + data.size() - 32, 32) == 0;
+}
+
+} // namespace
+
+const esp_partition_t* esp_ota_get_running_partition() {
+    return &simSlots[simOta().running];
+}
+
+const esp_partition_t* esp_ota_get_boot_partition() {
+    return &simSlots[simOta().boot];
+}
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from) {
+    int slot = start_from ? simSlotOf(start_from) : simOta().running;
+    return slot < 0 ? nullptr : &simSlots[slot ^ 1];
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp_ota_handle_t* out_handle) {
+    int slot = simSlotOf(partition);
+    if (slot < 0 || out_handle == nullptr) return ESP_ERR_INVALID_ARG;
+    if (slot == simOta().running) return ESP_ERR_OTA_PARTITION_CONFLICT;
+    if (image_size != OTA_SIZE_UNKNOWN && image_size != OTA_WITH_SEQUENTIAL_WRITES &&
+        image_size > partition->size) return ESP_ERR_INVALID_SIZE;
+    if (writeFile) return ESP_ERR_INVALID_STATE;
+    
+    writeFile = fopen(simOtaPath(slot ? "ota_1.bin" : "ota_0.bin").c_str(), "wb");
+    if (!writeFile) return ESP_FAIL;
+    
+    // Слот переписується - його старий образ більше не дійсний
+    otaData.state[slot] = ESP_OTA_IMG_INVALID;
+    simOtaSave();
+    
+    writeSlot = slot;
+    writeSize = 0;
+    writeFailed = false;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size) {
+    if (handle != 1 || !writeFile) return ESP_ERR_INVALID_ARG;
+    if (writeSize == 0 && size > 0 && ((const uint8_t*)data)[0] != SIM_IMAGE_MAGIC) {
+        writeFailed = true;
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    if (writeSize + size > simSlots[writeSlot].size) {
+        writeFailed = true;
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    fwrite(data, 1, size, writeFile);
+    writeSize += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+    if (handle != 1 || !writeFile) return ESP_ERR_NOT_FOUND;
+    
+    fclose(writeFile);
+    writeFile = nullptr;
+    
+    bool valid = !writeFailed && simVerifyImage(writeSlot);
+    if (valid) {
+        otaData.state[writeSlot] = ESP_OTA_IMG_VALID;
+        simOtaSave();
+    }
+    return valid ? ESP_OK : ESP_ERR_OTA_VALIDATE_FAILED;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+    if (handle != 1 || !writeFile) return ESP_ERR_NOT_FOUND;
+    
+    fclose(writeFile);
+    writeFile = nullptr;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition) {
+    int slot = simSlotOf(partition);
+    if (slot < 0) return ESP_ERR_INVALID_ARG;
+    if (slot != simOta().running && !simVerifyImage(slot)) return ESP_ERR_OTA_VALIDATE_FAILED;
+    
+    otaData.boot = slot;
+    if (slot != otaData.running) otaData.state[slot] = ESP_OTA_IMG_NEW;
+    simOtaSave();
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t* partition, esp_ota_img_states_t* ota_state) {
+    int slot = simSlotOf(partition);
+    if (slot < 0 || ota_state == nullptr) return ESP_ERR_INVALID_ARG;
+    
+    *ota_state = (esp_ota_img_states_t)simOta().state[slot];
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback() {
+    simOta().state[otaData.running] = ESP_OTA_IMG_VALID;
+    simOtaSave();
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_invalid_rollback_and_reboot() {
+    int other = simOta().running ^ 1;
+    if (otaData.state[other] != ESP_OTA_IMG_VALID) return ESP_ERR_OTA_ROLLBACK_FAILED;
+    
+    otaData.state[otaData.running] = ESP_OTA_IMG_INVALID;
+    otaData.boot = other;
+    simOtaSave();
+    
+    esp_restart();
+    return ESP_OK;
+}
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_OTA_PARTITION_CONFLICT: return "ESP_ERR_OTA_PARTITION_CONFLICT";
+        case ESP_ERR_OTA_VALIDATE_FAILED: return "ESP_ERR_OTA_VALIDATE_FAILED";
+        case ESP_ERR_OTA_ROLLBACK_FAILED: return "ESP_ERR_OTA_ROLLBACK_FAILED";
+        default: return "UNKNOWN_ERROR";
+    }
+}
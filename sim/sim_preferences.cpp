@@ -0,0 +1,184 @@
+// Preferences з файловим сховищем (native симулятор)
+
+#include "Preferences.h"
+#include "sim_hal.h"
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+
+// Ліміти ESP-IDF NVS
+#define NVS_KEY_NAME_MAX  15
+#define NVS_SIM_ENTRIES   630
+
+namespace {
+
+std::string storageDir = "sim_nvs";
+std::atomic<uint32_t> writeCount(0);
+std::recursive_mutex fileLock;
+std::map<std::string, std::map<std::string, std::vector<uint8_t>>> namespaces;
+
+} // namespace
+
+namespace sim {
+
+void setNvsDir(const char* dir) {
+    storageDir = dir;
+}
+
+const char* nvsDir() {
+    return storageDir.c_str();
+}
+
+uint32_t nvsWrites() {
+    return writeCount;
+}
+
+} // namespace sim
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partition) {
+    (void)partition;
+    if (_started) return false;
+    if (!name || strlen(name) > NVS_KEY_NAME_MAX) return false;
+    
+    std::lock_guard<std::recursive_mutex> lock(fileLock);
+    mkdir(storageDir.c_str(), 0755);
+    _path = storageDir + "/" + name + ".nvs";
+    _readOnly = readOnly;
+    _started = true;
+    load();
+    return true;
+}
+
+void Preferences::end() {
+    _started = false;
+    _entries = nullptr;
+}
+
+bool Preferences::clear() {
+    if (!_started || _readOnly) return false;
+    std::lock_guard<std::recursive_mutex> lock(fileLock);
+    _entries->clear();
+    return store();
+}
+
+bool Preferences::remove(const char* key) {
+    if (!_started || _readOnly) return false;
+    std::lock_guard<std::recursive_mutex> lock(fileLock);
+    if (_entries->erase(key) == 0) return false;
+    return store();
+}
+
+bool Preferences::isKey(const char* key) {
+    std::vector<uint8_t> v;
+    return findRaw(key, v);
+}
+
+String Preferences::getString(const char* key, const String& def) {
+    std::vector<uint8_t> v;
+    if (!findRaw(key, v)) return def;
+    return String((const char*)v.data(), v.size());
+}
+
+size_t Preferences::getString(const char* key, char* value, size_t maxLen) {
+    std::vector<uint8_t> v;
+    if (!findRaw(key, v) || !value || v.size() + 1 > maxLen) return 0;
+    memcpy(value, v.data(), v.size());
+    value[v.size()] = 0;
+    return v.size() + 1;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    std::vector<uint8_t> v;
+    return findRaw(key, v) ? v.size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    std::vector<uint8_t> v;
+    if (!findRaw(key, v) || !buf || v.size() > maxLen) return 0;
+    memcpy(buf, v.data(), v.size());
+    return v.size();
+}
+
+size_t Preferences::freeEntries() {
+    if (!_started) return 0;
+    std::lock_guard<std::recursive_mutex> lock(fileLock);
+    return _entries->size() >= NVS_SIM_ENTRIES ? 0 : NVS_SIM_ENTRIES - _entries->size();
+}
+
+size_t Preferences::putRaw(const char* key, const void* value, size_t len) {
+    if (!_started || _readOnly || !key || strlen(key) > NVS_KEY_NAME_MAX) return 0;
+    
+    const uint8_t* p = (const uint8_t*)value;
+    std::vector<uint8_t> data(p, p + len);
+    
+    std::lock_guard<std::recursive_mutex> lock(fileLock);
+    
+    // NVS не переписує ідентичне значення
+    auto it = _entries->find(key);
+    if (it != _entries->end() && it->second == data) return len;
+    
+    (*_entries)[key] = std::move(data);
+    return store() ? len : 0;
+}
+
+bool Preferences::findRaw(const char* key, std::vector<uint8_t>& out) {
+    if (!_started || !key) return false;
+    std::lock_guard<std::recursive_mutex> lock(fileLock);
+    auto it = _entries->find(key);
+    if (it == _entries->end()) return false;
+    out = it->second;
+    return true;
+}
+
+// Формат файлу: [u8 довжина ключа][ключ][u32 довжина][дані]...
+// Файл читається один раз на процес, далі всі об'єкти ділять кеш
+void Preferences::load() {
+    auto cached = namespaces.find(_path);
+    if (cached != namespaces.end()) {
+        _entries = &cached->second;
+        return;
+    }
+    
+    _entries = &namespaces[_path];
+    
+    FILE* f = fopen(_path.c_str(), "rb");
+    if (!f) return;
+    
+    while (true) {
+        uint8_t keyLen;
+        if (fread(&keyLen, 1, 1, f) != 1) break;
+        std::string key(keyLen, 0);
+        uint32_t len;
+        if (fread(&key[0], 1, keyLen, f) != keyLen) break;
+        if (fread(&len, sizeof(len), 1, f) != 1) break;
+        std::vector<uint8_t> data(len);
+        if (len && fread(data.data(), 1, len, f) != len) break;
+        (*_entries)[key] = std::move(data);
+    }
+    
+    fclose(f);
+}
+
+// Атомарний запис через тимчасовий файл (викликати під fileLock)
+bool Preferences::store() {
+    std::string tmp = _path + ".tmp";
+    
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    
+    for (const auto& e : *_entries) {
+        uint8_t keyLen = e.first.size();
+        uint32_t len = e.second.size();
+        fwrite(&keyLen, 1, 1, f);
+        fwrite(e.first.data(), 1, keyLen, f);
+        fwrite(&len, sizeof(len), 1, f);
+        fwrite(e.second.data(), 1, len, f);
+    }
+    
+    bool ok = fclose(f) == 0 && rename(tmp.c_str(), _path.c_str()) == 0;
+    if (ok) writeCount++;
+    return ok;
+}
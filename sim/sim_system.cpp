@@ -0,0 +1,346 @@
+// Task watchdog, причина скидання, апаратні таймери і живлення (native симулятор)
+
+#include "Arduino.h"
+#include "esp_system.h"
+#include "esp_task_wdt.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "driver/adc.h"
+#include "sim_hal.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+struct SimHwTimer {
+    uint8_t num = 0;
+    uint16_t divider = 80;
+    uint64_t alarm = 0;
+    std::atomic<void (*)(void)> isr{nullptr};
+    std::atomic<bool> enabled{false};
+    std::atomic<bool> stopped{false};
+};
+
+namespace {
+
+// ---- Task watchdog ----
+std::mutex wdtLock;
+std::map<TaskHandle_t, uint64_t> wdtTasks;     // Задача -> остання відмітка (мкс)
+uint64_t wdtTimeoutUs = 0;
+bool wdtPanic = false;
+std::once_flag wdtStart;
+
+// ---- Живлення ----
+std::atomic<uint32_t> cpuMhz(240);
+
+// ---- ADC DMA ----
+std::mutex adcLock;
+std::vector<uint8_t> adcChannels;               // Патерн: канали ADC1 по черзі
+uint32_t adcFrameBytes = 0;
+uint32_t adcFreq = 0;
+bool adcReady = false;
+std::atomic<bool> adcRunning(false);
+std::mt19937 adcNoise(1);
+
+// Канал ADC1 -> GPIO: 0-3 - GPIO36-39, 4-7 - GPIO32-35
+uint8_t adcChannelPin(uint8_t channel) {
+    return channel < 4 ? 36 + channel : 28 + channel;
+}
+
+std::string resetReasonPath() {
+    return std::string(sim::nvsDir()) + "/reset_reason";
+}
+
+// Раз на 100 мс: задача без відмітки довше за тайм-аут -> "перезавантаження"
+void wdtCheck() {
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        
+        std::lock_guard<std::mutex> lock(wdtLock);
+        uint64_t now = sim::nowMicros();
+        for (auto& entry : wdtTasks) {
+            if (now - entry.second <= wdtTimeoutUs) continue;
+            
+            fflush(stdout);
+            fprintf(stderr, "[SIM] task watchdog: %s did not reset in %llu ms\n",
+                    pcTaskGetName(entry.first), (unsigned long long)(wdtTimeoutUs / 1000));
+            if (!wdtPanic) {
+                entry.second = now;
+                continue;
+            }
+            sim::setResetReason(ESP_RST_TASK_WDT);
+            _exit(4);
+        }
+    }
+}
+
+} // namespace
+
+// ========================================
+// ПРИЧИНА СКИДАННЯ
+// ========================================
+
+namespace sim {
+
+void setResetReason(int reason) {
+    FILE* f = fopen(resetReasonPath().c_str(), "w");
+    if (!f) return;
+    fprintf(f, "%d\n", reason);
+    fclose(f);
+}
+
+} // namespace sim
+
+// Файл читається один раз: наступний запуск без нього - увімкнення живлення
+esp_reset_reason_t esp_reset_reason() {
+    static int reason = -1;
+    if (reason < 0) {
+        reason = ESP_RST_POWERON;
+        FILE* f = fopen(resetReasonPath().c_str(), "r");
+        if (f) {
+            if (fscanf(f, "%d", &reason) != 1) reason = ESP_RST_UNKNOWN;
+            fclose(f);
+            remove(resetReasonPath().c_str());
+        }
+    }
+    return (esp_reset_reason_t)reason;
+}
+
+// ========================================
+// TASK WATCHDOG
+// ========================================
+
+esp_err_t esp_task_wdt_init(uint32_t timeout_s, bool panic) {
+    {
+        std::lock_guard<std::mutex> lock(wdtLock);
+        wdtTimeoutUs = (uint64_t)timeout_s * 1000000;
+        wdtPanic = panic;
+    }
+    // З ручним годинником час стоїть - перевірка не має сенсу
+    if (!sim::isManualClock()) {
+        std::call_once(wdtStart, [] { std::thread(wdtCheck).detach(); });
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_add(TaskHandle_t task) {
+    if (task == NULL) task = xTaskGetCurrentTaskHandle();
+    std::lock_guard<std::mutex> lock(wdtLock);
+    if (wdtTasks.count(task)) return ESP_ERR_INVALID_ARG;
+    wdtTasks[task] = sim::nowMicros();
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_delete(TaskHandle_t task) {
+    if (task == NULL) task = xTaskGetCurrentTaskHandle();
+    std::lock_guard<std::mutex> lock(wdtLock);
+    return wdtTasks.erase(task) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_task_wdt_reset() {
+    std::lock_guard<std::mutex> lock(wdtLock);
+    auto it = wdtTasks.find(xTaskGetCurrentTaskHandle());
+    if (it == wdtTasks.end()) return ESP_ERR_NOT_FOUND;
+    it->second = sim::nowMicros();
+    return ESP_OK;
+}
+
+// ========================================
+// АПАРАТНИЙ ТАЙМЕР
+// ========================================
+
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp) {
+    (void)countUp;
+    hw_timer_t* timer = new hw_timer_t();
+    timer->num = num;
+    timer->divider = divider ? divider : 1;
+    
+    if (!sim::isManualClock()) {
+        std::thread([timer] {
+            uint64_t next = sim::nowMicros();
+            while (!timer->stopped) {
+                // Тік таймера = divider / 80 МГц
+                uint64_t periodUs = timer->alarm * timer->divider / 80;
+                if (!timer->enabled || periodUs == 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    next = sim::nowMicros();
+                    continue;
+                }
+                next += periodUs;
+                uint64_t now = sim::nowMicros();
+                if (next > now) std::this_thread::sleep_for(std::chrono::microseconds(next - now));
+                
+                void (*isr)(void) = timer->isr;
+                if (isr && timer->enabled) isr();
+            }
+            delete timer;
+        }).detach();
+    }
+    return timer;
+}
+
+void timerEnd(hw_timer_t* timer) {
+    if (!timer) return;
+    timer->enabled = false;
+    timer->stopped = true;
+    if (sim::isManualClock()) delete timer;
+}
+
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(void), bool edge) {
+    (void)edge;
+    if (timer) timer->isr = fn;
+}
+
+void timerDetachInterrupt(hw_timer_t* timer) {
+    if (timer) timer->isr = nullptr;
+}
+
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoreload) {
+    (void)autoreload;
+    if (timer) timer->alarm = alarmValue;
+}
+
+void timerAlarmEnable(hw_timer_t* timer) {
+    if (timer) timer->enabled = true;
+}
+
+void timerAlarmDisable(hw_timer_t* timer) {
+    if (timer) timer->enabled = false;
+}
+
+// ========================================
+// ЖИВЛЕННЯ
+// ========================================
+
+bool setCpuFrequencyMhz(uint32_t mhz) {
+    if (mhz != 240 && mhz != 160 && mhz != 80) return false;
+    if (cpuMhz != mhz) sim::trace("cpu %u MHz", mhz);
+    cpuMhz = mhz;
+    return true;
+}
+
+uint32_t getCpuFrequencyMhz() {
+    return cpuMhz;
+}
+
+esp_err_t esp_pm_configure(const void* config) {
+    (void)config;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup() {
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+    (void)intr_type;
+    return gpio_num >= 0 && gpio_num < 40 ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num) {
+    return gpio_num >= 0 && gpio_num < 40 ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+    (void)intr_type;
+    return gpio_num >= 0 && gpio_num < 40 ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num) {
+    return gpio_num >= 0 && gpio_num < 40 ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num) {
+    return gpio_num >= 0 && gpio_num < 40 ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+// ========================================
+// ADC DMA
+// ========================================
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t *init_config) {
+    if (!init_config || init_config->adc2_chan_mask || init_config->conv_num_each_intr == 0 ||
+        init_config->conv_num_each_intr % SOC_ADC_DIGI_RESULT_BYTES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(adcLock);
+    adcFrameBytes = init_config->conv_num_each_intr;
+    adcReady = true;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t *config) {
+    if (!config || config->pattern_num == 0 || config->conv_mode != ADC_CONV_SINGLE_UNIT_1 ||
+        config->sample_freq_hz < 20000 || config->sample_freq_hz > 2000000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(adcLock);
+    if (!adcReady) return ESP_ERR_INVALID_STATE;
+    adcChannels.clear();
+    for (uint32_t i = 0; i < config->pattern_num; i++) adcChannels.push_back(config->adc_pattern[i].channel);
+    adcFreq = config->sample_freq_hz;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_start(void) {
+    std::lock_guard<std::mutex> lock(adcLock);
+    if (!adcReady || adcChannels.empty()) return ESP_ERR_INVALID_STATE;
+    adcRunning = true;
+    sim::trace("adc dma %u Hz, %u channels", adcFreq, (unsigned)adcChannels.size());
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_stop(void) {
+    adcRunning = false;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_read_bytes(uint8_t *buf, uint32_t length_max, uint32_t *out_length, uint32_t timeout_ms) {
+    *out_length = 0;
+    if (!adcRunning) {
+        delay(timeout_ms == ADC_MAX_DELAY ? 100 : timeout_ms);
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    uint32_t samples;
+    uint32_t freq;
+    {
+        std::lock_guard<std::mutex> lock(adcLock);
+        uint32_t bytes = adcFrameBytes < length_max ? adcFrameBytes : length_max;
+        samples = bytes / SOC_ADC_DIGI_RESULT_BYTES;
+        freq = adcFreq;
+    }
+    
+    // Кадр готовий, коли ADC набрав усі вибірки
+    delay((uint32_t)((uint64_t)samples * 1000 / freq));
+    
+    std::lock_guard<std::mutex> lock(adcLock);
+    std::uniform_int_distribution<int> noise(-20, 20);
+    for (uint32_t i = 0; i < samples; i++) {
+        uint8_t channel = adcChannels[i % adcChannels.size()];
+        int level = sim::getAnalog(adcChannelPin(channel)) + noise(adcNoise);
+        adc_digi_output_data_t sample;
+        sample.type1.data = level < 0 ? 0 : level > 4095 ? 4095 : level;
+        sample.type1.channel = channel;
+        memcpy(&buf[i * SOC_ADC_DIGI_RESULT_BYTES], &sample, SOC_ADC_DIGI_RESULT_BYTES);
+    }
+    *out_length = samples * SOC_ADC_DIGI_RESULT_BYTES;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_deinitialize(void) {
+    std::lock_guard<std::mutex> lock(adcLock);
+    adcRunning = false;
+    adcReady = false;
+    adcChannels.clear();
+    return ESP_OK;
+}
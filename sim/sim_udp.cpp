@@ -0,0 +1,94 @@
+// AsyncUDP для native симулятора
+
+#include "AsyncUDP.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static in_addr simUdpAddr(const IPAddress& ip) {
+    in_addr addr;
+    addr.s_addr = (uint32_t)ip;
+    return addr;
+}
+
+bool AsyncUDP::listenMulticast(const IPAddress addr, uint16_t port, uint8_t ttl) {
+    close();
+    
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return false;
+    
+    // Кілька процесів на одному порту
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    
+    // Група і відправка - через loopback, власні пакети теж повертаються
+    ip_mreq mreq = {};
+    mreq.imr_multiaddr = simUdpAddr(addr);
+    mreq.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+    in_addr loopback;
+    loopback.s_addr = htonl(INADDR_LOOPBACK);
+    unsigned char mttl = ttl;
+    unsigned char loop = 1;
+    
+    if (bind(fd, (sockaddr*)&local, sizeof(local)) != 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback)) != 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &mttl, sizeof(mttl)) != 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) != 0) {
+        fprintf(stderr, "[SIM] UDP: cannot join %s:%u\n", addr.toString().c_str(), port);
+        ::close(fd);
+        return false;
+    }
+    
+    _fd = fd;
+    _running = true;
+    _thread = std::thread(&AsyncUDP::receiveLoop, this);
+    return true;
+}
+
+size_t AsyncUDP::writeTo(const uint8_t* data, size_t len, const IPAddress addr, uint16_t port) {
+    if (_fd < 0) return 0;
+    
+    sockaddr_in dest = {};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    dest.sin_addr = simUdpAddr(addr);
+    
+    ssize_t sent = sendto(_fd, data, len, 0, (sockaddr*)&dest, sizeof(dest));
+    return sent < 0 ? 0 : (size_t)sent;
+}
+
+void AsyncUDP::close() {
+    _running = false;
+    if (_thread.joinable()) _thread.join();
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
+
+void AsyncUDP::receiveLoop() {
+    uint8_t buf[1500];
+    
+    while (_running) {
+        pollfd pfd = {_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) continue;
+        
+        sockaddr_in peer = {};
+        socklen_t peerLen = sizeof(peer);
+        ssize_t len = recvfrom(_fd, buf, sizeof(buf), 0, (sockaddr*)&peer, &peerLen);
+        if (len <= 0 || !_handler) continue;
+        
+        AsyncUDPPacket packet(buf, len, IPAddress(peer.sin_addr.s_addr), ntohs(peer.sin_port));
+        _handler(packet);
+    }
+}
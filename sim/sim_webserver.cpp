@@ -0,0 +1,1168 @@
+// ESPAsyncWebServer для native симулятора: HTTP/1.1, WebSocket (RFC 6455), SSE
+
+#include "ESPAsyncWebServer.h"
+#include "sim_hal.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#define SIM_HTTP_MAX_HEAD   8192
+#define SIM_HTTP_MAX_BODY   (8 * 1024 * 1024)
+#define SIM_UPLOAD_CHUNK    1436
+#define SIM_WS_MAX_FRAME    (64 * 1024)
+#define SIM_WS_SNDBUF       5744        // TCP_SND_BUF lwIP на ESP32: повільний клієнт швидко заповнює чергу
+
+namespace {
+
+uint16_t portOverride = 0;
+
+// ---- SHA-1 (тільки для рукостискання WebSocket) ----
+void sha1(const uint8_t* data, size_t len, uint8_t out[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::string msg((const char*)data, len);
+    uint64_t bits = (uint64_t)len * 8;
+    msg.push_back((char)0x80);
+    while (msg.size() % 64 != 56) msg.push_back(0);
+    for (int i = 7; i >= 0; i--) msg.push_back((char)(bits >> (i * 8)));
+    
+    auto rol = [](uint32_t v, int n) { return (v << n) | (v >> (32 - n)); };
+    
+    for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            const uint8_t* p = (const uint8_t*)&msg[chunk + i * 4];
+            w[i] = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+        }
+        for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rol(b, 30); b = a; a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+    
+    for (int i = 0; i < 5; i++) {
+        out[i * 4] = h[i] >> 24;
+        out[i * 4 + 1] = h[i] >> 16;
+        out[i * 4 + 2] = h[i] >> 8;
+        out[i * 4 + 3] = h[i];
+    }
+}
+
+std::string base64(const uint8_t* data, size_t len) {
+    static const char* tbl = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t n = data[i] << 16;
+        if (i + 1 < len) n |= data[i + 1] << 8;
+        if (i + 2 < len) n |= data[i + 2];
+        out.push_back(tbl[(n >> 18) & 63]);
+        out.push_back(tbl[(n >> 12) & 63]);
+        out.push_back(i + 1 < len ? tbl[(n >> 6) & 63] : '=');
+        out.push_back(i + 2 < len ? tbl[n & 63] : '=');
+    }
+    return out;
+}
+
+bool writeAll(int fd, const void* data, size_t len) {
+    const char* p = (const char*)data;
+    while (len) {
+        ssize_t n = ::send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool readAll(int fd, void* data, size_t len) {
+    char* p = (char*)data;
+    while (len) {
+        ssize_t n = ::recv(fd, p, len, 0);
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+String urlDecode(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '+') out.push_back(' ');
+        else if (s[i] == '%' && i + 2 < s.size()) {
+            out.push_back((char)strtol(s.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else out.push_back(s[i]);
+    }
+    return String(out);
+}
+
+const char* statusText(int code) {
+    switch (code) {
+        case 101: return "Switching Protocols";
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 422: return "Unprocessable Entity";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "";
+    }
+}
+
+bool headerEquals(const String& a, const char* b) {
+    return a.equalsIgnoreCase(String(b));
+}
+
+} // namespace
+
+namespace sim {
+
+void setHttpPort(uint16_t port) {
+    portOverride = port;
+}
+
+uint16_t httpPort() {
+    return portOverride;
+}
+
+} // namespace sim
+
+std::recursive_mutex& simAsyncLock() {
+    static std::recursive_mutex lock;
+    return lock;
+}
+
+// ========================================
+// ВІДПОВІДІ
+// ========================================
+
+bool AsyncWebServerResponse::simWriteHead(int fd, long contentLength) {
+    std::string head = "HTTP/1.1 " + std::to_string(_code) + " " + statusText(_code) + "\r\n";
+    if (_contentType.length()) head += "Content-Type: " + _contentType.str() + "\r\n";
+    if (contentLength >= 0) head += "Content-Length: " + std::to_string(contentLength) + "\r\n";
+    else head += "Transfer-Encoding: chunked\r\n";
+    for (const auto& h : _headers) head += h.name().str() + ": " + h.value().str() + "\r\n";
+    head += "Connection: close\r\n\r\n";
+    return writeAll(fd, head.data(), head.size());
+}
+
+bool AsyncWebServerResponse::simWrite(int fd) {
+    return simWriteHead(fd, _body.size()) && writeAll(fd, _body.data(), _body.size());
+}
+
+bool AsyncChunkedResponse::simWrite(int fd) {
+    if (!simWriteHead(fd, -1)) return false;
+    
+    uint8_t buf[1460];
+    size_t index = 0;
+    while (true) {
+        size_t n;
+        {
+            std::lock_guard<std::recursive_mutex> lock(simAsyncLock());
+            n = _filler(buf, sizeof(buf), index);
+        }
+        if (n == (size_t)-1) {   // RESPONSE_TRY_AGAIN
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        char size[16];
+        int len = snprintf(size, sizeof(size), "%zx\r\n", n);
+        if (!writeAll(fd, size, len)) return false;
+        if (n && !writeAll(fd, buf, n)) return false;
+        if (!writeAll(fd, "\r\n", 2)) return false;
+        if (n == 0) return true;
+        index += n;
+    }
+}
+
+// ========================================
+// ЗАПИТ
+// ========================================
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+    if (_onDisconnect) _onDisconnect();
+    free(_tempObject);
+}
+
+bool AsyncWebServerRequest::authenticate(const char* username, const char* password, const char* realm, bool passwordIsHash) const {
+    (void)realm;
+    (void)passwordIsHash;
+    
+    const String& auth = header("Authorization");
+    if (!auth.startsWith("Basic ")) return false;
+    
+    std::string pair = std::string(username) + ":" + password;
+    return base64((const uint8_t*)pair.data(), pair.size()) == auth.substring(6).c_str();
+}
+
+void AsyncWebServerRequest::requestAuthentication(const char* realm, bool isDigest) {
+    (void)isDigest;
+    
+    AsyncWebServerResponse* response = beginResponse(401);
+    response->addHeader("WWW-Authenticate", String("Basic realm=\"") + (realm ? realm : "Login Required") + "\"");
+    send(response);
+}
+
+const char* AsyncWebServerRequest::methodToString() const {
+    switch (_method) {
+        case HTTP_GET: return "GET";
+        case HTTP_POST: return "POST";
+        case HTTP_DELETE: return "DELETE";
+        case HTTP_PUT: return "PUT";
+        case HTTP_PATCH: return "PATCH";
+        case HTTP_HEAD: return "HEAD";
+        case HTTP_OPTIONS: return "OPTIONS";
+        default: return "UNKNOWN";
+    }
+}
+
+bool AsyncWebServerRequest::simParse(const std::string& head) {
+    size_t lineEnd = head.find("\r\n");
+    std::string requestLine = head.substr(0, lineEnd);
+    
+    size_t sp1 = requestLine.find(' ');
+    size_t sp2 = requestLine.find(' ', sp1 + 1);
+    if (sp1 == std::string::npos || sp2 == std::string::npos) return false;
+    
+    std::string method = requestLine.substr(0, sp1);
+    if (method == "GET") _method = HTTP_GET;
+    else if (method == "POST") _method = HTTP_POST;
+    else if (method == "DELETE") _method = HTTP_DELETE;
+    else if (method == "PUT") _method = HTTP_PUT;
+    else if (method == "PATCH") _method = HTTP_PATCH;
+    else if (method == "HEAD") _method = HTTP_HEAD;
+    else if (method == "OPTIONS") _method = HTTP_OPTIONS;
+    else return false;
+    
+    std::string target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+    size_t q = target.find('?');
+    _url = urlDecode(target.substr(0, q));
+    if (q != std::string::npos) simParseForm(target.substr(q + 1), false);
+    
+    size_t pos = lineEnd + 2;
+    while (pos < head.size()) {
+        size_t end = head.find("\r\n", pos);
+        if (end == std::string::npos) end = head.size();
+        std::string line = head.substr(pos, end - pos);
+        pos = end + 2;
+        
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(' '));
+        String name(line.substr(0, colon));
+        
+        _headers.emplace_back(new AsyncWebHeader(name, String(value)));
+        if (headerEquals(name, "Host")) _host = value;
+        else if (headerEquals(name, "Content-Type")) _contentType = value;
+        else if (headerEquals(name, "Content-Length")) _contentLength = strtoul(value.c_str(), nullptr, 10);
+    }
+    return true;
+}
+
+void AsyncWebServerRequest::simParseForm(const std::string& body, bool post) {
+    size_t pos = 0;
+    while (pos <= body.size()) {
+        size_t amp = body.find('&', pos);
+        if (amp == std::string::npos) amp = body.size();
+        std::string pair = body.substr(pos, amp - pos);
+        if (!pair.empty()) {
+            size_t eq = pair.find('=');
+            String name = urlDecode(pair.substr(0, eq));
+            String value = eq == std::string::npos ? String() : urlDecode(pair.substr(eq + 1));
+            _params.emplace_back(new AsyncWebParameter(name, value, post));
+        }
+        pos = amp + 1;
+    }
+}
+
+AsyncWebParameter* AsyncWebServerRequest::getParam(size_t index) const {
+    return index < _params.size() ? _params[index].get() : NULL;
+}
+
+bool AsyncWebServerRequest::hasParam(const String& name, bool post, bool file) const {
+    return getParam(name, post, file) != NULL;
+}
+
+AsyncWebParameter* AsyncWebServerRequest::getParam(const String& name, bool post, bool file) const {
+    for (const auto& p : _params) {
+        if (p->name() == name && p->isPost() == post && p->isFile() == file) return p.get();
+    }
+    return NULL;
+}
+
+bool AsyncWebServerRequest::hasArg(const char* name) const {
+    for (const auto& p : _params) {
+        if (p->name() == name) return true;
+    }
+    return false;
+}
+
+const String& AsyncWebServerRequest::arg(const String& name) const {
+    static const String empty;
+    for (const auto& p : _params) {
+        if (p->name() == name) return p->value();
+    }
+    return empty;
+}
+
+bool AsyncWebServerRequest::hasHeader(const String& name) const {
+    return getHeader(name) != NULL;
+}
+
+AsyncWebHeader* AsyncWebServerRequest::getHeader(const String& name) const {
+    for (const auto& h : _headers) {
+        if (h->name().equalsIgnoreCase(name)) return h.get();
+    }
+    return NULL;
+}
+
+const String& AsyncWebServerRequest::header(const char* name) const {
+    static const String empty;
+    AsyncWebHeader* h = getHeader(String(name));
+    return h ? h->value() : empty;
+}
+
+void AsyncWebServerRequest::send(int code, const String& contentType, const String& content) {
+    send(beginResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::send_P(int code, const String& contentType, const char* content) {
+    send(beginResponse(code, contentType, String(content)));
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response) {
+    _response.reset(response);
+}
+
+void AsyncWebServerRequest::redirect(const String& url) {
+    AsyncWebServerResponse* response = beginResponse(302);
+    response->addHeader("Location", url);
+    send(response);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code, const String& contentType, const String& content) {
+    AsyncWebServerResponse* response = new AsyncWebServerResponse(code, contentType);
+    response->_body = content.str();
+    return response;
+}
+
+AsyncResponseStream* AsyncWebServerRequest::beginResponseStream(const String& contentType, size_t bufferSize) {
+    return new AsyncResponseStream(contentType, bufferSize);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginChunkedResponse(const String& contentType, AwsResponseFiller callback) {
+    return new AsyncChunkedResponse(contentType, callback);
+}
+
+// ========================================
+// ОБРОБНИКИ
+// ========================================
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest* request) {
+    if (!(_method & request->method())) return false;
+    
+    const String& url = request->url();
+    if (_uri.length() && _uri.endsWith("*")) {
+        return url.startsWith(_uri.substring(0, _uri.length() - 1));
+    }
+    return url == _uri || url.startsWith(_uri + "/");
+}
+
+void AsyncCallbackWebHandler::handleRequest(AsyncWebServerRequest* request) {
+    if (_onRequest) _onRequest(request);
+    else request->send(500);
+}
+
+void AsyncCallbackWebHandler::handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index,
+                                           uint8_t* data, size_t len, bool final) {
+    if (_onUpload) _onUpload(request, filename, index, data, len, final);
+}
+
+void AsyncCallbackWebHandler::handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                                         size_t index, size_t total) {
+    if (_onBody) _onBody(request, data, len, index, total);
+}
+
+// ========================================
+// СЕРВЕР
+// ========================================
+
+AsyncWebServer::~AsyncWebServer() {
+    end();
+}
+
+void AsyncWebServer::begin() {
+    if (_running) return;
+    signal(SIGPIPE, SIG_IGN);
+    
+    uint16_t port = sim::httpPort() ? sim::httpPort() : _port;
+    
+    _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    
+    if (bind(_listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(_listenFd, 64) != 0) {
+        fprintf(stderr, "[SIM] HTTP: cannot listen on 127.0.0.1:%u\n", port);
+        ::close(_listenFd);
+        _listenFd = -1;
+        return;
+    }
+    
+    fprintf(stderr, "[SIM] HTTP server: http://127.0.0.1:%u/\n", port);
+    _running = true;
+    std::thread(&AsyncWebServer::acceptLoop, this).detach();
+}
+
+void AsyncWebServer::end() {
+    _running = false;
+    if (_listenFd >= 0) {
+        shutdown(_listenFd, SHUT_RDWR);
+        ::close(_listenFd);
+        _listenFd = -1;
+    }
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, ArRequestHandlerFunction onRequest) {
+    return on(uri, HTTP_ANY, onRequest, nullptr, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest) {
+    return on(uri, method, onRequest, nullptr, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload) {
+    return on(uri, method, onRequest, onUpload, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload,
+                                            ArBodyHandlerFunction onBody) {
+    AsyncCallbackWebHandler* handler = new AsyncCallbackWebHandler(uri, method, onRequest, onUpload, onBody);
+    _ownedHandlers.emplace_back(handler);
+    _handlers.push_back(handler);
+    return *handler;
+}
+
+AsyncWebHandler& AsyncWebServer::addHandler(AsyncWebHandler* handler) {
+    _handlers.push_back(handler);
+    return *handler;
+}
+
+void AsyncWebServer::acceptLoop() {
+    while (_running) {
+        sockaddr_in peer = {};
+        socklen_t peerLen = sizeof(peer);
+        int fd = accept(_listenFd, (sockaddr*)&peer, &peerLen);
+        if (fd < 0) {
+            if (!_running) break;
+            continue;
+        }
+        
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        
+        uint32_t raw = peer.sin_addr.s_addr;
+        IPAddress ip(raw & 0xFF, (raw >> 8) & 0xFF, (raw >> 16) & 0xFF, raw >> 24);
+        std::thread(&AsyncWebServer::handleConnection, this, fd, ip, ntohs(peer.sin_port)).detach();
+    }
+}
+
+// Розбір multipart/form-data: поля -> параметри, файли -> handleUpload частинами
+static void parseMultipart(AsyncWebServerRequest* request, AsyncWebHandler* handler, const std::string& body) {
+    const String& type = request->contentType();
+    int b = type.indexOf("boundary=");
+    if (b < 0) return;
+    std::string boundary = "--" + type.substring(b + 9).str();
+    if (boundary.size() > 2 && boundary[2] == '"') {
+        boundary = "--" + boundary.substr(3, boundary.find('"', 3) - 3);
+    }
+    
+    size_t pos = body.find(boundary);
+    while (pos != std::string::npos) {
+        pos += boundary.size();
+        if (body.compare(pos, 2, "--") == 0) break;
+        pos += 2;
+        
+        size_t headEnd = body.find("\r\n\r\n", pos);
+        if (headEnd == std::string::npos) break;
+        std::string head = body.substr(pos, headEnd - pos);
+        size_t dataStart = headEnd + 4;
+        size_t next = body.find("\r\n" + boundary, dataStart);
+        if (next == std::string::npos) break;
+        
+        auto attr = [&head](const char* key) -> std::string {
+            std::string k = std::string(key) + "=\"";
+            size_t p = head.find(k);
+            if (p == std::string::npos) return "";
+            p += k.size();
+            return head.substr(p, head.find('"', p) - p);
+        };
+        
+        std::string name = attr("name");
+        std::string filename = attr("filename");
+        size_t len = next - dataStart;
+        
+        if (head.find("filename=") != std::string::npos) {
+            size_t index = 0;
+            do {
+                size_t n = std::min<size_t>(SIM_UPLOAD_CHUNK, len - index);
+                bool final = index + n >= len;
+                handler->handleUpload(request, String(filename), index,
+                                      (uint8_t*)&body[dataStart + index], n, final);
+                index += n;
+            } while (index < len);
+        } else {
+            request->simParseForm(name + "=" + body.substr(dataStart, len), true);
+        }
+        
+        pos = next + 2;
+    }
+}
+
+void AsyncWebServer::handleConnection(int fd, IPAddress ip, uint16_t port) {
+    timeval tv = {10, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    
+    // Заголовки
+    std::string buf;
+    size_t headEnd = std::string::npos;
+    char chunk[2048];
+    while (headEnd == std::string::npos && buf.size() < SIM_HTTP_MAX_HEAD) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) { ::close(fd); return; }
+        buf.append(chunk, n);
+        headEnd = buf.find("\r\n\r\n");
+    }
+    if (headEnd == std::string::npos) { ::close(fd); return; }
+    
+    std::unique_ptr<AsyncWebServerRequest> request(new AsyncWebServerRequest());
+    request->_client._ip = ip;
+    request->_client._port = port;
+    if (!request->simParse(buf.substr(0, headEnd))) {
+        AsyncWebServerResponse(400, "text/plain").simWrite(fd);
+        ::close(fd);
+        return;
+    }
+    
+    // Тіло
+    std::string body = buf.substr(headEnd + 4);
+    size_t total = request->contentLength();
+    if (total > SIM_HTTP_MAX_BODY) {
+        AsyncWebServerResponse(413, "text/plain").simWrite(fd);
+        ::close(fd);
+        return;
+    }
+    if (body.size() < total) {
+        size_t have = body.size();
+        body.resize(total);
+        if (!readAll(fd, &body[have], total - have)) { ::close(fd); return; }
+    }
+    body.resize(total);
+    
+    // Пошук обробника
+    AsyncWebHandler* handler = NULL;
+    {
+        std::lock_guard<std::recursive_mutex> lock(simAsyncLock());
+        for (AsyncWebHandler* h : _handlers) {
+            if (h->canHandle(request.get())) { handler = h; break; }
+        }
+    }
+    
+    // WebSocket / SSE тримають з'єднання самі
+    if (handler && handler->simTakeConnection(request.get(), fd)) {
+        request.reset();
+        ::close(fd);
+        return;
+    }
+    
+    {
+        std::lock_guard<std::recursive_mutex> lock(simAsyncLock());
+        const String& type = request->contentType();
+        
+        if (handler) {
+            if (type.startsWith("application/x-www-form-urlencoded")) {
+                request->simParseForm(body, true);
+            } else if (type.startsWith("multipart/form-data")) {
+                parseMultipart(request.get(), handler, body);
+            } else if (!body.empty()) {
+                for (size_t index = 0; index < body.size(); index += SIM_UPLOAD_CHUNK) {
+                    size_t n = std::min<size_t>(SIM_UPLOAD_CHUNK, body.size() - index);
+                    handler->handleBody(request.get(), (uint8_t*)&body[index], n, index, body.size());
+                }
+            }
+            request->_body = body;
+            handler->handleRequest(request.get());
+        } else if (_onBody && !body.empty()) {
+            _onBody(request.get(), (uint8_t*)&body[0], body.size(), 0, body.size());
+        }
+        
+        if (!handler) {
+            if (_notFound) _notFound(request.get());
+            else request->send(404);
+        }
+        
+        if (!request->_response) request->send(500, "text/plain", "No response");
+    }
+    
+    if (request->method() == HTTP_HEAD) {
+        request->_response->_body.clear();
+    }
+    request->_response->simWrite(fd);
+    
+    {
+        std::lock_guard<std::recursive_mutex> lock(simAsyncLock());
+        request.reset();
+    }
+    shutdown(fd, SHUT_WR);
+    ::close(fd);
+}
+
+// ========================================
+// WEBSOCKET
+// ========================================
+
+AsyncWebSocketClient::AsyncWebSocketClient(AsyncWebSocket* server, int fd, uint32_t id, IPAddress ip)
+    : _server(server), _fd(fd), _id(id), _ip(ip), _status(WS_CONNECTED) {}
+
+AsyncWebSocketClient::~AsyncWebSocketClient() {
+    releaseQueue();
+}
+
+bool AsyncWebSocketClient::sendFrame(uint8_t opcode, const uint8_t* data, size_t len) {
+    uint8_t head[10];
+    size_t headLen = 2;
+    head[0] = 0x80 | opcode;
+    if (len < 126) {
+        head[1] = len;
+    } else if (len < 65536) {
+        head[1] = 126;
+        head[2] = len >> 8;
+        head[3] = len;
+        headLen = 4;
+    } else {
+        head[1] = 127;
+        for (int i = 0; i < 8; i++) head[2 + i] = (uint64_t)len >> (56 - i * 8);
+        headLen = 10;
+    }
+    
+    std::lock_guard<std::mutex> lock(_sendLock);
+    return writeAll(_fd, head, headLen) && (len == 0 || writeAll(_fd, data, len));
+}
+
+void AsyncWebSocketClient::enqueue(uint8_t opcode, const uint8_t* data, size_t len, AsyncWebSocketMessageBuffer* shared) {
+    if (_status != WS_CONNECTED) return;
+    
+    std::lock_guard<std::mutex> lock(_queueLock);
+    if (_queue.size() >= WS_MAX_QUEUED_MESSAGES) {
+        // Як і ESPAsyncWebServer - повідомлення відкидається
+        fprintf(stderr, "[SIM] WS #%u: Too many messages queued\n", _id);
+        return;
+    }
+    if (shared) {
+        (*shared)++;
+        _queue.push_back({opcode, std::string(), shared});
+    } else {
+        _queue.push_back({opcode, std::string((const char*)data, len), NULL});
+    }
+    _queueChanged.notify_one();
+}
+
+// Невідправлені кадри зі спільним буфером більше його не тримають
+void AsyncWebSocketClient::releaseQueue() {
+    std::lock_guard<std::mutex> lock(_queueLock);
+    for (auto& msg : _queue) {
+        if (msg.shared) (*msg.shared)--;
+    }
+    _queue.clear();
+}
+
+void AsyncWebSocketClient::text(const char* message, size_t len) {
+    enqueue(WS_TEXT, (const uint8_t*)message, len);
+}
+
+void AsyncWebSocketClient::text(AsyncWebSocketMessageBuffer* buffer) {
+    if (buffer) enqueue(WS_TEXT, NULL, 0, buffer);
+}
+
+void AsyncWebSocketClient::binary(const uint8_t* data, size_t len) {
+    enqueue(WS_BINARY, data, len);
+}
+
+void AsyncWebSocketClient::ping(const uint8_t* data, size_t len) {
+    enqueue(WS_PING, data, len);
+}
+
+void AsyncWebSocketClient::close(uint16_t code, const char* message) {
+    if (_status != WS_CONNECTED) return;
+    _status = WS_DISCONNECTING;
+    
+    uint8_t payload[125];
+    size_t len = 0;
+    if (code) {
+        payload[0] = code >> 8;
+        payload[1] = code;
+        len = 2;
+        if (message) {
+            size_t m = std::min<size_t>(strlen(message), sizeof(payload) - 2);
+            memcpy(payload + 2, message, m);
+            len += m;
+        }
+    }
+    sendFrame(WS_DISCONNECT, payload, len);
+    shutdown(_fd, SHUT_RDWR);
+    _queueChanged.notify_all();
+}
+
+size_t AsyncWebSocketClient::queueLen() {
+    std::lock_guard<std::mutex> lock(_queueLock);
+    return _queue.size();
+}
+
+bool AsyncWebSocketClient::queueIsFull() {
+    return queueLen() >= WS_MAX_QUEUED_MESSAGES || _status != WS_CONNECTED;
+}
+
+void AsyncWebSocketClient::writerLoop() {
+    while (true) {
+        Message msg;
+        {
+            std::unique_lock<std::mutex> lock(_queueLock);
+            _queueChanged.wait(lock, [this] { return !_queue.empty() || _status == WS_DISCONNECTED; });
+            if (_queue.empty()) return;
+            msg = std::move(_queue.front());
+            _queue.pop_front();
+        }
+        
+        bool sent;
+        if (msg.shared) {
+            sent = sendFrame(msg.opcode, msg.shared->get(), msg.shared->length());
+            (*msg.shared)--;
+        } else {
+            sent = sendFrame(msg.opcode, (const uint8_t*)msg.data.data(), msg.data.size());
+        }
+        if (!sent) {
+            shutdown(_fd, SHUT_RDWR);
+            return;
+        }
+    }
+}
+
+void AsyncWebSocketClient::simRun() {
+    std::thread writer(&AsyncWebSocketClient::writerLoop, this);
+    
+    std::string message;
+    uint8_t messageOpcode = 0;
+    
+    while (true) {
+        uint8_t head[2];
+        if (!readAll(_fd, head, 2)) break;
+        
+        bool fin = head[0] & 0x80;
+        uint8_t opcode = head[0] & 0x0F;
+        bool masked = head[1] & 0x80;
+        uint64_t len = head[1] & 0x7F;
+        
+        if (len == 126) {
+            uint8_t ext[2];
+            if (!readAll(_fd, ext, 2)) break;
+            len = (ext[0] << 8) | ext[1];
+        } else if (len == 127) {
+            uint8_t ext[8];
+            if (!readAll(_fd, ext, 8)) break;
+            len = 0;
+            for (int i = 0; i < 8; i++) len = (len << 8) | ext[i];
+        }
+        if (len > SIM_WS_MAX_FRAME) break;
+        
+        uint8_t mask[4] = {0, 0, 0, 0};
+        if (masked && !readAll(_fd, mask, 4)) break;
+        
+        std::string payload(len, 0);
+        if (len && !readAll(_fd, &payload[0], len)) break;
+        for (size_t i = 0; i < len; i++) payload[i] ^= mask[i & 3];
+        
+        if (opcode == WS_DISCONNECT) {
+            if (_status == WS_CONNECTED) {
+                _status = WS_DISCONNECTING;
+                sendFrame(WS_DISCONNECT, (const uint8_t*)payload.data(), std::min<size_t>(payload.size(), 2));
+            }
+            break;
+        }
+        if (opcode == WS_PING) {
+            enqueue(WS_PONG, (const uint8_t*)payload.data(), payload.size());
+            continue;
+        }
+        if (opcode == WS_PONG) {
+            _server->simEvent(this, WS_EVT_PONG, NULL, (uint8_t*)&payload[0], payload.size());
+            continue;
+        }
+        
+        // Фрагментовані повідомлення збираються і віддаються одним кадром
+        if (opcode != WS_CONTINUATION) {
+            message.clear();
+            messageOpcode = opcode;
+        }
+        message += payload;
+        if (!fin) continue;
+        
+        AwsFrameInfo info = {};
+        info.message_opcode = messageOpcode;
+        info.opcode = messageOpcode;
+        info.final = 1;
+        info.masked = masked;
+        info.index = 0;
+        info.len = message.size();
+        
+        // +1 байт: прошивка пише data[len] = 0
+        std::vector<uint8_t> data(message.begin(), message.end());
+        data.push_back(0);
+        _server->simEvent(this, WS_EVT_DATA, &info, data.data(), message.size());
+    }
+    
+    _status = WS_DISCONNECTED;
+    _queueChanged.notify_all();
+    shutdown(_fd, SHUT_RDWR);
+    writer.join();
+    releaseQueue();
+}
+
+size_t AsyncWebSocket::count() {
+    std::lock_guard<std::mutex> lock(_clientsLock);
+    size_t n = 0;
+    for (const auto& c : _clients) {
+        if (c->status() == WS_CONNECTED) n++;
+    }
+    return n;
+}
+
+AsyncWebSocketClient* AsyncWebSocket::client(uint32_t id) {
+    std::lock_guard<std::mutex> lock(_clientsLock);
+    for (const auto& c : _clients) {
+        if (c->id() == id && c->status() == WS_CONNECTED) return c.get();
+    }
+    return NULL;
+}
+
+void AsyncWebSocket::cleanupClients(uint16_t maxClients) {
+    std::shared_ptr<AsyncWebSocketClient> oldest;
+    {
+        std::lock_guard<std::mutex> lock(_clientsLock);
+        if (_clients.size() > maxClients) oldest = _clients.front();
+    }
+    if (oldest) oldest->close();
+}
+
+void AsyncWebSocket::closeAll(uint16_t code, const char* message) {
+    std::list<std::shared_ptr<AsyncWebSocketClient>> clients;
+    {
+        std::lock_guard<std::mutex> lock(_clientsLock);
+        clients = _clients;
+    }
+    for (auto& c : clients) c->close(code, message);
+}
+
+void AsyncWebSocket::text(uint32_t id, const char* message, size_t len) {
+    std::shared_ptr<AsyncWebSocketClient> target;
+    {
+        std::lock_guard<std::mutex> lock(_clientsLock);
+        for (const auto& c : _clients) {
+            if (c->id() == id) target = c;
+        }
+    }
+    if (target) target->text(message, len);
+}
+
+void AsyncWebSocket::textAll(const char* message, size_t len) {
+    std::list<std::shared_ptr<AsyncWebSocketClient>> clients;
+    {
+        std::lock_guard<std::mutex> lock(_clientsLock);
+        clients = _clients;
+    }
+    for (auto& c : clients) c->text(message, len);
+}
+
+void AsyncWebSocket::textAll(AsyncWebSocketMessageBuffer* buffer) {
+    if (!buffer) return;
+    
+    std::list<std::shared_ptr<AsyncWebSocketClient>> clients;
+    {
+        std::lock_guard<std::mutex> lock(_clientsLock);
+        clients = _clients;
+    }
+    buffer->lock();
+    for (auto& c : clients) {
+        if (c->status() == WS_CONNECTED) c->text(buffer);
+    }
+    buffer->unlock();
+    cleanBuffers();
+}
+
+AsyncWebSocketMessageBuffer* AsyncWebSocket::makeBuffer(size_t size) {
+    AsyncWebSocketMessageBuffer* buffer = new AsyncWebSocketMessageBuffer(size);
+    std::lock_guard<std::mutex> lock(_clientsLock);
+    _buffers.push_back(buffer);
+    return buffer;
+}
+
+AsyncWebSocketMessageBuffer* AsyncWebSocket::makeBuffer(uint8_t* data, size_t size) {
+    AsyncWebSocketMessageBuffer* buffer = new AsyncWebSocketMessageBuffer(data, size);
+    std::lock_guard<std::mutex> lock(_clientsLock);
+    _buffers.push_back(buffer);
+    return buffer;
+}
+
+void AsyncWebSocket::cleanBuffers() {
+    std::lock_guard<std::mutex> lock(_clientsLock);
+    _buffers.remove_if([](AsyncWebSocketMessageBuffer* b) {
+        if (!b->canDelete()) return false;
+        delete b;
+        return true;
+    });
+}
+
+bool AsyncWebSocket::availableForWriteAll() {
+    std::lock_guard<std::mutex> lock(_clientsLock);
+    for (const auto& c : _clients) {
+        if (c->queueIsFull()) return false;
+    }
+    return true;
+}
+
+bool AsyncWebSocket::canHandle(AsyncWebServerRequest* request) {
+    return _enabled && request->method() == HTTP_GET && request->url() == _url &&
+           request->hasHeader("Upgrade") && request->header("Upgrade").equalsIgnoreCase("websocket");
+}
+
+bool AsyncWebSocket::simTakeConnection(AsyncWebServerRequest* request, int fd) {
+    if (!request->hasHeader("Sec-WebSocket-Key")) {
+        AsyncWebServerResponse(400, "text/plain").simWrite(fd);
+        return true;
+    }
+    
+    std::string key = request->header("Sec-WebSocket-Key").str() + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    uint8_t digest[20];
+    sha1((const uint8_t*)key.data(), key.size(), digest);
+    
+    std::string head = "HTTP/1.1 101 Switching Protocols\r\n"
+                       "Upgrade: websocket\r\n"
+                       "Connection: Upgrade\r\n"
+                       "Sec-WebSocket-Accept: " + base64(digest, 20) + "\r\n\r\n";
+    if (!writeAll(fd, head.data(), head.size())) return true;
+    
+    // Без таймауту читання - клієнт може мовчати скільки завгодно
+    timeval tv = {0, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    int sndbuf = SIM_WS_SNDBUF;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    
+    auto client = std::make_shared<AsyncWebSocketClient>(this, fd, _nextId++, request->client()->remoteIP());
+    {
+        std::lock_guard<std::mutex> lock(_clientsLock);
+        _clients.push_back(client);
+    }
+    
+    simEvent(client.get(), WS_EVT_CONNECT, request, NULL, 0);
+    client->simRun();
+    simEvent(client.get(), WS_EVT_DISCONNECT, NULL, NULL, 0);
+    simRemove(client.get());
+    return true;
+}
+
+void AsyncWebSocket::simEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    if (!_handler) return;
+    std::lock_guard<std::recursive_mutex> lock(simAsyncLock());
+    _handler(this, client, type, arg, data, len);
+}
+
+void AsyncWebSocket::simRemove(AsyncWebSocketClient* client) {
+    std::lock_guard<std::mutex> lock(_clientsLock);
+    _clients.remove_if([client](const std::shared_ptr<AsyncWebSocketClient>& c) { return c.get() == client; });
+}
+
+// ========================================
+// SERVER-SENT EVENTS
+// ========================================
+
+static std::string eventMessage(const char* message, const char* event, uint32_t id, uint32_t reconnect) {
+    std::string out;
+    if (reconnect) out += "retry: " + std::to_string(reconnect) + "\r\n";
+    if (id) out += "id: " + std::to_string(id) + "\r\n";
+    if (event) out += std::string("event: ") + event + "\r\n";
+    if (message) {
+        std::string msg(message);
+        size_t pos = 0;
+        while (true) {
+            size_t nl = msg.find('\n', pos);
+            out += "data: " + msg.substr(pos, nl == std::string::npos ? std::string::npos : nl - pos) + "\r\n";
+            if (nl == std::string::npos) break;
+            pos = nl + 1;
+        }
+    }
+    out += "\r\n";
+    return out;
+}
+
+AsyncEventSourceClient::AsyncEventSourceClient(AsyncEventSource* server, int fd, uint32_t lastId)
+    : _server(server), _fd(fd), _lastId(lastId) {}
+
+AsyncEventSourceClient::~AsyncEventSourceClient() {}
+
+void AsyncEventSourceClient::write(const std::string& data) {
+    if (!_connected) return;
+    std::lock_guard<std::mutex> lock(_queueLock);
+    if (_queue.size() >= SSE_MAX_QUEUED_MESSAGES) {
+        fprintf(stderr, "[SIM] SSE: Too many messages queued\n");
+        return;
+    }
+    _queue.push_back(data);
+    _queueChanged.notify_one();
+}
+
+void AsyncEventSourceClient::send(const char* message, const char* event, uint32_t id, uint32_t reconnect) {
+    write(eventMessage(message, event, id, reconnect));
+}
+
+void AsyncEventSourceClient::close() {
+    _connected = false;
+    shutdown(_fd, SHUT_RDWR);
+    _queueChanged.notify_all();
+}
+
+size_t AsyncEventSourceClient::packetsWaiting() {
+    std::lock_guard<std::mutex> lock(_queueLock);
+    return _queue.size();
+}
+
+void AsyncEventSourceClient::simRun() {
+    while (_connected) {
+        std::string data;
+        {
+            std::unique_lock<std::mutex> lock(_queueLock);
+            _queueChanged.wait_for(lock, std::chrono::milliseconds(100),
+                                   [this] { return !_queue.empty() || !_connected; });
+            if (!_queue.empty()) {
+                data = std::move(_queue.front());
+                _queue.pop_front();
+            }
+        }
+        if (!data.empty() && !writeAll(_fd, data.data(), data.size())) break;
+        
+        // Виявлення закриття з'єднання клієнтом
+        pollfd p = {_fd, POLLIN, 0};
+        if (poll(&p, 1, 0) > 0) {
+            char tmp[64];
+            if (recv(_fd, tmp, sizeof(tmp), MSG_DONTWAIT) <= 0) break;
+        }
+    }
+    _connected = false;
+}
+
+void AsyncEventSource::close() {
+    std::list<std::shared_ptr<AsyncEventSourceClient>> clients;
+    {
+        std::lock_guard<std::mutex> lock(_clientsLock);
+        clients = _clients;
+    }
+    for (auto& c : clients) c->close();
+}
+
+void AsyncEventSource::send(const char* message, const char* event, uint32_t id, uint32_t reconnect) {
+    std::list<std::shared_ptr<AsyncEventSourceClient>> clients;
+    {
+        std::lock_guard<std::mutex> lock(_clientsLock);
+        clients = _clients;
+    }
+    for (auto& c : clients) c->send(message, event, id, reconnect);
+}
+
+size_t AsyncEventSource::count() {
+    std::lock_guard<std::mutex> lock(_clientsLock);
+    size_t n = 0;
+    for (const auto& c : _clients) {
+        if (c->connected()) n++;
+    }
+    return n;
+}
+
+size_t AsyncEventSource::avgPacketsWaiting() {
+    std::list<std::shared_ptr<AsyncEventSourceClient>> clients;
+    {
+        std::lock_guard<std::mutex> lock(_clientsLock);
+        clients = _clients;
+    }
+    if (clients.empty()) return 0;
+    size_t total = 0;
+    for (auto& c : clients) total += c->packetsWaiting();
+    return (total + clients.size() - 1) / clients.size();
+}
+
+bool AsyncEventSource::canHandle(AsyncWebServerRequest* request) {
+    return request->method() == HTTP_GET && request->url() == _url;
+}
+
+bool AsyncEventSource::simTakeConnection(AsyncWebServerRequest* request, int fd) {
+    uint32_t lastId = 0;
+    if (request->hasHeader("Last-Event-ID")) {
+        lastId = strtoul(request->header("Last-Event-ID").c_str(), nullptr, 10);
+    }
+    
+    const char* head = "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/event-stream\r\n"
+                       "Cache-Control: no-cache\r\n"
+                       "Connection: keep-alive\r\n\r\n";
+    if (!writeAll(fd, head, strlen(head))) return true;
+    
+    auto client = std::make_shared<AsyncEventSourceClient>(this, fd, lastId);
+    {
+        std::lock_guard<std::mutex> lock(_clientsLock);
+        _clients.push_back(client);
+    }
+    
+    if (_connectCb) {
+        std::lock_guard<std::recursive_mutex> lock(simAsyncLock());
+        _connectCb(client.get());
+    }
+    
+    client->simRun();
+    simRemove(client.get());
+    return true;
+}
+
+void AsyncEventSource::simRemove(AsyncEventSourceClient* client) {
+    std::lock_guard<std::mutex> lock(_clientsLock);
+    _clients.remove_if([client](const std::shared_ptr<AsyncEventSourceClient>& c) { return c.get() == client; });
+}
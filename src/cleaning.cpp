@@ -0,0 +1,297 @@
+#include "cleaning.h"
+#include "control.h"
+#include "safety.h"
+#include "power.h"
+#include "manifold.h"
+
+#if ENABLE_WIFI
+#include "network.h"
+#endif
+
+static_assert(PRIME_MAX_TIME < MAX_POUR_TIME, "prime must stop before the pump cutoff");
+
+extern SystemState g_systemState;
+extern uint8_t g_selectedShot;
+extern bool g_glassPresent[GLASS_COUNT];
+extern float g_pumpRate;
+extern float g_primeVolume;
+extern Servo servo;
+
+static const CleanProgram programs[] = {
+    {"flush", 3000, 0,    1, 255, "3 s continuous per glass"},
+    {"clean", 1500, 1000, 4, 255, "4 pulses of 1.5 s per glass"},
+    {"soak",  400,  4000, 3, 160, "3 short slow shots, 4 s soak"},
+};
+
+enum CleanPhase : uint8_t {
+    PHASE_MOVE = 0,     // Серво їде до позиції
+    PHASE_PUMP,         // Помпа працює
+    PHASE_REST          // Пауза між імпульсами
+};
+
+static volatile bool running = false;
+static const CleanProgram *program = NULL;  // NULL - прокачка
+static uint8_t shotMask = 0;                // Ще не відвідані позиції (біт 0 = рюмка 1)
+static uint8_t shot = 0;
+static uint8_t cycle = 0;
+static CleanPhase phase = PHASE_MOVE;
+static unsigned long phaseStart = 0;
+
+// Трубка: заповнена чи злита
+static bool primed = false;
+static unsigned long primedAt = 0;
+
+// ========================================
+// ПОМПА І ПОЗИЦІЇ
+// ========================================
+
+static void pumpOn(uint8_t duty) {
+#if MANIFOLD_CHANNELS
+    // Колектор: вихід цієї рюмки
+    manifoldWrite(shot, duty);
+#else
+    safetyPumpOn();
+    ledcWrite(PUMP_CHANNEL, duty);
+#endif
+    phase = PHASE_PUMP;
+    phaseStart = millis();
+}
+
+static void pumpOff() {
+#if MANIFOLD_CHANNELS
+    manifoldWrite(shot, 0);
+#else
+    ledcWrite(PUMP_CHANNEL, 0);
+    safetyPumpOff();
+#endif
+}
+
+static void moveTo(uint8_t next) {
+    shot = next;
+    shotMask &= ~(1 << (next - 1));
+    cycle = 0;
+    servo.write(shotPosition(next));
+    phase = PHASE_MOVE;
+    phaseStart = millis();
+}
+
+// Наступна позиція з рюмкою. false - обійдено всі
+static bool moveNext() {
+    for (uint8_t i = 0; i < GLASS_COUNT; i++) {
+        if ((shotMask & (1 << i)) && g_glassPresent[i]) {
+            moveTo(i + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void finish() {
+    pumpOff();
+    safetyRelease();
+    servo.write(POS_PARKING);
+    running = false;
+    tubeMarkPrimed();
+    
+    if (g_systemState == STATE_CLEANING) g_systemState = STATE_IDLE;
+
+#if ENABLE_WIFI
+    broadcastState();
+#endif
+}
+
+// Сервісний цикл можна почати тільки з простою
+static bool canStart() {
+    if (g_systemState != STATE_IDLE && g_systemState != STATE_READY) {
+        LOG_W("Busy: %s", g_systemState == STATE_CLEANING ? "cleaning in progress" : "pour in progress");
+        return false;
+    }
+    return true;
+}
+
+// ========================================
+// ПРОКАЧКА
+// ========================================
+
+bool primeStart() {
+    if (!canStart()) return false;
+#if MANIFOLD_CHANNELS
+    if (g_selectedShot > MANIFOLD_CHANNELS) {
+        LOG_W("Shot %d has no manifold output", g_selectedShot);
+        return false;
+    }
+#endif
+    if (!g_glassPresent[g_selectedShot - 1]) {
+        LOG_W("No glass detected!");
+        return false;
+    }
+    
+    powerWake();
+    
+    program = NULL;
+    shotMask = 0;
+    moveTo(g_selectedShot);
+    running = true;
+    g_systemState = STATE_CLEANING;
+    
+    LOG_I("Prime: shot %d, stop when liquid reaches the spout", g_selectedShot);
+
+#if ENABLE_WIFI
+    broadcastState();
+#endif
+    return true;
+}
+
+bool primeFinish() {
+    if (!running || program != NULL) return false;
+    
+    if (phase == PHASE_PUMP) {
+        // Помпу вже знеструмив ISR кнопки START - об'єм до того моменту
+        unsigned long stoppedAt = safetyHaltMs() != 0 ? safetyHaltMs() : millis();
+        float ml = stoppedAt > phaseStart ? (stoppedAt - phaseStart) * g_pumpRate / 1000 : 0;
+        if (ml <= PRIME_ML_MAX) {
+            setPrimeVolume(ml);
+            LOG_I("Prime: dead volume %.1f ml", ml);
+        } else {
+            LOG_W("Prime: %.1f ml is over %.0f ml, dead volume kept", ml, PRIME_ML_MAX);
+        }
+    }
+    
+    finish();
+    return true;
+}
+
+// ========================================
+// ПРОГРАМИ
+// ========================================
+
+bool cleanStart(const char* name) {
+    const CleanProgram *found = NULL;
+    for (const CleanProgram &p : programs) {
+        if (strcmp(p.name, name) == 0) found = &p;
+    }
+    if (found == NULL) {
+        LOG_W("Unknown cleaning program: %s", name);
+        return false;
+    }
+    if (!canStart()) return false;
+    
+    uint8_t mask = 0;
+    for (int i = 0; i < GLASS_COUNT; i++) {
+        if (g_glassPresent[i]) mask |= 1 << i;
+    }
+#if MANIFOLD_CHANNELS
+    mask &= (1 << MANIFOLD_CHANNELS) - 1;
+#endif
+    if (mask == 0) {
+        LOG_W("No glass detected!");
+        return false;
+    }
+    
+    powerWake();
+    
+    program = found;
+    shotMask = mask;
+    moveNext();
+    running = true;
+    g_systemState = STATE_CLEANING;
+    
+    uint8_t glasses = 0;
+    for (int i = 0; i < GLASS_COUNT; i++) glasses += (mask >> i) & 1;
+    unsigned long total = (unsigned long)glasses *
+        (CLEAN_MOVE_MS + program->cycles * (program->onMs + program->offMs));
+    LOG_I("Cleaning: %s, %d glasses, ~%lu s", program->name, glasses, total / 1000);
+
+#if ENABLE_WIFI
+    broadcastState();
+#endif
+    return true;
+}
+
+void updateCleaning() {
+    if (!running) return;
+    
+    // stopPour(), відсічка або оновлення прошивки вже зупинили помпу
+    if (g_systemState != STATE_CLEANING) {
+        running = false;
+        return;
+    }
+    
+    unsigned long elapsed = millis() - phaseStart;
+    
+    // Рюмку (ємність) зняли - помпа стоп, далі наступна позиція
+    if (!g_glassPresent[shot - 1]) {
+        pumpOff();
+        LOG_W("Cleaning: glass %d removed", shot);
+        if (program == NULL || !moveNext()) finish();
+        return;
+    }
+    
+    switch (phase) {
+        case PHASE_MOVE:
+            if (elapsed >= CLEAN_MOVE_MS) pumpOn(program ? program->duty : PUMP_SPEED_DEFAULT);
+            break;
+        
+        case PHASE_PUMP:
+            if (program == NULL) {
+                // Користувач так і не зупинив: трубка точно повна, об'єм не змінюється
+                if (elapsed >= PRIME_MAX_TIME) {
+                    LOG_W("Prime: not stopped in %d ms, dead volume kept", PRIME_MAX_TIME);
+                    finish();
+                }
+                break;
+            }
+            if (elapsed < program->onMs) break;
+            
+            pumpOff();
+            if (++cycle < program->cycles) {
+                phase = PHASE_REST;
+                phaseStart = millis();
+            } else if (!moveNext()) {
+                LOG_I("Cleaning: %s done", program->name);
+                finish();
+            }
+            break;
+        
+        case PHASE_REST:
+            if (elapsed >= program->offMs) pumpOn(program->duty);
+            break;
+    }
+}
+
+// ========================================
+// ТРУБКА
+// ========================================
+
+bool tubePrimed() {
+    return primed && millis() - primedAt < PRIME_HOLD_TIME;
+}
+
+void tubeMarkPrimed() {
+    primed = true;
+    primedAt = millis();
+}
+
+void setPrimeVolume(float ml) {
+    if (ml < 0 || ml > PRIME_ML_MAX) return;
+    g_primeVolume = ml;
+    
+    extern void saveSettings();
+    saveSettings();
+}
+
+// ========================================
+// СТАТУС
+// ========================================
+
+const char* cleanProgramName() {
+    if (!running) return NULL;
+    return program ? program->name : "prime";
+}
+
+void printCleanPrograms(Print &out) {
+    for (const CleanProgram &p : programs) {
+        out.printf("  %-6s %s\n", p.name, p.description);
+    }
+    out.printf("Dead volume: %.1f ml, tube %s\n", g_primeVolume, tubePrimed() ? "primed" : "drained");
+}
@@ -0,0 +1,805 @@
+#include "commands.h"
+#include "control.h"
+#include "storage.h"
+#include "safety.h"
+#include "power.h"
+#include "cleaning.h"
+#include "manifold.h"
+#include "recipes.h"
+#include "glass_sensor.h"
+
+#if ENABLE_WIFI
+#include "network.h"
+#endif
+
+#if ENABLE_WIFI && ENABLE_FLEET
+#include "fleet.h"
+#endif
+
+extern SystemState g_systemState;
+extern PourMode g_pourMode;
+extern uint16_t g_targetVolume;
+extern uint8_t g_selectedShot;
+extern uint8_t g_selectedRecipe;
+extern Statistics g_stats;
+extern float g_primeVolume;
+extern TaskHandle_t uiTaskHandle;
+extern TaskHandle_t controlTaskHandle;
+
+// Обробник отримує лише аргументи - після імені та підкоманди
+typedef CommandResult (*CommandHandler)(int argc, const char* const *argv, Print &out);
+
+struct CommandDef {
+    const char* name;
+    const char* sub;            // Друге слово (wifi set) або NULL
+    uint8_t minArgs;
+    uint8_t maxArgs;
+    CommandHandler handler;
+    const char* usage;          // Аргументи для help
+    const char* help;
+};
+
+// Рядок Serial збирається між викликами updateCommands()
+static char serialLine[CMD_LINE_MAX];
+static size_t serialLen = 0;
+static bool serialOverflow = false;
+
+// restart з WebSocket/HTTP - після відповіді, з loop()
+static unsigned long restartAt = 0;
+
+// Ідемпотентні сетери: слайдер веб-інтерфейсу шле команду на кожен крок.
+// Зберігається лише останнє значення, у NVS і розсилку - з loop()
+enum CommandSetter : uint8_t {
+    SETTER_VOLUME = 0,
+    SETTER_MODE,
+    SETTER_SHOT,
+    SETTER_COUNT
+};
+
+static portMUX_TYPE setterMux = portMUX_INITIALIZER_UNLOCKED;
+static long setterValue[SETTER_COUNT];
+static uint8_t setterPending = 0;           // Біт на сетер
+static unsigned long setterFlushAt = 0;
+static uint32_t settersReceived = 0;
+static uint32_t settersApplied = 0;
+
+// ========================================
+// АРГУМЕНТИ
+// ========================================
+
+static bool argInt(const char* s, long min, long max, long &out) {
+    char *end = NULL;
+    long value = strtol(s, &end, 10);
+    if (end == s || *end != 0 || value < min || value > max) return false;
+    
+    out = value;
+    return true;
+}
+
+static bool argFloat(const char* s, float min, float max, float &out) {
+    char *end = NULL;
+    float value = strtof(s, &end);
+    if (end == s || *end != 0 || value < min || value > max) return false;
+    
+    out = value;
+    return true;
+}
+
+static void changed() {
+#if ENABLE_WIFI
+    broadcastState();
+#endif
+}
+
+static void setterPut(CommandSetter setter, long value) {
+    portENTER_CRITICAL(&setterMux);
+    setterValue[setter] = value;
+    setterPending |= 1 << setter;
+    settersReceived++;
+    portEXIT_CRITICAL(&setterMux);
+}
+
+void commandFlushSetters() {
+    long values[SETTER_COUNT];
+    
+    portENTER_CRITICAL(&setterMux);
+    uint8_t pending = setterPending;
+    setterPending = 0;
+    memcpy(values, setterValue, sizeof(values));
+    portEXIT_CRITICAL(&setterMux);
+    
+    setterFlushAt = millis();
+    if (pending == 0) return;
+    
+    // Значення, що збігається з поточним (слайдер повернули назад), не пишеться
+    uint32_t applied = 0;
+    if ((pending & (1 << SETTER_VOLUME)) && values[SETTER_VOLUME] != g_targetVolume) {
+        setTargetVolume(values[SETTER_VOLUME]);
+        applied++;
+    }
+    if ((pending & (1 << SETTER_MODE)) && values[SETTER_MODE] != g_pourMode) {
+        setPourMode((PourMode)values[SETTER_MODE]);
+        applied++;
+    }
+    if ((pending & (1 << SETTER_SHOT)) && values[SETTER_SHOT] != g_selectedShot) {
+        selectShot(values[SETTER_SHOT]);
+        applied++;
+    }
+    
+    if (applied == 0) return;
+    
+    portENTER_CRITICAL(&setterMux);
+    settersApplied += applied;
+    portEXIT_CRITICAL(&setterMux);
+    changed();
+}
+
+uint32_t commandSettersReceived() {
+    return settersReceived;
+}
+
+uint32_t commandSettersApplied() {
+    return settersApplied;
+}
+
+// ========================================
+// ОБРОБНИКИ
+// ========================================
+
+static CommandResult cmdHelp(int argc, const char* const *argv, Print &out);
+
+static CommandResult cmdStats(int argc, const char* const *argv, Print &out) {
+    out.println("\n=== Statistics ===");
+    out.printf("Total pours: %d\n", g_stats.totalPours);
+    out.printf("Total volume: %d ml\n", g_stats.totalVolume);
+    out.printf("Total time: %d sec\n", g_stats.totalTime);
+    out.printf("Errors: %d\n", g_stats.errors);
+    out.printf("Setters: %lu received, %lu applied\n",
+               (unsigned long)commandSettersReceived(), (unsigned long)commandSettersApplied());
+    out.println("==================\n");
+    return CMD_OK;
+}
+
+static CommandResult cmdHeap(int argc, const char* const *argv, Print &out) {
+    out.println("\n=== Memory ===");
+    out.printf("Free Heap: %d bytes\n", ESP.getFreeHeap());
+    out.printf("Min Free Heap: %d bytes\n", ESP.getMinFreeHeap());
+    out.printf("Heap Size: %d bytes\n", ESP.getHeapSize());
+    out.println("==============\n");
+    return CMD_OK;
+}
+
+static CommandResult cmdTasks(int argc, const char* const *argv, Print &out) {
+    out.println("\n=== FreeRTOS Tasks ===");
+    out.printf("UI Task: %s\n", uiTaskHandle != NULL ? "Running" : "Stopped");
+    out.printf("Control Task: %s\n", controlTaskHandle != NULL ? "Running" : "Stopped");
+    out.printf("Free Heap: %d bytes\n", ESP.getFreeHeap());
+    out.println("======================\n");
+    return CMD_OK;
+}
+
+static CommandResult cmdReset(int argc, const char* const *argv, Print &out) {
+    resetStatistics();
+    out.println("Statistics reset!");
+    changed();
+    return CMD_OK;
+}
+
+static CommandResult cmdRestart(int argc, const char* const *argv, Print &out) {
+    out.println("Restarting...");
+    restartAt = millis() + 1000;
+    return CMD_OK;
+}
+
+static CommandResult cmdPour(int argc, const char* const *argv, Print &out) {
+    long vol = g_targetVolume;
+    if (argc > 0 && !argInt(argv[0], VOLUME_MIN, VOLUME_MAX, vol)) {
+        out.println("Invalid volume!");
+        return CMD_BAD_ARGS;
+    }
+    
+    // На паузі - продовження; об'єм стає поточним лише після прийнятого розливу
+    bool started = argc == 0 || g_systemState == STATE_PAUSED ? startPour() : startPourTo(g_selectedShot, vol);
+    if (!started) {
+        out.println("Busy or no glass!");
+        return CMD_FAILED;
+    }
+    if (vol != g_targetVolume) setterPut(SETTER_VOLUME, vol);
+    out.printf("Pouring %ld ml\n", vol);
+    return CMD_OK;
+}
+
+static CommandResult cmdVolume(int argc, const char* const *argv, Print &out) {
+    long vol;
+    if (!argInt(argv[0], VOLUME_MIN, VOLUME_MAX, vol)) {
+        out.printf("Volume must be %d-%d ml\n", VOLUME_MIN, VOLUME_MAX);
+        return CMD_BAD_ARGS;
+    }
+    
+    setterPut(SETTER_VOLUME, vol);
+    out.printf("Volume: %ld ml\n", vol);
+    return CMD_OK;
+}
+
+static CommandResult cmdMode(int argc, const char* const *argv, Print &out) {
+    long mode;
+    if (strcmp(argv[0], "manual") == 0) mode = MODE_MANUAL;
+    else if (strcmp(argv[0], "auto") == 0) mode = MODE_AUTO;
+    else if (!argInt(argv[0], MODE_MANUAL, MODE_AUTO, mode)) {
+        out.println("Mode must be manual|auto");
+        return CMD_BAD_ARGS;
+    }
+    
+    setterPut(SETTER_MODE, mode);
+    out.printf("Mode: %s\n", mode == MODE_MANUAL ? "manual" : "auto");
+    return CMD_OK;
+}
+
+static CommandResult cmdShot(int argc, const char* const *argv, Print &out) {
+    long shot;
+    if (!argInt(argv[0], 1, GLASS_COUNT, shot)) {
+        out.printf("Shot must be 1-%d\n", GLASS_COUNT);
+        return CMD_BAD_ARGS;
+    }
+    if (shotLocked()) {
+        out.println("Pour in progress!");
+        return CMD_FAILED;
+    }
+    
+    setterPut(SETTER_SHOT, shot);
+    out.printf("Shot: %ld\n", shot);
+    return CMD_OK;
+}
+
+static CommandResult cmdStart(int argc, const char* const *argv, Print &out) {
+    if (!startPour()) {
+        out.println("Busy or no glass!");
+        return CMD_FAILED;
+    }
+    out.println("OK");
+    return CMD_OK;
+}
+
+static CommandResult cmdStop(int argc, const char* const *argv, Print &out) {
+    stopPour();
+    out.println("OK");
+    return CMD_OK;
+}
+
+static CommandResult cmdPause(int argc, const char* const *argv, Print &out) {
+    if (!pausePour()) {
+        out.println("Not pouring!");
+        return CMD_FAILED;
+    }
+    out.printf("Paused: %d of %d ml\n", pourDispensedMl(), pourTargetMl());
+    return CMD_OK;
+}
+
+static CommandResult cmdResume(int argc, const char* const *argv, Print &out) {
+    if (!resumePour()) {
+        out.println("Not paused or no glass!");
+        return CMD_FAILED;
+    }
+    out.println("OK");
+    return CMD_OK;
+}
+
+static CommandResult cmdPrime(int argc, const char* const *argv, Print &out) {
+    if (!primeStart()) {
+        out.println("Busy or no glass!");
+        return CMD_FAILED;
+    }
+    out.println("Priming: 'prime stop' when liquid reaches the spout");
+    return CMD_OK;
+}
+
+static CommandResult cmdPrimeStop(int argc, const char* const *argv, Print &out) {
+    if (!primeFinish()) {
+        out.println("Not priming!");
+        return CMD_FAILED;
+    }
+    out.printf("Dead volume: %.1f ml\n", g_primeVolume);
+    return CMD_OK;
+}
+
+static CommandResult cmdPrimeSet(int argc, const char* const *argv, Print &out) {
+    float ml;
+    if (!argFloat(argv[0], 0, PRIME_ML_MAX, ml)) {
+        out.printf("Dead volume must be 0-%.0f ml\n", PRIME_ML_MAX);
+        return CMD_BAD_ARGS;
+    }
+    
+    setPrimeVolume(ml);
+    out.printf("Dead volume: %.1f ml\n", g_primeVolume);
+    return CMD_OK;
+}
+
+static CommandResult cmdClean(int argc, const char* const *argv, Print &out) {
+    if (argc == 0) {
+        out.println("Programs:");
+        printCleanPrograms(out);
+        return CMD_OK;
+    }
+    if (!cleanStart(argv[0])) {
+        out.println("Unknown program, busy or no glass!");
+        printCleanPrograms(out);
+        return CMD_FAILED;
+    }
+    out.println("OK");
+    return CMD_OK;
+}
+
+static CommandResult cmdRecipe(int argc, const char* const *argv, Print &out) {
+    if (argc == 0) {
+        printRecipes(out);
+        return CMD_OK;
+    }
+    if (!recipeSelectName(argv[0])) {
+#if MANIFOLD_CHANNELS
+        out.println("Recipes need the servo build (MANIFOLD_CHANNELS=0)");
+#else
+        out.println("Unknown recipe!");
+#endif
+        return CMD_BAD_ARGS;
+    }
+    
+    const char* name = recipeSelectedName();
+    const char* missing = NULL;
+    if (name != NULL && !recipeAvailable(*recipeAt(g_selectedRecipe), &missing)) {
+        out.printf("Recipe: %s (no pump with %s yet)\n", name, missing);
+    } else {
+        out.printf("Recipe: %s\n", name ? name : "off");
+    }
+    changed();
+    return CMD_OK;
+}
+
+static CommandResult cmdRecipeSet(int argc, const char* const *argv, Print &out) {
+    Recipe recipe;
+    if (strlen(argv[0]) >= RECIPE_NAME_LEN || !recipeParse(argv[1], recipe)) {
+        out.printf("Usage: recipe set NAME ING:PARTS[,ING:PARTS][/ING:PARTS] (%d ingredients)\n", RECIPE_STEPS_MAX);
+        return CMD_BAD_ARGS;
+    }
+    strlcpy(recipe.name, argv[0], sizeof(recipe.name));
+    
+    if (!recipeSave(recipe)) {
+        out.printf("Recipe book full (%d)!\n", RECIPES_MAX);
+        return CMD_FAILED;
+    }
+    out.printf("Recipe %s saved\n", recipe.name);
+    changed();
+    return CMD_OK;
+}
+
+static CommandResult cmdRecipeDel(int argc, const char* const *argv, Print &out) {
+    if (!recipeDelete(argv[0])) {
+        out.println("Unknown recipe!");
+        return CMD_FAILED;
+    }
+    out.println("Recipe deleted");
+    changed();
+    return CMD_OK;
+}
+
+static CommandResult cmdPump(int argc, const char* const *argv, Print &out) {
+    long pump;
+    float rate = 0;
+    if (!argInt(argv[0], 1, RECIPE_PUMPS, pump) ||
+        (argc > 2 && !argFloat(argv[2], PUMP_RATE_MIN, PUMP_RATE_MAX, rate))) {
+        out.printf("Usage: pump 1-%d INGREDIENT [ML/S]\n", RECIPE_PUMPS);
+        return CMD_BAD_ARGS;
+    }
+    
+    if (!pumpLoad(pump, argv[1], rate)) {
+        out.println("Invalid name or ingredient already in another pump!");
+        return CMD_FAILED;
+    }
+    out.printf("Pump %ld: %s, %.2f ml/s\n", pump, argv[1], pumpRate(pump));
+    return CMD_OK;
+}
+
+static CommandResult cmdQueue(int argc, const char* const *argv, Print &out) {
+    long shot;
+    long vol = g_targetVolume;
+    if (!argInt(argv[0], 1, GLASS_COUNT, shot) || (argc > 1 && !argInt(argv[1], VOLUME_MIN, VOLUME_MAX, vol))) {
+        out.println("Usage: queue SHOT [ML]");
+        return CMD_BAD_ARGS;
+    }
+    
+    if (!queuePour(shot, vol)) {
+        out.println("Queue full!");
+        return CMD_FAILED;
+    }
+    out.printf("Queued shot %ld, %ld ml (%d in queue)\n", shot, vol, pourQueueLength());
+    changed();
+    return CMD_OK;
+}
+
+static CommandResult cmdQueueClear(int argc, const char* const *argv, Print &out) {
+    clearPourQueue();
+    out.println("Queue cleared");
+    changed();
+    return CMD_OK;
+}
+
+static CommandResult cmdSafety(int argc, const char* const *argv, Print &out) {
+    out.println("\n=== Safety ===");
+    printSafetyStatus(out);
+    out.println("==============\n");
+    return CMD_OK;
+}
+
+static CommandResult cmdPower(int argc, const char* const *argv, Print &out) {
+    out.println("\n=== Power ===");
+    printPowerStatus(out);
+    out.println("=============\n");
+    return CMD_OK;
+}
+
+#if MANIFOLD_CHANNELS
+static CommandResult cmdManifold(int argc, const char* const *argv, Print &out) {
+    out.println("\n=== Manifold ===");
+    printManifoldStatus(out);
+    out.println("================\n");
+    return CMD_OK;
+}
+#endif
+
+#if GLASS_SENSOR_ANALOG
+static CommandResult cmdGlass(int argc, const char* const *argv, Print &out) {
+    out.println("\n=== Glass sensors ===");
+    printGlassSensors(out);
+    out.println("=====================\n");
+    return CMD_OK;
+}
+#endif
+
+static CommandResult cmdSafetyClear(int argc, const char* const *argv, Print &out) {
+    safetyClearFaults();
+    out.println("Fault records cleared");
+    return CMD_OK;
+}
+
+#if ENABLE_TRACE
+static CommandResult cmdTrace(int argc, const char* const *argv, Print &out) {
+    // Маркери - щоб витягнути JSON з потоку логів
+    out.println("\n=== TRACE BEGIN ===");
+    traceDump(out);
+    out.println("=== TRACE END ===\n");
+    return CMD_OK;
+}
+
+static CommandResult cmdTraceStats(int argc, const char* const *argv, Print &out) {
+    out.println("\n=== Trace ===");
+    out.printf("Control loop: %u iterations, %u missed\n",
+        traceLoops(TRACE_LOOP_CONTROL), traceMisses(TRACE_LOOP_CONTROL));
+    out.printf("UI loop: %u iterations, %u missed\n",
+        traceLoops(TRACE_LOOP_UI), traceMisses(TRACE_LOOP_UI));
+    for (int i = 0; i < TRACE_MISS_CONTROL; i++) {
+        out.printf("  %-14s max %lu us\n", tracePointName(i), (unsigned long)traceMaxUs(i));
+    }
+    out.println("=============\n");
+    return CMD_OK;
+}
+
+static CommandResult cmdTraceClear(int argc, const char* const *argv, Print &out) {
+    traceClear();
+    out.println("Trace cleared!");
+    return CMD_OK;
+}
+#endif
+
+#if ENABLE_WIFI
+static CommandResult cmdWifi(int argc, const char* const *argv, Print &out) {
+    out.println("\n=== WiFi ===");
+    printWifiStatus(out);
+    out.println("============\n");
+    return CMD_OK;
+}
+
+static CommandResult cmdWs(int argc, const char* const *argv, Print &out) {
+    out.println("\n=== WebSocket ===");
+    printWsStatus(out);
+    out.println("=================\n");
+    return CMD_OK;
+}
+
+static CommandResult cmdWifiSet(int argc, const char* const *argv, Print &out) {
+    const char* ssid = argv[0];
+    const char* pass = argc > 1 ? argv[1] : "";
+    
+    if (ssid[0] == 0 || strlen(ssid) >= WIFI_SSID_LEN || strlen(pass) >= WIFI_PASS_LEN) {
+        out.println("Invalid SSID or password!");
+        return CMD_BAD_ARGS;
+    }
+    
+    wifiSetCredentials(ssid, pass);
+    out.printf("Connecting to %s...\n", ssid);
+    return CMD_OK;
+}
+
+#if ENABLE_OTA || ENABLE_ARDUINO_OTA
+static CommandResult cmdOtaPassword(int argc, const char* const *argv, Print &out) {
+    size_t len = strlen(argv[0]);
+    if (len < OTA_PASSWORD_MIN || len >= OTA_PASSWORD_LEN) {
+        out.printf("Password must be %d-%d chars\n", OTA_PASSWORD_MIN, OTA_PASSWORD_LEN - 1);
+        return CMD_BAD_ARGS;
+    }
+    if (!otaSetPassword(argv[0])) {
+        out.println("Failed to save password!");
+        return CMD_FAILED;
+    }
+    out.println("OTA password saved");
+    return CMD_OK;
+}
+#endif
+
+static CommandResult cmdWifiReset(int argc, const char* const *argv, Print &out) {
+    wifiForget();
+    out.println("WiFi credentials cleared, starting AP");
+    return CMD_OK;
+}
+#endif
+
+#if ENABLE_WIFI && ENABLE_FLEET
+static CommandResult cmdFleet(int argc, const char* const *argv, Print &out) {
+    out.println("\n=== Fleet ===");
+    printFleetStatus(out);
+    out.println("=============\n");
+    return CMD_OK;
+}
+
+static CommandResult cmdFleetOn(int argc, const char* const *argv, Print &out) {
+    setFleetEnabled(true);
+    out.println("Fleet enabled");
+    return CMD_OK;
+}
+
+static CommandResult cmdFleetOff(int argc, const char* const *argv, Print &out) {
+    setFleetEnabled(false);
+    out.println("Fleet disabled");
+    return CMD_OK;
+}
+
+static CommandResult cmdFleetOrder(int argc, const char* const *argv, Print &out) {
+    long vol;
+    if (!argInt(argv[0], VOLUME_MIN, VOLUME_MAX, vol)) {
+        out.println("Invalid volume!");
+        return CMD_BAD_ARGS;
+    }
+    
+    uint32_t node = fleetOrder(vol);
+    if (node == 0) {
+        out.println("No free glass in fleet!");
+        return CMD_FAILED;
+    }
+    out.printf("Order %ld ml -> %08lX\n", vol, (unsigned long)node);
+    return CMD_OK;
+}
+#endif
+
+// ========================================
+// ТАБЛИЦЯ
+// ========================================
+
+// Рядки з підкомандою - раніше за рядок без неї з тим самим ім'ям
+static const CommandDef commands[] = {
+    {"help",    NULL,    0, 0, cmdHelp,       "",              "List commands"},
+    {"stats",   NULL,    0, 0, cmdStats,      "",              "Show statistics"},
+    {"heap",    NULL,    0, 0, cmdHeap,       "",              "Show memory"},
+    {"tasks",   NULL,    0, 0, cmdTasks,      "",              "Show task info"},
+    {"reset",   NULL,    0, 0, cmdReset,      "",              "Reset statistics"},
+    {"restart", NULL,    0, 0, cmdRestart,    "",              "Restart device"},
+    {"pour",    NULL,    0, 1, cmdPour,       "[ML]",          "Pour ML (default: current volume)"},
+    {"volume",  NULL,    1, 1, cmdVolume,     "ML",            "Set target volume"},
+    {"mode",    NULL,    1, 1, cmdMode,       "manual|auto",   "Set pour mode"},
+    {"shot",    NULL,    1, 1, cmdShot,       "N",             "Select shot (1 = first glass)"},
+    {"start",   NULL,    0, 0, cmdStart,      "",              "Start pouring"},
+    {"stop",    NULL,    0, 0, cmdStop,       "",              "Stop pouring, clear queue"},
+    {"pause",   NULL,    0, 0, cmdPause,      "",              "Pause pouring, keep spout in place"},
+    {"resume",  NULL,    0, 0, cmdResume,     "",              "Pour the rest of a paused pour"},
+    {"prime",   "stop",  0, 0, cmdPrimeStop,  "",              "Liquid at the spout: save dead volume"},
+    {"prime",   "set",   1, 1, cmdPrimeSet,   "ML",            "Set tube dead volume"},
+    {"prime",   NULL,    0, 0, cmdPrime,      "",              "Prime the tube over the selected shot"},
+    {"clean",   NULL,    0, 1, cmdClean,      "[PROGRAM]",     "Run a cleaning program, list without args"},
+    {"recipe",  "set",   2, 2, cmdRecipeSet,  "NAME SPEC",     "Save recipe: gin:2,tonic:3/lime:1 (/ - next stage)"},
+    {"recipe",  "del",   1, 1, cmdRecipeDel,  "NAME",          "Delete recipe"},
+    {"recipe",  NULL,    0, 1, cmdRecipe,     "[NAME|N|off]",  "Select cocktail, list without args"},
+    {"pump",    NULL,    2, 3, cmdPump,       "N ING [ML/S]",  "Ingredient in pump N and its flow rate"},
+    {"queue",   "clear", 0, 0, cmdQueueClear, "",              "Clear pour queue"},
+    {"queue",   NULL,    1, 2, cmdQueue,      "SHOT [ML]",     "Queue an order"},
+    {"safety",  "clear", 0, 0, cmdSafetyClear, "",             "Clear fault records"},
+    {"safety",  NULL,    0, 0, cmdSafety,     "",              "Watchdog and last fault"},
+    {"power",   NULL,    0, 0, cmdPower,      "",              "Idle level, CPU frequency"},
+#if MANIFOLD_CHANNELS
+    {"manifold", NULL,   0, 0, cmdManifold,   "",              "Per-glass outputs and current budget"},
+#endif
+#if GLASS_SENSOR_ANALOG
+    {"glass",   NULL,    0, 0, cmdGlass,      "",              "Analog glass levels, baselines, thresholds"},
+#endif
+#if ENABLE_TRACE
+    {"trace",   "stats", 0, 0, cmdTraceStats, "",              "Loop deadlines and stage maxima"},
+    {"trace",   "clear", 0, 0, cmdTraceClear, "",              "Clear trace buffer"},
+    {"trace",   NULL,    0, 0, cmdTrace,      "",              "Dump Chrome trace JSON"},
+#endif
+#if ENABLE_WIFI
+    {"wifi",    "set",   1, 2, cmdWifiSet,    "SSID [PASS]",   "Save network and connect (\"quote\" spaces)"},
+    {"wifi",    "reset", 0, 0, cmdWifiReset,  "",              "Forget network, start AP"},
+    {"wifi",    NULL,    0, 0, cmdWifi,       "",              "Show WiFi status"},
+#if ENABLE_OTA || ENABLE_ARDUINO_OTA
+    {"ota",     "password", 1, 1, cmdOtaPassword, "PASS",      "Set firmware update password (Serial only)"},
+#endif
+    {"ws",      NULL,    0, 0, cmdWs,         "",              "WebSocket clients and frame counters"},
+#endif
+#if ENABLE_WIFI && ENABLE_FLEET
+    {"fleet",   "on",    0, 0, cmdFleetOn,    "",              "Enable fleet mode"},
+    {"fleet",   "off",   0, 0, cmdFleetOff,   "",              "Disable fleet mode"},
+    {"fleet",   "order", 1, 1, cmdFleetOrder, "ML",            "Pour ML on least busy node"},
+    {"fleet",   NULL,    0, 0, cmdFleet,      "",              "Show fleet nodes"},
+#endif
+};
+
+static const size_t commandCount = sizeof(commands) / sizeof(commands[0]);
+
+static void printCommand(Print &out, const CommandDef &c) {
+    out.printf("%s%s%s%s%s", c.name, c.sub ? " " : "", c.sub ? c.sub : "",
+               c.usage[0] ? " " : "", c.usage);
+}
+
+static CommandResult cmdHelp(int argc, const char* const *argv, Print &out) {
+    out.println("\n=== Commands ===");
+    for (size_t i = 0; i < commandCount; i++) {
+        printCommand(out, commands[i]);
+        out.printf(" - %s\n", commands[i].help);
+    }
+    out.println("================\n");
+    return CMD_OK;
+}
+
+// ========================================
+// ДИСПЕТЧЕР
+// ========================================
+
+// Команди, що беруть volume/mode/shot або перезапускають пристрій: перед ними
+// відкладені сетери застосовуються ("volume 50" + "start"). Решта - стан, довідка,
+// wifi - не пише NVS заради читання, сетери чекають свого CMD_COALESCE_MS
+static bool readsSetters(CommandHandler handler) {
+    static const CommandHandler readers[] = {
+        cmdPour, cmdStart, cmdResume, cmdPrime, cmdClean, cmdRecipe, cmdQueue, cmdRestart,
+#if ENABLE_WIFI && ENABLE_FLEET
+        cmdFleetOrder,
+#endif
+    };
+    for (CommandHandler reader : readers) {
+        if (reader == handler) return true;
+    }
+    return false;
+}
+
+int commandTokenize(char *line, char **argv, int maxArgs) {
+    int argc = 0;
+    char *p = line;
+    
+    while (true) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        if (*p == 0) break;
+        if (argc >= maxArgs) return -1;
+        
+        if (*p == '"') {
+            // До закривальної лапки, пробіли всередині - частина значення
+            argv[argc++] = ++p;
+            while (*p != 0 && *p != '"') p++;
+            if (*p == 0) return -1;
+        } else {
+            argv[argc++] = p;
+            while (*p != 0 && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+            if (*p == 0) break;
+        }
+        *p++ = 0;
+    }
+    return argc;
+}
+
+CommandResult commandExecuteArgs(int argc, const char* const *argv, Print &out, CommandSource source) {
+    if (argc <= 0) return CMD_EMPTY;
+    
+    bool known = false;
+    for (size_t i = 0; i < commandCount; i++) {
+        const CommandDef &c = commands[i];
+        if (strcmp(c.name, argv[0]) != 0) continue;
+        known = true;
+        
+        int skip = 1;
+        if (c.sub != NULL) {
+            if (argc < 2 || strcmp(c.sub, argv[1]) != 0) continue;
+            skip = 2;
+        }
+        
+        // Не та кількість - можливо, підійде рядок без підкоманди
+        int args = argc - skip;
+        if (args < c.minArgs || args > c.maxArgs) continue;
+        
+#if ENABLE_WIFI && (ENABLE_OTA || ENABLE_ARDUINO_OTA)
+        // Пароль оновлення - лише з фізичного доступу: з мережі його задав би будь-хто
+        if (c.handler == cmdOtaPassword && source != CMD_SRC_SERIAL) {
+            out.println("Only from Serial");
+            return CMD_FAILED;
+        }
+#endif
+        
+        if (readsSetters(c.handler)) commandFlushSetters();
+        
+        LOG_D("Command from %d: %s", source, argv[0]);
+        return c.handler(args, argv + skip, out);
+    }
+    
+    if (!known) {
+        out.println("Unknown command. Type 'help'");
+        return CMD_UNKNOWN;
+    }
+    
+    // Ім'я відоме - всі його форми як підказка
+    for (size_t i = 0; i < commandCount; i++) {
+        if (strcmp(commands[i].name, argv[0]) != 0) continue;
+        out.print("Usage: ");
+        printCommand(out, commands[i]);
+        out.println();
+    }
+    return CMD_BAD_ARGS;
+}
+
+CommandResult commandExecute(char *line, Print &out, CommandSource source) {
+    char *argv[CMD_ARGS_MAX];
+    int argc = commandTokenize(line, argv, CMD_ARGS_MAX);
+    if (argc < 0) {
+        out.println("Bad syntax: unclosed quote or too many arguments");
+        return CMD_BAD_ARGS;
+    }
+    return commandExecuteArgs(argc, argv, out, source);
+}
+
+const char* commandResultName(CommandResult result) {
+    switch (result) {
+        case CMD_OK: return "ok";
+        case CMD_EMPTY: return "empty command";
+        case CMD_UNKNOWN: return "unknown command";
+        case CMD_BAD_ARGS: return "bad arguments";
+        case CMD_FAILED: return "failed";
+        default: return "unknown";
+    }
+}
+
+void updateCommands() {
+    // Скільки є в буфері UART - без readStringUntil і його таймауту
+    while (Serial.available() > 0) {
+        int c = Serial.read();
+        if (c < 0) break;
+        
+        if (c == '\n' || c == '\r') {
+            if (serialOverflow) {
+                Serial.printf("Line too long (max %d)\n", CMD_LINE_MAX - 1);
+            } else if (serialLen > 0) {
+                serialLine[serialLen] = 0;
+                commandExecute(serialLine, Serial, CMD_SRC_SERIAL);
+            }
+            serialLen = 0;
+            serialOverflow = false;
+            continue;
+        }
+        
+        // Задовгий рядок відкидається цілком до кінця рядка
+        if (serialLen + 1 >= sizeof(serialLine)) {
+            serialOverflow = true;
+            continue;
+        }
+        serialLine[serialLen++] = c;
+    }
+    
+    if (setterPending != 0 && millis() - setterFlushAt >= CMD_COALESCE_MS) {
+        commandFlushSetters();
+    }
+    
+    if (restartAt != 0 && (long)(millis() - restartAt) >= 0) {
+        esp_restart();
+    }
+}
@@ -1,4 +1,11 @@
 #include "control.h"
+#include "safety.h"
+#include "metrics.h"
+#include "power.h"
+#include "cleaning.h"
+#include "manifold.h"
+#include "recipes.h"
+#include "inputs.h"
 
 // Об'єкти
 Servo servo;
@@ -9,23 +16,33 @@ volatile int encoderPos = 0;
 volatile bool encoderChanged = false;
 int lastEncoderPos = 0;
 
-// Стани кнопок
-bool buttonStartPressed = false;
-bool encoderButtonPressed = false;
-unsigned long lastButtonPress = 0;
-unsigned long lastEncoderPress = 0;
-
 // Стан розливу
-unsigned long pourStartTime = 0;
+unsigned long pourStartTime = 0;    // Початок поточного відрізка роботи помпи
 bool isPourActive = false;
+uint16_t pourVolume = 0;            // Об'єм поточного розливу
+static uint8_t pourShot = 1;        // Рюмка поточного розливу - g_selectedShot лише вибір
+static unsigned long pourPumpedMs = 0;  // Помпа працювала до останньої паузи
+static unsigned long pourPrimeMs = 0;   // Заповнення злитої трубки на початку розливу
+static bool glassFilled[GLASS_COUNT] = {false};   // Налито в цю рюмку, скидається коли її знімають
+
+// Стартова анімація LED - кадрами в updateLED(), без delay() у setup()
+static unsigned long ledIntroStart = 0;
+
+// Черга замовлень
+portMUX_TYPE controlMux = portMUX_INITIALIZER_UNLOCKED;
+static PourOrder pourQueue[POUR_QUEUE_SIZE];
+static uint8_t pourQueueHead = 0;
+static uint8_t pourQueueCount = 0;
 
 // Зовнішні глобальні змінні
 extern SystemState g_systemState;
 extern PourMode g_pourMode;
 extern uint16_t g_targetVolume;
 extern uint8_t g_selectedShot;
-extern bool g_glassPresent[5];
+extern bool g_glassPresent[GLASS_COUNT];
 extern Statistics g_stats;
+extern float g_pumpRate;
+extern float g_primeVolume;
 
 // Interrupt handlers
 void IRAM_ATTR encoderISR() {
@@ -51,19 +68,14 @@ void initPeripherals() {
     // Енкодер
     pinMode(ENCODER_CLK, INPUT_PULLUP);
     pinMode(ENCODER_DT, INPUT_PULLUP);
-    pinMode(ENCODER_SW, INPUT_PULLUP);
     
     attachInterrupt(digitalPinToInterrupt(ENCODER_CLK), encoderISR, CHANGE);
     
-    // Кнопка старт
-    pinMode(BUTTON_START, INPUT);
-    
-    // Датчики рюмок
-    pinMode(GLASS_PIN_1, INPUT);
-    pinMode(GLASS_PIN_2, INPUT);
-    pinMode(GLASS_PIN_3, INPUT);
-    pinMode(GLASS_PIN_4, INPUT);
-    pinMode(GLASS_PIN_5, INPUT);
+    // Кнопки і датчики рюмок - на перериваннях (inputs.cpp)
+    setupInputs();
+    for (int i = 0; i < GLASS_COUNT; i++) {
+        g_glassPresent[i] = inputActive(INPUT_GLASS_FIRST + i);
+    }
     
     // Помпа
     pinMode(PUMP_POWER, OUTPUT);
@@ -72,7 +84,17 @@ void initPeripherals() {
     ledcSetup(PUMP_CHANNEL, PUMP_FREQ, 8);
     ledcAttachPin(PUMP_POWER, PUMP_CHANNEL);
     ledcWrite(PUMP_CHANNEL, 0);
+
+#if MANIFOLD_CHANNELS
+    // Вихід на кожну рюмку
+    setupManifold();
+#endif
     
+#if RECIPE_PUMPS > 1
+    // Помпи інгредієнтів коктейлів
+    setupRecipePumps();
+#endif
+
     // Сервопривод
     pinMode(SERVO_POWER, OUTPUT);
     digitalWrite(SERVO_POWER, HIGH);
@@ -85,20 +107,122 @@ void initPeripherals() {
     FastLED.addLeds<LED_TYPE, LED_PIN, LED_ORDER>(leds, LED_COUNT);
     FastLED.setBrightness(LED_BRIGHTNESS);
     
-    // Стартова анімація
-    for (int i = 0; i < LED_COUNT; i++) {
-        leds[i] = CHSV(LED_COLOR, 255, 255);
-        FastLED.show();
-        delay(50);
+    // Стартова анімація - в updateLED()
+    ledIntroStart = millis();
+}
+
+// Кнопка енкодера: коротке - наступна рюмка, довге - прокачка, подвійне - режим,
+// з поворотом - коктейль. На паузі і в прокачці діє одразу на натисканні
+static void onEncoderButton(const InputEvent &event) {
+    switch (event.type) {
+        case INPUT_DOWN:
+            if (g_systemState == STATE_PAUSED) {
+                // На паузі - скасувати залишок розливу
+                inputConsume(INPUT_ENCODER_SW);
+                stopPour();
+            } else if (g_systemState == STATE_CLEANING) {
+                // Прокачка: рідина дійшла до носика. Промивка - перервати
+                inputConsume(INPUT_ENCODER_SW);
+                if (!primeFinish()) stopPour();
+            }
+            break;
+        
+        case INPUT_SHORT:
+            if (shotLocked() || g_systemState == STATE_CLEANING) break;
+            
+            // Наступна рюмка
+            g_selectedShot++;
+            if (g_selectedShot > GLASS_COUNT) g_selectedShot = 1;
+            
+            DEBUG_PRINTF("Shot selected: %d\n", g_selectedShot);
+            
+            extern void saveSettings();
+            saveSettings();
+            break;
+        
+        case INPUT_LONG:
+            // Прокачка - тільки в ручному режимі, з простою
+            if (g_pourMode == MODE_MANUAL) primeStart();
+            break;
+        
+        case INPUT_DOUBLE:
+            // Ручний / авто
+            if (g_systemState != STATE_IDLE && g_systemState != STATE_READY) break;
+            setPourMode(g_pourMode == MODE_MANUAL ? MODE_AUTO : MODE_MANUAL);
+
+#if ENABLE_WIFI
+            extern void broadcastState();
+            broadcastState();
+#endif
+            break;
+        
+        default:
+            break;
+    }
+}
+
+// START: старт / пауза / продовжити. Помпу на паузу вже знеструмив ISR кнопки,
+// утримання на паузі - скасувати розлив
+static void onStartButton(const InputEvent &event) {
+    if (event.type == INPUT_DOWN) {
+        if (g_systemState == STATE_IDLE || g_systemState == STATE_READY) {
+            startPour();
+        } else if (g_systemState == STATE_POURING) {
+            pausePour();
+        } else if (g_systemState == STATE_PAUSED) {
+            resumePour();
+        } else if (g_systemState == STATE_CLEANING) {
+            if (!primeFinish()) stopPour();
+        }
+    } else if (event.type == INPUT_LONG && g_systemState == STATE_PAUSED) {
+        stopPour();
+    }
+}
+
+// Помпу знеструмив ISR кнопки START, а подія натискання не дійшла. Пауза чи стоп
+// самі відпускають виходи (safetyRelease) - аж тоді, як облікували зупинку
+static void onStartHalted() {
+    LOG_W("START halt without a queued press, stopping");
+    if (g_systemState == STATE_POURING) {
+        if (!pausePour()) stopPour();
+    } else if (g_systemState == STATE_CLEANING) {
+        if (!primeFinish()) stopPour();
+    } else {
+        stopPour();
+    }
+}
+
+static void onGlass(const InputEvent &event) {
+    uint8_t i = event.input - INPUT_GLASS_FIRST;
+    if (event.type == INPUT_DOWN) {
+        g_glassPresent[i] = true;
+    } else if (event.type == INPUT_UP) {
+        g_glassPresent[i] = false;
+        glassFilled[i] = false;
     }
 }
 
 void updateControls() {
+    TRACE_SCOPE(TRACE_CONTROLS);
+    
     // Обробка енкодера
     if (encoderChanged) {
         int delta = encoderPos - lastEncoderPos;
         
-        if (delta != 0) {
+        if (delta != 0 && inputActive(INPUT_ENCODER_SW)) {
+            // Поворот з натиснутою кнопкою - вибір коктейлю; відпускання вже не вибирає рюмку
+            inputConsume(INPUT_ENCODER_SW);
+            if (g_systemState == STATE_IDLE || g_systemState == STATE_READY) {
+                recipeSelectNext(delta);
+
+#if ENABLE_WIFI
+                extern void broadcastState();
+                broadcastState();
+#endif
+            }
+            
+            lastEncoderPos = encoderPos;
+        } else if (delta != 0) {
             // Зміна об'єму
             int newVolume = g_targetVolume + (delta * VOLUME_STEP);
             
@@ -120,121 +244,219 @@ void updateControls() {
         encoderChanged = false;
     }
     
-    // Кнопка енкодера (вибір рюмки)
-    if (digitalRead(ENCODER_SW) == LOW) {
-        if (!encoderButtonPressed && (millis() - lastEncoderPress > DEBOUNCE_MS)) {
-            encoderButtonPressed = true;
-            lastEncoderPress = millis();
-            
-            // Наступна рюмка
-            g_selectedShot++;
-            if (g_selectedShot > 5) g_selectedShot = 1;
-            
-            DEBUG_PRINTF("Shot selected: %d\n", g_selectedShot);
-            
-            extern void saveSettings();
-            saveSettings();
-        }
-    } else {
-        encoderButtonPressed = false;
+    // Кнопки і рюмки: події з черги переривань
+    InputEvent event;
+    while (inputNext(event)) {
+        if (event.input == INPUT_ENCODER_SW) onEncoderButton(event);
+        else if (event.input == INPUT_START) onStartButton(event);
+        else onGlass(event);
     }
     
-    // Кнопка старт/стоп
-    bool startButton = digitalRead(BUTTON_START);
-    if (startButton == HIGH) {
-        if (!buttonStartPressed && (millis() - lastButtonPress > DEBOUNCE_MS)) {
-            buttonStartPressed = true;
-            lastButtonPress = millis();
-            
-            if (g_systemState == STATE_IDLE || g_systemState == STATE_READY) {
-                startPour();
-            } else if (g_systemState == STATE_POURING) {
-                stopPour();
-            }
-        }
-    } else {
-        buttonStartPressed = false;
+    // Швидкий стоп без події START: фронт загубився в повній черзі. Фронт, що прийшов
+    // після розбору черги, ще молодший за DEBOUNCE_MS і буде розібраний наступним тіком
+    if (safetyHaltMs() != 0 && millis() - safetyHaltMs() >= DEBOUNCE_MS) {
+        onStartHalted();
+    }
+}
+
+unsigned long pourDurationMs(uint16_t volume) {
+    return (volume / g_pumpRate) * 1000;
+}
+
+int shotPosition(uint8_t shot) {
+    if (shot < 1 || shot > GLASS_COUNT) return POS_PARKING;
+    return hw::shotAngles[shot - 1];
+}
+
+// Помпа розливу: основна або помпи коктейлю за розкладом на поточний момент
+static void pourPumpWrite(bool on) {
+    if (recipeActive()) {
+        if (on) recipeApply(pourElapsedMs());
+        else recipeOutputsOff();
+        return;
     }
+    ledcWrite(PUMP_CHANNEL, on ? PUMP_SPEED_DEFAULT : 0);
+}
+
+// Наступне замовлення з черги, коли розлив вільний і рюмка на місці
+static void processPourQueue() {
+#if MANIFOLD_CHANNELS
+    // Колектор: замовлення стартують і поруч з іншими розливами
+    if (g_systemState != STATE_IDLE && g_systemState != STATE_READY && g_systemState != STATE_POURING) return;
+    uint8_t busy = manifoldBusyMask();
+#else
+    if (g_systemState != STATE_IDLE && g_systemState != STATE_READY) return;
+    uint8_t busy = 0;
+#endif
+    
+    PourOrder order;
+    portENTER_CRITICAL(&controlMux);
+    uint8_t head = pourQueueCount > 0 ? pourQueue[pourQueueHead].shot : 0;
+    bool ready = head != 0 && g_glassPresent[head - 1] && !(busy & (1 << (head - 1)));
+    if (ready) {
+        order = pourQueue[pourQueueHead];
+        pourQueueHead = (pourQueueHead + 1) % POUR_QUEUE_SIZE;
+        pourQueueCount--;
+    }
+    portEXIT_CRITICAL(&controlMux);
     
-    // Оновити датчики рюмок
-    g_glassPresent[0] = digitalRead(GLASS_PIN_1) == HIGH;
-    g_glassPresent[1] = digitalRead(GLASS_PIN_2) == HIGH;
-    g_glassPresent[2] = digitalRead(GLASS_PIN_3) == HIGH;
-    g_glassPresent[3] = digitalRead(GLASS_PIN_4) == HIGH;
-    g_glassPresent[4] = digitalRead(GLASS_PIN_5) == HIGH;
+    if (ready) {
+        startPourTo(order.shot, order.volume);
+    }
 }
 
 void updatePourState() {
-    if (!isPourActive) return;
+#if MANIFOLD_CHANNELS
+    TRACE_SCOPE(TRACE_POUR_STATE);
+    processPourQueue();
+    updateManifold();
+    return;
+#endif
+
+    if (!isPourActive) {
+        processPourQueue();
+        return;
+    }
+    
+    // На паузі помпа стоїть: ні таймауту, ні завершення
+    if (g_systemState == STATE_PAUSED) return;
+    
+    TRACE_SCOPE(TRACE_POUR_STATE);
     
-    unsigned long elapsed = millis() - pourStartTime;
-    unsigned long pourTime = (g_targetVolume / PUMP_ML_PER_SEC) * 1000;
+    unsigned long elapsed = pourElapsedMs();
+    unsigned long pourTime = recipeActive() ? recipeTotalMs() : pourPrimeMs + pourDurationMs(pourVolume);
     
     // Перевірка таймауту
     if (elapsed > MAX_POUR_TIME) {
-        Serial.println("ERROR: Pour timeout!");
+        LOG_E("Pour timeout!");
         stopPour();
         g_systemState = STATE_ERROR;
+        portENTER_CRITICAL(&controlMux);
         g_stats.errors++;
+        portEXIT_CRITICAL(&controlMux);
+        
+        extern void markStatisticsDirty();
+        markStatisticsDirty();
         return;
     }
     
+    // Коктейль: наступний етап - інші помпи
+    recipeApply(elapsed);
+    
     // Завершення розливу
     if (elapsed >= pourTime) {
         completePour();
     }
 }
 
-void startPour() {
-    if (g_systemState == STATE_POURING) {
-        Serial.println("Already pouring!");
-        return;
+bool startPour() {
+    // "Налити" на паузі - продовжити поточний розлив
+    if (g_systemState == STATE_PAUSED) {
+        return resumePour();
+    }
+    return startPourTo(g_selectedShot, g_targetVolume);
+}
+
+bool startPourTo(uint8_t shot, uint16_t volume) {
+#if MANIFOLD_CHANNELS
+    // Без серво: кожна рюмка - свій вихід
+    if (!manifoldStart(shot, volume)) return false;
+    g_selectedShot = shot;
+#if ENABLE_WIFI
+    extern void broadcastState();
+    broadcastState();
+#endif
+    return true;
+#endif
+
+    // Стан займається під controlMux до руху серво: другий старт під час delay()
+    // нижче (HTTP/WS з AsyncTCP, START, енкодер, черга) бачить MOVING і отримує відмову
+    const char* refused = NULL;
+    portENTER_CRITICAL(&controlMux);
+    SystemState prev = g_systemState;
+    if (prev == STATE_MOVING || prev == STATE_POURING) {
+        refused = "Already pouring!";
+    } else if (prev == STATE_PAUSED) {
+        refused = "Pour paused: resume or stop it first";
+    } else if (prev == STATE_CLEANING) {
+        refused = "Cleaning in progress!";
+    } else if (prev == STATE_UPDATING) {
+        refused = "Firmware update in progress!";
+    } else if (shot < 1 || shot > GLASS_COUNT || !g_glassPresent[shot - 1]) {
+        refused = "No glass detected!";
+    } else {
+        g_systemState = STATE_MOVING;
+        pourShot = shot;
+        pourVolume = volume;
     }
+    portEXIT_CRITICAL(&controlMux);
     
-    // Перевірка рюмки
-    if (!g_glassPresent[g_selectedShot - 1]) {
-        Serial.println("No glass detected!");
-        return;
+    if (refused != NULL) {
+        LOG_W("%s", refused);
+        return false;
     }
     
-    Serial.printf("Starting pour: %d ml to shot %d\n", g_targetVolume, g_selectedShot);
+    // Коктейль: розклад до руху серво - без інгредієнта нічого не рушить
+    if (recipeSelectedName() != NULL && !recipePlan(volume, tubePrimed())) {
+        g_systemState = prev;
+        return false;
+    }
     
-    g_systemState = STATE_MOVING;
+    LOG_I("Starting pour: %d ml to shot %d", volume, shot);
     
-    // Рух до рюмки
-    int position = 0;
-    switch (g_selectedShot) {
-        case 1: position = POS_SHOT_1; break;
-        case 2: position = POS_SHOT_2; break;
-        case 3: position = POS_SHOT_3; break;
-        case 4: position = POS_SHOT_4; break;
-        case 5: position = POS_SHOT_5; break;
-    }
+    // Зі сну: серво знову під живленням до першого руху
+    powerWake();
+    g_selectedShot = shot;
     
-    servo.write(position);
+    // Рух до рюмки
+    servo.write(shotPosition(pourShot));
     delay(500); // Чекати завершення руху
     
+    // Поки серво рухалось, розлив скасували (stopPour, оновлення прошивки)
+    if (g_systemState != STATE_MOVING) return false;
+    
+    // Злита трубка: спершу її мертвий об'єм, у рюмку - повний об'єм.
+    // Коктейль доливає мертвий об'єм кожної трубки у своєму розкладі
+    pourPrimeMs = tubePrimed() || recipeActive() ? 0 : (unsigned long)(g_primeVolume / g_pumpRate * 1000);
+    if (pourPrimeMs > 0) LOG_I("Tube drained: +%.1f ml to prime", g_primeVolume);
+    
     // Почати розлив
     g_systemState = STATE_POURING;
     isPourActive = true;
+    pourPumpedMs = 0;
     pourStartTime = millis();
     
-    ledcWrite(PUMP_CHANNEL, PUMP_SPEED_DEFAULT);
+    safetyPumpOn();
+    pourPumpWrite(true);
     
 #if ENABLE_WIFI
     extern void broadcastState();
     broadcastState();
 #endif
+    return true;
 }
 
 void stopPour() {
-    Serial.println("Stopping pour");
+    LOG_I("Stopping pour");
     
     // Зупинити помпу
     ledcWrite(PUMP_CHANNEL, 0);
+    recipeEnd();
+    safetyPumpOff();
+#if MANIFOLD_CHANNELS
+    manifoldStop();
+#endif
+    // Виходи в нулі - швидкий стоп START більше не потрібен
+    safetyRelease();
+    
+    // Зупинка скасовує і решту замовлень
+    clearPourQueue();
+    
+    // Трубку встигли заповнити - наступний розлив без доливу
+    if (isPourActive && pourElapsedMs() >= pourPrimeMs) tubeMarkPrimed();
     
     isPourActive = false;
-    g_systemState = STATE_IDLE;
+    if (g_systemState != STATE_UPDATING) g_systemState = STATE_IDLE;
     
     // Повернення в паркінг
     servo.write(POS_PARKING);
@@ -245,17 +467,147 @@ void stopPour() {
 #endif
 }
 
+bool pausePour() {
+    if (g_systemState != STATE_POURING) {
+        LOG_W("Not pouring!");
+        return false;
+    }
+    
+#if MANIFOLD_CHANNELS
+    if (!manifoldPause()) return false;
+    safetyRelease();
+#if ENABLE_WIFI
+    extern void broadcastState();
+    broadcastState();
+#endif
+    return true;
+#endif
+
+    // Зупинити помпу, серво не чіпати
+    pourPumpWrite(false);
+    safetyPumpOff();
+    
+    // Стан і налите - разом: контур керування не побачить відрізок двічі
+    // Помпу зупинила ще ISR кнопки START - налите рахувати до того моменту
+    unsigned long stoppedAt = safetyHaltMs() != 0 ? safetyHaltMs() : millis();
+    
+    portENTER_CRITICAL(&controlMux);
+    pourPumpedMs += stoppedAt - pourStartTime;
+    g_systemState = STATE_PAUSED;
+    portEXIT_CRITICAL(&controlMux);
+    
+    // Зупинку обліковано, виходи в нулі - LEDC знову веде піни
+    safetyRelease();
+    
+    LOG_I("Pour paused: %d of %d ml", pourDispensedMl(), pourVolume);
+
+#if ENABLE_WIFI
+    extern void broadcastState();
+    broadcastState();
+#endif
+    return true;
+}
+
+bool resumePour() {
+    if (g_systemState != STATE_PAUSED) {
+        LOG_W("Pour is not paused!");
+        return false;
+    }
+
+#if MANIFOLD_CHANNELS
+    if (!manifoldResume()) return false;
+#if ENABLE_WIFI
+    extern void broadcastState();
+    broadcastState();
+#endif
+    return true;
+#endif
+
+    if (!g_glassPresent[pourShot - 1]) {
+        LOG_W("No glass detected!");
+        return false;
+    }
+    
+    LOG_I("Resuming pour: %d ml left", pourVolume - pourDispensedMl());
+    
+    portENTER_CRITICAL(&controlMux);
+    pourStartTime = millis();
+    g_systemState = STATE_POURING;
+    portEXIT_CRITICAL(&controlMux);
+    
+    safetyPumpOn();
+    pourPumpWrite(true);
+
+#if ENABLE_WIFI
+    extern void broadcastState();
+    broadcastState();
+#endif
+    return true;
+}
+
+unsigned long pourElapsedMs() {
+#if MANIFOLD_CHANNELS
+    // Кілька розливів: час, за який одна помпа налила б стільки ж
+    return pourDurationMs(manifoldDispensedMl());
+#endif
+    if (!isPourActive) return 0;
+    
+    portENTER_CRITICAL(&controlMux);
+    unsigned long elapsed = pourPumpedMs;
+    if (g_systemState == STATE_POURING) elapsed += millis() - pourStartTime;
+    portEXIT_CRITICAL(&controlMux);
+    
+    return elapsed;
+}
+
+uint16_t pourDispensedMl() {
+#if MANIFOLD_CHANNELS
+    return manifoldDispensedMl();
+#endif
+    if (!isPourActive) return 0;
+    if (recipeActive()) return recipeDispensedMl(pourElapsedMs());
+    unsigned long elapsed = pourElapsedMs();
+    if (elapsed <= pourPrimeMs) return 0;
+    float ml = (elapsed - pourPrimeMs) * g_pumpRate / 1000;
+    return ml < pourVolume ? (uint16_t)ml : pourVolume;
+}
+
+uint16_t pourTargetMl() {
+#if MANIFOLD_CHANNELS
+    return manifoldTargetMl();
+#endif
+    return isPourActive ? pourVolume : 0;
+}
+
+void recordPour(uint8_t shot, uint16_t volume, unsigned long pumpMs) {
+    glassFilled[shot - 1] = true;
+    
+    // Оновити статистику - під controlMux, saveStatistics() копіює її з loop()
+    unsigned long now = millis();
+    portENTER_CRITICAL(&controlMux);
+    g_stats.totalPours++;
+    g_stats.totalVolume += volume;
+    g_stats.lastPourVolume = volume;
+    g_stats.lastPourTime = now;
+    portEXIT_CRITICAL(&controlMux);
+    metricsPourDone(pumpMs);
+    
+    // Запис у flash - з loop() за інтервалом
+    extern void markStatisticsDirty();
+    markStatisticsDirty();
+}
+
 void completePour() {
-    Serial.println("Pour complete!");
+    LOG_I("Pour complete!");
     
     // Зупинити помпу
     ledcWrite(PUMP_CHANNEL, 0);
+    recipeEnd();
+    safetyPumpOff();
+    safetyRelease();
     
-    // Оновити статистику
-    g_stats.totalPours++;
-    g_stats.totalVolume += g_targetVolume;
-    g_stats.lastPourVolume = g_targetVolume;
-    g_stats.lastPourTime = millis();
+    tubeMarkPrimed();
+    recordPour(pourShot, pourVolume, pourElapsedMs());
     
     isPourActive = false;
     
@@ -268,12 +620,9 @@ void completePour() {
     // В авто-режимі перейти до наступної рюмки
     if (g_pourMode == MODE_AUTO) {
         g_selectedShot++;
-        if (g_selectedShot > 5) g_selectedShot = 1;
+        if (g_selectedShot > GLASS_COUNT) g_selectedShot = 1;
     }
     
-    extern void saveStatistics();
-    saveStatistics();
-    
 #if ENABLE_WIFI
     extern void broadcastState();
     broadcastState();
@@ -284,13 +633,34 @@ void updateLED(SystemState state, PourMode mode) {
     static unsigned long lastUpdate = 0;
     if (millis() - lastUpdate < 50) return; // 20 FPS
     
+    TRACE_SCOPE(TRACE_LED);
+    
     uint8_t hue = mode == MODE_MANUAL ? 160 : 96; // Синій / Зелений
     
+    // У сні стрічка погашена (див. power.cpp)
+    if (powerLevel() == POWER_SLEEP) return;
+    
+    // Стартова анімація: світлодіоди загоряються по одному, поки нічого не відбувається
+    unsigned long intro = millis() - ledIntroStart;
+    if (state == STATE_IDLE && intro < (unsigned long)LED_COUNT * LED_INTRO_STEP) {
+        int lit = intro / LED_INTRO_STEP + 1;
+        for (int i = 0; i < LED_COUNT; i++) {
+            if (i < lit) leds[i] = CHSV(LED_COLOR, 255, 255);
+            else leds[i] = CRGB::Black;
+        }
+        FastLED.show();
+        lastUpdate = millis();
+        return;
+    }
+    
     switch (state) {
         case STATE_IDLE:
         case STATE_READY:
-            // Статичний колір
-            fill_solid(leds, LED_COUNT, CHSV(hue, 255, 150));
+            // Статичний колір, сегмент над порожнім місцем - тьмяніше
+            for (uint8_t shot = 1; shot <= GLASS_COUNT; shot++) {
+                fill_solid(leds + hw::ledSegmentFirst(shot), hw::ledSegmentLength(shot),
+                           CHSV(hue, 255, g_glassPresent[shot - 1] ? 150 : 60));
+            }
             break;
             
         case STATE_MOVING:
@@ -310,6 +680,25 @@ void updateLED(SystemState state, PourMode mode) {
                 }
             }
             break;
+        
+        case STATE_PAUSED:
+            // Повільне дихання кольором режиму
+            fill_solid(leds, LED_COUNT, CHSV(hue, 255, beatsin8(20, 40, 200)));
+            break;
+        
+        case STATE_CLEANING:
+            // Бірюзовий біжучий вогник
+            {
+                uint8_t pos = beat8(30) * LED_COUNT / 256;
+                fill_solid(leds, LED_COUNT, CRGB::Black);
+                leds[pos] = CRGB(0, 200, 200);
+            }
+            break;
+            
+        case STATE_UPDATING:
+            // Повільне синє дихання
+            fill_solid(leds, LED_COUNT, CRGB(0, 0, beatsin8(20, 20, 200)));
+            break;
             
         case STATE_ERROR:
             // Червоне мигання
@@ -324,10 +713,26 @@ void updateLED(SystemState state, PourMode mode) {
             break;
     }
     
-    FastLED.show();
+    {
+        TRACE_SCOPE(TRACE_LED_SHOW);
+        FastLED.show();
+    }
     lastUpdate = millis();
 }
 
+void setServoPower(bool on) {
+    if (on) {
+        digitalWrite(SERVO_POWER, HIGH);
+        if (!servo.attached()) {
+            servo.attach(SERVO_PIN, SERVO_MIN_US, SERVO_MAX_US);
+            servo.write(POS_PARKING);
+        }
+    } else {
+        servo.detach();
+        digitalWrite(SERVO_POWER, LOW);
+    }
+}
+
 // API функції
 void setTargetVolume(uint16_t vol) {
     if (vol >= VOLUME_MIN && vol <= VOLUME_MAX) {
@@ -349,8 +754,20 @@ void setPourMode(PourMode mode) {
     DEBUG_PRINTF("Mode set: %s\n", mode == MODE_MANUAL ? "Manual" : "Auto");
 }
 
+bool shotLocked() {
+#if MANIFOLD_CHANNELS
+    return false;
+#else
+    return g_systemState == STATE_MOVING || g_systemState == STATE_POURING || g_systemState == STATE_PAUSED;
+#endif
+}
+
 void selectShot(uint8_t shot) {
-    if (shot >= 1 && shot <= 5) {
+    if (shotLocked()) {
+        LOG_W("Shot %d: pour in progress, selection unchanged", shot);
+        return;
+    }
+    if (shot >= 1 && shot <= GLASS_COUNT) {
         g_selectedShot = shot;
         
         extern void saveSettings();
@@ -358,4 +775,105 @@ void selectShot(uint8_t shot) {
         
         DEBUG_PRINTF("Shot selected: %d\n", shot);
     }
+}
+
+void setPumpRate(float mlPerSec) {
+    if (mlPerSec >= PUMP_RATE_MIN && mlPerSec <= PUMP_RATE_MAX) {
+        g_pumpRate = mlPerSec;
+        
+        extern void saveSettings();
+        saveSettings();
+        
+        LOG_I("Pump rate set: %.2f ml/s", mlPerSec);
+    }
+}
+
+// ========================================
+// ЧЕРГА ЗАМОВЛЕНЬ
+// ========================================
+
+bool queuePour(uint8_t shot, uint16_t volume) {
+    if (shot < 1 || shot > GLASS_COUNT || volume < VOLUME_MIN || volume > VOLUME_MAX) return false;
+#if MANIFOLD_CHANNELS
+    if (shot > MANIFOLD_CHANNELS) return false;
+#endif
+    if (g_systemState == STATE_UPDATING) return false;
+    
+    portENTER_CRITICAL(&controlMux);
+    bool added = pourQueueCount < POUR_QUEUE_SIZE;
+    if (added) {
+        pourQueue[(pourQueueHead + pourQueueCount) % POUR_QUEUE_SIZE] = {shot, volume};
+        pourQueueCount++;
+    }
+    portEXIT_CRITICAL(&controlMux);
+    
+    return added;
+}
+
+void clearPourQueue() {
+    portENTER_CRITICAL(&controlMux);
+    pourQueueHead = 0;
+    pourQueueCount = 0;
+    portEXIT_CRITICAL(&controlMux);
+}
+
+// Рюмки, куди ще можна налити: стоять, порожні, не в черзі і не під краном
+static uint8_t freeGlassMaskLocked() {
+    uint8_t mask = 0;
+    for (int i = 0; i < GLASS_COUNT; i++) {
+        if (g_glassPresent[i] && !glassFilled[i]) mask |= 1 << i;
+    }
+    for (uint8_t i = 0; i < pourQueueCount; i++) {
+        mask &= ~(1 << (pourQueue[(pourQueueHead + i) % POUR_QUEUE_SIZE].shot - 1));
+    }
+    if (isPourActive || g_systemState == STATE_MOVING) {
+        mask &= ~(1 << (pourShot - 1));
+    }
+#if MANIFOLD_CHANNELS
+    // Рюмки без свого виходу колектор не наливає
+    mask &= manifoldBusyMask() ^ ((1 << MANIFOLD_CHANNELS) - 1);
+#endif
+    return mask;
+}
+
+uint8_t freeGlassMask() {
+    portENTER_CRITICAL(&controlMux);
+    uint8_t mask = freeGlassMaskLocked();
+    portEXIT_CRITICAL(&controlMux);
+    
+    return mask;
+}
+
+bool queuePourAny(uint16_t volume, uint8_t &shot) {
+    if (volume < VOLUME_MIN || volume > VOLUME_MAX) return false;
+    if (g_systemState == STATE_UPDATING) return false;
+    
+    portENTER_CRITICAL(&controlMux);
+    uint8_t mask = pourQueueCount < POUR_QUEUE_SIZE ? freeGlassMaskLocked() : 0;
+    shot = 0;
+    for (int i = 0; i < GLASS_COUNT && shot == 0; i++) {
+        if (mask & (1 << i)) shot = i + 1;
+    }
+    if (shot != 0) {
+        pourQueue[(pourQueueHead + pourQueueCount) % POUR_QUEUE_SIZE] = {shot, volume};
+        pourQueueCount++;
+    }
+    portEXIT_CRITICAL(&controlMux);
+    
+    return shot != 0;
+}
+
+uint8_t pourQueueLength() {
+    return pourQueueCount;
+}
+
+bool pourQueueAt(uint8_t index, PourOrder &out) {
+    portENTER_CRITICAL(&controlMux);
+    bool found = index < pourQueueCount;
+    if (found) {
+        out = pourQueue[(pourQueueHead + index) % POUR_QUEUE_SIZE];
+    }
+    portEXIT_CRITICAL(&controlMux);
+    
+    return found;
 }
\ No newline at end of file
@@ -1,7 +1,15 @@
 #include "display.h"
+#include "control.h"
+#include "recipes.h"
+
+extern uint8_t g_selectedRecipe;
 
 TFT_eSPI tft = TFT_eSPI();
 
+// Заставка без затримок: showSplash() малює текст, крапки домальовує updateDisplay()
+static unsigned long splashStart = 0;
+static bool splashActive = false;
+
 bool initDisplay() {
     Serial.println("[DISPLAY] Starting init...");
     
@@ -17,10 +25,11 @@ bool initDisplay() {
     tft.fillScreen(COLOR_BG);
     Serial.println("[DISPLAY] Screen fill - OK");
     
-    // Увімкнути підсвітку
+    // Увімкнути підсвітку (PWM - для тьмяного режиму простою)
     Serial.println("[DISPLAY] Enabling backlight (pin 4)...");
-    pinMode(TFT_BL, OUTPUT);
-    digitalWrite(TFT_BL, HIGH);
+    ledcSetup(BACKLIGHT_CHANNEL, BACKLIGHT_FREQ, 8);
+    ledcAttachPin(TFT_BL, BACKLIGHT_CHANNEL);
+    setBacklight(BACKLIGHT_ON);
     Serial.println("[DISPLAY] Backlight - OK");
     
     Serial.println("[DISPLAY] Drawing test rectangle...");
@@ -39,20 +48,9 @@ bool initDisplay() {
 }
 
 void showSplash() {
+    if (SPLASH_DURATION == 0) return;
     Serial.println("[DISPLAY] Showing splash screen...");
     
-    // Тестовые цвета
-    tft.fillScreen(TFT_BLACK);
-    delay(500);
-    tft.fillScreen(TFT_RED);
-    delay(500);
-    tft.fillScreen(TFT_GREEN);
-    delay(500);
-    tft.fillScreen(TFT_BLUE);
-    delay(500);
-    tft.fillScreen(TFT_WHITE);
-    delay(500);
-    
     tft.fillScreen(COLOR_BG);
     
     // Заголовок
@@ -68,24 +66,46 @@ void showSplash() {
     tft.print("v");
     tft.println(FIRMWARE_VERSION);
     
-    // Анімація
-    for (int i = 0; i < 3; i++) {
-        tft.fillCircle(SCREEN_WIDTH/2 - 20 + i*20, 140, 4, COLOR_SUCCESS);
-        delay(300);
+    splashStart = millis();
+    splashActive = true;
+}
+
+// Крок анімації заставки. false - заставка закрита, час малювати основний екран
+static bool updateSplash(SystemState state) {
+    unsigned long elapsed = millis() - splashStart;
+    
+    // Розлив не чекає на заставку
+    if (elapsed >= SPLASH_DURATION || state != STATE_IDLE) {
+        splashActive = false;
+        return false;
     }
     
-    Serial.println("[DISPLAY] Splash screen complete");
+    // Три крапки по черзі за час заставки
+    int dots = min(3, (int)(elapsed * 4 / SPLASH_DURATION));
+    for (int i = 0; i < dots; i++) {
+        tft.fillCircle(SCREEN_WIDTH/2 - 20 + i*20, 140, 4, COLOR_SUCCESS);
+    }
+    return true;
 }
 
-void updateDisplay(SystemState state, PourMode mode, uint16_t volume, uint8_t shot, bool glasses[5]) {
+void updateDisplay(SystemState state, PourMode mode, uint16_t volume, uint8_t shot, bool glasses[GLASS_COUNT]) {
+    TRACE_SCOPE(TRACE_DISPLAY);
+    
     static SystemState lastState = STATE_IDLE;
     static PourMode lastMode = MODE_MANUAL;
     static uint16_t lastVolume = 0;
     static uint8_t lastShot = 0;
+    static uint8_t lastRecipe = 0;
+    static bool forceRedraw = false;
+    
+    if (splashActive) {
+        if (updateSplash(state)) return;
+        forceRedraw = true;
+    }
     
     // Перемальовувати тільки при зміні
-    bool needRedraw = (state != lastState || mode != lastMode || 
-                       volume != lastVolume || shot != lastShot);
+    bool needRedraw = forceRedraw || (state != lastState || mode != lastMode || 
+                       volume != lastVolume || shot != lastShot || g_selectedRecipe != lastRecipe);
     
     if (needRedraw) {
         tft.fillScreen(COLOR_BG);
@@ -96,18 +116,29 @@ void updateDisplay(SystemState state, PourMode mode, uint16_t volume, uint8_t sh
         // Об'єм
         drawVolume(volume);
         
+        // Коктейль замість шоту
+        const char* recipe = recipeSelectedName();
+        if (recipe != NULL) {
+            tft.setTextColor(COLOR_WARNING);
+            tft.setTextSize(1);
+            tft.setCursor((SCREEN_WIDTH - strlen(recipe) * 6) / 2, 118);
+            tft.print(recipe);
+        }
+        
         // Вибір рюмки
         drawShotSelector(shot, glasses);
         
-        // Прогрес (якщо розлив)
-        if (state == STATE_POURING) {
-            drawProgress(50); // TODO: реальний прогрес
+        // Прогрес (якщо розлив або пауза)
+        if ((state == STATE_POURING || state == STATE_PAUSED) && pourTargetMl() > 0) {
+            drawProgress(pourDispensedMl() * 100 / pourTargetMl());
         }
         
         lastState = state;
         lastMode = mode;
         lastVolume = volume;
         lastShot = shot;
+        lastRecipe = g_selectedRecipe;
+        forceRedraw = false;
     }
 }
 
@@ -142,6 +173,9 @@ void drawStatusBar(SystemState state, PourMode mode) {
         case STATE_CLEANING:
             tft.print("Cleaning");
             break;
+        case STATE_UPDATING:
+            tft.print("Updating");
+            break;
     }
     
     // Режим
@@ -167,13 +201,15 @@ void drawVolume(uint16_t volume) {
     tft.print("ml");
 }
 
-void drawShotSelector(uint8_t selected, bool glasses[5]) {
+void drawShotSelector(uint8_t selected, bool glasses[GLASS_COUNT]) {
+    // Ряд кружків на всю ширину, скільки б рюмок не було в профілі
+    constexpr int spacing = (SCREEN_WIDTH - 10) / GLASS_COUNT;
+    constexpr int radius = spacing / 2 - 2 < 10 ? spacing / 2 - 2 : 10;
+    constexpr int startX = (SCREEN_WIDTH - GLASS_COUNT * spacing + spacing) / 2;
     int startY = 140;
-    int spacing = 25;
-    int radius = 10;
     
-    for (int i = 0; i < 5; i++) {
-        int x = 15 + i * spacing;
+    for (int i = 0; i < GLASS_COUNT; i++) {
+        int x = startX + i * spacing;
         int y = startY;
         
         // Колір залежно від вибору та наявності рюмки
@@ -217,6 +253,10 @@ void drawProgress(uint8_t percent) {
     tft.print("%");
 }
 
+void setBacklight(uint8_t level) {
+    ledcWrite(BACKLIGHT_CHANNEL, level);
+}
+
 void showError(const char* message) {
     tft.fillScreen(COLOR_ERROR);
     
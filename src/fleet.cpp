@@ -0,0 +1,621 @@
+#include "fleet.h"
+
+#if ENABLE_WIFI && ENABLE_FLEET
+
+#include "control.h"
+#include "storage.h"
+#include "network.h"
+
+extern SystemState g_systemState;
+extern Statistics g_stats;
+extern bool g_fleetEnabled;
+
+// ========================================
+// ФОРМАТ ПАКЕТІВ
+// ========================================
+
+// Little-endian без вирівнювання - однаково на ESP32 і x86 (симулятор)
+#define FLEET_MAGIC     0x4C464447UL    // "GDFL"
+#define FLEET_VERSION   1
+
+enum FleetMsgType : uint8_t {
+    FLEET_MSG_STATUS = 1,       // Статус вузла, multicast періодично і при змінах
+    FLEET_MSG_ORDER,            // Замовлення для target
+    FLEET_MSG_ACK               // Відповідь target на замовлення
+};
+
+enum FleetAckStatus : uint8_t {
+    FLEET_ACK_QUEUED = 0,       // Поставлено в чергу
+    FLEET_ACK_NO_GLASS          // Вільної рюмки вже немає - шукати інший вузол
+};
+
+struct __attribute__((packed)) FleetHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t type;
+    uint16_t reserved;
+    uint32_t node;              // Відправник
+};
+
+struct __attribute__((packed)) FleetStatusMsg {
+    FleetHeader hdr;
+    uint32_t seq;
+    uint8_t state;
+    uint8_t freeMask;
+    uint8_t queueLen;
+    uint8_t queueFree;
+    uint32_t totalPours;
+    char name[16];
+};
+
+struct __attribute__((packed)) FleetOrderMsg {
+    FleetHeader hdr;
+    uint32_t target;
+    uint32_t orderId;
+    uint16_t volume;
+    uint16_t reserved;
+};
+
+struct __attribute__((packed)) FleetAckMsg {
+    FleetHeader hdr;
+    uint32_t target;            // Вузол, що надіслав замовлення
+    uint32_t orderId;
+    uint8_t status;
+    uint8_t shot;
+    uint16_t reserved;
+};
+
+// ========================================
+// СТАН
+// ========================================
+
+// Замовлення, надіслане іншому вузлу і ще не підтверджене
+struct FleetPending {
+    bool used;
+    bool rejected;              // NO_GLASS - перенаправити
+    uint8_t attempts;
+    uint8_t reroutes;
+    uint16_t volume;
+    uint32_t orderId;
+    uint32_t target;
+    unsigned long sentAt;
+};
+
+// Прийняте замовлення: повтор від відправника отримує ту саму відповідь
+struct FleetSeen {
+    uint32_t origin;
+    uint32_t orderId;
+    uint8_t status;
+    uint8_t shot;
+};
+
+static AsyncUDP fleetUdp;
+static portMUX_TYPE fleetMux = portMUX_INITIALIZER_UNLOCKED;   // UDP задача / loop() / HTTP
+
+static FleetPeer fleetPeers[FLEET_MAX_PEERS];
+static uint8_t fleetPeerCount = 0;
+static FleetPending fleetPending[FLEET_PENDING_MAX];
+static FleetSeen fleetSeen[FLEET_PENDING_MAX];
+static uint8_t fleetSeenNext = 0;
+
+static uint32_t fleetId = 0;
+static char fleetName[16];
+static bool fleetListening = false;
+static unsigned long fleetListenAttempt = 0;
+static uint32_t fleetSeq = 0;
+static uint32_t fleetNextOrderId = 0;
+static unsigned long fleetLastStatus = 0;
+static uint32_t fleetSentHash = 0;
+
+// Лічильники
+static uint32_t fleetRouted = 0;        // Підтверджено іншими вузлами
+static uint32_t fleetLocal = 0;         // Поставлено в чергу тут
+static uint32_t fleetReceived = 0;      // Прийнято від інших вузлів
+static uint32_t fleetFailed = 0;        // Не знайшлося вузла
+
+static void fleetHeader(FleetHeader &hdr, uint8_t type) {
+    hdr.magic = FLEET_MAGIC;
+    hdr.version = FLEET_VERSION;
+    hdr.type = type;
+    hdr.reserved = 0;
+    hdr.node = fleetId;
+}
+
+static void fleetSend(const void *msg, size_t len) {
+    fleetUdp.writeTo((const uint8_t*)msg, len, FLEET_GROUP, FLEET_PORT);
+}
+
+// Цей вузол у тому ж вигляді, що й інші
+static void fleetSelf(FleetPeer &out) {
+    out.id = fleetId;
+    out.ip = (uint32_t)WiFi.localIP();
+    strlcpy(out.name, fleetName, sizeof(out.name));
+    out.state = g_systemState;
+    out.freeMask = freeGlassMask();
+    out.queueLen = pourQueueLength();
+    out.queueFree = POUR_QUEUE_SIZE - out.queueLen;
+    out.totalPours = g_stats.totalPours;
+    out.lastSeen = millis();
+}
+
+static uint8_t fleetGlassCount(uint8_t mask) {
+    uint8_t count = 0;
+    for (; mask; mask &= mask - 1) count++;
+    return count;
+}
+
+static bool fleetEligible(const FleetPeer &p) {
+    return p.state != STATE_ERROR && p.state != STATE_UPDATING && p.freeMask != 0 && p.queueFree > 0;
+}
+
+// Навантаження: черга плюс поточний розлив
+static uint8_t fleetLoad(const FleetPeer &p) {
+    return p.queueLen + (p.state == STATE_MOVING || p.state == STATE_POURING || p.state == STATE_PAUSED ? 1 : 0);
+}
+
+// Краще: менше навантаження, більше вільних рюмок, цей вузол (без мережі), менший id
+static bool fleetBetter(const FleetPeer &a, const FleetPeer &b) {
+    if (fleetLoad(a) != fleetLoad(b)) return fleetLoad(a) < fleetLoad(b);
+    
+    uint8_t freeA = fleetGlassCount(a.freeMask);
+    uint8_t freeB = fleetGlassCount(b.freeMask);
+    if (freeA != freeB) return freeA > freeB;
+    
+    if ((a.id == fleetId) != (b.id == fleetId)) return a.id == fleetId;
+    return a.id < b.id;
+}
+
+static FleetPeer* fleetFindPeerLocked(uint32_t id) {
+    for (uint8_t i = 0; i < fleetPeerCount; i++) {
+        if (fleetPeers[i].id == id) return &fleetPeers[i];
+    }
+    return NULL;
+}
+
+static void fleetRemovePeerLocked(uint8_t index) {
+    fleetPeers[index] = fleetPeers[--fleetPeerCount];
+}
+
+// ========================================
+// МАРШРУТИЗАЦІЯ
+// ========================================
+
+// Вибір вузла і відправка. reroutes - скільки вузлів уже відмовили
+static uint32_t fleetRoute(uint16_t volume, uint8_t reroutes) {
+    FleetPeer self;
+    fleetSelf(self);
+    
+    FleetOrderMsg msg;
+    uint32_t target = 0;
+    
+    portENTER_CRITICAL(&fleetMux);
+    FleetPeer *best = fleetEligible(self) ? &self : NULL;
+    for (uint8_t i = 0; i < fleetPeerCount; i++) {
+        if (fleetEligible(fleetPeers[i]) && (best == NULL || fleetBetter(fleetPeers[i], *best))) {
+            best = &fleetPeers[i];
+        }
+    }
+    
+    FleetPending *slot = NULL;
+    if (best != NULL && best != &self) {
+        for (uint8_t i = 0; i < FLEET_PENDING_MAX && slot == NULL; i++) {
+            if (!fleetPending[i].used) slot = &fleetPending[i];
+        }
+    }
+    
+    if (slot != NULL) {
+        FleetPeer *peer = best;
+        target = peer->id;
+        
+        *slot = {true, false, 1, reroutes, volume, ++fleetNextOrderId, target, millis()};
+        
+        // До наступного статусу вважаємо рюмку зайнятою - серія замовлень розходиться по вузлах
+        peer->freeMask &= peer->freeMask - 1;
+        peer->queueLen++;
+        peer->queueFree--;
+        
+        fleetHeader(msg.hdr, FLEET_MSG_ORDER);
+        msg.target = target;
+        msg.orderId = slot->orderId;
+        msg.volume = volume;
+        msg.reserved = 0;
+    }
+    portEXIT_CRITICAL(&fleetMux);
+    
+    if (target != 0) {
+        fleetSend(&msg, sizeof(msg));
+        LOG_I("Fleet: %d ml -> node %08lX", volume, (unsigned long)target);
+        return target;
+    }
+    
+    // Цей вузол найкращий або всі слоти відправки зайняті
+    uint8_t shot;
+    if (fleetEligible(self) && queuePourAny(volume, shot)) {
+        portENTER_CRITICAL(&fleetMux);
+        fleetLocal++;
+        portEXIT_CRITICAL(&fleetMux);
+        
+        LOG_I("Fleet: %d ml -> local shot %d", volume, shot);
+        return fleetId;
+    }
+    
+    return 0;
+}
+
+uint32_t fleetOrder(uint16_t volume) {
+    if (volume < VOLUME_MIN || volume > VOLUME_MAX) return 0;
+    
+    uint32_t target = fleetRoute(volume, 0);
+    if (target == 0) {
+        portENTER_CRITICAL(&fleetMux);
+        fleetFailed++;
+        portEXIT_CRITICAL(&fleetMux);
+        
+        LOG_W("Fleet: no free glass for %d ml", volume);
+    }
+    return target;
+}
+
+// ========================================
+// ПРИЙОМ (задача AsyncUDP)
+// ========================================
+
+static void fleetOnStatus(const FleetStatusMsg &msg, uint32_t ip) {
+    portENTER_CRITICAL(&fleetMux);
+    FleetPeer *peer = fleetFindPeerLocked(msg.hdr.node);
+    if (peer == NULL && fleetPeerCount < FLEET_MAX_PEERS) {
+        peer = &fleetPeers[fleetPeerCount++];
+    }
+    if (peer != NULL) {
+        peer->id = msg.hdr.node;
+        peer->ip = ip;
+        memcpy(peer->name, msg.name, sizeof(peer->name));
+        peer->name[sizeof(peer->name) - 1] = 0;
+        peer->state = msg.state;
+        peer->freeMask = msg.freeMask;
+        peer->queueLen = msg.queueLen;
+        peer->queueFree = msg.queueFree;
+        peer->totalPours = msg.totalPours;
+        peer->lastSeen = millis();
+    }
+    portEXIT_CRITICAL(&fleetMux);
+}
+
+static void fleetOnOrder(const FleetOrderMsg &msg) {
+    FleetAckMsg ack;
+    fleetHeader(ack.hdr, FLEET_MSG_ACK);
+    ack.target = msg.hdr.node;
+    ack.orderId = msg.orderId;
+    ack.reserved = 0;
+    
+    // Повтор уже прийнятого - тільки відповідь
+    bool seen = false;
+    portENTER_CRITICAL(&fleetMux);
+    for (uint8_t i = 0; i < FLEET_PENDING_MAX && !seen; i++) {
+        if (fleetSeen[i].origin == msg.hdr.node && fleetSeen[i].orderId == msg.orderId) {
+            ack.status = fleetSeen[i].status;
+            ack.shot = fleetSeen[i].shot;
+            seen = true;
+        }
+    }
+    portEXIT_CRITICAL(&fleetMux);
+    
+    if (!seen) {
+        uint8_t shot = 0;
+        bool queued = g_systemState != STATE_ERROR && queuePourAny(msg.volume, shot);
+        ack.status = queued ? FLEET_ACK_QUEUED : FLEET_ACK_NO_GLASS;
+        ack.shot = shot;
+        
+        portENTER_CRITICAL(&fleetMux);
+        fleetSeen[fleetSeenNext] = {msg.hdr.node, msg.orderId, ack.status, ack.shot};
+        fleetSeenNext = (fleetSeenNext + 1) % FLEET_PENDING_MAX;
+        if (queued) fleetReceived++;
+        portEXIT_CRITICAL(&fleetMux);
+        
+        if (queued) {
+            LOG_I("Fleet: order %d ml from %08lX -> shot %d", msg.volume, (unsigned long)msg.hdr.node, shot);
+        }
+    }
+    
+    fleetSend(&ack, sizeof(ack));
+}
+
+static void fleetOnAck(const FleetAckMsg &msg) {
+    portENTER_CRITICAL(&fleetMux);
+    for (uint8_t i = 0; i < FLEET_PENDING_MAX; i++) {
+        FleetPending &p = fleetPending[i];
+        if (!p.used || p.orderId != msg.orderId || p.target != msg.hdr.node) continue;
+        
+        if (msg.status == FLEET_ACK_QUEUED) {
+            p.used = false;
+            fleetRouted++;
+        } else {
+            // Перенаправлення - з loop(), тут лише позначка
+            p.rejected = true;
+            FleetPeer *peer = fleetFindPeerLocked(msg.hdr.node);
+            if (peer != NULL) peer->freeMask = 0;
+        }
+        break;
+    }
+    portEXIT_CRITICAL(&fleetMux);
+}
+
+static void fleetOnPacket(AsyncUDPPacket &packet) {
+    size_t len = packet.length();
+    if (len < sizeof(FleetHeader)) return;
+    
+    FleetHeader hdr;
+    memcpy(&hdr, packet.data(), sizeof(hdr));
+    if (hdr.magic != FLEET_MAGIC || hdr.version != FLEET_VERSION || hdr.node == fleetId) return;
+    
+    switch (hdr.type) {
+        case FLEET_MSG_STATUS:
+            if (len >= sizeof(FleetStatusMsg)) {
+                FleetStatusMsg msg;
+                memcpy(&msg, packet.data(), sizeof(msg));
+                fleetOnStatus(msg, (uint32_t)packet.remoteIP());
+            }
+            break;
+        
+        case FLEET_MSG_ORDER:
+            if (len >= sizeof(FleetOrderMsg)) {
+                FleetOrderMsg msg;
+                memcpy(&msg, packet.data(), sizeof(msg));
+                if (msg.target == fleetId) fleetOnOrder(msg);
+            }
+            break;
+        
+        case FLEET_MSG_ACK:
+            if (len >= sizeof(FleetAckMsg)) {
+                FleetAckMsg msg;
+                memcpy(&msg, packet.data(), sizeof(msg));
+                if (msg.target == fleetId) fleetOnAck(msg);
+            }
+            break;
+    }
+}
+
+// ========================================
+// LOOP
+// ========================================
+
+static void fleetStart() {
+    unsigned long now = millis();
+    if (fleetListenAttempt != 0 && now - fleetListenAttempt < 5000) return;
+    fleetListenAttempt = now;
+    
+    if (!fleetUdp.listenMulticast(FLEET_GROUP, FLEET_PORT)) {
+        LOG_E("Fleet: multicast listen failed");
+        return;
+    }
+    fleetUdp.onPacket(fleetOnPacket);
+    
+    fleetListening = true;
+    fleetListenAttempt = 0;
+    fleetLastStatus = 0;
+    LOG_I("Fleet: %s (%08lX) joined %s:%d", fleetName, (unsigned long)fleetId,
+          FLEET_GROUP.toString().c_str(), FLEET_PORT);
+}
+
+static void fleetStop() {
+    fleetUdp.close();
+    fleetListening = false;
+    
+    // Непідтверджені замовлення втрачені разом з мережею
+    portENTER_CRITICAL(&fleetMux);
+    for (uint8_t i = 0; i < FLEET_PENDING_MAX; i++) {
+        if (fleetPending[i].used) fleetFailed++;
+        fleetPending[i].used = false;
+    }
+    fleetPeerCount = 0;
+    portEXIT_CRITICAL(&fleetMux);
+    
+    LOG_I("Fleet: stopped");
+}
+
+static void fleetSendStatus(const FleetPeer &self) {
+    FleetStatusMsg msg;
+    fleetHeader(msg.hdr, FLEET_MSG_STATUS);
+    msg.seq = ++fleetSeq;
+    msg.state = self.state;
+    msg.freeMask = self.freeMask;
+    msg.queueLen = self.queueLen;
+    msg.queueFree = self.queueFree;
+    msg.totalPours = self.totalPours;
+    memset(msg.name, 0, sizeof(msg.name));
+    strlcpy(msg.name, fleetName, sizeof(msg.name));
+    
+    fleetSend(&msg, sizeof(msg));
+}
+
+// Повтори без відповіді, перенаправлення після відмови або мовчання
+static void fleetUpdatePending(unsigned long now) {
+    for (uint8_t i = 0; i < FLEET_PENDING_MAX; i++) {
+        FleetOrderMsg msg;
+        bool resend = false;
+        bool reroute = false;
+        uint16_t volume = 0;
+        uint8_t reroutes = 0;
+        
+        portENTER_CRITICAL(&fleetMux);
+        FleetPending &p = fleetPending[i];
+        if (p.used && (p.rejected || now - p.sentAt >= FLEET_RETRY_MS)) {
+            if (!p.rejected && p.attempts < FLEET_RETRIES) {
+                p.attempts++;
+                p.sentAt = now;
+                
+                fleetHeader(msg.hdr, FLEET_MSG_ORDER);
+                msg.target = p.target;
+                msg.orderId = p.orderId;
+                msg.volume = p.volume;
+                msg.reserved = 0;
+                resend = true;
+            } else {
+                // Мовчить - вважаємо, що вузла немає, до наступного статусу
+                if (!p.rejected) {
+                    for (uint8_t j = 0; j < fleetPeerCount; j++) {
+                        if (fleetPeers[j].id == p.target) {
+                            fleetRemovePeerLocked(j);
+                            break;
+                        }
+                    }
+                }
+                p.used = false;
+                volume = p.volume;
+                reroutes = p.reroutes;
+                reroute = true;
+            }
+        }
+        portEXIT_CRITICAL(&fleetMux);
+        
+        if (resend) {
+            fleetSend(&msg, sizeof(msg));
+        } else if (reroute) {
+            uint32_t target = reroutes < FLEET_REROUTES ? fleetRoute(volume, reroutes + 1) : 0;
+            if (target == 0) {
+                portENTER_CRITICAL(&fleetMux);
+                fleetFailed++;
+                portEXIT_CRITICAL(&fleetMux);
+                
+                LOG_W("Fleet: order %d ml not delivered", volume);
+            }
+        }
+    }
+}
+
+void updateFleet() {
+    bool wanted = g_fleetEnabled && WiFi.isConnected();
+    if (wanted && !fleetListening) fleetStart();
+    if (!wanted && fleetListening) fleetStop();
+    if (!fleetListening) return;
+    
+    unsigned long now = millis();
+    
+    // Вузли без статусів
+    portENTER_CRITICAL(&fleetMux);
+    for (uint8_t i = 0; i < fleetPeerCount; ) {
+        if (now - fleetPeers[i].lastSeen > FLEET_PEER_TIMEOUT) {
+            fleetRemovePeerLocked(i);
+        } else {
+            i++;
+        }
+    }
+    portEXIT_CRITICAL(&fleetMux);
+    
+    fleetUpdatePending(now);
+    
+    // Статус: періодично, або одразу при змінах (не частіше FLEET_HEARTBEAT_MIN)
+    FleetPeer self;
+    fleetSelf(self);
+    uint32_t hash = self.state | self.freeMask << 8 | self.queueLen << 16 | self.queueFree << 24;
+    
+    unsigned long elapsed = now - fleetLastStatus;
+    if (fleetLastStatus == 0 || elapsed >= FLEET_HEARTBEAT_MS ||
+        (hash != fleetSentHash && elapsed >= FLEET_HEARTBEAT_MIN)) {
+        fleetSendStatus(self);
+        fleetSentHash = hash;
+        fleetLastStatus = now;
+    }
+}
+
+// ========================================
+// API
+// ========================================
+
+void setupFleet() {
+    // Унікальна частина MAC (нижні 3 байти адреси лежать у старших бітах)
+    fleetId = (uint32_t)(ESP.getEfuseMac() >> 16);
+    if (fleetId == 0) fleetId = esp_random();
+    snprintf(fleetName, sizeof(fleetName), "%s-%04lX", DEVICE_NAME, (unsigned long)(fleetId >> 16));
+    
+    fleetNextOrderId = esp_random() & 0xFFFF;
+}
+
+void setFleetEnabled(bool enabled) {
+    if (g_fleetEnabled == enabled) return;
+    
+    g_fleetEnabled = enabled;
+    saveSettings();
+    LOG_I("Fleet %s", enabled ? "enabled" : "disabled");
+}
+
+bool fleetActive() {
+    return fleetListening;
+}
+
+uint32_t fleetNodeId() {
+    return fleetId;
+}
+
+// Знімок таблиці: цей вузол першим
+static uint8_t fleetSnapshot(FleetPeer *out) {
+    fleetSelf(out[0]);
+    
+    portENTER_CRITICAL(&fleetMux);
+    uint8_t count = fleetPeerCount;
+    memcpy(&out[1], fleetPeers, count * sizeof(FleetPeer));
+    portEXIT_CRITICAL(&fleetMux);
+    
+    return count + 1;
+}
+
+void serializeFleet(JsonDocument &doc) {
+    FleetPeer nodes[FLEET_MAX_PEERS + 1];
+    uint8_t count = fleetSnapshot(nodes);
+    unsigned long now = millis();
+    
+    doc["enabled"] = g_fleetEnabled;
+    doc["active"] = fleetListening;
+    doc["id"] = fleetId;
+    doc["name"] = fleetName;
+    
+    uint8_t pending = 0;
+    portENTER_CRITICAL(&fleetMux);
+    for (uint8_t i = 0; i < FLEET_PENDING_MAX; i++) {
+        if (fleetPending[i].used) pending++;
+    }
+    uint32_t routed = fleetRouted, local = fleetLocal, received = fleetReceived, failed = fleetFailed;
+    portEXIT_CRITICAL(&fleetMux);
+    
+    JsonObject counters = doc.createNestedObject("orders");
+    counters["routed"] = routed;
+    counters["local"] = local;
+    counters["received"] = received;
+    counters["failed"] = failed;
+    counters["pending"] = pending;
+    
+    JsonArray list = doc.createNestedArray("nodes");
+    for (uint8_t i = 0; i < count; i++) {
+        const FleetPeer &p = nodes[i];
+        JsonObject node = list.createNestedObject();
+        node["id"] = p.id;
+        node["name"] = p.name;
+        node["ip"] = IPAddress(p.ip).toString();
+        node["self"] = i == 0;
+        node["state"] = getStateString((SystemState)p.state);
+        node["free"] = p.freeMask;
+        node["queue"] = p.queueLen;
+        node["queueFree"] = p.queueFree;
+        node["pours"] = p.totalPours;
+        node["age"] = now - p.lastSeen;
+    }
+}
+
+void printFleetStatus(Print &out) {
+    FleetPeer nodes[FLEET_MAX_PEERS + 1];
+    uint8_t count = fleetSnapshot(nodes);
+    
+    out.printf("Fleet: %s, %s\n", g_fleetEnabled ? "enabled" : "disabled",
+               fleetListening ? "active" : "inactive");
+    for (uint8_t i = 0; i < count; i++) {
+        const FleetPeer &p = nodes[i];
+        out.printf("%c %08lX %-16s %-15s free %u, queue %u\n", i == 0 ? '*' : ' ',
+                   (unsigned long)p.id, p.name, IPAddress(p.ip).toString().c_str(),
+                   fleetGlassCount(p.freeMask), p.queueLen);
+    }
+    out.printf("Orders: %lu routed, %lu local, %lu received, %lu failed\n",
+               (unsigned long)fleetRouted, (unsigned long)fleetLocal,
+               (unsigned long)fleetReceived, (unsigned long)fleetFailed);
+}
+
+#endif // ENABLE_WIFI && ENABLE_FLEET
@@ -0,0 +1,161 @@
+#include "glass_sensor.h"
+
+// ========================================
+// ФІЛЬТР
+// ========================================
+
+void glassFilterReset(GlassFilter &filter) {
+    memset(&filter, 0, sizeof(filter));
+}
+
+uint16_t glassFilterBaseline(const GlassFilter &filter) {
+    return filter.baseline >> GLASS_ADC_BASELINE_SHIFT;
+}
+
+bool glassFilterStep(GlassFilter &filter, uint16_t level) {
+    filter.level = level;
+    
+    // Перший кадр: рюмка, що вже стоїть, не стає базовою лінією
+    if (!filter.primed) {
+        uint16_t start = level < GLASS_ADC_BASELINE_INIT ? level : GLASS_ADC_BASELINE_INIT;
+        filter.baseline = (uint32_t)start << GLASS_ADC_BASELINE_SHIFT;
+        filter.primed = true;
+    }
+    
+    int delta = (int)level - glassFilterBaseline(filter);
+    bool beyond = filter.present ? delta < GLASS_ADC_OFF_DELTA : delta > GLASS_ADC_ON_DELTA;
+    if (!beyond) {
+        filter.hold = 0;
+    } else if (++filter.hold >= GLASS_ADC_HOLD_FRAMES) {
+        filter.present = !filter.present;
+        filter.hold = 0;
+    }
+    
+    // Темніше за базову лінію - одразу вниз. Без рюмки і без підйому до порогу -
+    // повільно за освітленням бару; під рюмкою лінія стоїть
+    if (delta < 0) {
+        filter.baseline = (uint32_t)level << GLASS_ADC_BASELINE_SHIFT;
+    } else if (!filter.present && filter.hold == 0) {
+        filter.baseline += level - glassFilterBaseline(filter);
+    }
+    return filter.present;
+}
+
+#if GLASS_SENSOR_ANALOG
+
+#include <driver/adc.h>
+
+#define GLASS_ADC_BYTES (GLASS_ADC_FRAME * SOC_ADC_DIGI_RESULT_BYTES)
+
+static GlassFilter filters[GLASS_COUNT];
+static uint8_t channelGlass[8];             // Канал ADC1 -> рюмка, 0xFF - не наш
+static volatile uint8_t presentMask = 0;
+static volatile uint32_t frames = 0;
+static volatile uint32_t overruns = 0;
+static TaskHandle_t glassTaskHandle = NULL;
+
+// ========================================
+// DMA
+// ========================================
+
+static void glassTask(void *param) {
+    static uint8_t buf[GLASS_ADC_BYTES];
+    
+    for (;;) {
+        // Блокує до кадру DMA: задача спить, поки ADC сам заповнює буфер
+        uint32_t len = 0;
+        esp_err_t err = adc_digi_read_bytes(buf, sizeof(buf), &len, ADC_MAX_DELAY);
+        if (err == ESP_ERR_INVALID_STATE) {
+            // Внутрішній буфер драйвера переповнився - старі кадри загублено, дані свіжі
+            overruns++;
+        } else if (err != ESP_OK) {
+            continue;
+        }
+        
+        uint32_t sum[GLASS_COUNT] = {0};
+        uint16_t count[GLASS_COUNT] = {0};
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            const adc_digi_output_data_t *sample = (const adc_digi_output_data_t*)&buf[i];
+            uint8_t channel = sample->type1.channel;
+            if (channel >= sizeof(channelGlass) || channelGlass[channel] >= GLASS_COUNT) continue;
+            sum[channelGlass[channel]] += sample->type1.data;
+            count[channelGlass[channel]]++;
+        }
+        
+        uint8_t mask = 0;
+        for (uint8_t i = 0; i < GLASS_COUNT; i++) {
+            if (count[i] > 0) glassFilterStep(filters[i], sum[i] / count[i]);
+            if (filters[i].present) mask |= 1 << i;
+        }
+        presentMask = mask;
+        frames++;
+    }
+}
+
+void setupGlassSensors() {
+    memset(channelGlass, 0xFF, sizeof(channelGlass));
+    
+    adc_digi_init_config_t init = {};
+    init.max_store_buf_size = GLASS_ADC_BYTES * 4;
+    init.conv_num_each_intr = GLASS_ADC_BYTES;
+    
+    static adc_digi_pattern_config_t pattern[GLASS_COUNT];
+    for (uint8_t i = 0; i < GLASS_COUNT; i++) {
+        uint8_t channel = hw::adc1Channel(hw::glassPins[i]);
+        channelGlass[channel] = i;
+        init.adc1_chan_mask |= 1 << channel;
+        
+        pattern[i].atten = ADC_ATTEN_DB_11;
+        pattern[i].channel = channel;
+        pattern[i].unit = 0;            // ADC1
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+        glassFilterReset(filters[i]);
+    }
+    
+    adc_digi_configuration_t config = {};
+    config.conv_limit_en = 1;
+    config.conv_limit_num = 255;
+    config.pattern_num = GLASS_COUNT;
+    config.adc_pattern = pattern;
+    config.sample_freq_hz = GLASS_ADC_SAMPLE_HZ;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+    
+    esp_err_t err = adc_digi_initialize(&init);
+    if (err == ESP_OK) err = adc_digi_controller_configure(&config);
+    if (err == ESP_OK) err = adc_digi_start();
+    if (err != ESP_OK) {
+        LOG_E("Glass sensors: ADC DMA failed (%d), no glass detection", err);
+        return;
+    }
+    
+    xTaskCreatePinnedToCore(
+        glassTask,
+        "Glass_Task",
+        STACK_SIZE_GLASS,
+        NULL,
+        PRIORITY_GLASS,
+        &glassTaskHandle,
+        CORE_GLASS
+    );
+    
+    LOG_I("Glass sensors: %d ADC1 channels, %d Hz, frame %d samples",
+          GLASS_COUNT, GLASS_ADC_SAMPLE_HZ, GLASS_ADC_FRAME);
+}
+
+uint8_t glassSensorMask() {
+    return presentMask;
+}
+
+void printGlassSensors(Print &out) {
+    out.printf("Frames: %lu, overruns: %lu\n", (unsigned long)frames, (unsigned long)overruns);
+    for (uint8_t i = 0; i < GLASS_COUNT; i++) {
+        const GlassFilter &f = filters[i];
+        out.printf("  %d: GPIO%d level %4u, baseline %4u, %s\n", i + 1, hw::glassPins[i],
+                   f.level, glassFilterBaseline(f), f.present ? "glass" : "empty");
+    }
+    out.printf("Thresholds: on +%d, off +%d, hold %d frames\n",
+               GLASS_ADC_ON_DELTA, GLASS_ADC_OFF_DELTA, GLASS_ADC_HOLD_FRAMES);
+}
+
+#endif // GLASS_SENSOR_ANALOG
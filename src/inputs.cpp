@@ -0,0 +1,292 @@
+#include "inputs.h"
+#include "safety.h"
+#include "glass_sensor.h"
+
+static_assert(INPUT_QUEUE_SIZE <= 255, "edge queue indices are uint8_t");
+
+// Фронт з ISR
+struct InputEdge {
+    uint8_t input;
+    uint8_t level;
+    uint32_t us;
+};
+
+// Стан входу в контурі керування
+struct InputState {
+    bool active;                // Стабільний стан
+    bool dirty;                 // Були фронти після останньої зміни - звірити з рівнем
+    uint32_t changedUs;         // Остання прийнята зміна
+    uint32_t edgeUs;            // Останній фронт
+};
+
+// Натискання кнопки: довге, подвійне, використане
+struct PressState {
+    uint32_t downUs;
+    uint32_t upUs;
+    bool longFired;
+    bool consumed;
+    uint8_t clicks;             // Коротке відпущене і чекає на друге (лише енкодер)
+};
+
+#define PRESS_BUTTONS 2         // INPUT_ENCODER_SW, INPUT_START
+
+// Аналогові датчики рюмок - без переривань і без settle()
+#if GLASS_SENSOR_ANALOG
+#define INPUT_INTERRUPTS INPUT_GLASS_FIRST
+#else
+#define INPUT_INTERRUPTS INPUT_COUNT
+#endif
+
+// Пін і активний рівень читає ISR
+static uint8_t inputPins[INPUT_COUNT];
+static uint8_t inputActiveLevel[INPUT_COUNT];
+static volatile uint32_t isrEdgeUs[INPUT_COUNT];
+
+static portMUX_TYPE inputMux = portMUX_INITIALIZER_UNLOCKED;
+static InputEdge edges[INPUT_QUEUE_SIZE];
+static volatile uint8_t edgeHead = 0;
+static volatile uint8_t edgeCount = 0;
+static volatile uint32_t edgesDropped = 0;
+
+static InputState states[INPUT_COUNT];
+static PressState presses[PRESS_BUTTONS];
+
+// Розпізнані події до inputNext()
+static InputEvent events[INPUT_QUEUE_SIZE];
+static uint8_t eventHead = 0;
+static uint8_t eventCount = 0;
+
+// ========================================
+// ISR
+// ========================================
+
+static void IRAM_ATTR inputISR(void* arg) {
+    uint8_t input = (uint8_t)(uintptr_t)arg;
+    uint32_t now = micros();
+    uint8_t level = digitalRead(inputPins[input]);
+    
+    // START натиснуто: помпа стоп одразу. Брязкіт відпускання (фронт одразу після
+    // попереднього) нічого не зупиняє - розлив після "продовжити" не смикається
+    if (input == INPUT_START && level == inputActiveLevel[input] &&
+        now - isrEdgeUs[input] > DEBOUNCE_MS * 1000UL) {
+        safetyHaltISR();
+    }
+    isrEdgeUs[input] = now;
+    
+    portENTER_CRITICAL_ISR(&inputMux);
+    if (edgeCount < INPUT_QUEUE_SIZE) {
+        InputEdge &edge = edges[(edgeHead + edgeCount) % INPUT_QUEUE_SIZE];
+        edge.input = input;
+        edge.level = level;
+        edge.us = now;
+        edgeCount++;
+    } else {
+        edgesDropped++;
+    }
+    portEXIT_CRITICAL_ISR(&inputMux);
+}
+
+// ========================================
+// ПОДІЇ
+// ========================================
+
+static void pushEvent(uint8_t input, InputEventType type, uint32_t us) {
+    if (eventCount >= INPUT_QUEUE_SIZE) return;
+    InputEvent &event = events[(eventHead + eventCount) % INPUT_QUEUE_SIZE];
+    event.input = input;
+    event.type = type;
+    event.us = us;
+    eventCount++;
+}
+
+static bool doublePress(uint8_t input) {
+    return input == INPUT_ENCODER_SW;
+}
+
+// Прийнята зміна стабільного стану: DOWN/UP і розбір натискання
+static void applyChange(uint8_t input, bool active, uint32_t us) {
+    InputState &st = states[input];
+    st.active = active;
+    st.changedUs = us;
+    
+    pushEvent(input, active ? INPUT_DOWN : INPUT_UP, us);
+    if (input >= PRESS_BUTTONS) return;
+    
+    PressState &press = presses[input];
+    if (active) {
+        // Перше коротке вже не дочекалось другого - віддати його до нового натискання
+        bool second = press.clicks == 1 && us - press.upUs <= DOUBLE_PRESS_MS * 1000UL;
+        if (press.clicks == 1 && !second) pushEvent(input, INPUT_SHORT, us);
+        press.clicks = second ? 2 : 0;
+        press.downUs = us;
+        press.longFired = false;
+        press.consumed = false;
+        return;
+    }
+    
+    if (press.consumed || press.longFired) {
+        press.clicks = 0;
+    } else if (press.clicks == 2) {
+        pushEvent(input, INPUT_DOUBLE, us);
+        press.clicks = 0;
+    } else if (doublePress(input)) {
+        press.clicks = 1;
+        press.upUs = us;
+    } else {
+        pushEvent(input, INPUT_SHORT, us);
+    }
+}
+
+// Фронт з черги. Кнопка - перший фронт одразу, далі DEBOUNCE_MS тиші;
+// датчик - лише позначка, рівень звіряється, коли брязкіт стих
+static void processEdge(const InputEdge &edge) {
+    InputState &st = states[edge.input];
+    st.edgeUs = edge.us;
+    st.dirty = true;
+    if (edge.input >= PRESS_BUTTONS) return;
+    
+    bool active = edge.level == inputActiveLevel[edge.input];
+    if (active != st.active && edge.us - st.changedUs >= DEBOUNCE_MS * 1000UL) {
+        applyChange(edge.input, active, edge.us);
+    }
+}
+
+// Брязкіт стих: рівень, на якому вхід зупинився. Ловить і фронти, загублені в черзі
+static void settle(uint32_t now) {
+    for (uint8_t i = 0; i < INPUT_INTERRUPTS; i++) {
+        InputState &st = states[i];
+        if (!st.dirty) continue;
+        if (now - st.edgeUs < DEBOUNCE_MS * 1000UL || now - st.changedUs < DEBOUNCE_MS * 1000UL) continue;
+        
+        st.dirty = false;
+        bool active = digitalRead(inputPins[i]) == inputActiveLevel[i];
+        if (active != st.active) applyChange(i, active, now);
+    }
+}
+
+// Таймери натискань: довге, коротке без другого
+static void pressTimers(uint32_t now) {
+    for (uint8_t i = 0; i < PRESS_BUTTONS; i++) {
+        PressState &press = presses[i];
+        if (states[i].active) {
+            if (!press.longFired && !press.consumed && now - press.downUs >= LONG_PRESS_MS * 1000UL) {
+                press.longFired = true;
+                press.clicks = 0;
+                pushEvent(i, INPUT_LONG, now);
+            }
+        } else if (press.clicks == 1 && now - press.upUs > DOUBLE_PRESS_MS * 1000UL) {
+            press.clicks = 0;
+            pushEvent(i, INPUT_SHORT, now);
+        }
+    }
+}
+
+#if GLASS_SENSOR_ANALOG
+// Аналогові датчики: фільтр у задачі ADC уже прибрав брязкіт, маска - стабільний стан
+static void glassSensorChanges(uint32_t now) {
+    uint8_t mask = glassSensorMask();
+    for (uint8_t i = 0; i < GLASS_COUNT; i++) {
+        bool active = mask & (1 << i);
+        if (active != states[INPUT_GLASS_FIRST + i].active) applyChange(INPUT_GLASS_FIRST + i, active, now);
+    }
+}
+#endif
+
+bool inputNext(InputEvent &out) {
+    if (eventCount == 0) {
+        InputEdge edge;
+        for (;;) {
+            portENTER_CRITICAL(&inputMux);
+            bool found = edgeCount > 0;
+            if (found) {
+                edge = edges[edgeHead];
+                edgeHead = (edgeHead + 1) % INPUT_QUEUE_SIZE;
+                edgeCount--;
+            }
+            portEXIT_CRITICAL(&inputMux);
+            
+            if (!found) break;
+            processEdge(edge);
+        }
+        
+        uint32_t now = micros();
+        settle(now);
+#if GLASS_SENSOR_ANALOG
+        glassSensorChanges(now);
+#endif
+        pressTimers(now);
+        if (eventCount == 0) return false;
+    }
+    
+    out = events[eventHead];
+    eventHead = (eventHead + 1) % INPUT_QUEUE_SIZE;
+    eventCount--;
+    return true;
+}
+
+// ========================================
+// НАЛАШТУВАННЯ
+// ========================================
+
+void setupInputs() {
+    inputPins[INPUT_ENCODER_SW] = ENCODER_SW;
+    inputActiveLevel[INPUT_ENCODER_SW] = LOW;
+    inputPins[INPUT_START] = BUTTON_START;
+    inputActiveLevel[INPUT_START] = HIGH;
+    for (uint8_t i = 0; i < GLASS_COUNT; i++) {
+        inputPins[INPUT_GLASS_FIRST + i] = hw::glassPins[i];
+        inputActiveLevel[INPUT_GLASS_FIRST + i] = HIGH;
+    }
+    
+    pinMode(ENCODER_SW, INPUT_PULLUP);
+    pinMode(BUTTON_START, INPUT);
+#if GLASS_SENSOR_ANALOG
+    // Рюмки - з маски датчиків: на старті всі порожні, поставлені прийдуть подіями
+    // після перших кадрів (авторежим на постановку не наливає, лише показує)
+    setupGlassSensors();
+#else
+    for (uint8_t pin : hw::glassPins) pinMode(pin, INPUT);
+#endif
+    
+    // Стан на старті - без подій: рюмки, що вже стоять, не "ставили"
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < INPUT_COUNT; i++) {
+        states[i].active = i < INPUT_INTERRUPTS && digitalRead(inputPins[i]) == inputActiveLevel[i];
+        states[i].changedUs = now;
+        states[i].edgeUs = now;
+        states[i].dirty = false;
+        isrEdgeUs[i] = now;
+    }
+    // Кнопку, затиснуту на старті, не вважати натисканням
+    for (PressState &press : presses) {
+        press.clicks = 0;
+        press.longFired = true;
+        press.consumed = true;
+    }
+    
+    for (uint8_t i = 0; i < INPUT_INTERRUPTS; i++) {
+        attachInterruptArg(digitalPinToInterrupt(inputPins[i]), inputISR, (void*)(uintptr_t)i, CHANGE);
+    }
+}
+
+bool inputActive(uint8_t input) {
+    return input < INPUT_COUNT && states[input].active;
+}
+
+void inputConsume(uint8_t input) {
+    if (input >= PRESS_BUTTONS) return;
+    presses[input].consumed = true;
+    presses[input].clicks = 0;
+}
+
+void inputsResync() {
+    uint32_t now = micros();
+    for (InputState &st : states) {
+        st.dirty = true;
+        st.edgeUs = now - DEBOUNCE_MS * 1000UL;
+    }
+}
+
+uint32_t inputsDropped() {
+    return edgesDropped;
+}
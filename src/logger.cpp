@@ -0,0 +1,145 @@
+#include "config.h"
+#include <atomic>
+
+// Слот кільця. seq == номер запису + 1 коли запис завершено, 0 - під час запису
+struct LogSlot {
+    std::atomic<uint32_t> seq;
+    uint32_t timestamp;
+    uint8_t level;
+    char msg[LOG_MSG_LEN];
+};
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+
+static LogSlot logRing[LOG_RING_SIZE];
+static std::atomic<uint32_t> logNext(0);     // Наступний вільний номер
+static uint32_t logDrainCursor = 0;          // Курсор фонової задачі
+static std::atomic<uint32_t> logLost(0);     // Записи, перезаписані до виводу
+
+TaskHandle_t logTaskHandle = NULL;
+
+const char* logLevelName(uint8_t level) {
+    switch (level) {
+        case LOG_LEVEL_ERROR: return "E";
+        case LOG_LEVEL_WARN: return "W";
+        case LOG_LEVEL_INFO: return "I";
+        case LOG_LEVEL_DEBUG: return "D";
+        default: return "?";
+    }
+}
+
+void logWrite(uint8_t level, const char* fmt, ...) {
+    // Резервування слоту - без блокувань, безпечно з обох ядер
+    uint32_t idx = logNext.fetch_add(1, std::memory_order_relaxed);
+    LogSlot &slot = logRing[idx & (LOG_RING_SIZE - 1)];
+    
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    slot.timestamp = millis();
+    slot.level = level;
+    
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(slot.msg, LOG_MSG_LEN, fmt, args);
+    va_end(args);
+    
+    // Прибрати перенесення рядка в кінці (старі DEBUG_PRINTF з "\n")
+    if (len > LOG_MSG_LEN - 1) len = LOG_MSG_LEN - 1;
+    while (len > 0 && (slot.msg[len - 1] == '\n' || slot.msg[len - 1] == '\r')) {
+        slot.msg[--len] = 0;
+    }
+    
+    slot.seq.store(idx + 1, std::memory_order_release);
+}
+
+uint32_t logHead() {
+    return logNext.load(std::memory_order_acquire);
+}
+
+uint32_t logOldest() {
+    uint32_t head = logHead();
+    return head > LOG_RING_SIZE ? head - LOG_RING_SIZE : 0;
+}
+
+uint32_t logDropped() {
+    return logLost.load(std::memory_order_relaxed);
+}
+
+bool logRead(uint32_t &cursor, LogEntry &out) {
+    while (true) {
+        uint32_t head = logHead();
+        if (cursor >= head) return false;
+        
+        // Записувач обігнав курсор
+        if (head - cursor > LOG_RING_SIZE) {
+            cursor = head - LOG_RING_SIZE;
+        }
+        
+        const LogSlot &slot = logRing[cursor & (LOG_RING_SIZE - 1)];
+        uint32_t before = slot.seq.load(std::memory_order_acquire);
+        
+        // Запис ще не завершений - почекати до наступного виклику
+        if (before == 0 || before < cursor + 1) return false;
+        
+        // Слот уже перезаписаний новішим записом
+        if (before != cursor + 1) {
+            cursor++;
+            continue;
+        }
+        
+        out.seq = cursor;
+        out.timestamp = slot.timestamp;
+        out.level = slot.level;
+        memcpy(out.msg, slot.msg, LOG_MSG_LEN);
+        out.msg[LOG_MSG_LEN - 1] = 0;
+        
+        // Перевірка, що слот не перезаписали під час копіювання
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != before) {
+            cursor++;
+            continue;
+        }
+        
+        cursor++;
+        return true;
+    }
+}
+
+// Фонова задача - вивід у Serial поза контуром керування
+static void logTask(void *parameter) {
+    LogEntry entry;
+    char line[LOG_MSG_LEN + 24];
+    
+    while (true) {
+        uint32_t expected = logDrainCursor;
+        
+        while (logRead(logDrainCursor, entry)) {
+            if (entry.seq != expected) {
+                logLost.fetch_add(entry.seq - expected, std::memory_order_relaxed);
+            }
+            expected = entry.seq + 1;
+            
+            int len = snprintf(line, sizeof(line), "[%8lu] %s: %s\n",
+                (unsigned long)entry.timestamp, logLevelName(entry.level), entry.msg);
+            if (len > (int)sizeof(line) - 1) len = sizeof(line) - 1;
+            Serial.write((const uint8_t*)line, len);
+        }
+        
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL));
+    }
+}
+
+void initLog() {
+    if (logTaskHandle != NULL) return;
+    
+    xTaskCreatePinnedToCore(
+        logTask,
+        "Log_Task",
+        STACK_SIZE_LOG,
+        NULL,
+        PRIORITY_LOG,
+        &logTaskHandle,
+        CORE_LOG
+    );
+}
@@ -3,11 +3,26 @@
 #include "display.h"
 #include "control.h"
 #include "storage.h"
+#include "commands.h"
+#include "safety.h"
+#include "metrics.h"
+#include "power.h"
+#include "cleaning.h"
+#include "recipes.h"
+#include <esp_task_wdt.h>
 
 #if ENABLE_WIFI
 #include "network.h"
 #endif
 
+#if ENABLE_WIFI && ENABLE_FLEET
+#include "fleet.h"
+#endif
+
+#if ENABLE_WIFI && ENABLE_OTA
+#include "ota.h"
+#endif
+
 // FreeRTOS Task Handles
 TaskHandle_t uiTaskHandle = NULL;
 TaskHandle_t controlTaskHandle = NULL;
@@ -17,8 +32,12 @@ SystemState g_systemState = STATE_IDLE;
 PourMode g_pourMode = MODE_MANUAL;
 uint16_t g_targetVolume = VOLUME_DEFAULT;
 uint8_t g_selectedShot = 1;
-bool g_glassPresent[5] = {false};
-Statistics g_stats = {0};
+uint8_t g_selectedRecipe = 0;           // Коктейль: 0 - звичайний розлив, 1.. - рецепт
+bool g_glassPresent[GLASS_COUNT] = {false};
+Statistics g_stats = {};
+float g_pumpRate = PUMP_ML_PER_SEC;     // Калібрування помпи (мл/сек)
+float g_primeVolume = PRIME_ML_DEFAULT; // Мертвий об'єм трубки (мл)
+bool g_fleetEnabled = false;            // Режим флоту (кілька наливаторів)
 
 // Час останнього збереження статистики
 unsigned long lastStatsSave = 0;
@@ -27,9 +46,21 @@ unsigned long lastStatsSave = 0;
 void uiTask(void *parameter);
 void controlTask(void *parameter);
 
+// Етапи старту: тривалість кожного і час від увімкнення
+static unsigned long bootMark = 0;
+
+static void bootPhase(const char* name) {
+    unsigned long now = millis();
+    LOG_I("Boot: %s %lu ms (at %lu ms)", name, now - bootMark, now);
+    bootMark = now;
+}
+
 void setup() {
     Serial.begin(115200);
-    delay(100);
+    
+    // Логи з задач ідуть через кільцевий буфер
+    initLog();
+    bootMark = millis();
     
     Serial.println("\n\n=== GyverDrink T4 Start ===");
     Serial.print("Firmware: v");
@@ -37,44 +68,55 @@ void setup() {
     Serial.print("Free Heap: ");
     Serial.println(ESP.getFreeHeap());
     
-    // Ініціалізація дисплея
-    Serial.print("Init display... ");
-    if (!initDisplay()) {
-        Serial.println("FAILED!");
-        SAFE_RESTART();
-    }
-    Serial.println("OK");
-    
-    // Показати заставку
-    showSplash();
-    delay(2000);
-    
-    // Ініціалізація периферії
-    Serial.print("Init peripherals... ");
-    initPeripherals();
-    Serial.println("OK");
-    
-    // Завантаження налаштувань
+    // Завантаження налаштувань - потрібні і розливу, і мережі
     Serial.print("Loading settings... ");
     loadSettings();
+    loadRecipes();
     Serial.println("OK");
+
+    // Запис про збій попереднього запуску (watchdog, відсічка помпи)
+    safetyBootCheck();
+
+#if ENABLE_WIFI && ENABLE_OTA
+    // Непідтверджена прошивка, що не доживає до перевірки, відкочується тут
+    otaBootCheck();
+#endif
     
 #ifdef FACTORY_RESET
     Serial.println("FACTORY RESET!");
     resetSettings();
     delay(1000);
 #endif
+    bootPhase("settings");
     
-#if ENABLE_WIFI
-    // Ініціалізація мережі
-    Serial.print("Init network... ");
-    setupNetwork();
+    // Ініціалізація периферії (LED анімація - кадрами в controlTask)
+    Serial.print("Init peripherals... ");
+    initPeripherals();
+    setupPower();
     Serial.println("OK");
-#endif
+    bootPhase("peripherals");
     
-    // Створення задач FreeRTOS
+    // Створення задач FreeRTOS: розлив доступний, щойно стартує controlTask,
+    // дисплей ініціалізується в uiTask паралельно з мережею
     Serial.println("Creating tasks...");
     
+    // Control задача (управління) на ядрі 1
+    xTaskCreatePinnedToCore(
+        controlTask,
+        "Control_Task",
+        STACK_SIZE_CONTROL,
+        NULL,
+        PRIORITY_CONTROL,
+        &controlTaskHandle,
+        CORE_CONTROL
+    );
+    
+    if (controlTaskHandle == NULL) {
+        Serial.println("ERROR: Failed to create Control task!");
+        SAFE_RESTART();
+    }
+    Serial.println("Control Task started on core 1");
+    
     // UI задача (дисплей) на ядрі 0
     xTaskCreatePinnedToCore(
         uiTask,
@@ -92,23 +134,24 @@ void setup() {
     }
     Serial.println("UI Task started on core 0");
     
-    // Control задача (управління) на ядрі 1
-    xTaskCreatePinnedToCore(
-        controlTask,
-        "Control_Task",
-        STACK_SIZE_CONTROL,
-        NULL,
-        PRIORITY_CONTROL,
-        &controlTaskHandle,
-        CORE_CONTROL
-    );
-    
-    if (controlTaskHandle == NULL) {
-        Serial.println("ERROR: Failed to create Control task!");
-        SAFE_RESTART();
-    }
-    Serial.println("Control Task started on core 1");
+    // Watchdog задач і апаратна відсічка помпи - одразу: START може почати розлив,
+    // щойно стартував controlTask, ще до мережі
+    setupSafety(uiTaskHandle, controlTaskHandle);
+    bootPhase("tasks");
+
+#if ENABLE_WIFI
+    // Ініціалізація мережі. WiFi підключається у фоні, updateNetwork() веде далі
+    Serial.print("Init network... ");
+    setupNetwork();
+    Serial.println("OK");
+#endif
+
+#if ENABLE_WIFI && ENABLE_FLEET
+    setupFleet();
+#endif
+    bootPhase("network");
     
+    LOG_I("Boot complete in %lu ms", millis());
     Serial.println("Setup complete!");
     Serial.println("===================\n");
 }
@@ -120,7 +163,24 @@ void loop() {
     updateNetwork();
 #endif
     
-    // Періодичне збереження статистики
+#if ENABLE_WIFI && ENABLE_FLEET
+    updateFleet();
+#endif
+
+#if ENABLE_WIFI && ENABLE_OTA
+    updateOta();
+#endif
+    
+    // Команди з Serial (без блокування на readStringUntil)
+    updateCommands();
+    
+    // Watchdog loop() і наслідки відсічки помпи
+    updateSafety();
+    
+    // Облік часу роботи
+    updateUptime();
+    
+    // Періодичне збереження статистики (тільки якщо змінена)
     if (millis() - lastStatsSave > STATS_SAVE_INTERVAL) {
         saveStatistics();
         lastStatsSave = millis();
@@ -129,7 +189,7 @@ void loop() {
     // Debug info
     static unsigned long lastDebug = 0;
     if (millis() - lastDebug > 10000) {
-        Serial.printf("Heap: %d, State: %d, Volume: %d\n", 
+        LOG_D("Heap: %u, State: %d, Volume: %d",
             ESP.getFreeHeap(), g_systemState, g_targetVolume);
         lastDebug = millis();
     }
@@ -141,22 +201,42 @@ void loop() {
 // UI TASK - Оновлення дисплея
 // ========================================
 void uiTask(void *parameter) {
-    Serial.println("UI Task running");
+    // Дисплей - тут, а не в setup(): мережа і розлив не чекають на нього
+    unsigned long displayStart = millis();
+    if (!initDisplay()) {
+        LOG_E("Display init failed!");
+        SAFE_RESTART();
+    }
+    showSplash();
+    LOG_I("UI Task running, display ready in %lu ms", millis() - displayStart);
     
     TickType_t lastWakeTime = xTaskGetTickCount();
     const TickType_t frequency = pdMS_TO_TICKS(50); // 20 FPS
+    TickType_t period = frequency;
     
     while (true) {
-        // Оновити дисплей
-        updateDisplay(g_systemState, g_pourMode, g_targetVolume, g_selectedShot, g_glassPresent);
-        
-        // Перевірка стану пам'яті
-        if (ESP.getFreeHeap() < 50000) {
-            Serial.println("WARNING: Low memory!");
+        {
+            TRACE_SCOPE(TRACE_UI_LOOP);
+            
+            // Оновити дисплей
+            updateDisplay(g_systemState, g_pourMode, g_targetVolume, g_selectedShot, g_glassPresent);
+            
+            // Перевірка стану пам'яті
+            if (ESP.getFreeHeap() < 50000) {
+                LOG_W("Low memory!");
+            }
+            
+            esp_task_wdt_reset();
         }
         
+        // У сні екран погашений - кадри рідше
+        period = powerLevel() == POWER_SLEEP ? pdMS_TO_TICKS(POWER_SLEEP_UI_MS) : frequency;
+        
+        // Чи встигли до наступного кадру
+        TRACE_DEADLINE(TRACE_LOOP_UI, lastWakeTime, period);
+        
         // Чекати до наступного оновлення
-        vTaskDelayUntil(&lastWakeTime, frequency);
+        vTaskDelayUntil(&lastWakeTime, period);
     }
 }
 
@@ -164,108 +244,45 @@ void uiTask(void *parameter) {
 // CONTROL TASK - Управління розливом
 // ========================================
 void controlTask(void *parameter) {
-    Serial.println("Control Task running");
+    LOG_I("Control Task running, pour ready at %lu ms", millis());
     
     TickType_t lastWakeTime = xTaskGetTickCount();
     const TickType_t frequency = pdMS_TO_TICKS(10); // 100 Hz
+    TickType_t period = frequency;
     
     while (true) {
-        // Обробка енкодера та кнопок
-        updateControls();
+        // Відхилення періоду від номінального - гістограма в /metrics
+        metricsControlTick(period * portTICK_PERIOD_MS * 1000);
         
-        // Оновлення стану розливу
-        updatePourState();
+        {
+            TRACE_SCOPE(TRACE_CONTROL_LOOP);
+            
+            // Обробка енкодера та кнопок
+            updateControls();
+            
+            // Оновлення стану розливу
+            updatePourState();
+            
+            // Прокачка і промивка
+            updateCleaning();
+            
+            // Простій: підсвітка, LED, серво, частота CPU
+            updatePower();
+            
+            // Оновлення LED
+            updateLED(g_systemState, g_pourMode);
+            
+            // Відмітка для watchdog і таймера відсічки
+            safetyFeed();
+        }
         
-        // Оновлення LED
-        updateLED(g_systemState, g_pourMode);
+        // У сні - довші паузи для light sleep, реакція не довша за POWER_SLEEP_TICK_MS
+        period = powerLevel() == POWER_SLEEP ? pdMS_TO_TICKS(POWER_SLEEP_TICK_MS) : frequency;
         
-        // Чекати до наступного оновлення
-        vTaskDelayUntil(&lastWakeTime, frequency);
-    }
-}
-
-// ========================================
-// ДОПОМІЖНІ ФУНКЦІЇ
-// ========================================
-
-void stopAllTasks() {
-    Serial.println("Stopping all tasks...");
-    
-    if (uiTaskHandle != NULL) {
-        vTaskDelete(uiTaskHandle);
-        uiTaskHandle = NULL;
-    }
-    
-    if (controlTaskHandle != NULL) {
-        vTaskDelete(controlTaskHandle);
-        controlTaskHandle = NULL;
-    }
-    
-    // Зупинити розлив
-    stopPour();
-}
-
-// Serial команди для debug
-void serialEvent() {
-    if (Serial.available()) {
-        String cmd = Serial.readStringUntil('\n');
-        cmd.trim();
+        // Чи встигли до наступного тіку
+        TRACE_DEADLINE(TRACE_LOOP_CONTROL, lastWakeTime, period);
         
-        if (cmd == "help") {
-            Serial.println("\n=== Commands ===");
-            Serial.println("help - List commands");
-            Serial.println("stats - Show statistics");
-            Serial.println("heap - Show memory");
-            Serial.println("tasks - Show task info");
-            Serial.println("reset - Reset statistics");
-            Serial.println("restart - Restart device");
-            Serial.println("pour X - Pour X ml");
-            Serial.println("================\n");
-        }
-        else if (cmd == "stats") {
-            Serial.println("\n=== Statistics ===");
-            Serial.printf("Total pours: %d\n", g_stats.totalPours);
-            Serial.printf("Total volume: %d ml\n", g_stats.totalVolume);
-            Serial.printf("Total time: %d sec\n", g_stats.totalTime);
-            Serial.printf("Errors: %d\n", g_stats.errors);
-            Serial.println("==================\n");
-        }
-        else if (cmd == "heap") {
-            Serial.println("\n=== Memory ===");
-            Serial.printf("Free Heap: %d bytes\n", ESP.getFreeHeap());
-            Serial.printf("Min Free Heap: %d bytes\n", ESP.getMinFreeHeap());
-            Serial.printf("Heap Size: %d bytes\n", ESP.getHeapSize());
-            Serial.println("==============\n");
-        }
-        else if (cmd == "tasks") {
-            Serial.println("\n=== FreeRTOS Tasks ===");
-            Serial.printf("UI Task: %s\n", uiTaskHandle != NULL ? "Running" : "Stopped");
-            Serial.printf("Control Task: %s\n", controlTaskHandle != NULL ? "Running" : "Stopped");
-            Serial.printf("Free Heap: %d bytes\n", ESP.getFreeHeap());
-            Serial.println("======================\n");
-        }
-        else if (cmd == "reset") {
-            resetStatistics();
-            Serial.println("Statistics reset!");
-        }
-        else if (cmd == "restart") {
-            Serial.println("Restarting...");
-            delay(1000);
-            esp_restart();
-        }
-        else if (cmd.startsWith("pour ")) {
-            int vol = cmd.substring(5).toInt();
-            if (vol >= VOLUME_MIN && vol <= VOLUME_MAX) {
-                g_targetVolume = vol;
-                startPour();
-                Serial.printf("Pouring %d ml\n", vol);
-            } else {
-                Serial.println("Invalid volume!");
-            }
-        }
-        else {
-            Serial.println("Unknown command. Type 'help'");
-        }
+        // Чекати до наступного оновлення
+        vTaskDelayUntil(&lastWakeTime, period);
     }
 }
-
@@ -0,0 +1,353 @@
+#include "manifold.h"
+
+#if MANIFOLD_CHANNELS
+
+#include "control.h"
+#include "safety.h"
+#include "power.h"
+
+#if ENABLE_WIFI
+#include "network.h"
+#endif
+
+static_assert(MANIFOLD_LEDC_FIRST + MANIFOLD_CHANNELS <= BACKLIGHT_CHANNEL, "LEDC channels overlap the backlight");
+static_assert(MANIFOLD_CHANNEL_MA <= MANIFOLD_BUDGET_MA, "budget must fit at least one output");
+
+extern SystemState g_systemState;
+extern bool g_glassPresent[GLASS_COUNT];
+extern Statistics g_stats;
+extern float g_pumpRate;
+extern float g_primeVolume;
+
+// Пін читає ISR відсічки
+static const DRAM_ATTR uint8_t manifoldPins[] = MANIFOLD_PINS;
+static_assert(sizeof(manifoldPins) >= MANIFOLD_CHANNELS, "MANIFOLD_PINS shorter than MANIFOLD_CHANNELS");
+
+enum ChannelState : uint8_t {
+    CH_IDLE = 0,
+    CH_WAITING,         // Чекає на струм у бюджеті
+    CH_PUMPING,
+    CH_PAUSED
+};
+
+struct ManifoldChannel {
+    ChannelState state;
+    uint8_t duty;                   // Поточний вихід, для бюджету струму
+    uint16_t volume;
+    unsigned long startMs;          // Початок поточного відрізка роботи
+    unsigned long pumpedMs;         // Відпрацьовано до паузи
+    unsigned long primeMs;          // Заповнення злитої трубки на початку
+    unsigned long lastOffMs;        // Трубка заповнена до PRIME_HOLD_TIME після зупинки
+    unsigned long onMs;             // Вихід увімкнено з нуля - для таймера відсічки
+    bool primed;
+};
+
+static ManifoldChannel channels[MANIFOLD_CHANNELS];
+
+// ========================================
+// ВИХОДИ
+// ========================================
+
+static uint32_t currentMa() {
+    uint32_t ma = 0;
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        ma += (uint32_t)MANIFOLD_CHANNEL_MA * channels[i].duty / 255;
+    }
+    return ma;
+}
+
+// Таймер відсічки один на всі виходи і рахує від виходу, що працює найдовше:
+// повторний запис чи ще один вихід відлік не перезапускають, вимкнення
+// останнього знімає охорону
+static void armCutoff() {
+    bool on = false;
+    unsigned long oldest = 0;
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        const ManifoldChannel &c = channels[i];
+        if (c.duty == 0) continue;
+        if (!on || (long)(c.onMs - oldest) < 0) oldest = c.onMs;
+        on = true;
+    }
+    
+    if (on) {
+        safetyPumpOn(oldest);
+    } else {
+        safetyPumpOff();
+    }
+}
+
+static void output(uint8_t ch, uint8_t duty) {
+    ManifoldChannel &c = channels[ch];
+    if (c.duty != 0 && duty == 0) {
+        c.primed = true;
+        c.lastOffMs = millis();
+    } else if (c.duty == 0 && duty != 0) {
+        c.onMs = millis();
+    }
+    c.duty = duty;
+    ledcWrite(MANIFOLD_LEDC_FIRST + ch, duty);
+    armCutoff();
+}
+
+static unsigned long channelElapsed(const ManifoldChannel &c, unsigned long now) {
+    if (c.state == CH_PUMPING) return c.pumpedMs + (now - c.startMs);
+    return c.pumpedMs;
+}
+
+static uint16_t channelDispensed(const ManifoldChannel &c, unsigned long now) {
+    unsigned long elapsed = channelElapsed(c, now);
+    if (elapsed <= c.primeMs) return 0;
+    float ml = (elapsed - c.primeMs) * g_pumpRate / 1000;
+    return ml < c.volume ? (uint16_t)ml : c.volume;
+}
+
+void setupManifold() {
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        pinMode(manifoldPins[i], OUTPUT);
+        digitalWrite(manifoldPins[i], LOW);
+        ledcSetup(MANIFOLD_LEDC_FIRST + i, PUMP_FREQ, 8);
+        ledcAttachPin(manifoldPins[i], MANIFOLD_LEDC_FIRST + i);
+        ledcWrite(MANIFOLD_LEDC_FIRST + i, 0);
+    }
+    
+    LOG_I("Manifold: %d outputs, %d mA budget (%d at full PWM)",
+          MANIFOLD_CHANNELS, MANIFOLD_BUDGET_MA, MANIFOLD_BUDGET_MA / MANIFOLD_CHANNEL_MA);
+}
+
+void manifoldWrite(uint8_t shot, uint8_t duty) {
+    if (shot < 1 || shot > MANIFOLD_CHANNELS) return;
+    output(shot - 1, duty);
+}
+
+void IRAM_ATTR manifoldCutoffISR() {
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        ledcDetachPin(manifoldPins[i]);
+        digitalWrite(manifoldPins[i], LOW);
+    }
+}
+
+void manifoldReattach() {
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        channels[i].duty = 0;
+        ledcWrite(MANIFOLD_LEDC_FIRST + i, 0);
+        ledcAttachPin(manifoldPins[i], MANIFOLD_LEDC_FIRST + i);
+    }
+}
+
+// ========================================
+// РОЗЛИВИ
+// ========================================
+
+bool manifoldStart(uint8_t shot, uint16_t volume) {
+    if (g_systemState == STATE_UPDATING || g_systemState == STATE_CLEANING || g_systemState == STATE_PAUSED) {
+        LOG_W("Manifold: not ready (%d)", g_systemState);
+        return false;
+    }
+    if (shot < 1 || shot > MANIFOLD_CHANNELS || !g_glassPresent[shot - 1]) {
+        LOG_W("No glass detected!");
+        return false;
+    }
+    
+    ManifoldChannel &c = channels[shot - 1];
+    if (c.state != CH_IDLE) {
+        LOG_W("Manifold: shot %d already pouring", shot);
+        return false;
+    }
+    
+    // Зі сну: таймери простою не вимкнуть нічого посеред розливу
+    powerWake();
+    
+    bool primed = c.primed && millis() - c.lastOffMs < PRIME_HOLD_TIME;
+    
+    portENTER_CRITICAL(&controlMux);
+    c.volume = volume;
+    c.pumpedMs = 0;
+    c.primeMs = primed ? 0 : (unsigned long)(g_primeVolume / g_pumpRate * 1000);
+    c.state = CH_WAITING;
+    g_systemState = STATE_POURING;
+    portEXIT_CRITICAL(&controlMux);
+    
+    LOG_I("Starting pour: %d ml to shot %d%s", volume, shot, primed ? "" : " (priming tube)");
+    return true;
+}
+
+void manifoldStop() {
+    portENTER_CRITICAL(&controlMux);
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        channels[i].state = CH_IDLE;
+    }
+    portEXIT_CRITICAL(&controlMux);
+    
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        output(i, 0);
+    }
+}
+
+bool manifoldPause() {
+    // Виходи вже знеструмив ISR кнопки START - налите рахувати до того моменту
+    unsigned long now = safetyHaltMs() != 0 ? safetyHaltMs() : millis();
+    bool paused = false;
+    
+    portENTER_CRITICAL(&controlMux);
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        ManifoldChannel &c = channels[i];
+        if (c.state == CH_PUMPING && now > c.startMs) c.pumpedMs += now - c.startMs;
+        if (c.state == CH_PUMPING || c.state == CH_WAITING) {
+            c.state = CH_PAUSED;
+            paused = true;
+        }
+    }
+    if (paused) g_systemState = STATE_PAUSED;
+    portEXIT_CRITICAL(&controlMux);
+    
+    if (!paused) return false;
+    
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        if (channels[i].duty != 0) output(i, 0);
+    }
+    LOG_I("Pour paused: %d of %d ml", manifoldDispensedMl(), manifoldTargetMl());
+    return true;
+}
+
+bool manifoldResume() {
+    if (g_systemState != STATE_PAUSED) return false;
+    
+    // Рюмки на місці - в чергу за струмом, зняті - лишаються на паузі
+    bool resumed = false;
+    portENTER_CRITICAL(&controlMux);
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        if (channels[i].state == CH_PAUSED && g_glassPresent[i]) {
+            channels[i].state = CH_WAITING;
+            resumed = true;
+        }
+    }
+    if (resumed) g_systemState = STATE_POURING;
+    portEXIT_CRITICAL(&controlMux);
+    
+    if (!resumed) {
+        LOG_W("No glass detected!");
+        return false;
+    }
+    LOG_I("Resuming pour: %d ml left", manifoldTargetMl() - manifoldDispensedMl());
+    return true;
+}
+
+static void complete(uint8_t ch, unsigned long now) {
+    ManifoldChannel &c = channels[ch];
+    unsigned long pumpMs = channelElapsed(c, now);
+    
+    c.state = CH_IDLE;
+    output(ch, 0);
+    
+    LOG_I("Pour complete: shot %d", ch + 1);
+    recordPour(ch + 1, c.volume, pumpMs);
+}
+
+void updateManifold() {
+    if (g_systemState != STATE_POURING && g_systemState != STATE_PAUSED) return;
+    
+    unsigned long now = millis();
+    bool changed = false;
+    
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        ManifoldChannel &c = channels[i];
+        if (c.state == CH_IDLE || c.state == CH_PAUSED) continue;
+        
+        // Рюмку зняли - цей розлив скасовано, решта триває
+        if (!g_glassPresent[i]) {
+            LOG_W("Pour cancelled: glass %d removed", i + 1);
+            c.state = CH_IDLE;
+            output(i, 0);
+            changed = true;
+            continue;
+        }
+        if (c.state != CH_PUMPING) continue;
+        
+        unsigned long elapsed = channelElapsed(c, now);
+        if (elapsed > MAX_POUR_TIME) {
+            LOG_E("Pour timeout: shot %d", i + 1);
+            stopPour();
+            g_systemState = STATE_ERROR;
+            portENTER_CRITICAL(&controlMux);
+            g_stats.errors++;
+            portEXIT_CRITICAL(&controlMux);
+            
+            extern void markStatisticsDirty();
+            markStatisticsDirty();
+            return;
+        }
+        if (elapsed >= c.primeMs + pourDurationMs(c.volume)) {
+            complete(i, now);
+            changed = true;
+        }
+    }
+    
+    // Ті, що чекають - по порядку рюмок, поки струм у межах бюджету
+    if (g_systemState == STATE_POURING) {
+        for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+            ManifoldChannel &c = channels[i];
+            if (c.state != CH_WAITING) continue;
+            if (currentMa() + (uint32_t)MANIFOLD_CHANNEL_MA * PUMP_SPEED_DEFAULT / 255 > MANIFOLD_BUDGET_MA) break;
+            
+            c.startMs = now;
+            c.state = CH_PUMPING;
+            output(i, PUMP_SPEED_DEFAULT);
+            changed = true;
+        }
+    }
+    
+    // Останній розлив закінчився
+    if (manifoldBusyMask() == 0) {
+        g_systemState = STATE_IDLE;
+        changed = true;
+    }
+
+#if ENABLE_WIFI
+    if (changed) broadcastState();
+#endif
+}
+
+// ========================================
+// СТАТУС
+// ========================================
+
+uint8_t manifoldBusyMask() {
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        if (channels[i].state != CH_IDLE) mask |= 1 << i;
+    }
+    return mask;
+}
+
+uint16_t manifoldDispensedMl() {
+    unsigned long now = millis();
+    uint16_t ml = 0;
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        if (channels[i].state != CH_IDLE) ml += channelDispensed(channels[i], now);
+    }
+    return ml;
+}
+
+uint16_t manifoldTargetMl() {
+    uint16_t ml = 0;
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        if (channels[i].state != CH_IDLE) ml += channels[i].volume;
+    }
+    return ml;
+}
+
+void printManifoldStatus(Print &out) {
+    static const char* const names[] = {"idle", "waiting", "pumping", "paused"};
+    unsigned long now = millis();
+    
+    out.printf("Outputs: %d, current %lu of %d mA\n", MANIFOLD_CHANNELS,
+               (unsigned long)currentMa(), MANIFOLD_BUDGET_MA);
+    for (uint8_t i = 0; i < MANIFOLD_CHANNELS; i++) {
+        const ManifoldChannel &c = channels[i];
+        out.printf("  %d: GPIO%d %-7s", i + 1, manifoldPins[i], names[c.state]);
+        if (c.state != CH_IDLE) out.printf(" %d of %d ml", channelDispensed(c, now), c.volume);
+        out.println();
+    }
+}
+
+#endif // MANIFOLD_CHANNELS
@@ -0,0 +1,292 @@
+#include "metrics.h"
+
+#if ENABLE_METRICS
+
+#include "storage.h"
+#include "safety.h"
+#include "commands.h"
+
+#if ENABLE_WIFI
+#include "network.h"
+#endif
+
+extern Statistics g_stats;
+
+// Межі кошиків: тривалість розливу (мс) і відхилення періоду controlTask (мкс)
+static const uint32_t pourBoundsMs[METRICS_BUCKETS] = {1000, 2000, 3000, 5000, 8000, 13000, 20000, 30000};
+static const uint32_t jitterBoundsUs[METRICS_BUCKETS] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000};
+
+static MetricsHistogram pourHistogram;
+static MetricsHistogram jitterHistogram;
+static portMUX_TYPE metricsMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void histogramObserve(MetricsHistogram &h, const uint32_t *bounds, uint32_t value) {
+    uint8_t i = 0;
+    while (i < METRICS_BUCKETS && value > bounds[i]) i++;
+    
+    portENTER_CRITICAL(&metricsMux);
+    h.buckets[i]++;
+    h.count++;
+    h.sum += value;
+    portEXIT_CRITICAL(&metricsMux);
+}
+
+void metricsPourDone(uint32_t durationMs) {
+    histogramObserve(pourHistogram, pourBoundsMs, durationMs);
+}
+
+void metricsControlTick(uint32_t periodUs) {
+    static uint32_t lastUs = 0;
+    uint32_t now = micros();
+    
+    if (lastUs != 0) {
+        uint32_t period = now - lastUs;
+        uint32_t jitter = period > periodUs ? period - periodUs : periodUs - period;
+        histogramObserve(jitterHistogram, jitterBoundsUs, jitter);
+    }
+    lastUs = now;
+}
+
+// ========================================
+// ЕКСПОРТ
+// ========================================
+
+// Сімейства метрик у порядку виводу
+enum MetricsFamily : uint8_t {
+    METRICS_INFO = 0,
+    METRICS_UPTIME,
+    METRICS_POURS,
+    METRICS_VOLUME,
+    METRICS_ERRORS,
+    METRICS_SAFETY_FAULTS,
+    METRICS_POUR_DURATION,
+    METRICS_CONTROL_JITTER,
+    METRICS_CONTROL_MISSES,
+    METRICS_HEAP,
+    METRICS_NVS_WRITES,
+    METRICS_SETTERS,
+    METRICS_WS_CLIENTS,
+    METRICS_BYTES_SENT,
+    METRICS_WS_FRAMES,
+    METRICS_WIFI_RSSI,
+    METRICS_DONE
+};
+
+// Значення в одиницях -> секунди: "1.5", "0.00025" (без float, без зайвих нулів)
+static int formatSeconds(char *out, size_t size, uint64_t value, uint32_t unitsPerSec) {
+    unsigned long whole = value / unitsPerSec;
+    uint32_t frac = value % unitsPerSec;
+    if (frac == 0) return snprintf(out, size, "%lu", whole);
+    
+    int digits = 0;
+    for (uint32_t u = unitsPerSec; u > 1; u /= 10) digits++;
+    while (frac % 10 == 0) {
+        frac /= 10;
+        digits--;
+    }
+    return snprintf(out, size, "%lu.%0*lu", whole, digits, (unsigned long)frac);
+}
+
+MetricsExporter::MetricsExporter()
+    : _family(METRICS_INFO), _bucket(0), _lineLen(0), _linePos(0) {
+    // Один знімок на запит: кошики, count і sum узгоджені між собою
+    portENTER_CRITICAL(&metricsMux);
+    _pour = pourHistogram;
+    _jitter = jitterHistogram;
+    portEXIT_CRITICAL(&metricsMux);
+}
+
+size_t MetricsExporter::fillHistogram(const char* name, const char* help, const MetricsHistogram &h,
+                                      const uint32_t *bounds, uint32_t unitsPerSec) {
+    int len = 0;
+    char value[24];
+    
+    if (_bucket == 0) {
+        len = snprintf(_line, sizeof(_line), "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    }
+    
+    // Кошики кумулятивні: <= межі
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i <= _bucket && i <= METRICS_BUCKETS; i++) cumulative += h.buckets[i];
+    
+    if (_bucket < METRICS_BUCKETS) {
+        formatSeconds(value, sizeof(value), bounds[_bucket], unitsPerSec);
+        len += snprintf(_line + len, sizeof(_line) - len, "%s_bucket{le=\"%s\"} %lu\n",
+                        name, value, (unsigned long)cumulative);
+        _bucket++;
+        return len;
+    }
+    
+    formatSeconds(value, sizeof(value), h.sum, unitsPerSec);
+    len += snprintf(_line + len, sizeof(_line) - len,
+                    "%s_bucket{le=\"+Inf\"} %lu\n%s_sum %s\n%s_count %lu\n",
+                    name, (unsigned long)cumulative, name, value, name, (unsigned long)h.count);
+    _bucket = 0;
+    _family++;
+    return len;
+}
+
+size_t MetricsExporter::fill() {
+    int len = 0;
+    
+    switch (_family) {
+        case METRICS_INFO:
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_info Firmware build\n# TYPE gyverdrink_info gauge\n"
+                "gyverdrink_info{version=\"%s\"} 1\n", FIRMWARE_VERSION);
+            break;
+        
+        case METRICS_UPTIME:
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_uptime_seconds Time since boot\n# TYPE gyverdrink_uptime_seconds gauge\n"
+                "gyverdrink_uptime_seconds %lu\n", millis() / 1000);
+            break;
+        
+        case METRICS_POURS:
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_pours_total Completed pours\n# TYPE gyverdrink_pours_total counter\n"
+                "gyverdrink_pours_total %lu\n", (unsigned long)g_stats.totalPours);
+            break;
+        
+        case METRICS_VOLUME:
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_poured_ml_total Poured volume\n# TYPE gyverdrink_poured_ml_total counter\n"
+                "gyverdrink_poured_ml_total %lu\n", (unsigned long)g_stats.totalVolume);
+            break;
+        
+        case METRICS_ERRORS:
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_errors_total Pour errors (timeouts, safety cutoffs)\n"
+                "# TYPE gyverdrink_errors_total counter\n"
+                "gyverdrink_errors_total %lu\n", (unsigned long)g_stats.errors);
+            break;
+        
+        case METRICS_SAFETY_FAULTS:
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_safety_faults_total Recorded safety faults (watchdog, pump cutoff)\n"
+                "# TYPE gyverdrink_safety_faults_total counter\n"
+                "gyverdrink_safety_faults_total %lu\n", (unsigned long)safetyFaultCount());
+            break;
+        
+        case METRICS_POUR_DURATION:
+            return _lineLen = fillHistogram("gyverdrink_pour_duration_seconds", "Pump on time per completed pour",
+                                            _pour, pourBoundsMs, 1000);
+        
+        case METRICS_CONTROL_JITTER:
+            return _lineLen = fillHistogram("gyverdrink_control_jitter_seconds",
+                                            "Deviation of control loop period from nominal",
+                                            _jitter, jitterBoundsUs, 1000000);
+        
+        case METRICS_CONTROL_MISSES:
+#if ENABLE_TRACE
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_loop_deadline_misses_total Missed loop deadlines\n"
+                "# TYPE gyverdrink_loop_deadline_misses_total counter\n"
+                "gyverdrink_loop_deadline_misses_total{loop=\"control\"} %lu\n"
+                "gyverdrink_loop_deadline_misses_total{loop=\"ui\"} %lu\n",
+                (unsigned long)traceMisses(TRACE_LOOP_CONTROL), (unsigned long)traceMisses(TRACE_LOOP_UI));
+#endif
+            break;
+        
+        case METRICS_HEAP:
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_heap_bytes Heap memory\n# TYPE gyverdrink_heap_bytes gauge\n"
+                "gyverdrink_heap_bytes{kind=\"free\"} %lu\n"
+                "gyverdrink_heap_bytes{kind=\"min_free\"} %lu\n"
+                "gyverdrink_heap_bytes{kind=\"largest_block\"} %lu\n",
+                (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(),
+                (unsigned long)ESP.getMaxAllocHeap());
+            break;
+        
+        case METRICS_NVS_WRITES:
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_nvs_writes_total NVS key writes since boot\n"
+                "# TYPE gyverdrink_nvs_writes_total counter\n"
+                "gyverdrink_nvs_writes_total %lu\n", (unsigned long)storageWriteCount());
+            break;
+
+        case METRICS_SETTERS:
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_setter_commands_total volume/mode/shot commands (applied after coalescing)\n"
+                "# TYPE gyverdrink_setter_commands_total counter\n"
+                "gyverdrink_setter_commands_total{result=\"received\"} %lu\n"
+                "gyverdrink_setter_commands_total{result=\"applied\"} %lu\n",
+                (unsigned long)commandSettersReceived(), (unsigned long)commandSettersApplied());
+            break;
+
+#if ENABLE_WIFI
+        case METRICS_WS_CLIENTS:
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_ws_clients Connected WebSocket clients\n# TYPE gyverdrink_ws_clients gauge\n"
+                "gyverdrink_ws_clients %lu\n", (unsigned long)wsClientCount());
+            break;
+        
+        case METRICS_BYTES_SENT:
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_push_bytes_sent_total Payload bytes pushed to clients\n"
+                "# TYPE gyverdrink_push_bytes_sent_total counter\n"
+                "gyverdrink_push_bytes_sent_total{channel=\"ws\"} %lu\n"
+                "gyverdrink_push_bytes_sent_total{channel=\"sse\"} %lu\n",
+                (unsigned long)wsBytesSent(), (unsigned long)sseBytesSent());
+            break;
+        
+        case METRICS_WS_FRAMES:
+            len = snprintf(_line, sizeof(_line),
+                "# HELP gyverdrink_ws_frames_total WebSocket frames by outcome\n"
+                "# TYPE gyverdrink_ws_frames_total counter\n"
+                "gyverdrink_ws_frames_total{result=\"sent\"} %lu\n"
+                "gyverdrink_ws_frames_total{result=\"superseded\"} %lu\n"
+                "gyverdrink_ws_frames_total{result=\"dropped\"} %lu\n",
+                (unsigned long)wsFramesSent(), (unsigned long)wsFramesSuperseded(),
+                (unsigned long)wsFramesDropped());
+            break;
+        
+        case METRICS_WIFI_RSSI:
+            // Без підключення до точки доступу RSSI немає
+            if (WiFi.isConnected()) {
+                len = snprintf(_line, sizeof(_line),
+                    "# HELP gyverdrink_wifi_rssi_dbm Station signal strength\n"
+                    "# TYPE gyverdrink_wifi_rssi_dbm gauge\n"
+                    "gyverdrink_wifi_rssi_dbm %d\n", (int)WiFi.RSSI());
+            }
+            break;
+#endif
+
+        case METRICS_DONE:
+            return 0;
+        
+        default:
+            // Сімейство вимкнене в цій збірці
+            break;
+    }
+    
+    _family++;
+    if (len < 0) len = 0;
+    if (len > (int)sizeof(_line) - 1) len = sizeof(_line) - 1;
+    _lineLen = len;
+    return _lineLen;
+}
+
+size_t MetricsExporter::read(uint8_t *buf, size_t maxLen) {
+    size_t written = 0;
+    
+    while (written < maxLen) {
+        if (_linePos >= _lineLen) {
+            _linePos = 0;
+            _lineLen = 0;
+            // Порожні рядки (вимкнені сімейства) пропускаються
+            while (_lineLen == 0 && _family < METRICS_DONE) fill();
+            if (_lineLen == 0) break;
+        }
+        
+        size_t chunk = _lineLen - _linePos;
+        if (chunk > maxLen - written) chunk = maxLen - written;
+        memcpy(buf + written, _line + _linePos, chunk);
+        _linePos += chunk;
+        written += chunk;
+    }
+    
+    return written;
+}
+
+#endif // ENABLE_METRICS
@@ -2,16 +2,37 @@
 
 #if ENABLE_WIFI
 
+#include "control.h"
+#include "storage.h"
+#include "fleet.h"
+#include "ota.h"
+#include "commands.h"
+#include "metrics.h"
+#include "power.h"
+#include "cleaning.h"
+#include "recipes.h"
+#include "manifold.h"
+#include <atomic>
+#include <cerrno>
+#include <memory>
+
 AsyncWebServer server(WEB_PORT);
 AsyncWebSocket ws("/ws");
 AsyncEventSource events("/events");
 
+// Надіслані байти корисного навантаження (для /metrics)
+static std::atomic<uint32_t> wsBytes(0);
+static std::atomic<uint32_t> sseBytes(0);
+
 extern SystemState g_systemState;
 extern PourMode g_pourMode;
 extern uint16_t g_targetVolume;
 extern uint8_t g_selectedShot;
-extern bool g_glassPresent[5];
+extern uint8_t g_selectedRecipe;
+extern bool g_glassPresent[GLASS_COUNT];
 extern Statistics g_stats;
+extern float g_pumpRate;
+extern float g_primeVolume;
 
 // HTML сторінка
 const char index_html[] PROGMEM = R"rawliteral(
@@ -84,6 +105,10 @@ const char index_html[] PROGMEM = R"rawliteral(
             background: #4CAF50;
             color: white;
         }
+        .btn-warning {
+            background: #FF9800;
+            color: white;
+        }
         .btn-danger {
             background: #f44336;
             color: white;
@@ -96,7 +121,6 @@ const char index_html[] PROGMEM = R"rawliteral(
         }
         .shot-selector {
             display: grid;
-            grid-template-columns: repeat(5, 1fr);
             gap: 10px;
             margin: 20px 0;
         }
@@ -135,6 +159,14 @@ const char index_html[] PROGMEM = R"rawliteral(
             font-size: 0.9em;
             opacity: 0.8;
         }
+        select {
+            width: 100%;
+            padding: 12px;
+            font-size: 1.1em;
+            border: none;
+            border-radius: 10px;
+            background: rgba(255,255,255,0.9);
+        }
         .mode-toggle {
             display: flex;
             gap: 10px;
@@ -178,16 +210,18 @@ const char index_html[] PROGMEM = R"rawliteral(
 
         <div class="control-group">
             <label>Вибір рюмки:</label>
-            <div class="shot-selector">
-                <div class="shot-btn" id="shot1" onclick="selectShot(1)">1</div>
-                <div class="shot-btn" id="shot2" onclick="selectShot(2)">2</div>
-                <div class="shot-btn" id="shot3" onclick="selectShot(3)">3</div>
-                <div class="shot-btn" id="shot4" onclick="selectShot(4)">4</div>
-                <div class="shot-btn" id="shot5" onclick="selectShot(5)">5</div>
-            </div>
+            <div class="shot-selector" id="shotSelector"></div>
+        </div>
+
+        <div class="control-group">
+            <label>Коктейль:</label>
+            <select id="recipeSelect" onchange="selectRecipe(this.value)">
+                <option value="off">Без коктейлю</option>
+            </select>
         </div>
 
         <button class="btn btn-primary" onclick="startPour()">▶️ Налити</button>
+        <button class="btn btn-warning" id="btnPause" onclick="togglePause()">⏸️ Пауза</button>
         <button class="btn btn-danger" onclick="stopPour()">⏹️ Стоп</button>
 
         <div class="stats">
@@ -211,7 +245,7 @@ const char index_html[] PROGMEM = R"rawliteral(
     </div>
 
     <script>
-        var gateway = `ws://${window.location.hostname}/ws`;
+        var gateway = `ws://${window.location.host}/ws`;
         var websocket;
 
         function initWebSocket() {
@@ -236,27 +270,38 @@ const char index_html[] PROGMEM = R"rawliteral(
             console.log('Received:', data);
             
             if (data.status !== undefined) {
-                document.getElementById('status').textContent = data.status;
+                paused = data.status === 'Пауза';
+                let status = data.status;
+                if (data.pour !== undefined) status += ' (' + data.pour.ml + ' з ' + data.pour.total + ' мл)';
+                document.getElementById('status').textContent = status;
+                document.getElementById('btnPause').textContent = paused ? '⏯️ Продовжити' : '⏸️ Пауза';
             }
             if (data.mode !== undefined) {
                 document.getElementById('mode').textContent = data.mode == 0 ? 'Ручний' : 'Авто';
                 document.getElementById('btnManual').classList.toggle('active', data.mode == 0);
                 document.getElementById('btnAuto').classList.toggle('active', data.mode == 1);
             }
-            if (data.volume !== undefined) {
+            // Під час перетягування слайдер не смикається від старішого стану
+            if (data.volume !== undefined && volumeTimer === null) {
                 document.getElementById('volumeDisplay').textContent = data.volume;
                 document.getElementById('volumeSlider').value = data.volume;
             }
-            if (data.shot !== undefined) {
-                for (let i = 1; i <= 5; i++) {
-                    document.getElementById('shot' + i).classList.toggle('active', i == data.shot);
-                }
-            }
+            // Кнопки рюмок - за кількістю в стані: прошивка зібрана під свій профіль
             if (data.glasses !== undefined) {
-                for (let i = 0; i < 5; i++) {
+                buildShots(data.glasses.length);
+                for (let i = 0; i < data.glasses.length; i++) {
                     document.getElementById('shot' + (i+1)).classList.toggle('has-glass', data.glasses[i]);
                 }
             }
+            if (data.shot !== undefined) {
+                let buttons = document.querySelectorAll('.shot-btn');
+                for (let i = 0; i < buttons.length; i++) {
+                    buttons[i].classList.toggle('active', i + 1 == data.shot);
+                }
+            }
+            if (recipesLoaded && data.status !== undefined) {
+                document.getElementById('recipeSelect').value = data.recipe !== undefined ? data.recipe : 'off';
+            }
             if (data.stats !== undefined) {
                 document.getElementById('totalPours').textContent = data.stats.pours;
                 document.getElementById('totalVolume').textContent = data.stats.volume;
@@ -271,19 +316,70 @@ const char index_html[] PROGMEM = R"rawliteral(
             }
         }
 
+        // Слайдер: перше значення одразу, далі не частіше VOLUME_THROTTLE_MS, останнє - завжди
+        const VOLUME_THROTTLE_MS = 150;
+        var volumeTimer = null;
+        var volumePending = null;
+
         function updateVolume(value) {
             document.getElementById('volumeDisplay').textContent = value;
-            websocket.send(JSON.stringify({cmd: 'volume', value: parseInt(value)}));
+            volumePending = parseInt(value);
+            if (volumeTimer === null) sendVolume();
+        }
+
+        function sendVolume() {
+            if (volumePending === null) {
+                volumeTimer = null;
+                return;
+            }
+            websocket.send(JSON.stringify({cmd: 'volume', value: volumePending}));
+            volumePending = null;
+            volumeTimer = setTimeout(sendVolume, VOLUME_THROTTLE_MS);
         }
 
         function setMode(mode) {
             websocket.send(JSON.stringify({cmd: 'mode', value: mode}));
         }
 
+        function buildShots(count) {
+            let selector = document.getElementById('shotSelector');
+            if (selector.children.length == count) return;
+            selector.innerHTML = '';
+            selector.style.gridTemplateColumns = 'repeat(' + count + ', 1fr)';
+            for (let i = 1; i <= count; i++) {
+                let btn = document.createElement('div');
+                btn.className = 'shot-btn';
+                btn.id = 'shot' + i;
+                btn.textContent = i;
+                btn.onclick = () => selectShot(i);
+                selector.appendChild(btn);
+            }
+        }
+
         function selectShot(shot) {
             websocket.send(JSON.stringify({cmd: 'shot', value: shot}));
         }
 
+        // Рецепти без заправлених інгредієнтів видно, але вибрати не можна
+        var recipesLoaded = false;
+
+        function loadRecipes() {
+            fetch('/api/recipes').then(r => r.json()).then(data => {
+                let select = document.getElementById('recipeSelect');
+                for (let r of data.recipes) {
+                    let option = new Option(r.name + ' (' + r.spec + ')', r.name);
+                    option.disabled = !r.available;
+                    select.add(option);
+                }
+                select.selectedIndex = data.selected;
+                recipesLoaded = true;
+            });
+        }
+
+        function selectRecipe(name) {
+            websocket.send(JSON.stringify({cmd: 'recipe', value: name}));
+        }
+
         function startPour() {
             websocket.send(JSON.stringify({cmd: 'start'}));
         }
@@ -292,44 +388,384 @@ const char index_html[] PROGMEM = R"rawliteral(
             websocket.send(JSON.stringify({cmd: 'stop'}));
         }
 
+        var paused = false;
+
+        function togglePause() {
+            websocket.send(JSON.stringify({cmd: paused ? 'resume' : 'pause'}));
+        }
+
         window.addEventListener('load', onLoad);
         function onLoad(event) {
             initWebSocket();
+            loadRecipes();
         }
     </script>
 </body>
 </html>
 )rawliteral";
 
-void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
-    if (type == WS_EVT_CONNECT) {
-        Serial.printf("WebSocket client #%u connected from %s\n", client->id(), client->remoteIP().toString().c_str());
+void serializeState(JsonDocument &doc) {
+    doc["status"] = getStateString(g_systemState);
+    doc["mode"] = g_pourMode;
+    doc["volume"] = g_targetVolume;
+    doc["shot"] = g_selectedShot;
+    
+    const char* recipe = recipeSelectedName();
+    if (recipe != NULL) doc["recipe"] = recipe;
+    
+    JsonArray glasses = doc.createNestedArray("glasses");
+    for (int i = 0; i < GLASS_COUNT; i++) {
+        glasses.add(g_glassPresent[i]);
+    }
+    
+    // Розлив у процесі: на паузі - скільки налито і скільки лишилось
+    if (pourTargetMl() > 0) {
+        JsonObject pour = doc.createNestedObject("pour");
+        pour["ml"] = pourDispensedMl();
+        pour["total"] = pourTargetMl();
+    }
+    
+    // Очищення: яка програма (або "prime")
+    const char* program = cleanProgramName();
+    if (program != NULL) doc["program"] = program;
+    
+    JsonObject stats = doc.createNestedObject("stats");
+    stats["pours"] = g_stats.totalPours;
+    stats["volume"] = g_stats.totalVolume;
+    
+    doc["uptime"] = millis() / 1000;
+    doc["heap"] = ESP.getFreeHeap();
+}
+
+// Записи логу починаючи з since: {"next": N, "dropped": N, "logs": [...]}
+void serializeLogs(JsonDocument &doc, uint32_t since) {
+    JsonArray logs = doc.createNestedArray("logs");
+    
+    uint32_t cursor = since;
+    LogEntry entry;
+    while (logRead(cursor, entry)) {
+        JsonObject item = logs.createNestedObject();
+        item["seq"] = entry.seq;
+        item["t"] = entry.timestamp;
+        item["level"] = logLevelName(entry.level);
+        item["msg"] = entry.msg;
+    }
+    
+    doc["next"] = cursor;
+    doc["dropped"] = logDropped();
+}
+
+// ========================================
+// SERVER-SENT EVENTS
+// ========================================
+
+// Потоки подій на /events (ім'я потоку = event:)
+enum SseStream : uint8_t {
+    SSE_STREAM_STATE = 0,
+    SSE_STREAM_PROGRESS,
+    SSE_STREAM_LOG,
+    SSE_STREAM_COUNT
+};
+
+static const char* const sseStreamNames[SSE_STREAM_COUNT] = {"state", "progress", "log"};
+
+// Недавня подія для повтору після перепідключення
+struct SseBacklogEntry {
+    uint32_t id;
+    uint8_t stream;
+    char data[SSE_EVENT_LEN];
+};
+
+static SseBacklogEntry sseBacklog[SSE_BACKLOG_SIZE];
+static uint32_t sseFirstId = 0;          // Перший id після старту
+static uint32_t sseLastId = 0;           // id останньої події
+static SemaphoreHandle_t sseLock = NULL; // loop() пише, AsyncTCP повторює
+static unsigned long sseLastSent[SSE_STREAM_COUNT] = {0};
+static uint32_t sseSentStateHash = 0;
+static uint32_t sseLogCursor = 0;
+
+// Відбиток полів, що потрапляють у state - без серіалізації
+static uint32_t sseStateHash() {
+    uint32_t hash = 2166136261u;
+    uint32_t glassMask = 0;
+    for (uint8_t i = 0; i < GLASS_COUNT; i++) {
+        if (g_glassPresent[i]) glassMask |= 1u << i;
+    }
+    uint32_t fields[] = {
+        (uint32_t)g_systemState, (uint32_t)g_pourMode, g_targetVolume, g_selectedShot, g_selectedRecipe,
+        glassMask, g_stats.totalPours, g_stats.totalVolume
+    };
+    for (uint32_t f : fields) {
+        hash = (hash ^ f) * 16777619u;
+    }
+    return hash;
+}
+
+static void sseEmit(uint8_t stream, const char* data) {
+    xSemaphoreTake(sseLock, portMAX_DELAY);
+    
+    uint32_t id = ++sseLastId;
+    SseBacklogEntry &entry = sseBacklog[id % SSE_BACKLOG_SIZE];
+    entry.id = id;
+    entry.stream = stream;
+    strlcpy(entry.data, data, sizeof(entry.data));
+    
+    events.send(entry.data, sseStreamNames[stream], id);
+    sseBytes += strlen(entry.data) * events.count();
+    
+    xSemaphoreGive(sseLock);
+    
+    sseLastSent[stream] = millis();
+}
+
+// Новий клієнт: повтор пропущених подій або повний стан
+static void sseReplay(AsyncEventSourceClient *client) {
+    xSemaphoreTake(sseLock, portMAX_DELAY);
+    
+    uint32_t lastId = client->lastId();
+    uint32_t oldest = sseLastId - sseFirstId >= SSE_BACKLOG_SIZE ? sseLastId - SSE_BACKLOG_SIZE + 1 : sseFirstId + 1;
+    bool inBacklog = lastId != 0 && lastId >= oldest - 1 && lastId <= sseLastId;
+    
+    if (inBacklog) {
+        for (uint32_t id = lastId + 1; id <= sseLastId; id++) {
+            const SseBacklogEntry &entry = sseBacklog[id % SSE_BACKLOG_SIZE];
+            client->send(entry.data, sseStreamNames[entry.stream], entry.id,
+                         id == lastId + 1 ? SSE_RECONNECT : 0);
+        }
+    } else {
+        // Перший візит або id застарів (чи з попереднього запуску)
+        DynamicJsonDocument doc(512);
+        serializeState(doc);
         
-        // Відправити поточний стан
+        char data[SSE_EVENT_LEN];
+        serializeJson(doc, data, sizeof(data));
+        client->send(data, sseStreamNames[SSE_STREAM_STATE], sseLastId, SSE_RECONNECT);
+    }
+    
+    xSemaphoreGive(sseLock);
+}
+
+static void sseUpdate() {
+    if (sseLock == NULL) return;
+    
+    unsigned long now = millis();
+    char data[SSE_EVENT_LEN];
+    
+    // state - тільки при змінах, не частіше SSE_STATE_INTERVAL
+    uint32_t hash = sseStateHash();
+    if (hash != sseSentStateHash && now - sseLastSent[SSE_STREAM_STATE] >= SSE_STATE_INTERVAL) {
         DynamicJsonDocument doc(512);
-        doc["status"] = getStateString(g_systemState);
-        doc["mode"] = g_pourMode;
-        doc["volume"] = g_targetVolume;
+        serializeState(doc);
+        serializeJson(doc, data, sizeof(data));
+        
+        sseEmit(SSE_STREAM_STATE, data);
+        sseSentStateHash = hash;
+    }
+    
+    // progress - тільки поки помпа працює (пауза видна в state)
+    if (g_systemState == STATE_POURING && pourTargetMl() > 0 &&
+        now - sseLastSent[SSE_STREAM_PROGRESS] >= SSE_PROGRESS_INTERVAL) {
+        // Налите - з лічильників розливу: заповнення трубки, коктейль і колектор
+        // рахуються там, а не з часу
+        uint16_t target = pourTargetMl();
+        uint16_t ml = pourDispensedMl();
+        uint8_t percent = ml < target ? (uint32_t)ml * 100 / target : 100;
+        
+        DynamicJsonDocument doc(160);
         doc["shot"] = g_selectedShot;
+        doc["elapsed"] = pourElapsedMs();
+        doc["total"] = pourDurationMs(target);
+        doc["percent"] = percent;
+        doc["ml"] = ml;
+        doc["target"] = target;
+        serializeJson(doc, data, sizeof(data));
+        
+        sseEmit(SSE_STREAM_PROGRESS, data);
+    }
+    
+    // log - пачка нових записів, що влазить в одну подію
+    if (logHead() != sseLogCursor && now - sseLastSent[SSE_STREAM_LOG] >= SSE_LOG_INTERVAL) {
+        DynamicJsonDocument doc(SSE_EVENT_LEN * 2);
+        JsonArray logs = doc.createNestedArray("logs");
         
-        JsonArray glasses = doc.createNestedArray("glasses");
-        for (int i = 0; i < 5; i++) {
-            glasses.add(g_glassPresent[i]);
+        LogEntry entry;
+        uint32_t cursor = sseLogCursor;
+        while (logRead(cursor, entry)) {
+            JsonObject item = logs.createNestedObject();
+            item["seq"] = entry.seq;
+            item["t"] = entry.timestamp;
+            item["level"] = logLevelName(entry.level);
+            item["msg"] = entry.msg;
+            
+            // Не влазить - залишити на наступну подію
+            if (measureJson(doc) > SSE_EVENT_LEN - 32 && logs.size() > 1) {
+                logs.remove(logs.size() - 1);
+                cursor = entry.seq;
+                break;
+            }
         }
         
-        JsonObject stats = doc.createNestedObject("stats");
-        stats["pours"] = g_stats.totalPours;
-        stats["volume"] = g_stats.totalVolume;
+        doc["next"] = cursor;
+        sseLogCursor = cursor;
         
-        doc["uptime"] = millis() / 1000;
-        doc["heap"] = ESP.getFreeHeap();
+        if (logs.size() > 0) {
+            serializeJson(doc, data, sizeof(data));
+            sseEmit(SSE_STREAM_LOG, data);
+        }
+    }
+}
+
+// ========================================
+// WEBSOCKET
+// ========================================
+
+// Клієнт і що з ним сталося. Черга AsyncWebSocket на клієнта - до WS_MAX_QUEUED_MESSAGES
+// копій; тут вона обмежена WS_CLIENT_QUEUE_MAX, а стан для повільного клієнта чекає окремо
+struct WsClientSlot {
+    uint32_t id;                // 0 - вільний
+    bool statePending;          // Новіший стан не вліз у чергу - відправити, коли звільниться
+    uint32_t sent;              // Кадрів поставлено в чергу
+    uint32_t superseded;        // Кадрів стану, замінених новішим до відправки
+    uint32_t dropped;           // Відповідей не поставлено (повна черга), стан при відключенні
+};
+
+static WsClientSlot wsClients[WS_CLIENTS_MAX];
+static SemaphoreHandle_t wsLock = NULL;     // broadcastState() - з будь-якої задачі
+
+// Буфери стану: власні (не ws.makeBuffer - ті звільняються лише в textAll).
+// count() - кадри з буфером у чергах клієнтів; 0 - буфер можна перевикористати
+static AsyncWebSocketMessageBuffer *wsStateBuffers[WS_STATE_BUFFERS];
+static AsyncWebSocketMessageBuffer *wsState = NULL;    // Останній стан
+
+// Підсумки, включно з відключеними клієнтами
+static std::atomic<uint32_t> wsSentTotal(0);
+static std::atomic<uint32_t> wsSupersededTotal(0);
+static std::atomic<uint32_t> wsDroppedTotal(0);
+
+static WsClientSlot* wsSlot(uint32_t id) {
+    for (int i = 0; i < WS_CLIENTS_MAX; i++) {
+        if (wsClients[i].id == id) return &wsClients[i];
+    }
+    return NULL;
+}
+
+static bool wsQueueFree(AsyncWebSocketClient *client) {
+    return client->status() == WS_CONNECTED && client->queueLen() < WS_CLIENT_QUEUE_MAX;
+}
+
+// Відповідь одному клієнту (копія). Повна черга - відповідь відкидається
+static void wsSend(AsyncWebSocketClient *client, const char* text, size_t len) {
+    xSemaphoreTake(wsLock, portMAX_DELAY);
+    WsClientSlot *slot = wsSlot(client->id());
+    if (wsQueueFree(client)) {
+        client->text(text, len);
+        wsBytes += len;
+        wsSentTotal++;
+        if (slot) slot->sent++;
+    } else {
+        wsDroppedTotal++;
+        if (slot) slot->dropped++;
+    }
+    xSemaphoreGive(wsLock);
+}
+
+// Останній стан клієнту або позначка, що він чекає. Під wsLock
+static void wsSendState(WsClientSlot &slot) {
+    AsyncWebSocketClient *client = ws.client(slot.id);
+    if (client == NULL || wsState == NULL) return;
+    
+    if (!wsQueueFree(client)) {
+        // Один відкладений стан на клієнта: попередній, якщо був, уже неактуальний
+        if (slot.statePending) {
+            slot.superseded++;
+            wsSupersededTotal++;
+        }
+        slot.statePending = true;
+        return;
+    }
+    
+    client->text(wsState);
+    slot.statePending = false;
+    slot.sent++;
+    wsSentTotal++;
+    wsBytes += wsState->length();
+}
+
+// Вільний буфер стану потрібного розміру. NULL - усі ще в чергах повільних клієнтів
+static AsyncWebSocketMessageBuffer* wsStateBuffer(size_t len) {
+    for (int i = 0; i < WS_STATE_BUFFERS; i++) {
+        AsyncWebSocketMessageBuffer *&buffer = wsStateBuffers[i];
+        if (buffer == NULL) {
+            buffer = new AsyncWebSocketMessageBuffer(len);
+            return buffer;
+        }
+        if (buffer == wsState || buffer->count() > 0) continue;
         
-        String response;
-        serializeJson(doc, response);
-        client->text(response);
+        buffer->reserve(len);
+        return buffer;
+    }
+    return NULL;
+}
+
+// З loop(): клієнтам, чия черга звільнилась, - останній стан
+static void wsUpdate() {
+    if (wsLock == NULL) return;
+    
+    xSemaphoreTake(wsLock, portMAX_DELAY);
+    for (int i = 0; i < WS_CLIENTS_MAX; i++) {
+        if (wsClients[i].id != 0 && wsClients[i].statePending) wsSendState(wsClients[i]);
+    }
+    xSemaphoreGive(wsLock);
+}
+
+static void wsConnected(AsyncWebSocketClient *client) {
+    xSemaphoreTake(wsLock, portMAX_DELAY);
+    WsClientSlot *slot = wsSlot(0);
+    if (slot != NULL) {
+        memset(slot, 0, sizeof(*slot));
+        slot->id = client->id();
+        slot->statePending = true;
+    }
+    xSemaphoreGive(wsLock);
+    
+    if (slot == NULL) {
+        LOG_W("WebSocket client #%u rejected: %d clients max", client->id(), WS_CLIENTS_MAX);
+        client->close(1013, "too many clients");
+        return;
+    }
+    
+    // Свіжа серіалізація для всіх: останній спільний стан міг застаріти (час роботи, heap)
+    broadcastState();
+}
+
+static void wsDisconnected(AsyncWebSocketClient *client) {
+    xSemaphoreTake(wsLock, portMAX_DELAY);
+    WsClientSlot *slot = wsSlot(client->id());
+    if (slot != NULL) {
+        if (slot->statePending) {
+            slot->dropped++;
+            wsDroppedTotal++;
+        }
+        LOG_I("WebSocket client #%u: %lu sent, %lu superseded, %lu dropped", slot->id,
+              (unsigned long)slot->sent, (unsigned long)slot->superseded, (unsigned long)slot->dropped);
+        slot->id = 0;
+    }
+    xSemaphoreGive(wsLock);
+}
+
+void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    if (type == WS_EVT_CONNECT) {
+        LOG_I("WebSocket client #%u connected from %s", client->id(), client->remoteIP().toString().c_str());
+        
+        // Хтось відкрив веб-інтерфейс - розбудити екран
+        powerActivity();
+        
+        // Поточний стан
+        wsConnected(client);
         
     } else if (type == WS_EVT_DISCONNECT) {
-        Serial.printf("WebSocket client #%u disconnected\n", client->id());
+        LOG_I("WebSocket client #%u disconnected", client->id());
+        wsDisconnected(client);
         
     } else if (type == WS_EVT_DATA) {
         AwsFrameInfo *info = (AwsFrameInfo*)arg;
@@ -339,147 +775,1401 @@ void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventTyp
             DynamicJsonDocument doc(256);
             DeserializationError error = deserializeJson(doc, (char*)data);
             
-            if (!error) {
-                String cmd = doc["cmd"];
+            if (error) {
+                // Не JSON - рядок команди, як у Serial: "volume 30", "wifi"
+                CommandReply reply;
+                commandExecute((char*)data, reply, CMD_SRC_WS);
+                wsSend(client, reply.c_str(), reply.length());
+                return;
+            }
+                
+            const char* cmd = doc["cmd"] | "";
+            
+            if (strcmp(cmd, "logs") == 0) {
+                // Відповідь тільки цьому клієнту
+                DynamicJsonDocument logs(LOG_RING_SIZE * 160);
+                serializeLogs(logs, doc["since"] | logOldest());
+                
+                String response;
+                serializeJson(logs, response);
+                wsSend(client, response.c_str(), response.length());
+            } else {
+                // {"cmd": "volume", "value": 30} - та сама таблиця команд, що й текстом
+                char value[16] = "";
+                JsonVariant arg = doc["value"];
+                if (arg.is<const char*>()) strlcpy(value, arg.as<const char*>(), sizeof(value));
+                else if (!arg.isNull()) snprintf(value, sizeof(value), "%ld", arg.as<long>());
+                
+                const char* argv[2] = {cmd, value};
+                CommandReply reply;
+                CommandResult result = commandExecuteArgs(value[0] ? 2 : 1, argv, reply, CMD_SRC_WS);
                 
-                if (cmd == "volume") {
-                    extern void setTargetVolume(uint16_t vol);
-                    setTargetVolume(doc["value"]);
-                } 
-                else if (cmd == "mode") {
-                    extern void setPourMode(PourMode mode);
-                    setPourMode((PourMode)(int)doc["value"]);
-                } 
-                else if (cmd == "shot") {
-                    extern void selectShot(uint8_t shot);
-                    selectShot(doc["value"]);
-                } 
-                else if (cmd == "start") {
-                    extern void startPour();
-                    startPour();
-                } 
-                else if (cmd == "stop") {
-                    extern void stopPour();
-                    stopPour();
+                // Успіх видно з розсилки стану, помилку - лише відправнику
+                if (result != CMD_OK) {
+                    DynamicJsonDocument answer(128);
+                    answer["ok"] = false;
+                    answer["cmd"] = cmd;
+                    answer["error"] = commandResultName(result);
+                    
+                    String response;
+                    serializeJson(answer, response);
+                    wsSend(client, response.c_str(), response.length());
                 }
             }
         }
     }
 }
 
-void setupNetwork() {
-    Serial.println("Setting up network...");
+// ========================================
+// REST API
+// ========================================
+
+// Команди REST / batch. Спочатку всі перевіряються, потім застосовуються разом
+enum ApiCommandType : uint8_t {
+    API_CMD_VOLUME = 0,
+    API_CMD_MODE,
+    API_CMD_SHOT,
+    API_CMD_RECIPE,
+    API_CMD_QUEUE,
+    API_CMD_CLEAR_QUEUE,
+    API_CMD_CALIBRATE,
+    API_CMD_START,
+    API_CMD_STOP,
+    API_CMD_PAUSE,
+    API_CMD_RESUME,
+    API_CMD_RESET_STATS
+};
+
+struct ApiCommand {
+    uint8_t type;
+    uint8_t shot;
+    uint16_t value;         // Об'єм / режим / рецепт; 0 у queue - поточний об'єм
+    float rate;             // Для calibrate
+};
+
+struct ApiError {
+    int code;
+    int index;
+    const char* message;
+};
+
+// Розбір однієї команди без побічних ефектів. NULL - команда коректна
+static const char* parseApiCommand(JsonObject obj, ApiCommand &out) {
+    const char* cmd = obj["cmd"] | "";
+    memset(&out, 0, sizeof(out));
+    
+    if (strcmp(cmd, "volume") == 0) {
+        int value = obj["value"] | -1;
+        if (value < VOLUME_MIN || value > VOLUME_MAX) return "volume out of range";
+        out.type = API_CMD_VOLUME;
+        out.value = value;
+    }
+    else if (strcmp(cmd, "mode") == 0) {
+        int value = obj["value"] | -1;
+        if (value != MODE_MANUAL && value != MODE_AUTO) return "invalid mode";
+        out.type = API_CMD_MODE;
+        out.value = value;
+    }
+    else if (strcmp(cmd, "shot") == 0) {
+        int value = obj["value"] | 0;
+        if (value < 1 || value > GLASS_COUNT) return "shot out of range";
+        out.type = API_CMD_SHOT;
+        out.shot = value;
+    }
+    else if (strcmp(cmd, "recipe") == 0) {
+        // Назва, номер або 0 / "off" - без коктейлю
+        int index = obj["value"].is<const char*>() ? recipeIndex(obj["value"].as<const char*>()) : (obj["value"] | -1);
+        if (index < 0 || index > recipeCount()) return "unknown recipe";
+#if MANIFOLD_CHANNELS
+        if (index != 0) return "recipes need the servo build";
+#endif
+        out.type = API_CMD_RECIPE;
+        out.value = index;
+    }
+    else if (strcmp(cmd, "queue") == 0) {
+        int shot = obj["shot"] | 0;
+        int volume = obj["volume"] | 0;
+        if (shot < 1 || shot > GLASS_COUNT) return "shot out of range";
+        if (volume != 0 && (volume < VOLUME_MIN || volume > VOLUME_MAX)) return "volume out of range";
+        out.type = API_CMD_QUEUE;
+        out.shot = shot;
+        out.value = volume;
+    }
+    else if (strcmp(cmd, "clearQueue") == 0) {
+        out.type = API_CMD_CLEAR_QUEUE;
+    }
+    else if (strcmp(cmd, "calibrate") == 0) {
+        // Або готова швидкість, або заданий/фактичний об'єм тестового розливу
+        float rate = obj["mlPerSec"] | 0.0f;
+        float target = obj["target"] | 0.0f;
+        float actual = obj["actual"] | 0.0f;
+        if (rate == 0 && target > 0 && actual > 0) rate = g_pumpRate * actual / target;
+        if (rate < PUMP_RATE_MIN || rate > PUMP_RATE_MAX) return "pump rate out of range";
+        out.type = API_CMD_CALIBRATE;
+        out.rate = rate;
+    }
+    else if (strcmp(cmd, "start") == 0) {
+        out.type = API_CMD_START;
+    }
+    else if (strcmp(cmd, "stop") == 0) {
+        out.type = API_CMD_STOP;
+    }
+    else if (strcmp(cmd, "pause") == 0) {
+        out.type = API_CMD_PAUSE;
+    }
+    else if (strcmp(cmd, "resume") == 0) {
+        out.type = API_CMD_RESUME;
+    }
+    else if (strcmp(cmd, "resetStats") == 0) {
+        out.type = API_CMD_RESET_STATS;
+    }
+    else {
+        return "unknown command";
+    }
+    
+    return NULL;
+}
+
+// Стан, у якому дію застануть попередні дії пакета
+struct ApiActionState {
+    SystemState state;
+    uint8_t busy;           // Колектор: виходи, що вже наливають
+};
+
+// Дія розливу проти стану до неї; shot - рюмка після налаштувань пакета.
+// NULL - дія пройде, стан оновлено
+static const char* checkApiAction(uint8_t type, ApiActionState &s, uint8_t shot) {
+    switch (type) {
+        case API_CMD_START:
+            // start на паузі - продовження
+            if (s.state == STATE_PAUSED) return checkApiAction(API_CMD_RESUME, s, shot);
+            if (s.state == STATE_CLEANING || s.state == STATE_UPDATING || s.state == STATE_MOVING) return "busy";
+#if MANIFOLD_CHANNELS
+            if (s.busy & 1 << (shot - 1)) return "already pouring";
+            s.busy |= 1 << (shot - 1);
+#else
+            if (s.state == STATE_POURING) return "already pouring";
+#endif
+            if (!g_glassPresent[shot - 1]) return "no glass";
+            s.state = STATE_POURING;
+            return NULL;
+        case API_CMD_PAUSE:
+            if (s.state != STATE_POURING) return "not pouring";
+            s.state = STATE_PAUSED;
+            return NULL;
+        case API_CMD_RESUME:
+            if (s.state != STATE_PAUSED) return "not paused";
+#if !MANIFOLD_CHANNELS
+            if (!g_glassPresent[shot - 1]) return "no glass";
+#endif
+            s.state = STATE_POURING;
+            return NULL;
+        case API_CMD_STOP:
+            if (s.state != STATE_UPDATING) s.state = STATE_IDLE;
+            s.busy = 0;
+            return NULL;
+        default:
+            return NULL;
+    }
+}
+
+// Застосування перевірених команд. Спершу дії розливу перевіряються проти стану -
+// відмова повертає 409 з індексом, і нічого не застосовано. Далі зміни налаштувань
+// і черги - одним блоком під controlMux (контур керування не бачить проміжного
+// стану), один запис у NVS, потім дії start/stop/pause/resume/resetStats у порядку
+// запиту. Дія, якій все ж відмовили (стан змінився, немає інгредієнта) - 409, решта
+// дій пакета не виконується
+static ApiError applyApiCommands(const ApiCommand *cmds, size_t count) {
+    bool settingsChanged = false;
     
-    WiFi.mode(WIFI_AP);
+    // Відкладені volume/mode/shot з WebSocket - раніше, ніж цей запит
+    commandFlushSetters();
     
-    // Налаштування IP адреси
-    if (!WiFi.softAPConfig(AP_IP, AP_GATEWAY, AP_SUBNET)) {
-        Serial.println("AP Config Failed!");
-        return;
+    uint8_t shot = g_selectedShot;
+    for (size_t i = 0; i < count; i++) {
+        if (cmds[i].type == API_CMD_SHOT) shot = cmds[i].shot;
+    }
+    ApiActionState state = {g_systemState, 0};
+#if MANIFOLD_CHANNELS
+    state.busy = manifoldBusyMask();
+#endif
+    for (size_t i = 0; i < count; i++) {
+        if (cmds[i].type == API_CMD_SHOT && shotLocked()) return {409, (int)i, "pour in progress"};
+        const char* error = checkApiAction(cmds[i].type, state, shot);
+        if (error != NULL) return {409, (int)i, error};
     }
     
-    // Створення точки доступу
-    if (!WiFi.softAP(AP_SSID, AP_PASS, AP_CHANNEL, AP_HIDDEN, AP_MAX_CONN)) {
-        Serial.println("AP Start Failed!");
-        return;
+    // Місце в черзі: рахуються замовлення після останнього clearQueue
+    size_t queued = 0;
+    bool clears = false;
+    for (size_t i = 0; i < count; i++) {
+        if (cmds[i].type == API_CMD_CLEAR_QUEUE) {
+            queued = 0;
+            clears = true;
+        }
+        if (cmds[i].type == API_CMD_QUEUE) queued++;
     }
     
-    Serial.println("Access Point started!");
-    Serial.print("SSID: ");
-    Serial.println(AP_SSID);
-    Serial.print("Password: ");
-    Serial.println(AP_PASS);
-    Serial.print("IP: ");
-    Serial.println(WiFi.softAPIP());
+    portENTER_CRITICAL(&controlMux);
     
-    // WebSocket
-    ws.onEvent(onWsEvent);
-    server.addHandler(&ws);
+    if (queued > 0 && (clears ? 0 : pourQueueLength()) + queued > POUR_QUEUE_SIZE) {
+        portEXIT_CRITICAL(&controlMux);
+        return {409, -1, "queue full"};
+    }
     
-    // Events
-    server.addHandler(&events);
+    for (size_t i = 0; i < count; i++) {
+        const ApiCommand &c = cmds[i];
+        switch (c.type) {
+            case API_CMD_VOLUME:
+                g_targetVolume = c.value;
+                settingsChanged = true;
+                break;
+            case API_CMD_MODE:
+                g_pourMode = (PourMode)c.value;
+                settingsChanged = true;
+                break;
+            case API_CMD_SHOT:
+                g_selectedShot = c.shot;
+                settingsChanged = true;
+                break;
+            case API_CMD_RECIPE:
+                g_selectedRecipe = c.value;
+                settingsChanged = true;
+                break;
+            case API_CMD_QUEUE:
+                queuePour(c.shot, c.value ? c.value : g_targetVolume);
+                break;
+            case API_CMD_CLEAR_QUEUE:
+                clearPourQueue();
+                break;
+            case API_CMD_CALIBRATE:
+                g_pumpRate = c.rate;
+                settingsChanged = true;
+                break;
+            default:
+                break;
+        }
+    }
     
-    // Головна сторінка
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
-        request->send_P(200, "text/html", index_html);
-    });
+    portEXIT_CRITICAL(&controlMux);
     
-    // API endpoints
-    server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request){
-        DynamicJsonDocument doc(512);
-        doc["state"] = getStateString(g_systemState);
-        doc["mode"] = g_pourMode;
-        doc["volume"] = g_targetVolume;
-        doc["shot"] = g_selectedShot;
-        doc["uptime"] = millis() / 1000;
-        doc["heap"] = ESP.getFreeHeap();
-        
-        JsonObject stats = doc.createNestedObject("stats");
-        stats["totalPours"] = g_stats.totalPours;
-        stats["totalVolume"] = g_stats.totalVolume;
-        stats["errors"] = g_stats.errors;
-        
-        String response;
-        serializeJson(doc, response);
-        request->send(200, "application/json", response);
-    });
+    if (settingsChanged) {
+        saveSettings();
+    }
     
-    server.on("/api/start", HTTP_POST, [](AsyncWebServerRequest *request){
-        extern void startPour();
-        startPour();
-        request->send(200, "text/plain", "OK");
-    });
+    for (size_t i = 0; i < count; i++) {
+        const char* error = NULL;
+        switch (cmds[i].type) {
+            case API_CMD_START: if (!startPour()) error = "start refused"; break;
+            case API_CMD_STOP: stopPour(); break;
+            case API_CMD_PAUSE: if (!pausePour()) error = "not pouring"; break;
+            case API_CMD_RESUME: if (!resumePour()) error = "not paused or no glass"; break;
+            case API_CMD_RESET_STATS: resetStatistics(); break;
+            default: break;
+        }
+        if (error != NULL) {
+            broadcastState();
+            return {409, (int)i, error};
+        }
+    }
     
-    server.on("/api/stop", HTTP_POST, [](AsyncWebServerRequest *request){
-        extern void stopPour();
-        stopPour();
-        request->send(200, "text/plain", "OK");
-    });
+    broadcastState();
+    return {200, -1, NULL};
+}
+
+// Розбір масиву команд: спочатку всі, при першій помилці - нічого не застосовано
+static ApiError runApiCommands(JsonArray list) {
+    ApiCommand cmds[API_BATCH_MAX];
+    size_t count = 0;
     
-    // 404
-    server.onNotFound([](AsyncWebServerRequest *request){
-        request->send(404, "text/plain", "Not found");
-    });
+    if (list.isNull() || list.size() == 0) return {400, -1, "no commands"};
+    if (list.size() > API_BATCH_MAX) return {413, -1, "too many commands"};
     
-    // Запуск сервера
-    server.begin();
-    Serial.println("HTTP server started");
+    for (JsonObject obj : list) {
+        const char* error = parseApiCommand(obj, cmds[count]);
+        if (error != NULL) return {400, (int)count, error};
+        count++;
+    }
     
-#if ENABLE_OTA
-    setupOTA();
-#endif
+    return applyApiCommands(cmds, count);
 }
 
-void updateNetwork() {
-    ws.cleanupClients();
+static void sendApiResult(AsyncWebServerRequest *request, const ApiError &result, size_t applied) {
+    DynamicJsonDocument doc(192);
+    doc["ok"] = result.code == 200;
+    if (result.code == 200) {
+        doc["applied"] = applied;
+    } else {
+        doc["error"] = result.message;
+        if (result.index >= 0) doc["index"] = result.index;
+    }
     
-#if ENABLE_OTA
-    ArduinoOTA.handle();
-#endif
+    String response;
+    serializeJson(doc, response);
+    request->send(result.code, "application/json", response);
 }
 
-void broadcastState() {
-    DynamicJsonDocument doc(512);
-    doc["status"] = getStateString(g_systemState);
+// Тіло запиту збирається в _tempObject (звільняється разом із запитом)
+static void collectBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (total > API_BODY_MAX) return;
+    
+    if (index == 0) {
+        request->_tempObject = malloc(total + 1);
+    }
+    if (request->_tempObject == NULL) return;
+    
+    memcpy((uint8_t*)request->_tempObject + index, data, len);
+    if (index + len == total) {
+        ((char*)request->_tempObject)[total] = 0;
+    }
+}
+
+// JSON з тіла, або з параметрів форми/URL (curl -d volume=30)
+static bool readApiBody(AsyncWebServerRequest *request, JsonDocument &doc) {
+    if (request->_tempObject != NULL) {
+        return !deserializeJson(doc, (const char*)request->_tempObject);
+    }
+    if (request->contentLength() > API_BODY_MAX) return false;
+    
+    JsonObject obj = doc.to<JsonObject>();
+    for (size_t i = 0; i < request->params(); i++) {
+        const AsyncWebParameter *p = request->getParam(i);
+        if (p->isFile()) continue;
+        
+        apiFormField(obj, p->name().c_str(), p->value().c_str());
+    }
+    return true;
+}
+
+// Числа як числа - далі розбір однаковий для JSON і форм. Ціле - саме цілим:
+// obj["volume"] | -1 не бачить int у double
+void apiFormField(JsonObject obj, const char* name, const char* value) {
+    if (*value != 0) {
+        char *end = NULL;
+        errno = 0;
+        long integer = strtol(value, &end, 10);
+        if (*end == 0 && errno == 0) {
+            obj[name] = integer;
+            return;
+        }
+        double number = strtod(value, &end);
+        if (*end == 0) {
+            obj[name] = number;
+            return;
+        }
+    }
+    obj[name] = value;
+}
+
+// Плоский об'єкт {"volume": 30, "mode": 1} -> команди з тим самим ім'ям
+static ApiError runApiFields(JsonObject obj, const char* const *fields, size_t fieldCount, size_t &applied) {
+    DynamicJsonDocument list(512);
+    JsonArray cmds = list.to<JsonArray>();
+    
+    for (size_t i = 0; i < fieldCount; i++) {
+        if (obj[fields[i]].isNull()) continue;
+        JsonObject cmd = cmds.createNestedObject();
+        cmd["cmd"] = fields[i];
+        cmd["value"] = obj[fields[i]];
+    }
+    
+    applied = cmds.size();
+    return runApiCommands(cmds);
+}
+
+static void serializeSettings(JsonDocument &doc) {
     doc["mode"] = g_pourMode;
     doc["volume"] = g_targetVolume;
     doc["shot"] = g_selectedShot;
+    doc["recipe"] = g_selectedRecipe;
+    doc["mlPerSec"] = g_pumpRate;
     
-    JsonArray glasses = doc.createNestedArray("glasses");
-    for (int i = 0; i < 5; i++) {
-        glasses.add(g_glassPresent[i]);
+    JsonObject limits = doc.createNestedObject("limits");
+    limits["volumeMin"] = VOLUME_MIN;
+    limits["volumeMax"] = VOLUME_MAX;
+    limits["volumeStep"] = VOLUME_STEP;
+    limits["queueSize"] = POUR_QUEUE_SIZE;
+}
+
+static void sendJson(AsyncWebServerRequest *request, JsonDocument &doc, int code = 200) {
+    String response;
+    serializeJson(doc, response);
+    request->send(code, "application/json", response);
+}
+
+static void setupApi() {
+    // Налаштування
+    server.on("/api/settings", HTTP_GET, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument doc(384);
+        serializeSettings(doc);
+        sendJson(request, doc);
+    });
+    
+    server.on("/api/settings", HTTP_POST, [](AsyncWebServerRequest *request){
+        static const char* const fields[] = {"volume", "mode", "shot", "recipe"};
+        DynamicJsonDocument body(API_BODY_MAX);
+        if (!readApiBody(request, body)) {
+            sendApiResult(request, {400, -1, "invalid body"}, 0);
+            return;
+        }
+        size_t applied = 0;
+        ApiError result = runApiFields(body.as<JsonObject>(), fields, 4, applied);
+        sendApiResult(request, result, applied);
+    }, NULL, collectBody);
+    
+    // Рюмки
+    server.on("/api/shots", HTTP_GET, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument doc(128 + GLASS_COUNT * 64);
+        doc["selected"] = g_selectedShot;
+        
+        JsonArray shots = doc.createNestedArray("shots");
+        for (int i = 0; i < GLASS_COUNT; i++) {
+            JsonObject shot = shots.createNestedObject();
+            shot["shot"] = i + 1;
+            shot["glass"] = g_glassPresent[i];
+            shot["position"] = hw::shotAngles[i];
+        }
+        sendJson(request, doc);
+    });
+    
+    server.on("/api/shots", HTTP_POST, [](AsyncWebServerRequest *request){
+        static const char* const fields[] = {"shot"};
+        DynamicJsonDocument body(API_BODY_MAX);
+        if (!readApiBody(request, body)) {
+            sendApiResult(request, {400, -1, "invalid body"}, 0);
+            return;
+        }
+        size_t applied = 0;
+        ApiError result = runApiFields(body.as<JsonObject>(), fields, 1, applied);
+        sendApiResult(request, result, applied);
+    }, NULL, collectBody);
+    
+    // Черга замовлень
+    server.on("/api/queue", HTTP_GET, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument doc(128 + POUR_QUEUE_SIZE * 48);
+        doc["capacity"] = POUR_QUEUE_SIZE;
+        
+        JsonArray orders = doc.createNestedArray("orders");
+        PourOrder order;
+        for (uint8_t i = 0; pourQueueAt(i, order); i++) {
+            JsonObject item = orders.createNestedObject();
+            item["shot"] = order.shot;
+            item["volume"] = order.volume;
+        }
+        doc["length"] = orders.size();
+        sendJson(request, doc);
+    });
+    
+    server.on("/api/queue", HTTP_POST, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument body(API_BODY_MAX);
+        if (!readApiBody(request, body)) {
+            sendApiResult(request, {400, -1, "invalid body"}, 0);
+            return;
+        }
+        
+        JsonObject cmd = body.as<JsonObject>();
+        cmd["cmd"] = "queue";
+        
+        ApiCommand parsed;
+        const char* error = parseApiCommand(cmd, parsed);
+        ApiError result = error ? ApiError{400, -1, error} : applyApiCommands(&parsed, 1);
+        sendApiResult(request, result, 1);
+    }, NULL, collectBody);
+    
+    server.on("/api/queue", HTTP_DELETE, [](AsyncWebServerRequest *request){
+        ApiCommand cmd = {API_CMD_CLEAR_QUEUE, 0, 0, 0};
+        sendApiResult(request, applyApiCommands(&cmd, 1), 1);
+    });
+    
+    // Статистика
+    server.on("/api/stats", HTTP_GET, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument doc(256);
+        doc["totalPours"] = g_stats.totalPours;
+        doc["totalVolume"] = g_stats.totalVolume;
+        doc["totalTime"] = g_stats.totalTime;
+        doc["errors"] = g_stats.errors;
+        doc["lastPourVolume"] = g_stats.lastPourVolume;
+        doc["lastPourTime"] = g_stats.lastPourTime;
+        sendJson(request, doc);
+    });
+    
+    server.on("/api/reset", HTTP_POST, [](AsyncWebServerRequest *request){
+        ApiCommand cmd = {API_CMD_RESET_STATS, 0, 0, 0};
+        sendApiResult(request, applyApiCommands(&cmd, 1), 1);
+    });
+    
+    // Калібрування помпи: {"mlPerSec": 9.5} або {"target": 100, "actual": 92}
+    server.on("/api/calibration", HTTP_GET, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument doc(128);
+        doc["mlPerSec"] = g_pumpRate;
+        doc["default"] = PUMP_ML_PER_SEC;
+        doc["min"] = PUMP_RATE_MIN;
+        doc["max"] = PUMP_RATE_MAX;
+        doc["primeMl"] = g_primeVolume;
+        doc["primed"] = tubePrimed();
+        sendJson(request, doc);
+    });
+    
+    server.on("/api/calibration", HTTP_POST, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument body(API_BODY_MAX);
+        if (!readApiBody(request, body)) {
+            sendApiResult(request, {400, -1, "invalid body"}, 0);
+            return;
+        }
+        
+        JsonObject cmd = body.as<JsonObject>();
+        cmd["cmd"] = "calibrate";
+        
+        ApiCommand parsed;
+        const char* error = parseApiCommand(cmd, parsed);
+        ApiError result = error ? ApiError{400, -1, error} : applyApiCommands(&parsed, 1);
+        sendApiResult(request, result, 1);
+    }, NULL, collectBody);
+    
+    // Коктейлі: помпи з інгредієнтами і книга рецептів
+    server.on("/api/recipes", HTTP_GET, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument doc(256 + RECIPE_PUMPS * 96 + RECIPES_MAX * 160);
+        doc["selected"] = g_selectedRecipe;
+        
+        JsonArray pumps = doc.createNestedArray("pumps");
+        for (uint8_t i = 1; i <= RECIPE_PUMPS; i++) {
+            JsonObject pump = pumps.createNestedObject();
+            pump["pump"] = i;
+            pump["ingredient"] = pumpSlot(i)->ingredient;
+            pump["mlPerSec"] = pumpRate(i);
+            pump["calibrated"] = pumpSlot(i)->rate > 0;
+        }
+        
+        JsonArray recipes = doc.createNestedArray("recipes");
+        for (uint8_t i = 1; i <= recipeCount(); i++) {
+            const Recipe *r = recipeAt(i);
+            char spec[RECIPE_STEPS_MAX * (RECIPE_NAME_LEN + 4)];
+            recipeFormat(*r, spec, sizeof(spec));
+            
+            JsonObject recipe = recipes.createNestedObject();
+            recipe["index"] = i;
+            recipe["name"] = r->name;
+            recipe["spec"] = spec;
+            recipe["available"] = recipeAvailable(*r);
+        }
+        sendJson(request, doc);
+    });
+    
+    // {"name": "gin-tonic", "spec": "gin:2,tonic:3/lime:1"}
+    server.on("/api/recipes", HTTP_POST, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument body(API_BODY_MAX);
+        if (!readApiBody(request, body)) {
+            sendApiResult(request, {400, -1, "invalid body"}, 0);
+            return;
+        }
+        
+        const char* name = body["name"] | "";
+        Recipe recipe;
+        if (name[0] == 0 || strlen(name) >= RECIPE_NAME_LEN || !recipeParse(body["spec"] | "", recipe)) {
+            sendApiResult(request, {400, -1, "invalid name or spec"}, 0);
+            return;
+        }
+        strlcpy(recipe.name, name, sizeof(recipe.name));
+        
+        bool saved = recipeSave(recipe);
+        if (saved) broadcastState();
+        sendApiResult(request, saved ? ApiError{200, -1, NULL} : ApiError{409, -1, "recipe book full"}, 1);
+    }, NULL, collectBody);
+    
+    server.on("/api/recipes", HTTP_DELETE, [](AsyncWebServerRequest *request){
+        if (!request->hasParam("name") || !recipeDelete(request->getParam("name")->value().c_str())) {
+            sendApiResult(request, {404, -1, "unknown recipe"}, 0);
+            return;
+        }
+        broadcastState();
+        sendApiResult(request, {200, -1, NULL}, 1);
+    });
+    
+    // Інгредієнт у помпі і його калібрування: {"pump": 2, "ingredient": "juice", "mlPerSec": 8.5}
+    // або {"pump": 2, "ingredient": "juice", "target": 100, "actual": 92}. Без швидкості - як основна
+    server.on("/api/pumps", HTTP_POST, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument body(API_BODY_MAX);
+        if (!readApiBody(request, body)) {
+            sendApiResult(request, {400, -1, "invalid body"}, 0);
+            return;
+        }
+        
+        int pump = body["pump"] | 0;
+        if (pump < 1 || pump > RECIPE_PUMPS) {
+            sendApiResult(request, {400, -1, "pump out of range"}, 0);
+            return;
+        }
+        // +1: задовга назва не обрізається мовчки, її відхилить pumpLoad()
+        char ingredient[RECIPE_NAME_LEN + 1];
+        strlcpy(ingredient, body["ingredient"] | pumpSlot(pump)->ingredient, sizeof(ingredient));
+        float rate = body["mlPerSec"] | 0.0f;
+        float target = body["target"] | 0.0f;
+        float actual = body["actual"] | 0.0f;
+        if (rate == 0 && target > 0 && actual > 0) rate = pumpRate(pump) * actual / target;
+        
+        if (!pumpLoad(pump, ingredient, rate)) {
+            sendApiResult(request, {400, -1, "invalid ingredient or rate"}, 0);
+            return;
+        }
+        sendApiResult(request, {200, -1, NULL}, 1);
+    }, NULL, collectBody);
+    
+    // Пакет команд: {"commands": [{"cmd": "volume", "value": 30}, ...]} або просто масив
+    server.on("/api/batch", HTTP_POST, [](AsyncWebServerRequest *request){
+        if (request->_tempObject == NULL) {
+            sendApiResult(request, {request->contentLength() > API_BODY_MAX ? 413 : 400, -1, "JSON body required"}, 0);
+            return;
+        }
+        
+        DynamicJsonDocument body(API_BODY_MAX * 2);
+        if (deserializeJson(body, (const char*)request->_tempObject)) {
+            sendApiResult(request, {400, -1, "invalid JSON"}, 0);
+            return;
+        }
+        
+        JsonArray list = body.is<JsonArray>() ? body.as<JsonArray>() : body["commands"].as<JsonArray>();
+        ApiError result = runApiCommands(list);
+        sendApiResult(request, result, list.size());
+    }, NULL, collectBody);
+    
+    // Рядок команди, як у Serial: тіло "volume 30" (text/plain) або поле line=...
+    // Відповідь - текст команди, код - за результатом
+    server.on("/api/cmd", HTTP_POST, [](AsyncWebServerRequest *request){
+        const char* text = NULL;
+        if (request->hasParam("line", true)) text = request->getParam("line", true)->value().c_str();
+        else if (request->hasParam("line")) text = request->getParam("line")->value().c_str();
+        else if (request->_tempObject != NULL) text = (const char*)request->_tempObject;
+        
+        if (text == NULL) {
+            sendApiResult(request, {400, -1, "command line required"}, 0);
+            return;
+        }
+        
+        char line[CMD_LINE_MAX];
+        if (strlcpy(line, text, sizeof(line)) >= sizeof(line)) {
+            sendApiResult(request, {413, -1, "command line too long"}, 0);
+            return;
+        }
+        
+        AsyncResponseStream *response = request->beginResponseStream("text/plain");
+        CommandResult result = commandExecute(line, *response, CMD_SRC_HTTP);
+        static const int codes[] = {200, 400, 404, 400, 409};   // За порядком CommandResult
+        response->setCode(codes[result]);
+        request->send(response);
+    }, NULL, collectBody);
+}
+
+// ========================================
+// WI-FI (STA + резервна точка доступу)
+// ========================================
+
+// Підключення до роутера ведеться без блокувань: WiFi.begin() лише запускає
+// спробу, результат перевіряє wifiUpdate() з loop()
+enum WifiLinkState : uint8_t {
+    WIFI_LINK_AP = 0,           // Немає даних - тільки точка доступу
+    WIFI_LINK_CONNECTING,       // Спроба підключення (до WIFI_TIMEOUT)
+    WIFI_LINK_CONNECTED,        // Підключено до роутера, AP вимкнена
+    WIFI_LINK_FALLBACK          // Не вдалося - AP, повтор через WIFI_RETRY_INTERVAL
+};
+
+static const char* const wifiLinkNames[] = {"ap", "connecting", "connected", "fallback"};
+
+static WifiLinkState wifiLink = WIFI_LINK_AP;
+static char wifiSsid[WIFI_SSID_LEN] = "";
+static char wifiPass[WIFI_PASS_LEN] = "";
+static unsigned long wifiStateSince = 0;
+static bool wifiApActive = false;
+static bool mdnsActive = false;
+static uint32_t wifiReconnects = 0;
+static volatile bool wifiReloadPending = false;  // Нові дані з /wifi або Serial
+
+const char wifi_html[] PROGMEM = R"rawliteral(
+<!DOCTYPE html>
+<html>
+<head>
+    <meta charset="UTF-8">
+    <meta name="viewport" content="width=device-width, initial-scale=1.0">
+    <title>GyverDrink WiFi</title>
+    <style>
+        body { font-family: Arial, sans-serif; background: #667eea; color: #fff; padding: 20px; }
+        .box { max-width: 400px; margin: 0 auto; background: rgba(255,255,255,0.1); padding: 20px; border-radius: 15px; }
+        input, button { width: 100%; padding: 10px; margin: 6px 0; border-radius: 8px; border: none; font-size: 16px; }
+        button { background: #4CAF50; color: #fff; cursor: pointer; }
+        #status { font-size: 14px; opacity: 0.9; }
+    </style>
+</head>
+<body>
+    <div class="box">
+        <h2>WiFi</h2>
+        <div id="status">...</div>
+        <form id="form">
+            <input name="ssid" placeholder="SSID" maxlength="32" required>
+            <input name="pass" type="password" placeholder="Password" maxlength="64">
+            <button type="submit">Connect</button>
+        </form>
+    </div>
+    <script>
+        function refresh() {
+            fetch('/api/wifi').then(r => r.json()).then(s => {
+                document.getElementById('status').innerText =
+                    s.state + (s.ssid ? ' - ' + s.ssid : '') + (s.ip ? ' - ' + s.ip : '') +
+                    ' (http://' + s.hostname + '.local)';
+            });
+        }
+        document.getElementById('form').onsubmit = function(e) {
+            e.preventDefault();
+            fetch('/api/wifi', { method: 'POST', body: new URLSearchParams(new FormData(this)) })
+                .then(r => r.json()).then(r => {
+                    document.getElementById('status').innerText = r.ok ? 'Connecting...' : r.error;
+                });
+        };
+        refresh();
+        setInterval(refresh, 3000);
+    </script>
+</body>
+</html>
+)rawliteral";
+
+static bool wifiStartAP() {
+    if (wifiApActive) return true;
+    
+    WiFi.mode(wifiSsid[0] ? WIFI_AP_STA : WIFI_AP);
+    
+    if (!WiFi.softAPConfig(AP_IP, AP_GATEWAY, AP_SUBNET)) {
+        LOG_E("AP config failed!");
+        return false;
+    }
+    if (!WiFi.softAP(AP_SSID, AP_PASS, AP_CHANNEL, AP_HIDDEN, AP_MAX_CONN)) {
+        LOG_E("AP start failed!");
+        return false;
     }
     
-    JsonObject stats = doc.createNestedObject("stats");
-    stats["pours"] = g_stats.totalPours;
-    stats["volume"] = g_stats.totalVolume;
+    wifiApActive = true;
+    LOG_I("Access point %s started, IP %s", AP_SSID, WiFi.softAPIP().toString().c_str());
+    return true;
+}
+
+static void wifiStopAP() {
+    if (!wifiApActive) return;
     
-    doc["uptime"] = millis() / 1000;
-    doc["heap"] = ESP.getFreeHeap();
+    WiFi.softAPdisconnect(true);
+    WiFi.mode(WIFI_STA);
+    wifiApActive = false;
+    LOG_I("Access point stopped");
+}
+
+static void wifiBeginConnect() {
+    LOG_I("Connecting to %s...", wifiSsid);
     
-    String response;
-    serializeJson(doc, response);
-    ws.textAll(response);
+    WiFi.mode(wifiApActive ? WIFI_AP_STA : WIFI_STA);
+    WiFi.begin(wifiSsid, wifiPass);
+    
+    wifiLink = WIFI_LINK_CONNECTING;
+    wifiStateSince = millis();
+}
+
+// Дані з NVS (або config.h): є - підключення, немає - тільки AP
+static void wifiLoadAndConnect() {
+    WiFi.disconnect();
+    
+    if (loadWifiCredentials(wifiSsid, sizeof(wifiSsid), wifiPass, sizeof(wifiPass))) {
+        wifiBeginConnect();
+    } else {
+        wifiStartAP();
+        wifiLink = WIFI_LINK_AP;
+        wifiStateSince = millis();
+    }
+}
+
+// mDNS: http://gyverdrink.local, сервіси _http._tcp і _ws._tcp.
+// Запускається один раз - IDF сам відстежує інтерфейси STA і AP
+static void mdnsStart() {
+    if (mdnsActive) return;
+    
+    if (!MDNS.begin(MDNS_HOSTNAME)) {
+        LOG_E("mDNS start failed!");
+        return;
+    }
+    
+    MDNS.setInstanceName(DEVICE_NAME);
+    MDNS.addService("http", "tcp", WEB_PORT);
+    MDNS.addServiceTxt("http", "tcp", "version", FIRMWARE_VERSION);
+    MDNS.addServiceTxt("http", "tcp", "api", "/api");
+    MDNS.addServiceTxt("http", "tcp", "events", "/events");
+    MDNS.addService("ws", "tcp", WEB_PORT);
+    MDNS.addServiceTxt("ws", "tcp", "path", "/ws");
+    
+    mdnsActive = true;
+    LOG_I("mDNS: http://%s.local", MDNS_HOSTNAME);
+}
+
+static void wifiUpdate() {
+    if (wifiReloadPending) {
+        wifiReloadPending = false;
+        wifiLoadAndConnect();
+        return;
+    }
+    
+    unsigned long now = millis();
+    
+    switch (wifiLink) {
+        case WIFI_LINK_CONNECTING:
+            if (WiFi.status() == WL_CONNECTED) {
+                wifiLink = WIFI_LINK_CONNECTED;
+                wifiStateSince = now;
+                LOG_I("WiFi connected: %s, IP %s, RSSI %d",
+                      wifiSsid, WiFi.localIP().toString().c_str(), WiFi.RSSI());
+                wifiStopAP();
+            } else if (now - wifiStateSince >= WIFI_TIMEOUT) {
+                LOG_W("WiFi %s unavailable, fallback to AP", wifiSsid);
+                WiFi.disconnect();
+                wifiStartAP();
+                wifiLink = WIFI_LINK_FALLBACK;
+                wifiStateSince = now;
+            }
+            break;
+        
+        case WIFI_LINK_CONNECTED:
+            if (WiFi.status() != WL_CONNECTED) {
+                LOG_W("WiFi connection lost");
+                wifiReconnects++;
+                wifiBeginConnect();
+            }
+            break;
+        
+        case WIFI_LINK_FALLBACK:
+            // Пошук мережі перемикає канал радіо - не заважаємо клієнтам AP
+            if (now - wifiStateSince >= WIFI_RETRY_INTERVAL) {
+                if (WiFi.softAPgetStationNum() == 0) {
+                    wifiBeginConnect();
+                } else {
+                    wifiStateSince = now;
+                }
+            }
+            break;
+        
+        default:
+            break;
+    }
+}
+
+void wifiSetCredentials(const char* ssid, const char* pass) {
+    if (saveWifiCredentials(ssid, pass)) {
+        wifiReloadPending = true;
+    }
+}
+
+void wifiForget() {
+    clearWifiCredentials();
+    wifiReloadPending = true;
+}
+
+const char* wifiStateString() {
+    return wifiLinkNames[wifiLink];
+}
+
+void serializeWifi(JsonDocument &doc) {
+    bool connected = wifiLink == WIFI_LINK_CONNECTED;
+    
+    doc["state"] = wifiStateString();
+    doc["ssid"] = wifiSsid;
+    doc["hostname"] = MDNS_HOSTNAME;
+    doc["ip"] = connected ? WiFi.localIP().toString() : String();
+    doc["rssi"] = connected ? WiFi.RSSI() : 0;
+    doc["ap"] = wifiApActive;
+    doc["apSsid"] = AP_SSID;
+    doc["apIp"] = wifiApActive ? WiFi.softAPIP().toString() : String();
+    doc["apClients"] = wifiApActive ? WiFi.softAPgetStationNum() : 0;
+    doc["reconnects"] = wifiReconnects;
+}
+
+void printWifiStatus(Print &out) {
+    out.printf("State: %s\n", wifiStateString());
+    out.printf("SSID: %s\n", wifiSsid[0] ? wifiSsid : "-");
+    if (wifiLink == WIFI_LINK_CONNECTED) {
+        out.printf("IP: %s, RSSI %d dBm\n", WiFi.localIP().toString().c_str(), WiFi.RSSI());
+    }
+    if (wifiApActive) {
+        out.printf("AP: %s, IP %s, %u clients\n", AP_SSID,
+                   WiFi.softAPIP().toString().c_str(), WiFi.softAPgetStationNum());
+    }
+    out.printf("mDNS: http://%s.local\n", MDNS_HOSTNAME);
+    out.printf("Reconnects: %lu\n", (unsigned long)wifiReconnects);
+}
+
+#if ENABLE_FLEET
+static void setupFleetRoutes() {
+    // Замовлення у флот: {"volume": 30, "count": 2}. Раніше за /api/fleet - той ловить і підшляхи
+    server.on("/api/fleet/order", HTTP_POST, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument body(256);
+        if (!readApiBody(request, body)) {
+            sendApiResult(request, {400, -1, "invalid body"}, 0);
+            return;
+        }
+        
+        int volume = body["volume"] | (int)g_targetVolume;
+        int count = body["count"] | 1;
+        if (volume < VOLUME_MIN || volume > VOLUME_MAX) {
+            sendApiResult(request, {400, -1, "volume out of range"}, 0);
+            return;
+        }
+        if (count < 1 || count > API_BATCH_MAX) {
+            sendApiResult(request, {400, -1, "count out of range"}, 0);
+            return;
+        }
+        
+        DynamicJsonDocument doc(96 + count * 32);
+        JsonArray nodes = doc.createNestedArray("nodes");
+        for (int i = 0; i < count; i++) {
+            uint32_t node = fleetOrder(volume);
+            if (node == 0) break;
+            nodes.add(node);
+        }
+        
+        doc["ok"] = nodes.size() == (size_t)count;
+        doc["routed"] = nodes.size();
+        if (nodes.size() < (size_t)count) doc["error"] = "no free glass";
+        sendJson(request, doc, nodes.size() > 0 ? 200 : 409);
+    }, NULL, collectBody);
+    
+    server.on("/api/fleet", HTTP_GET, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument doc(256 + (FLEET_MAX_PEERS + 1) * 224);
+        serializeFleet(doc);
+        sendJson(request, doc);
+    });
+    
+    // {"enabled": true}
+    server.on("/api/fleet", HTTP_POST, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument body(128);
+        if (!readApiBody(request, body) || body["enabled"].isNull()) {
+            sendApiResult(request, {400, -1, "enabled required"}, 0);
+            return;
+        }
+        
+        setFleetEnabled(body["enabled"].as<bool>());
+        sendApiResult(request, {200, -1, NULL}, 1);
+    }, NULL, collectBody);
+}
+#endif
+
+#if ENABLE_OTA || ENABLE_ARDUINO_OTA
+// Пароль оновлення з NVS. Порожній - прошивка по мережі не приймається
+static char otaPass[OTA_PASSWORD_LEN] = "";
+#endif
+#if ENABLE_ARDUINO_OTA
+static bool arduinoOtaStarted = false;
+#endif
+
+#if ENABLE_OTA
+const char update_html[] PROGMEM = R"rawliteral(
+<!DOCTYPE html>
+<html>
+<head>
+    <meta charset="UTF-8">
+    <meta name="viewport" content="width=device-width, initial-scale=1.0">
+    <title>GyverDrink Update</title>
+    <style>
+        body { font-family: Arial, sans-serif; background: #667eea; color: #fff; padding: 20px; }
+        .box { max-width: 400px; margin: 0 auto; background: rgba(255,255,255,0.1); padding: 20px; border-radius: 15px; }
+        input, button { width: 100%; padding: 10px; margin: 6px 0; border-radius: 8px; border: none; font-size: 16px; box-sizing: border-box; }
+        input[type=file] { background: rgba(255,255,255,0.2); color: #fff; }
+        button { background: #4CAF50; color: #fff; cursor: pointer; }
+        progress { width: 100%; }
+        #status { font-size: 14px; opacity: 0.9; }
+    </style>
+</head>
+<body>
+    <div class="box">
+        <h2>Firmware</h2>
+        <div id="status">...</div>
+        <form id="form">
+            <input name="file" type="file" accept=".bin" required>
+            <input name="sha256" placeholder="SHA-256 (optional)" maxlength="64" pattern="[0-9a-fA-F]{64}">
+            <button type="submit">Upload</button>
+        </form>
+        <progress id="progress" value="0" max="100"></progress>
+    </div>
+    <script>
+        function refresh() {
+            fetch('/api/ota').then(r => r.json()).then(s => {
+                document.getElementById('status').innerText =
+                    s.version + ' on ' + s.running + (s.verifying ? ' (verifying)' : '') + ' - ' + s.state +
+                    (s.error ? ': ' + s.error : '');
+            });
+        }
+        document.getElementById('form').onsubmit = function(e) {
+            e.preventDefault();
+            // Сирий файл у тілі запиту, без multipart - пристрій пише його потоком
+            const xhr = new XMLHttpRequest();
+            xhr.open('POST', '/api/ota');
+            if (this.sha256.value) xhr.setRequestHeader('X-Firmware-SHA256', this.sha256.value);
+            xhr.upload.onprogress = ev => {
+                document.getElementById('progress').value = ev.total ? ev.loaded * 100 / ev.total : 0;
+            };
+            xhr.onload = () => {
+                const r = JSON.parse(xhr.responseText || '{}');
+                document.getElementById('status').innerText = r.ok ? 'Rebooting...' : (r.error || xhr.status);
+            };
+            xhr.send(this.file.files[0]);
+        };
+        refresh();
+        setInterval(refresh, 3000);
+    </script>
+</body>
+</html>
+)rawliteral";
+
+// Пароль не задано - 403 без запиту Basic: вгадувати нічого, задати можна лише з Serial
+static bool otaAuthorized(AsyncWebServerRequest *request) {
+    if (otaPass[0] == 0) {
+        sendApiResult(request, {403, -1, "OTA password not set (Serial: ota password ...)"}, 0);
+        return false;
+    }
+    if (!request->authenticate(OTA_USER, otaPass)) {
+        request->requestAuthentication();
+        return false;
+    }
+    return true;
+}
+
+// Потокове завантаження прошивки: тіло запиту - сирий .bin, частини одразу йдуть у розділ
+static void otaUploadBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (index == 0) {
+        if (otaPass[0] == 0 || !request->authenticate(OTA_USER, otaPass)) return;
+        
+        const char* sha = NULL;
+        if (request->hasHeader("X-Firmware-SHA256")) sha = request->header("X-Firmware-SHA256").c_str();
+        else if (request->hasParam("sha256")) sha = request->getParam("sha256")->value().c_str();
+        
+        if (!otaBegin(request, total, sha)) return;
+        
+        // Обірване з'єднання не лишає розлив заблокованим
+        request->onDisconnect([request](){
+            otaAbort(request, "connection closed");
+        });
+    }
+    
+    if (!otaWrite(request, data, len)) return;
+    if (index + len == total) otaEnd(request);
+}
+
+static void setupOtaRoutes() {
+    server.on("/update", HTTP_GET, [](AsyncWebServerRequest *request){
+        if (!otaAuthorized(request)) return;
+        request->send_P(200, "text/html", update_html);
+    });
+    
+    server.on("/api/ota", HTTP_POST, [](AsyncWebServerRequest *request){
+        if (!otaAuthorized(request)) return;
+        
+        const char* message = NULL;
+        int code = otaResult(request, &message);
+        sendApiResult(request, {code, -1, code == 200 ? NULL : message}, code == 200 ? 1 : 0);
+    }, NULL, otaUploadBody);
+    
+    server.on("/api/ota", HTTP_GET, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument doc(384);
+        serializeOta(doc);
+        sendJson(request, doc);
+    });
+}
+#endif
+
+static void setupWifiRoutes() {
+    server.on("/wifi", HTTP_GET, [](AsyncWebServerRequest *request){
+        request->send_P(200, "text/html", wifi_html);
+    });
+    
+    server.on("/api/wifi", HTTP_GET, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument doc(384);
+        serializeWifi(doc);
+        sendJson(request, doc);
+    });
+    
+    // {"ssid": "...", "pass": "..."} або форма ssid=...&pass=...
+    // Рядки беруться як є - без перетворення чисел, як у readApiBody
+    server.on("/api/wifi", HTTP_POST, [](AsyncWebServerRequest *request){
+        String ssid;
+        String pass;
+        
+        if (request->_tempObject != NULL) {
+            DynamicJsonDocument body(256);
+            if (deserializeJson(body, (const char*)request->_tempObject)) {
+                sendApiResult(request, {400, -1, "invalid body"}, 0);
+                return;
+            }
+            ssid = body["ssid"] | "";
+            pass = body["pass"] | "";
+        } else {
+            if (request->hasParam("ssid", true)) ssid = request->getParam("ssid", true)->value();
+            if (request->hasParam("pass", true)) pass = request->getParam("pass", true)->value();
+        }
+        
+        if (ssid.length() == 0 || ssid.length() >= WIFI_SSID_LEN) {
+            sendApiResult(request, {400, -1, "ssid must be 1-32 chars"}, 0);
+            return;
+        }
+        // WPA2: 8-63 символи або 64 hex; порожній - відкрита мережа
+        if (pass.length() > 0 && (pass.length() < 8 || pass.length() >= WIFI_PASS_LEN)) {
+            sendApiResult(request, {400, -1, "password must be 8-64 chars"}, 0);
+            return;
+        }
+        
+        wifiSetCredentials(ssid.c_str(), pass.c_str());
+        sendApiResult(request, {200, -1, NULL}, 1);
+    }, NULL, collectBody);
+    
+    // Забути мережу - повернення до точки доступу
+    server.on("/api/wifi", HTTP_DELETE, [](AsyncWebServerRequest *request){
+        wifiForget();
+        sendApiResult(request, {200, -1, NULL}, 1);
+    });
+}
+
+void setupNetwork() {
+    Serial.println("Setting up network...");
+    
+    // Hostname - до першого WiFi.mode(). Перепідключенням керує wifiUpdate()
+    WiFi.persistent(false);
+    WiFi.setHostname(MDNS_HOSTNAME);
+    WiFi.setAutoReconnect(false);
+    
+    wifiLoadAndConnect();
+    mdnsStart();
+    
+#if ENABLE_OTA || ENABLE_ARDUINO_OTA
+    if (!loadOtaPassword(otaPass, sizeof(otaPass))) {
+        LOG_W("OTA password not set, network updates disabled (Serial: ota password ...)");
+    }
+#endif
+    
+    // WebSocket
+    wsLock = xSemaphoreCreateMutex();
+    ws.onEvent(onWsEvent);
+    server.addHandler(&ws);
+    
+    // Events: state / progress / log з повтором за Last-Event-ID.
+    // id починаються з випадкової бази - id з попереднього запуску не збігаються
+    sseLock = xSemaphoreCreateMutex();
+    sseFirstId = sseLastId = random(1, 0x40000000);
+    sseLogCursor = logOldest();
+    events.onConnect(sseReplay);
+    server.addHandler(&events);
+    
+    // Головна сторінка
+    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
+        request->send_P(200, "text/html", index_html);
+    });
+    
+    // API endpoints
+    server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request){
+        DynamicJsonDocument doc(512);
+        doc["state"] = getStateString(g_systemState);
+        doc["mode"] = g_pourMode;
+        doc["volume"] = g_targetVolume;
+        doc["shot"] = g_selectedShot;
+        doc["uptime"] = millis() / 1000;
+        doc["heap"] = ESP.getFreeHeap();
+        
+        if (pourTargetMl() > 0) {
+            JsonObject pour = doc.createNestedObject("pour");
+            pour["ml"] = pourDispensedMl();
+            pour["total"] = pourTargetMl();
+        }
+        
+        JsonObject stats = doc.createNestedObject("stats");
+        stats["totalPours"] = g_stats.totalPours;
+        stats["totalVolume"] = g_stats.totalVolume;
+        stats["errors"] = g_stats.errors;
+        
+        JsonObject wifi = doc.createNestedObject("wifi");
+        wifi["state"] = wifiStateString();
+        wifi["ip"] = WiFi.isConnected() ? WiFi.localIP().toString() : WiFi.softAPIP().toString();
+        wifi["rssi"] = WiFi.isConnected() ? WiFi.RSSI() : 0;
+        
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+    
+    // Лог: GET /api/logs?since=N - тільки нові записи
+    server.on("/api/logs", HTTP_GET, [](AsyncWebServerRequest *request){
+        uint32_t since = logOldest();
+        if (request->hasParam("since")) {
+            since = request->getParam("since")->value().toInt();
+        }
+        
+        DynamicJsonDocument doc(LOG_RING_SIZE * 160);
+        serializeLogs(doc, since);
+        
+        AsyncResponseStream *response = request->beginResponseStream("application/json");
+        serializeJson(doc, *response);
+        request->send(response);
+    });
+    
+#if ENABLE_TRACE
+    // Трасування: GET /api/trace[?clear=1] - Chrome trace-event JSON частинами
+    server.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *request){
+        std::shared_ptr<TraceExporter> exporter = std::make_shared<TraceExporter>();
+        if (request->hasParam("clear")) {
+            traceClear();
+        }
+        
+        AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+            [exporter](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                return exporter->read(buffer, maxLen);
+            });
+        response->addHeader("Content-Disposition", "inline; filename=trace.json");
+        request->send(response);
+    });
+#endif
+    
+#if ENABLE_METRICS
+    // Prometheus: текст генерується частинами прямо в буфер відповіді
+    server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request){
+        std::shared_ptr<MetricsExporter> exporter = std::make_shared<MetricsExporter>();
+        AsyncWebServerResponse *response = request->beginChunkedResponse("text/plain; version=0.0.4",
+            [exporter](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                return exporter->read(buffer, maxLen);
+            });
+        request->send(response);
+    });
+#endif
+
+    server.on("/api/start", HTTP_POST, [](AsyncWebServerRequest *request){
+        if (startPour()) request->send(200, "text/plain", "OK");
+        else request->send(409, "text/plain", "Busy or no glass");
+    });
+    
+    server.on("/api/stop", HTTP_POST, [](AsyncWebServerRequest *request){
+        extern void stopPour();
+        stopPour();
+        request->send(200, "text/plain", "OK");
+    });
+    
+    server.on("/api/pause", HTTP_POST, [](AsyncWebServerRequest *request){
+        if (pausePour()) request->send(200, "text/plain", "OK");
+        else request->send(409, "text/plain", "Not pouring");
+    });
+    
+    server.on("/api/resume", HTTP_POST, [](AsyncWebServerRequest *request){
+        if (resumePour()) request->send(200, "text/plain", "OK");
+        else request->send(409, "text/plain", "Not paused or no glass");
+    });
+    
+    // Налаштування, рюмки, черга, статистика, калібрування, batch
+    setupApi();
+    
+    // Сторінка /wifi і /api/wifi
+    setupWifiRoutes();
+    
+#if ENABLE_FLEET
+    setupFleetRoutes();
+#endif
+    
+#if ENABLE_OTA
+    // Сторінка /update і /api/ota
+    setupOtaRoutes();
+#endif
+
+    // 404
+    server.onNotFound([](AsyncWebServerRequest *request){
+        request->send(404, "text/plain", "Not found");
+    });
+    
+    // Запуск сервера
+    server.begin();
+    Serial.println("HTTP server started");
+    
+#if ENABLE_ARDUINO_OTA
+    setupOTA();
+#endif
+}
+
+void updateNetwork() {
+    // Підключення / резервна точка доступу
+    wifiUpdate();
+    
+    ws.cleanupClients();
+    wsUpdate();
+    
+    // Server-Sent Events
+    sseUpdate();
+    
+#if ENABLE_ARDUINO_OTA
+    if (arduinoOtaStarted) ArduinoOTA.handle();
+#endif
+}
+
+void broadcastState() {
+    TRACE_SCOPE(TRACE_BROADCAST);
+    
+    if (wsLock == NULL) return;
+    
+    DynamicJsonDocument doc(512);
+    serializeState(doc);
+    size_t len = measureJson(doc);
+    
+    // Одна серіалізація на всіх клієнтів: кадр у черзі - посилання на буфер
+    xSemaphoreTake(wsLock, portMAX_DELAY);
+    AsyncWebSocketMessageBuffer *buffer = wsStateBuffer(len);
+    if (buffer != NULL) {
+        serializeJson(doc, (char*)buffer->get(), len + 1);
+        wsState = buffer;
+    }
+    
+    // Без вільного буфера всі отримають останній стан з wsUpdate()
+    for (int i = 0; i < WS_CLIENTS_MAX; i++) {
+        if (wsClients[i].id == 0) continue;
+        if (buffer != NULL) {
+            wsSendState(wsClients[i]);
+        } else if (!wsClients[i].statePending) {
+            wsClients[i].statePending = true;
+        }
+    }
+    xSemaphoreGive(wsLock);
+}
+
+void printWsStatus(Print &out) {
+    out.printf("Clients: %lu, frames: %lu sent, %lu superseded, %lu dropped\n",
+               (unsigned long)ws.count(), (unsigned long)wsSentTotal, (unsigned long)wsSupersededTotal,
+               (unsigned long)wsDroppedTotal);
+    if (wsLock == NULL) return;
+    
+    xSemaphoreTake(wsLock, portMAX_DELAY);
+    for (int i = 0; i < WS_CLIENTS_MAX; i++) {
+        const WsClientSlot &slot = wsClients[i];
+        if (slot.id == 0) continue;
+        AsyncWebSocketClient *client = ws.client(slot.id);
+        out.printf("  #%lu queue %u%s, %lu sent, %lu superseded, %lu dropped\n", (unsigned long)slot.id,
+                   client ? (unsigned)client->queueLen() : 0, slot.statePending ? " +state" : "",
+                   (unsigned long)slot.sent, (unsigned long)slot.superseded, (unsigned long)slot.dropped);
+    }
+    xSemaphoreGive(wsLock);
+}
+
+uint32_t wsClientCount() {
+    return ws.count();
+}
+
+uint32_t wsBytesSent() {
+    return wsBytes;
+}
+
+uint32_t wsFramesSent() {
+    return wsSentTotal;
+}
+
+uint32_t wsFramesSuperseded() {
+    return wsSupersededTotal;
+}
+
+uint32_t wsFramesDropped() {
+    return wsDroppedTotal;
+}
+
+uint32_t sseBytesSent() {
+    return sseBytes;
 }
 
 const char* getStateString(SystemState state) {
@@ -491,27 +2181,44 @@ const char* getStateString(SystemState state) {
         case STATE_PAUSED: return "Пауза";
         case STATE_ERROR: return "Помилка";
         case STATE_CLEANING: return "Очищення";
+        case STATE_UPDATING: return "Оновлення";
         default: return "Невідомо";
     }
 }
 
-#if ENABLE_OTA
+#if ENABLE_OTA || ENABLE_ARDUINO_OTA
+bool otaSetPassword(const char* pass) {
+    if (!saveOtaPassword(pass)) return false;
+    strlcpy(otaPass, pass, sizeof(otaPass));
+    
+#if ENABLE_ARDUINO_OTA
+    setupOTA();
+#endif
+    return true;
+}
+#endif
+
+#if ENABLE_ARDUINO_OTA
 void setupOTA() {
+    // espota без пароля не вмикається. Новий пароль - з наступної сесії
+    if (otaPass[0] == 0) return;
+    ArduinoOTA.setPassword(otaPass);
+    if (arduinoOtaStarted) return;
+    
     ArduinoOTA.setHostname(DEVICE_NAME);
-    ArduinoOTA.setPassword(OTA_PASSWORD);
     ArduinoOTA.setPort(OTA_PORT);
     
     ArduinoOTA.onStart([]() {
         String type = (ArduinoOTA.getCommand() == U_FLASH) ? "sketch" : "filesystem";
         Serial.println("Start updating " + type);
         
-        // Зупинити всі задачі
-        extern void stopAllTasks();
-        stopAllTasks();
+        // Розлив зупиняється, задачі лишаються - інакше невдале оновлення не відновити
+        otaEnterUpdating();
     });
     
     ArduinoOTA.onEnd([]() {
         Serial.println("\nEnd");
+        if (ArduinoOTA.getCommand() == U_FLASH) otaMarkPending();
     });
     
     ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
@@ -525,9 +2232,11 @@ void setupOTA() {
         else if (error == OTA_CONNECT_ERROR) Serial.println("Connect Failed");
         else if (error == OTA_RECEIVE_ERROR) Serial.println("Receive Failed");
         else if (error == OTA_END_ERROR) Serial.println("End Failed");
+        otaLeaveUpdating();
     });
     
     ArduinoOTA.begin();
+    arduinoOtaStarted = true;
     Serial.println("OTA ready");
 }
 #endif
@@ -0,0 +1,350 @@
+#include "ota.h"
+
+#if ENABLE_WIFI && ENABLE_OTA
+
+#include "control.h"
+#include "network.h"
+#include <Preferences.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+
+extern SystemState g_systemState;
+extern TaskHandle_t uiTaskHandle;
+extern TaskHandle_t controlTaskHandle;
+
+enum OtaStage : uint8_t {
+    OTA_STAGE_IDLE = 0,
+    OTA_STAGE_RECEIVING,        // Частини пишуться в неактивний розділ
+    OTA_STAGE_READY,            // Розділ перемкнено, чекаємо перезавантаження
+    OTA_STAGE_FAILED
+};
+
+static const char* const otaStageNames[] = {"idle", "receiving", "ready", "failed"};
+
+static volatile OtaStage otaStage = OTA_STAGE_IDLE;
+static const void *otaOwner = NULL;
+static const esp_partition_t *otaPartition = NULL;
+static esp_ota_handle_t otaHandle = 0;
+static mbedtls_sha256_context otaSha;
+static uint8_t otaExpected[32];
+static bool otaHasExpected = false;
+static size_t otaSize = 0;
+static size_t otaWritten = 0;
+static unsigned long otaStartedAt = 0;
+static volatile unsigned long otaRestartAt = 0;
+static char otaErrorText[64] = "";
+static int otaErrorCode = 0;
+
+// Перевірка нової прошивки після перезавантаження
+static bool otaVerifying = false;
+static uint8_t otaBoots = 0;
+
+// ========================================
+// СТАН РОЗЛИВУ
+// ========================================
+
+void otaEnterUpdating() {
+    // Розлив зупиняє стан, а не видалення задач: контур керування далі працює
+    // і не почне новий розлив у STATE_UPDATING
+    if (g_systemState == STATE_MOVING || g_systemState == STATE_POURING ||
+        g_systemState == STATE_PAUSED || g_systemState == STATE_CLEANING) {
+        stopPour();
+    }
+    clearPourQueue();
+    g_systemState = STATE_UPDATING;
+    
+    LOG_I("Firmware update started, pouring locked");
+    broadcastState();
+}
+
+void otaLeaveUpdating() {
+    if (g_systemState != STATE_UPDATING) return;
+    
+    g_systemState = STATE_IDLE;
+    broadcastState();
+}
+
+// ========================================
+// ПІДТВЕРДЖЕННЯ І ВІДКАТ
+// ========================================
+
+void otaMarkPending() {
+    const esp_partition_t *boot = esp_ota_get_boot_partition();
+    
+    Preferences otaPrefs;
+    if (!otaPrefs.begin(OTA_PREFS_NAMESPACE, false)) return;
+    
+    // Слот нової прошивки: якщо завантажувач сам відкотиться, стара не вважатиметься новою
+    otaPrefs.putBool("pending", true);
+    otaPrefs.putString("slot", boot != NULL ? boot->label : "");
+    otaPrefs.putUChar("boots", 0);
+    otaPrefs.end();
+}
+
+static void otaClearPending() {
+    Preferences otaPrefs;
+    if (!otaPrefs.begin(OTA_PREFS_NAMESPACE, false)) return;
+    
+    otaPrefs.clear();
+    otaPrefs.end();
+}
+
+static void otaRollback(const char* reason) {
+    LOG_E("Firmware rollback: %s", reason);
+    otaClearPending();
+    delay(100);   // Лог встигає вийти в Serial
+    
+    // Із CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE - штатний шлях IDF, повертається лише при помилці
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+    
+    // Без підтримки завантажувача: з двома слотами "наступний" і є попередній
+    const esp_partition_t *previous = esp_ota_get_next_update_partition(NULL);
+    if (previous != NULL && esp_ota_set_boot_partition(previous) == ESP_OK) {
+        esp_restart();
+    }
+    LOG_E("Rollback failed, staying on current firmware");
+}
+
+void otaBootCheck() {
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    bool pending = false;
+    
+    Preferences otaPrefs;
+    if (otaPrefs.begin(OTA_PREFS_NAMESPACE, false)) {
+        pending = otaPrefs.getBool("pending", false);
+        if (pending && otaPrefs.getString("slot", "") != running->label) {
+            // Завантажувач уже відкотився на попередній слот
+            LOG_W("Firmware in %s was not confirmed, bootloader rolled back",
+                  otaPrefs.getString("slot", "").c_str());
+            otaPrefs.clear();
+            pending = false;
+        } else if (pending) {
+            otaBoots = otaPrefs.getUChar("boots", 0) + 1;
+            otaPrefs.putUChar("boots", otaBoots);
+        }
+        otaPrefs.end();
+    }
+    
+    // Прошивка з espota без нашої позначки теж чекає підтвердження
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(running, &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+        pending = true;
+    }
+    
+    otaVerifying = pending;
+    if (!pending) return;
+    
+    LOG_I("New firmware on %s, boot %d of %d before confirmation",
+          running->label, otaBoots, OTA_BOOT_ATTEMPTS);
+    
+    // Перезавантажується раніше, ніж встигає пройти перевірку
+    if (otaBoots > OTA_BOOT_ATTEMPTS) {
+        otaRollback("boot loop");
+    }
+}
+
+// Нова прошивка здорова: задачі працюють, пам'яті вистачає, мережа піднята
+static const char* otaHealthProblem() {
+    if (uiTaskHandle == NULL || controlTaskHandle == NULL) return "tasks not running";
+    if (ESP.getFreeHeap() < OTA_HEALTH_MIN_HEAP) return "low memory";
+    if (WiFi.getMode() == WIFI_OFF) return "network down";
+    return NULL;
+}
+
+void updateOta() {
+    if (otaRestartAt != 0 && (long)(millis() - otaRestartAt) >= 0) {
+        LOG_I("Restarting into new firmware...");
+        delay(100);   // Лог встигає вийти в Serial
+        esp_restart();
+    }
+    
+    if (otaVerifying && millis() >= OTA_HEALTH_DELAY) {
+        otaVerifying = false;
+        
+        const char* problem = otaHealthProblem();
+        if (problem != NULL) {
+            otaRollback(problem);
+            return;
+        }
+        
+        esp_ota_mark_app_valid_cancel_rollback();
+        otaClearPending();
+        LOG_I("Firmware %s confirmed", FIRMWARE_VERSION);
+    }
+}
+
+// ========================================
+// ЗАВАНТАЖЕННЯ
+// ========================================
+
+static bool otaFail(int code, const char* message) {
+    if (otaStage == OTA_STAGE_RECEIVING) {
+        esp_ota_abort(otaHandle);
+        mbedtls_sha256_free(&otaSha);
+    }
+    
+    otaStage = OTA_STAGE_FAILED;
+    otaErrorCode = code;
+    strlcpy(otaErrorText, message, sizeof(otaErrorText));
+    LOG_E("Firmware update failed: %s", message);
+    
+    otaLeaveUpdating();
+    return false;
+}
+
+static bool otaParseHex(const char* hex, uint8_t *out) {
+    if (strlen(hex) != 64) return false;
+    
+    for (int i = 0; i < 32; i++) {
+        char byte[3] = {hex[i * 2], hex[i * 2 + 1], 0};
+        char *end = NULL;
+        out[i] = strtoul(byte, &end, 16);
+        if (end != byte + 2) return false;
+    }
+    return true;
+}
+
+bool otaBegin(const void *owner, size_t size, const char *sha256Hex) {
+    if (otaStage == OTA_STAGE_RECEIVING || otaStage == OTA_STAGE_READY) return false;
+    
+    otaOwner = owner;
+    otaSize = size;
+    otaWritten = 0;
+    otaStartedAt = millis();
+    
+    otaHasExpected = sha256Hex != NULL && sha256Hex[0] != 0;
+    if (otaHasExpected && !otaParseHex(sha256Hex, otaExpected)) {
+        return otaFail(400, "invalid sha256");
+    }
+    
+    otaPartition = esp_ota_get_next_update_partition(NULL);
+    if (otaPartition == NULL) {
+        return otaFail(500, "no OTA partition");
+    }
+    if (size == 0 || size > otaPartition->size) {
+        return otaFail(413, "image does not fit partition");
+    }
+    
+    otaEnterUpdating();
+    
+    // Стирання посекторно під час запису - без паузи на стирання всього розділу
+    esp_err_t err = esp_ota_begin(otaPartition, OTA_WITH_SEQUENTIAL_WRITES, &otaHandle);
+    if (err != ESP_OK) {
+        return otaFail(500, esp_err_to_name(err));
+    }
+    
+    mbedtls_sha256_init(&otaSha);
+    mbedtls_sha256_starts(&otaSha, 0);
+    otaStage = OTA_STAGE_RECEIVING;
+    
+    LOG_I("Receiving firmware: %u bytes -> %s", (unsigned)size, otaPartition->label);
+    return true;
+}
+
+bool otaWrite(const void *owner, const uint8_t *data, size_t len) {
+    if (owner != otaOwner || otaStage != OTA_STAGE_RECEIVING) return false;
+    
+    if (otaWritten + len > otaSize) {
+        return otaFail(400, "more data than announced");
+    }
+    
+    esp_err_t err = esp_ota_write(otaHandle, data, len);
+    if (err != ESP_OK) {
+        return otaFail(err == ESP_ERR_OTA_VALIDATE_FAILED ? 400 : 500,
+                       err == ESP_ERR_OTA_VALIDATE_FAILED ? "not a firmware image" : esp_err_to_name(err));
+    }
+    
+    mbedtls_sha256_update(&otaSha, data, len);
+    otaWritten += len;
+    return true;
+}
+
+bool otaEnd(const void *owner) {
+    if (owner != otaOwner || otaStage != OTA_STAGE_RECEIVING) return false;
+    
+    if (otaWritten != otaSize) {
+        return otaFail(400, "incomplete image");
+    }
+    
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&otaSha, digest);
+    mbedtls_sha256_free(&otaSha);
+    
+    if (otaHasExpected && memcmp(digest, otaExpected, sizeof(digest)) != 0) {
+        return otaFail(400, "sha256 mismatch");
+    }
+    
+    // esp_ota_end перевіряє структуру образу і його вбудований хеш
+    esp_err_t err = esp_ota_end(otaHandle);
+    if (err != ESP_OK) {
+        otaStage = OTA_STAGE_IDLE;
+        return otaFail(400, err == ESP_ERR_OTA_VALIDATE_FAILED ? "image validation failed" : esp_err_to_name(err));
+    }
+    
+    err = esp_ota_set_boot_partition(otaPartition);
+    if (err != ESP_OK) {
+        otaStage = OTA_STAGE_IDLE;
+        return otaFail(500, esp_err_to_name(err));
+    }
+    
+    otaMarkPending();
+    otaStage = OTA_STAGE_READY;
+    otaOwner = NULL;
+    otaRestartAt = millis() + OTA_RESTART_DELAY;
+    
+    LOG_I("Firmware written in %lu ms, boot partition %s",
+          millis() - otaStartedAt, otaPartition->label);
+    return true;
+}
+
+void otaAbort(const void *owner, const char *reason) {
+    if (owner != otaOwner || otaStage != OTA_STAGE_RECEIVING) return;
+    otaFail(400, reason);
+}
+
+int otaResult(const void *owner, const char **message) {
+    if (owner != otaOwner && otaStage == OTA_STAGE_RECEIVING) {
+        *message = "update in progress";
+        return 409;
+    }
+    if (otaStage == OTA_STAGE_READY) {
+        *message = "rebooting";
+        return 200;
+    }
+    if (owner != otaOwner || otaStage == OTA_STAGE_IDLE) {
+        *message = "no firmware in body (Content-Type: application/octet-stream)";
+        return 400;
+    }
+    if (otaStage == OTA_STAGE_RECEIVING) {
+        *message = "incomplete image";
+        return 400;
+    }
+    
+    *message = otaErrorText;
+    return otaErrorCode;
+}
+
+void serializeOta(JsonDocument &doc) {
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    const esp_partition_t *next = esp_ota_get_next_update_partition(NULL);
+    
+    doc["version"] = FIRMWARE_VERSION;
+    doc["running"] = running != NULL ? running->label : "";
+    doc["next"] = next != NULL ? next->label : "";
+    doc["slotSize"] = next != NULL ? next->size : 0;
+    doc["verifying"] = otaVerifying;
+    doc["state"] = otaStageNames[otaStage];
+    doc["written"] = otaWritten;
+    doc["size"] = otaSize;
+    if (otaStage == OTA_STAGE_FAILED) doc["error"] = otaErrorText;
+}
+
+#ifndef SIMULATOR
+// Ядро Arduino не підтверджує образ саме - це робить updateOta() після перевірки здоров'я
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+#endif
+
+#endif // ENABLE_WIFI && ENABLE_OTA
@@ -0,0 +1,185 @@
+#include "power.h"
+#include "control.h"
+#include "display.h"
+#include "inputs.h"
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+
+extern SystemState g_systemState;
+extern PourMode g_pourMode;
+extern uint16_t g_targetVolume;
+extern uint8_t g_selectedShot;
+extern bool g_glassPresent[GLASS_COUNT];
+extern volatile int encoderPos;
+
+// Входи, що будять з light sleep: рівень, протилежний поточному
+static const uint8_t powerButtonPins[] = {ENCODER_SW, BUTTON_START};
+
+static volatile PowerLevel level = POWER_ACTIVE;
+static volatile unsigned long lastActivity = 0;
+static uint32_t lastSignature = 0;
+static bool pmSupported = true;
+static SemaphoreHandle_t powerLock = NULL;
+
+// Все, що користувач може змінити: енкодер, кнопки, рюмки, налаштування, стан
+static uint32_t inputSignature() {
+    uint32_t sig = (uint32_t)encoderPos;
+    sig = sig * 31 + digitalRead(ENCODER_SW);
+    sig = sig * 31 + digitalRead(BUTTON_START);
+    for (int i = 0; i < GLASS_COUNT; i++) sig = sig * 31 + g_glassPresent[i];
+    sig = sig * 31 + g_systemState;
+    sig = sig * 31 + g_pourMode;
+    sig = sig * 31 + g_targetVolume;
+    sig = sig * 31 + g_selectedShot;
+    return sig;
+}
+
+// Розлив, рух, черга - не простій
+static bool powerBusy() {
+    bool idle = g_systemState == STATE_IDLE || g_systemState == STATE_READY || g_systemState == STATE_ERROR;
+    return !idle || pourQueueLength() > 0;
+}
+
+// Частота CPU і light sleep. Без CONFIG_PM_ENABLE у збірці - лише частота
+static void setCpuSleep(bool sleep) {
+    int mhz = sleep ? POWER_SLEEP_CPU_MHZ : POWER_CPU_MHZ;
+    
+    if (pmSupported) {
+        esp_pm_config_esp32_t pm = {mhz, mhz, sleep};
+        esp_err_t err = esp_pm_configure(&pm);
+        if (err == ESP_OK) return;
+        
+        pmSupported = false;
+        LOG_W("Power: light sleep unavailable (%d), CPU frequency only", err);
+    }
+    setCpuFrequencyMhz(mhz);
+}
+
+// Пробудження - рівнем, а той самий пін веде переривання inputs.cpp: на час сну
+// переривання вимкнене (рівень інакше сипав би ISR), після - знову на обидва фронти
+static void armWakePin(uint8_t pin, bool enable) {
+    if (enable) {
+        gpio_intr_disable((gpio_num_t)pin);
+        gpio_wakeup_enable((gpio_num_t)pin, digitalRead(pin) ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    } else {
+        gpio_wakeup_disable((gpio_num_t)pin);
+        gpio_set_intr_type((gpio_num_t)pin, GPIO_INTR_ANYEDGE);
+        gpio_intr_enable((gpio_num_t)pin);
+    }
+}
+
+static void armWakePins(bool enable) {
+    for (uint8_t pin : powerButtonPins) armWakePin(pin, enable);
+    // Аналогові датчики не будять: драйвер ADC DMA тримає свій pm lock, і light sleep
+    // з ними не настає - лише знижена частота і згаслий дисплей
+#if !GLASS_SENSOR_ANALOG
+    for (uint8_t pin : hw::glassPins) armWakePin(pin, enable);
+#endif
+    if (enable) esp_sleep_enable_gpio_wakeup();
+    
+    // Фронти під час сну не рахувались - стан кнопок і рюмок звірити з рівнями
+    if (!enable) inputsResync();
+}
+
+// Викликати під powerLock
+static void applyLevel(PowerLevel target) {
+    PowerLevel from = level;
+    if (target == from) return;
+    
+    switch (target) {
+        case POWER_ACTIVE:
+            if (from == POWER_SLEEP) {
+                armWakePins(false);
+                setCpuSleep(false);
+                setServoPower(true);
+            }
+            FastLED.setBrightness(LED_BRIGHTNESS);
+            setBacklight(BACKLIGHT_ON);
+            break;
+        
+        case POWER_DIM:
+            FastLED.setBrightness(LED_BRIGHTNESS / 4);
+            setBacklight(BACKLIGHT_DIM);
+            break;
+        
+        case POWER_SLEEP:
+            setBacklight(0);
+            FastLED.clear(true);
+            setServoPower(false);
+            setCpuSleep(true);
+            armWakePins(true);
+            break;
+    }
+    
+    level = target;
+    LOG_I("Power: %s -> %s", powerLevelName(from), powerLevelName(target));
+}
+
+void setupPower() {
+    powerLock = xSemaphoreCreateMutex();
+    lastActivity = millis();
+    lastSignature = inputSignature();
+    setCpuFrequencyMhz(POWER_CPU_MHZ);
+}
+
+void powerActivity() {
+    lastActivity = millis();
+}
+
+void powerWake() {
+    lastActivity = millis();
+    if (level == POWER_ACTIVE || powerLock == NULL) return;
+    
+    xSemaphoreTake(powerLock, portMAX_DELAY);
+    applyLevel(POWER_ACTIVE);
+    xSemaphoreGive(powerLock);
+}
+
+void updatePower() {
+    uint32_t sig = inputSignature();
+    if (sig != lastSignature || powerBusy()) {
+        lastSignature = sig;
+        lastActivity = millis();
+    }
+    
+    PowerLevel target = POWER_ACTIVE;
+#if ENABLE_POWER_SAVE
+    uint32_t idle = powerIdleMs();
+    if (idle >= IDLE_SLEEP_TIMEOUT) target = POWER_SLEEP;
+    else if (idle >= IDLE_DIM_TIMEOUT) target = POWER_DIM;
+#endif
+    if (target == level || powerLock == NULL) return;
+    
+    xSemaphoreTake(powerLock, portMAX_DELAY);
+    applyLevel(target);
+    xSemaphoreGive(powerLock);
+}
+
+PowerLevel powerLevel() {
+    return level;
+}
+
+uint32_t powerIdleMs() {
+    return millis() - lastActivity;
+}
+
+const char* powerLevelName(PowerLevel lvl) {
+    switch (lvl) {
+        case POWER_ACTIVE: return "active";
+        case POWER_DIM: return "dim";
+        case POWER_SLEEP: return "sleep";
+        default: return "unknown";
+    }
+}
+
+void printPowerStatus(Print &out) {
+    out.printf("Level: %s, idle %lu s\n", powerLevelName(level), (unsigned long)(powerIdleMs() / 1000));
+    out.printf("CPU: %lu MHz, light sleep %s\n", (unsigned long)getCpuFrequencyMhz(),
+               level == POWER_SLEEP && pmSupported ? "on" : "off");
+#if ENABLE_POWER_SAVE
+    out.printf("Dim after %d s, sleep after %d s\n", IDLE_DIM_TIMEOUT / 1000, IDLE_SLEEP_TIMEOUT / 1000);
+#else
+    out.println("Power save disabled");
+#endif
+}
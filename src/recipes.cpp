@@ -0,0 +1,441 @@
+#include "recipes.h"
+#include "control.h"
+#include "storage.h"
+
+#if RECIPE_PUMPS > 1
+static_assert(RECIPE_PUMPS <= 5, "pump 1 + 4 RECIPE_PINS");
+static_assert(RECIPE_LEDC_FIRST + RECIPE_PUMPS - 1 <= BACKLIGHT_CHANNEL, "LEDC channels overlap the backlight");
+#endif
+
+extern uint8_t g_selectedRecipe;
+extern float g_pumpRate;
+extern float g_primeVolume;
+
+// Пін читає ISR відсічки
+static const DRAM_ATTR uint8_t recipePins[] = RECIPE_PINS;
+static_assert(sizeof(recipePins) >= RECIPE_PUMPS - 1, "RECIPE_PINS shorter than RECIPE_PUMPS - 1");
+
+static RecipeBook book;
+
+// Крок розкладу поточного коктейлю
+struct ScheduleStep {
+    uint8_t pump;               // 0 - основна
+    float ml;                   // Частки діляться без залишку
+    float rate;
+    unsigned long startMs;      // Від початку розливу, без пауз
+    unsigned long primeMs;      // Мертвий об'єм злитої трубки
+    unsigned long durationMs;   // Разом з primeMs
+};
+
+static ScheduleStep schedule[RECIPE_STEPS_MAX];
+static uint8_t scheduleSteps = 0;
+static unsigned long scheduleMs = 0;
+static bool active = false;
+static uint8_t pumpsOn = 0;     // Біт на помпу: що зараз увімкнено
+
+static const char* const defaultIngredients[] = {"vodka", "juice", "syrup", "soda", "tonic"};
+
+static void loadDefaults() {
+    memset(&book, 0, sizeof(book));
+    book.magic = RECIPE_MAGIC;
+    book.version = RECIPE_VERSION;
+    for (uint8_t i = 0; i < RECIPE_PUMPS; i++) {
+        strlcpy(book.pumps[i].ingredient, defaultIngredients[i], RECIPE_NAME_LEN);
+    }
+    
+    recipeParse("vodka:1,juice:2", book.recipes[0]);
+    strlcpy(book.recipes[0].name, "screwdriver", RECIPE_NAME_LEN);
+    recipeParse("syrup:1/vodka:2", book.recipes[1]);
+    strlcpy(book.recipes[1].name, "layered", RECIPE_NAME_LEN);
+    book.count = 2;
+}
+
+void loadRecipes() {
+    if (!loadRecipeBook(book) || book.count > RECIPES_MAX) loadDefaults();
+    if (g_selectedRecipe > book.count) g_selectedRecipe = 0;
+    
+    LOG_I("Recipes: %d, %d pumps, selected %s", book.count, RECIPE_PUMPS,
+          g_selectedRecipe ? book.recipes[g_selectedRecipe - 1].name : "none");
+}
+
+// ========================================
+// ПОМПИ
+// ========================================
+
+static void pumpWrite(uint8_t pump, uint8_t duty) {
+    if (pump == 0) {
+        ledcWrite(PUMP_CHANNEL, duty);
+        return;
+    }
+#if RECIPE_PUMPS > 1
+    ledcWrite(RECIPE_LEDC_FIRST + pump - 1, duty);
+#endif
+}
+
+#if RECIPE_PUMPS > 1
+void setupRecipePumps() {
+    for (uint8_t i = 0; i < RECIPE_PUMPS - 1; i++) {
+        pinMode(recipePins[i], OUTPUT);
+        digitalWrite(recipePins[i], LOW);
+        ledcSetup(RECIPE_LEDC_FIRST + i, PUMP_FREQ, 8);
+        ledcAttachPin(recipePins[i], RECIPE_LEDC_FIRST + i);
+        ledcWrite(RECIPE_LEDC_FIRST + i, 0);
+    }
+}
+
+void IRAM_ATTR recipeCutoffISR() {
+    for (uint8_t i = 0; i < RECIPE_PUMPS - 1; i++) {
+        ledcDetachPin(recipePins[i]);
+        digitalWrite(recipePins[i], LOW);
+    }
+}
+
+void recipeReattach() {
+    for (uint8_t i = 0; i < RECIPE_PUMPS - 1; i++) {
+        ledcWrite(RECIPE_LEDC_FIRST + i, 0);
+        ledcAttachPin(recipePins[i], RECIPE_LEDC_FIRST + i);
+    }
+    pumpsOn = 0;
+}
+#endif
+
+static int findPump(const char* ingredient) {
+    for (uint8_t i = 0; i < RECIPE_PUMPS; i++) {
+        if (strcasecmp(book.pumps[i].ingredient, ingredient) == 0) return i;
+    }
+    return -1;
+}
+
+bool pumpLoad(uint8_t pump, const char* ingredient, float rate) {
+    if (pump < 1 || pump > RECIPE_PUMPS) return false;
+    if (ingredient[0] == 0 || strlen(ingredient) >= RECIPE_NAME_LEN) return false;
+    if (rate != 0 && (rate < PUMP_RATE_MIN || rate > PUMP_RATE_MAX)) return false;
+    
+    // Той самий інгредієнт у двох помпах - рецепт не знав би, яку взяти
+    int other = findPump(ingredient);
+    if (other >= 0 && other != pump - 1) return false;
+    
+    portENTER_CRITICAL(&controlMux);
+    strlcpy(book.pumps[pump - 1].ingredient, ingredient, RECIPE_NAME_LEN);
+    book.pumps[pump - 1].rate = rate;
+    portEXIT_CRITICAL(&controlMux);
+    
+    saveRecipeBook(book);
+    LOG_I("Pump %d: %s, %.2f ml/s", pump, ingredient, pumpRate(pump));
+    return true;
+}
+
+const PumpSlot* pumpSlot(uint8_t pump) {
+    if (pump < 1 || pump > RECIPE_PUMPS) return NULL;
+    return &book.pumps[pump - 1];
+}
+
+float pumpRate(uint8_t pump) {
+    const PumpSlot *slot = pumpSlot(pump);
+    return slot != NULL && slot->rate > 0 ? slot->rate : g_pumpRate;
+}
+
+// ========================================
+// КНИГА РЕЦЕПТІВ
+// ========================================
+
+uint8_t recipeCount() {
+    return book.count;
+}
+
+const Recipe* recipeAt(uint8_t index) {
+    if (index < 1 || index > book.count) return NULL;
+    return &book.recipes[index - 1];
+}
+
+bool recipeAvailable(const Recipe &recipe, const char **missing) {
+    for (uint8_t i = 0; i < recipe.steps; i++) {
+        if (findPump(recipe.step[i].ingredient) < 0) {
+            if (missing != NULL) *missing = recipe.step[i].ingredient;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool recipeSelect(uint8_t index) {
+    if (index > book.count) return false;
+#if MANIFOLD_CHANNELS
+    // Колектор: у кожної рюмки своя помпа з одним напоєм
+    if (index != 0) return false;
+#endif
+    g_selectedRecipe = index;
+    
+    extern void saveSettings();
+    saveSettings();
+    
+    DEBUG_PRINTF("Recipe selected: %s\n", index ? book.recipes[index - 1].name : "none");
+    return true;
+}
+
+int recipeIndex(const char* name) {
+    if (strcmp(name, "off") == 0) return 0;
+    
+    for (uint8_t i = 0; i < book.count; i++) {
+        if (strcasecmp(book.recipes[i].name, name) == 0) return i + 1;
+    }
+    
+    char *end = NULL;
+    long index = strtol(name, &end, 10);
+    if (end == name || *end != 0 || index < 0 || index > book.count) return -1;
+    return index;
+}
+
+bool recipeSelectName(const char* name) {
+    int index = recipeIndex(name);
+    return index >= 0 && recipeSelect(index);
+}
+
+void recipeSelectNext(int dir) {
+    uint8_t options = book.count + 1;
+    uint8_t index = g_selectedRecipe;
+    
+    // Пропустити рецепти, яким бракує інгредієнта; 0 доступний завжди
+    for (uint8_t n = 0; n < options; n++) {
+        index = (index + options + (dir > 0 ? 1 : -1)) % options;
+        if (index == 0 || recipeAvailable(book.recipes[index - 1])) break;
+    }
+    recipeSelect(index);
+}
+
+const char* recipeSelectedName() {
+    return g_selectedRecipe ? book.recipes[g_selectedRecipe - 1].name : NULL;
+}
+
+bool recipeParse(const char* spec, Recipe &out) {
+    memset(&out, 0, sizeof(out));
+    uint8_t stage = 0;
+    const char *p = spec;
+    
+    while (*p) {
+        if (out.steps >= RECIPE_STEPS_MAX) return false;
+        RecipeStep &step = out.step[out.steps];
+        
+        size_t len = strcspn(p, ":,/");
+        if (len == 0 || len >= RECIPE_NAME_LEN) return false;
+        memcpy(step.ingredient, p, len);
+        p += len;
+        
+        step.parts = 1;
+        if (*p == ':') {
+            char *end = NULL;
+            long parts = strtol(p + 1, &end, 10);
+            if (end == p + 1 || parts < 1 || parts > RECIPE_PARTS_MAX) return false;
+            step.parts = parts;
+            p = end;
+        }
+        step.stage = stage;
+        out.steps++;
+        
+        if (*p == '/') stage++;
+        else if (*p != ',' && *p != 0) return false;
+        if (*p) {
+            p++;
+            if (*p == 0) return false;
+        }
+    }
+    
+    return out.steps > 0;
+}
+
+void recipeFormat(const Recipe &recipe, char *buf, size_t len) {
+    size_t pos = 0;
+    buf[0] = 0;
+    for (uint8_t i = 0; i < recipe.steps && pos < len; i++) {
+        const RecipeStep &step = recipe.step[i];
+        const char *sep = i == 0 ? "" : step.stage != recipe.step[i - 1].stage ? "/" : ",";
+        pos += snprintf(buf + pos, len - pos, "%s%s:%d", sep, step.ingredient, step.parts);
+    }
+}
+
+bool recipeSave(const Recipe &recipe) {
+    if (recipe.name[0] == 0 || recipe.steps == 0) return false;
+    
+    portENTER_CRITICAL(&controlMux);
+    uint8_t slot = book.count;
+    for (uint8_t i = 0; i < book.count; i++) {
+        if (strcasecmp(book.recipes[i].name, recipe.name) == 0) slot = i;
+    }
+    bool saved = slot < RECIPES_MAX;
+    if (saved) {
+        book.recipes[slot] = recipe;
+        if (slot == book.count) book.count++;
+    }
+    portEXIT_CRITICAL(&controlMux);
+    
+    if (!saved) return false;
+    saveRecipeBook(book);
+    LOG_I("Recipe saved: %s", recipe.name);
+    return true;
+}
+
+bool recipeDelete(const char* name) {
+    portENTER_CRITICAL(&controlMux);
+    int found = -1;
+    for (uint8_t i = 0; i < book.count; i++) {
+        if (strcasecmp(book.recipes[i].name, name) == 0) found = i;
+    }
+    if (found >= 0) {
+        memmove(&book.recipes[found], &book.recipes[found + 1], (book.count - found - 1) * sizeof(Recipe));
+        book.count--;
+    }
+    portEXIT_CRITICAL(&controlMux);
+    
+    if (found < 0) return false;
+    
+    // Вибір зсувається разом з рецептами
+    if (g_selectedRecipe == found + 1) recipeSelect(0);
+    else if (g_selectedRecipe > found + 1) recipeSelect(g_selectedRecipe - 1);
+    
+    saveRecipeBook(book);
+    LOG_I("Recipe deleted: %s", name);
+    return true;
+}
+
+// ========================================
+// РОЗКЛАД
+// ========================================
+
+bool recipePlan(uint16_t volume, bool primed) {
+    if (g_selectedRecipe == 0) return false;
+    
+    Recipe recipe;
+    portENTER_CRITICAL(&controlMux);
+    recipe = book.recipes[g_selectedRecipe - 1];
+    portEXIT_CRITICAL(&controlMux);
+    
+    uint16_t totalParts = 0;
+    for (uint8_t i = 0; i < recipe.steps; i++) totalParts += recipe.step[i].parts;
+    
+    // Кроки: помпа, об'єм, тривалість; етап триває, скільки його найдовший крок
+    unsigned long stageStart = 0;
+    unsigned long stageMs = 0;
+    uint8_t stagePumps = 0;
+    for (uint8_t i = 0; i < recipe.steps; i++) {
+        const RecipeStep &step = recipe.step[i];
+        ScheduleStep &s = schedule[i];
+        
+        if (i > 0 && step.stage != recipe.step[i - 1].stage) {
+            stageStart += stageMs;
+            stageMs = 0;
+            stagePumps = 0;
+        }
+        
+        int pump = findPump(step.ingredient);
+        if (pump < 0) {
+            LOG_W("Recipe %s: no pump with %s", recipe.name, step.ingredient);
+            return false;
+        }
+        if (stagePumps & (1 << pump)) {
+            LOG_W("Recipe %s: pump %d twice in one stage", recipe.name, pump + 1);
+            return false;
+        }
+        stagePumps |= 1 << pump;
+        
+        s.pump = pump;
+        s.rate = pumpRate(pump + 1);
+        s.ml = (float)volume * step.parts / totalParts;
+        s.startMs = stageStart;
+        s.primeMs = primed ? 0 : (unsigned long)(g_primeVolume / s.rate * 1000);
+        s.durationMs = s.primeMs + (unsigned long)(s.ml / s.rate * 1000);
+        if (s.durationMs > stageMs) stageMs = s.durationMs;
+    }
+    
+    unsigned long total = stageStart + stageMs;
+    if (total > MAX_POUR_TIME) {
+        LOG_W("Recipe %s: %lu ms is over %d ms, pour less", recipe.name, total, MAX_POUR_TIME);
+        return false;
+    }
+    
+    scheduleSteps = recipe.steps;
+    scheduleMs = total;
+    pumpsOn = 0;
+    active = true;
+    
+    LOG_I("Cocktail %s: %d ml, %d stages, %lu ms", recipe.name, volume,
+          recipe.step[recipe.steps - 1].stage + 1, total);
+    return true;
+}
+
+bool recipeActive() {
+    return active;
+}
+
+unsigned long recipeTotalMs() {
+    return scheduleMs;
+}
+
+void recipeApply(unsigned long elapsed) {
+    if (!active) return;
+    
+    uint8_t on = 0;
+    for (uint8_t i = 0; i < scheduleSteps; i++) {
+        const ScheduleStep &s = schedule[i];
+        if (elapsed >= s.startMs && elapsed < s.startMs + s.durationMs) on |= 1 << s.pump;
+    }
+    
+    // Запис тільки при зміні - розклад перевіряється кожен тік
+    uint8_t changed = on ^ pumpsOn;
+    for (uint8_t i = 0; i < RECIPE_PUMPS; i++) {
+        if (changed & (1 << i)) pumpWrite(i, on & (1 << i) ? PUMP_SPEED_DEFAULT : 0);
+    }
+    pumpsOn = on;
+}
+
+void recipeOutputsOff() {
+    for (uint8_t i = 0; i < RECIPE_PUMPS; i++) {
+        if (pumpsOn & (1 << i)) pumpWrite(i, 0);
+    }
+    pumpsOn = 0;
+}
+
+uint16_t recipeDispensedMl(unsigned long elapsed) {
+    if (!active) return 0;
+    
+    float total = 0;
+    for (uint8_t i = 0; i < scheduleSteps; i++) {
+        const ScheduleStep &s = schedule[i];
+        unsigned long from = s.startMs + s.primeMs;
+        if (elapsed <= from) continue;
+        float ml = (elapsed - from) * s.rate / 1000;
+        total += ml < s.ml ? ml : s.ml;
+    }
+    return total + 0.5f;
+}
+
+void recipeEnd() {
+    recipeOutputsOff();
+    active = false;
+    scheduleSteps = 0;
+    scheduleMs = 0;
+}
+
+// ========================================
+// СТАТУС
+// ========================================
+
+void printRecipes(Print &out) {
+    out.println("Pumps:");
+    for (uint8_t i = 0; i < RECIPE_PUMPS; i++) {
+        out.printf("  %d %-11s %.2f ml/s%s\n", i + 1, book.pumps[i].ingredient, pumpRate(i + 1),
+                   book.pumps[i].rate > 0 ? "" : " (main pump rate)");
+    }
+    
+    out.println("Recipes:");
+    out.printf("%c 0 (single shot)\n", g_selectedRecipe == 0 ? '*' : ' ');
+    for (uint8_t i = 0; i < book.count; i++) {
+        char spec[RECIPE_STEPS_MAX * (RECIPE_NAME_LEN + 4)];
+        recipeFormat(book.recipes[i], spec, sizeof(spec));
+        
+        const char *missing = NULL;
+        bool available = recipeAvailable(book.recipes[i], &missing);
+        out.printf("%c %d %-11s %s", g_selectedRecipe == i + 1 ? '*' : ' ', i + 1, book.recipes[i].name, spec);
+        if (!available) out.printf("  (no %s)", missing);
+        out.println();
+    }
+}
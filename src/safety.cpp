@@ -0,0 +1,284 @@
+#include "safety.h"
+#include "control.h"
+#include "storage.h"
+#include "manifold.h"
+#include "recipes.h"
+#include "inputs.h"
+#include <esp_task_wdt.h>
+#include <esp_system.h>
+
+#if ENABLE_WIFI
+#include "network.h"
+#endif
+
+extern SystemState g_systemState;
+extern Statistics g_stats;
+
+#define SAFETY_RTC_MAGIC  0x53414654   // "SAFT"
+
+// Переживає програмне скидання і watchdog (не вимкнення живлення)
+struct RtcFault {
+    uint32_t magic;
+    SafetyFault fault;
+};
+static RTC_NOINIT_ATTR RtcFault rtcFault;
+
+static hw_timer_t *safetyTimer = NULL;
+static volatile bool pumpArmed = false;
+static volatile uint32_t pumpOnAt = 0;
+static volatile uint32_t missedTicks = 0;
+static volatile uint8_t tripReason = FAULT_NONE;
+static volatile uint32_t haltAt = 0;        // Швидкий стоп кнопкою, 0 - немає
+static bool loopWatched = false;
+
+// Копія з NVS для статусу
+static SafetyFault lastFault;
+static uint32_t faultCount = 0;
+
+// ========================================
+// ВІДСІЧКА
+// ========================================
+
+static void IRAM_ATTR safetyRecord(uint8_t reason) {
+    rtcFault.fault.reason = reason;
+    rtcFault.fault.state = g_systemState;
+    rtcFault.fault.pumping = pumpArmed;
+    rtcFault.fault.reserved = 0;
+    rtcFault.fault.uptime = millis();
+    rtcFault.fault.pumpMs = pumpArmed ? millis() - pumpOnAt : 0;
+    rtcFault.magic = SAFETY_RTC_MAGIC;
+}
+
+// Пін від'єднується від LEDC і тримається в нулі - без драйвера LEDC і м'ютексів
+static void IRAM_ATTR safetyOutputsOff() {
+    ledcDetachPin(PUMP_POWER);
+    digitalWrite(PUMP_POWER, LOW);
+#if MANIFOLD_CHANNELS
+    manifoldCutoffISR();
+#endif
+#if RECIPE_PUMPS > 1
+    recipeCutoffISR();
+#endif
+}
+
+static void safetyOutputsAttach() {
+    ledcAttachPin(PUMP_POWER, PUMP_CHANNEL);
+#if MANIFOLD_CHANNELS
+    manifoldReattach();
+#endif
+#if RECIPE_PUMPS > 1
+    recipeReattach();
+#endif
+}
+
+static void IRAM_ATTR safetyTimerISR() {
+    if (!pumpArmed || tripReason != FAULT_NONE) return;
+    
+    uint8_t reason = FAULT_NONE;
+    if (++missedTicks > SAFETY_MISSED_TICKS) {
+        reason = FAULT_CONTROL_STALL;
+    } else if (millis() - pumpOnAt > MAX_POUR_TIME + SAFETY_POUR_MARGIN) {
+        reason = FAULT_POUR_TIMEOUT;
+    }
+    if (reason == FAULT_NONE) return;
+    
+    safetyOutputsOff();
+    safetyRecord(reason);
+    pumpArmed = false;
+    tripReason = reason;
+}
+
+void safetyFeed() {
+    missedTicks = 0;
+    esp_task_wdt_reset();
+}
+
+void IRAM_ATTR safetyHaltISR() {
+    if (!pumpArmed || haltAt != 0) return;
+    
+    safetyOutputsOff();
+    uint32_t now = millis();
+    haltAt = now != 0 ? now : 1;
+}
+
+void safetyRelease() {
+    if (haltAt == 0) return;
+    
+    // Виходи вже в нулі (пауза) або розлив триває далі - LEDC знову веде пін
+    safetyOutputsAttach();
+    haltAt = 0;
+}
+
+unsigned long safetyHaltMs() {
+    return haltAt;
+}
+
+void safetyPumpOn() {
+    safetyPumpOn(millis());
+}
+
+void safetyPumpOn(unsigned long since) {
+    missedTicks = 0;
+    pumpOnAt = since;
+    pumpArmed = true;
+}
+
+void safetyPumpOff() {
+    pumpArmed = false;
+}
+
+// ========================================
+// ЗАПИС ПРО ЗБІЙ
+// ========================================
+
+static uint8_t resetFaultReason(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_TASK_WDT: return FAULT_TASK_WDT;
+        case ESP_RST_INT_WDT: return FAULT_INT_WDT;
+        case ESP_RST_PANIC: return FAULT_PANIC;
+        case ESP_RST_BROWNOUT: return FAULT_BROWNOUT;
+        default: return FAULT_NONE;
+    }
+}
+
+static void safetySaveFault(const SafetyFault &fault) {
+    saveFaultRecord(fault);
+    lastFault = fault;
+    faultCount++;
+}
+
+void safetyBootCheck() {
+    esp_reset_reason_t reset = esp_reset_reason();
+    uint8_t reason = resetFaultReason(reset);
+    bool recorded = rtcFault.magic == SAFETY_RTC_MAGIC;
+    
+    loadFaultRecord(lastFault, faultCount);
+    
+    if (reason != FAULT_NONE || recorded) {
+        SafetyFault fault;
+        if (recorded) {
+            // Відсічка або обробник watchdog встигли записати стан
+            fault = rtcFault.fault;
+            if (reason != FAULT_NONE) fault.reason = reason;
+        } else {
+            memset(&fault, 0, sizeof(fault));
+            fault.reason = reason;
+        }
+        
+        safetySaveFault(fault);
+        LOG_E("Previous run ended with fault: %s (uptime %lu ms, pump %lu ms)",
+              safetyFaultName(fault.reason), (unsigned long)fault.uptime, (unsigned long)fault.pumpMs);
+    }
+    
+    // Після вимкнення живлення RTC містить сміття
+    rtcFault.magic = 0;
+}
+
+// ========================================
+// WATCHDOG І ТАЙМЕР
+// ========================================
+
+void setupSafety(TaskHandle_t uiTask, TaskHandle_t controlTask) {
+    // Паніка -> перезавантаження з ESP_RST_TASK_WDT, запис підхопить safetyBootCheck()
+    esp_task_wdt_init(WATCHDOG_TIMEOUT / 1000, true);
+    if (controlTask != NULL) esp_task_wdt_add(controlTask);
+    if (uiTask != NULL) esp_task_wdt_add(uiTask);
+    
+    // setup() і loop() - одна задача: мережа, OTA, команди
+    loopWatched = esp_task_wdt_add(NULL) == ESP_OK;
+    
+    // 1 МГц: 80 МГц APB / 80
+    safetyTimer = timerBegin(SAFETY_TIMER_NUM, 80, true);
+    timerAttachInterrupt(safetyTimer, &safetyTimerISR, true);
+    timerAlarmWrite(safetyTimer, SAFETY_TICK_US, true);
+    timerAlarmEnable(safetyTimer);
+    
+    LOG_I("Safety: watchdog %d s, pump cutoff after %d missed ticks",
+          WATCHDOG_TIMEOUT / 1000, SAFETY_MISSED_TICKS);
+}
+
+void updateSafety() {
+    if (loopWatched) esp_task_wdt_reset();
+    
+    uint8_t reason = tripReason;
+    if (reason == FAULT_NONE) return;
+    
+    SafetyFault fault = rtcFault.fault;
+    LOG_E("Pump cut off: %s after %lu ms", safetyFaultName(reason), (unsigned long)fault.pumpMs);
+    
+    // Помпа вже знеструмлена: закрити розлив і повернути пін у LEDC з нульовим duty
+    stopPour();
+    safetyOutputsAttach();
+    haltAt = 0;
+    
+    g_systemState = STATE_ERROR;
+    portENTER_CRITICAL(&controlMux);
+    g_stats.errors++;
+    portEXIT_CRITICAL(&controlMux);
+    markStatisticsDirty();
+    
+    safetySaveFault(fault);
+    rtcFault.magic = 0;
+    tripReason = FAULT_NONE;
+
+#if ENABLE_WIFI
+    broadcastState();
+#endif
+}
+
+// ========================================
+// СТАТУС
+// ========================================
+
+bool safetyLastFault(SafetyFault &out) {
+    out = lastFault;
+    return faultCount > 0;
+}
+
+uint32_t safetyFaultCount() {
+    return faultCount;
+}
+
+void safetyClearFaults() {
+    clearFaultRecords();
+    memset(&lastFault, 0, sizeof(lastFault));
+    faultCount = 0;
+}
+
+const char* safetyFaultName(uint8_t reason) {
+    switch (reason) {
+        case FAULT_NONE: return "none";
+        case FAULT_CONTROL_STALL: return "control stall";
+        case FAULT_POUR_TIMEOUT: return "pour timeout";
+        case FAULT_TASK_WDT: return "task watchdog";
+        case FAULT_INT_WDT: return "interrupt watchdog";
+        case FAULT_PANIC: return "panic";
+        case FAULT_BROWNOUT: return "brownout";
+        default: return "unknown";
+    }
+}
+
+void printSafetyStatus(Print &out) {
+    out.printf("Watchdog: %d s, cutoff after %d ms stall or %d ms pour\n",
+               WATCHDOG_TIMEOUT / 1000, SAFETY_MISSED_TICKS * SAFETY_TICK_US / 1000,
+               MAX_POUR_TIME + SAFETY_POUR_MARGIN);
+    if (pumpArmed) {
+        out.printf("Pump armed: yes, on for %lu ms\n", (unsigned long)(millis() - pumpOnAt));
+    } else {
+        out.printf("Pump armed: no\n");
+    }
+    out.printf("Input edges dropped: %lu\n", (unsigned long)inputsDropped());
+    out.printf("Faults: %lu\n", (unsigned long)faultCount);
+    if (faultCount > 0) {
+        out.printf("Last: %s, state %d, uptime %lu ms, pump %s %lu ms\n",
+                   safetyFaultName(lastFault.reason), lastFault.state, (unsigned long)lastFault.uptime,
+                   lastFault.pumping ? "on" : "off", (unsigned long)lastFault.pumpMs);
+    }
+}
+
+#ifndef SIMULATOR
+// IDF викликає з ISR task watchdog перед панікою: зберегти стан для наступного запуску
+extern "C" void IRAM_ATTR esp_task_wdt_isr_user_handler(void) {
+    safetyRecord(FAULT_TASK_WDT);
+}
+#endif
@@ -1,15 +1,109 @@
 #include "storage.h"
+#include "control.h"
+#include <atomic>
 
 Preferences prefs;
 
 extern Statistics g_stats;
+extern float g_pumpRate;
+extern float g_primeVolume;
+extern bool g_fleetEnabled;
 extern PourMode g_pourMode;
 extern uint16_t g_targetVolume;
 extern uint8_t g_selectedShot;
+extern uint8_t g_selectedRecipe;
+
+// Знімок статистики - один блоб з CRC, два слоти (A/B)
+struct StatsSnapshot {
+    uint16_t magic;
+    uint16_t version;
+    uint32_t sequence;          // Номер запису (новіший = більший)
+    Statistics stats;
+    uint32_t crc;               // CRC32 всіх попередніх полів
+};
+
+static const char* STATS_SLOT_KEYS[2] = {"statsA", "statsB"};
+
+static uint32_t statsSequence = 0;   // Номер останнього валідного запису
+static uint8_t statsNextSlot = 0;    // Слот для наступного запису
+static volatile bool statsDirty = false;
+
+// Облік часу роботи
+static unsigned long uptimeLastMs = 0;
+static unsigned long uptimeRemainderMs = 0;
+static uint32_t uptimeUnsavedSec = 0;       // Додано до totalTime після останнього запису
+
+// Записи ключів у NVS з моменту старту (знос flash видно в метриках)
+static std::atomic<uint32_t> nvsWrites(0);
+
+static uint32_t crc32(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t snapshotCrc(const StatsSnapshot& snap) {
+    return crc32((const uint8_t*)&snap, offsetof(StatsSnapshot, crc));
+}
+
+// Прочитати слот; false якщо порожній або пошкоджений
+static bool readStatsSlot(uint8_t slot, StatsSnapshot& snap) {
+    if (prefs.getBytesLength(STATS_SLOT_KEYS[slot]) != sizeof(StatsSnapshot)) {
+        return false;
+    }
+    prefs.getBytes(STATS_SLOT_KEYS[slot], &snap, sizeof(StatsSnapshot));
+    
+    return snap.magic == STATS_MAGIC &&
+           snap.version == STATS_VERSION &&
+           snap.crc == snapshotCrc(snap);
+}
+
+// Prefs вже відкриті
+static void loadStatistics() {
+    StatsSnapshot slots[2];
+    bool valid[2];
+    
+    for (uint8_t i = 0; i < 2; i++) {
+        valid[i] = readStatsSlot(i, slots[i]);
+    }
+    
+    int newest = -1;
+    if (valid[0] && valid[1]) {
+        // Порівняння з урахуванням переповнення лічильника
+        newest = (int32_t)(slots[1].sequence - slots[0].sequence) > 0 ? 1 : 0;
+    } else if (valid[0]) {
+        newest = 0;
+    } else if (valid[1]) {
+        newest = 1;
+    }
+    
+    if (newest >= 0) {
+        g_stats = slots[newest].stats;
+        statsSequence = slots[newest].sequence;
+        statsNextSlot = newest ^ 1;
+        statsDirty = false;
+        return;
+    }
+    
+    // Міграція зі старого формату (окремі ключі)
+    if (prefs.isKey("totalPours")) {
+        g_stats.totalPours = prefs.getUInt("totalPours", 0);
+        g_stats.totalVolume = prefs.getUInt("totalVolume", 0);
+        g_stats.totalTime = prefs.getUInt("totalTime", 0);
+        g_stats.errors = prefs.getUInt("errors", 0);
+        statsDirty = true;
+        LOG_I("Statistics migrated from legacy keys");
+    }
+}
 
 void loadSettings() {
     if (!prefs.begin(PREFS_NAMESPACE, false)) {
-        Serial.println("ERROR: Failed to init preferences!");
+        LOG_E("Failed to init preferences!");
         // Не критична помилка - продовжити з дефолтними значеннями
         return;
     }
@@ -18,79 +112,304 @@ void loadSettings() {
     g_pourMode = (PourMode)prefs.getUChar("pourMode", MODE_MANUAL);
     g_targetVolume = prefs.getUShort("volume", VOLUME_DEFAULT);
     g_selectedShot = prefs.getUChar("shot", 1);
+    // Збережено прошивкою з іншим профілем (GLASS_COUNT)
+    if (g_selectedShot < 1 || g_selectedShot > GLASS_COUNT) g_selectedShot = 1;
+    g_selectedRecipe = prefs.getUChar("recipe", 0);
+    g_pumpRate = prefs.getFloat("pumpRate", PUMP_ML_PER_SEC);
+    if (g_pumpRate < PUMP_RATE_MIN || g_pumpRate > PUMP_RATE_MAX) g_pumpRate = PUMP_ML_PER_SEC;
+    g_primeVolume = prefs.getFloat("primeMl", PRIME_ML_DEFAULT);
+    if (g_primeVolume < 0 || g_primeVolume > PRIME_ML_MAX) g_primeVolume = PRIME_ML_DEFAULT;
+    g_fleetEnabled = prefs.getBool("fleet", false);
     
     // Завантажити статистику
-    g_stats.totalPours = prefs.getUInt("totalPours", 0);
-    g_stats.totalVolume = prefs.getUInt("totalVolume", 0);
-    g_stats.totalTime = prefs.getUInt("totalTime", 0);
-    g_stats.errors = prefs.getUInt("errors", 0);
+    loadStatistics();
     
-    Serial.println("Settings loaded:");
-    Serial.printf("  Mode: %s\n", g_pourMode == MODE_MANUAL ? "Manual" : "Auto");
-    Serial.printf("  Volume: %d ml\n", g_targetVolume);
-    Serial.printf("  Shot: %d\n", g_selectedShot);
-    Serial.printf("  Total pours: %d\n", g_stats.totalPours);
+    LOG_I("Settings loaded: mode %s, volume %d ml, shot %d, total pours %u",
+        g_pourMode == MODE_MANUAL ? "Manual" : "Auto",
+        g_targetVolume, g_selectedShot, g_stats.totalPours);
     
     prefs.end();
 }
 
 void saveSettings() {
+    TRACE_SCOPE(TRACE_SAVE_SETTINGS);
+    
     if (!prefs.begin(PREFS_NAMESPACE, false)) {
-        Serial.println("ERROR: Failed to save settings!");
+        LOG_E("Failed to save settings!");
         return;
     }
     
     prefs.putUChar("pourMode", g_pourMode);
     prefs.putUShort("volume", g_targetVolume);
     prefs.putUChar("shot", g_selectedShot);
+    prefs.putUChar("recipe", g_selectedRecipe);
+    prefs.putFloat("pumpRate", g_pumpRate);
+    prefs.putFloat("primeMl", g_primeVolume);
+    prefs.putBool("fleet", g_fleetEnabled);
     
     prefs.end();
+    nvsWrites += 7;
     
     DEBUG_PRINTLN("Settings saved");
 }
 
+void markStatisticsDirty() {
+    statsDirty = true;
+}
+
+void updateUptime() {
+    unsigned long now = millis();
+    uptimeRemainderMs += now - uptimeLastMs;
+    uptimeLastMs = now;
+    
+    if (uptimeRemainderMs >= 1000) {
+        uint32_t sec = uptimeRemainderMs / 1000;
+        portENTER_CRITICAL(&controlMux);
+        g_stats.totalTime += sec;
+        portEXIT_CRITICAL(&controlMux);
+        uptimeRemainderMs %= 1000;
+        
+        // Сам час роботи - не привід писати flash щохвилини: він іде разом із
+        // наступним записом статистики, а без інших змін - раз на STATS_UPTIME_SAVE_INTERVAL
+        uptimeUnsavedSec += sec;
+        if (uptimeUnsavedSec >= STATS_UPTIME_SAVE_INTERVAL / 1000) statsDirty = true;
+    }
+}
+
 void saveStatistics() {
+    if (!statsDirty) return;
+    
+    TRACE_SCOPE(TRACE_SAVE_STATS);
+    
     if (!prefs.begin(PREFS_NAMESPACE, false)) {
-        Serial.println("ERROR: Failed to save statistics!");
+        LOG_E("Failed to save statistics!");
         return;
     }
     
-    prefs.putUInt("totalPours", g_stats.totalPours);
-    prefs.putUInt("totalVolume", g_stats.totalVolume);
-    prefs.putUInt("totalTime", g_stats.totalTime);
-    prefs.putUInt("errors", g_stats.errors);
+    // Знімок формується до запису; лічильники змінюються лише під controlMux
+    // (controlTask, відсічка, скидання) - копія не ловить їх напівоновленими
+    statsDirty = false;
+    uptimeUnsavedSec = 0;
     
-    prefs.end();
+    StatsSnapshot snap;
+    memset(&snap, 0, sizeof(snap));
+    snap.magic = STATS_MAGIC;
+    snap.version = STATS_VERSION;
+    snap.sequence = statsSequence + 1;
+    portENTER_CRITICAL(&controlMux);
+    snap.stats = g_stats;
+    portEXIT_CRITICAL(&controlMux);
+    snap.crc = snapshotCrc(snap);
+    
+    // Один запис у старіший слот - попередній знімок лишається цілим
+    if (prefs.putBytes(STATS_SLOT_KEYS[statsNextSlot], &snap, sizeof(snap)) == sizeof(snap)) {
+        statsSequence = snap.sequence;
+        statsNextSlot ^= 1;
+        nvsWrites++;
+        
+        // Прибрати старі ключі після першого успішного запису
+        if (prefs.isKey("totalPours")) {
+            prefs.remove("totalPours");
+            prefs.remove("totalVolume");
+            prefs.remove("totalTime");
+            prefs.remove("errors");
+        }
+        
+        DEBUG_PRINTLN("Statistics saved");
+    } else {
+        statsDirty = true;
+        LOG_E("Statistics write failed!");
+    }
     
-    DEBUG_PRINTLN("Statistics saved");
+    prefs.end();
 }
 
 void resetSettings() {
     if (!prefs.begin(PREFS_NAMESPACE, false)) {
-        Serial.println("ERROR: Failed to reset settings!");
+        LOG_E("Failed to reset settings!");
         return;
     }
     
     prefs.clear();
     prefs.end();
+    nvsWrites++;
     
     // Встановити дефолтні значення
     g_pourMode = MODE_MANUAL;
     g_targetVolume = VOLUME_DEFAULT;
     g_selectedShot = 1;
+    g_selectedRecipe = 0;
+    g_pumpRate = PUMP_ML_PER_SEC;
+    g_primeVolume = PRIME_ML_DEFAULT;
+    g_fleetEnabled = false;
+    
+    // Слоти статистики теж стерті
+    statsSequence = 0;
+    statsNextSlot = 0;
+    statsDirty = true;
     
-    Serial.println("Settings reset to defaults");
+    LOG_I("Settings reset to defaults");
 }
 
 void resetStatistics() {
+    portENTER_CRITICAL(&controlMux);
     g_stats.totalPours = 0;
     g_stats.totalVolume = 0;
     g_stats.totalTime = 0;
     g_stats.errors = 0;
     g_stats.lastPourVolume = 0;
     g_stats.lastPourTime = 0;
+    portEXIT_CRITICAL(&controlMux);
     
+    statsDirty = true;
     saveStatistics();
     
-    Serial.println("Statistics reset");
-}
\ No newline at end of file
+    LOG_I("Statistics reset");
+}
+
+bool loadWifiCredentials(char *ssid, size_t ssidLen, char *pass, size_t passLen) {
+    Preferences wifiPrefs;
+    ssid[0] = '\0';
+    pass[0] = '\0';
+    
+    if (wifiPrefs.begin(WIFI_PREFS_NAMESPACE, true)) {
+        wifiPrefs.getString("ssid", ssid, ssidLen);
+        wifiPrefs.getString("pass", pass, passLen);
+        wifiPrefs.end();
+    }
+    
+    // Нічого не збережено - дані з config.h
+    if (ssid[0] == '\0') {
+        strlcpy(ssid, WIFI_SSID, ssidLen);
+        strlcpy(pass, WIFI_PASS, passLen);
+    }
+    
+    return ssid[0] != '\0';
+}
+
+bool saveWifiCredentials(const char* ssid, const char* pass) {
+    Preferences wifiPrefs;
+    if (!wifiPrefs.begin(WIFI_PREFS_NAMESPACE, false)) {
+        LOG_E("Failed to open WiFi preferences!");
+        return false;
+    }
+    
+    bool ok = wifiPrefs.putString("ssid", ssid) > 0;
+    wifiPrefs.putString("pass", pass ? pass : "");
+    wifiPrefs.end();
+    nvsWrites += 2;
+    
+    if (ok) LOG_I("WiFi credentials saved: %s", ssid);
+    return ok;
+}
+
+bool loadOtaPassword(char *pass, size_t passLen) {
+    Preferences authPrefs;
+    pass[0] = '\0';
+    
+    if (authPrefs.begin(OTA_AUTH_NAMESPACE, true)) {
+        authPrefs.getString("pass", pass, passLen);
+        authPrefs.end();
+    }
+    
+    if (pass[0] == '\0') strlcpy(pass, OTA_PASSWORD, passLen);
+    return pass[0] != '\0';
+}
+
+bool saveOtaPassword(const char* pass) {
+    Preferences authPrefs;
+    if (!authPrefs.begin(OTA_AUTH_NAMESPACE, false)) {
+        LOG_E("Failed to open OTA preferences!");
+        return false;
+    }
+    
+    bool ok = authPrefs.putString("pass", pass) > 0;
+    authPrefs.end();
+    nvsWrites++;
+    
+    if (ok) LOG_I("OTA password saved");
+    return ok;
+}
+
+void clearWifiCredentials() {
+    Preferences wifiPrefs;
+    if (!wifiPrefs.begin(WIFI_PREFS_NAMESPACE, false)) {
+        LOG_E("Failed to open WiFi preferences!");
+        return;
+    }
+    
+    wifiPrefs.clear();
+    wifiPrefs.end();
+    nvsWrites++;
+    
+    LOG_I("WiFi credentials cleared");
+}
+
+bool loadFaultRecord(SafetyFault &fault, uint32_t &count) {
+    Preferences faultPrefs;
+    memset(&fault, 0, sizeof(fault));
+    count = 0;
+    
+    if (!faultPrefs.begin(SAFETY_PREFS_NAMESPACE, true)) return false;
+    
+    count = faultPrefs.getUInt("count", 0);
+    bool ok = faultPrefs.getBytes("last", &fault, sizeof(fault)) == sizeof(fault);
+    faultPrefs.end();
+    
+    return ok && count > 0;
+}
+
+void saveFaultRecord(const SafetyFault &fault) {
+    Preferences faultPrefs;
+    if (!faultPrefs.begin(SAFETY_PREFS_NAMESPACE, false)) {
+        LOG_E("Failed to open fault preferences!");
+        return;
+    }
+    
+    faultPrefs.putBytes("last", &fault, sizeof(fault));
+    faultPrefs.putUInt("count", faultPrefs.getUInt("count", 0) + 1);
+    faultPrefs.end();
+    nvsWrites += 2;
+}
+
+void clearFaultRecords() {
+    Preferences faultPrefs;
+    if (!faultPrefs.begin(SAFETY_PREFS_NAMESPACE, false)) {
+        LOG_E("Failed to open fault preferences!");
+        return;
+    }
+    
+    faultPrefs.clear();
+    faultPrefs.end();
+    nvsWrites++;
+    
+    LOG_I("Fault records cleared");
+}
+
+bool loadRecipeBook(RecipeBook &book) {
+    Preferences recipePrefs;
+    if (!recipePrefs.begin(RECIPE_PREFS_NAMESPACE, true)) return false;
+    
+    // Інша кількість помп або версія - розмір не збігається
+    bool ok = recipePrefs.getBytesLength("book") == sizeof(book) &&
+              recipePrefs.getBytes("book", &book, sizeof(book)) == sizeof(book);
+    recipePrefs.end();
+    
+    return ok && book.magic == RECIPE_MAGIC && book.version == RECIPE_VERSION;
+}
+
+void saveRecipeBook(const RecipeBook &book) {
+    Preferences recipePrefs;
+    if (!recipePrefs.begin(RECIPE_PREFS_NAMESPACE, false)) {
+        LOG_E("Failed to open recipe preferences!");
+        return;
+    }
+    
+    recipePrefs.putBytes("book", &book, sizeof(book));
+    recipePrefs.end();
+    nvsWrites++;
+}
+
+uint32_t storageWriteCount() {
+    return nvsWrites;
+}
@@ -0,0 +1,300 @@
+#include "config.h"
+
+#if ENABLE_TRACE
+
+#include <atomic>
+#include <new>
+#include <esp_task_wdt.h>
+
+// Слот кільця. seq == номер запису + 1 коли запис завершено, 0 - під час запису
+struct TraceSlot {
+    std::atomic<uint32_t> seq;
+    TraceEvent event;
+};
+
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of two");
+
+static TraceSlot traceRing[TRACE_RING_SIZE];
+static std::atomic<uint32_t> traceNext(0);
+static std::atomic<uint32_t> traceClearedAt(0);
+
+static std::atomic<uint32_t> traceLoopCount[TRACE_LOOP_COUNT];
+static std::atomic<uint32_t> traceMissCount[TRACE_LOOP_COUNT];
+static std::atomic<uint32_t> traceMaxNs[TRACE_POINT_COUNT];
+
+extern TaskHandle_t uiTaskHandle;
+extern TaskHandle_t controlTaskHandle;
+
+static const char* const tracePointNames[TRACE_POINT_COUNT] = {
+    "control_loop", "controls", "pour_state", "led", "led_show",
+    "ui_loop", "display",
+    "save_settings", "save_stats", "broadcast",
+    "deadline_miss", "deadline_miss",
+};
+
+static const char* const tracePointCats[TRACE_POINT_COUNT] = {
+    "control", "control", "control", "control", "control",
+    "ui", "ui",
+    "storage", "storage", "network",
+    "deadline", "deadline",
+};
+
+const char* tracePointName(uint8_t point) {
+    return point < TRACE_POINT_COUNT ? tracePointNames[point] : "?";
+}
+
+static uint8_t traceTaskId() {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    if (task != NULL && task == controlTaskHandle) return 1;
+    if (task != NULL && task == uiTaskHandle) return 2;
+    return 0;
+}
+
+// Такти -> нс за частотою, з якою їх рахували
+static uint32_t traceCyclesToNs(uint32_t cycles, uint8_t mhz) {
+    uint64_t ns = (uint64_t)cycles * 1000 / (mhz ? mhz : 240);
+    return ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+}
+
+void traceRecord(uint8_t point, uint32_t startUs, uint32_t cycles, uint16_t arg) {
+    if (point >= TRACE_POINT_COUNT) return;
+    
+    uint8_t mhz = ESP.getCpuFreqMHz();
+    
+    // Резервування слоту - як у кільці логів
+    uint32_t idx = traceNext.fetch_add(1, std::memory_order_relaxed);
+    TraceSlot &slot = traceRing[idx & (TRACE_RING_SIZE - 1)];
+    
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    slot.event.startUs = startUs;
+    slot.event.cycles = cycles;
+    slot.event.point = point;
+    slot.event.core = xPortGetCoreID();
+    slot.event.task = traceTaskId();
+    slot.event.mhz = mhz;
+    slot.event.arg = arg;
+    
+    slot.seq.store(idx + 1, std::memory_order_release);
+    
+    uint32_t ns = traceCyclesToNs(cycles, mhz);
+    uint32_t prev = traceMaxNs[point].load(std::memory_order_relaxed);
+    while (ns > prev &&
+           !traceMaxNs[point].compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void traceDeadline(uint8_t loop, TickType_t lastWakeTime, TickType_t period) {
+    if (loop >= TRACE_LOOP_COUNT) return;
+    traceLoopCount[loop].fetch_add(1, std::memory_order_relaxed);
+    
+    // lastWakeTime - запланований час поточної ітерації
+    TickType_t elapsed = xTaskGetTickCount() - lastWakeTime;
+    if (elapsed < period) return;
+    
+    traceMissCount[loop].fetch_add(1, std::memory_order_relaxed);
+    
+    uint32_t lateMs = (elapsed - period) * portTICK_PERIOD_MS;
+    if (lateMs > 0xFFFF) lateMs = 0xFFFF;
+    traceRecord(loop == TRACE_LOOP_CONTROL ? TRACE_MISS_CONTROL : TRACE_MISS_UI,
+                micros(), 0, lateMs);
+}
+
+uint32_t traceLoops(uint8_t loop) {
+    return loop < TRACE_LOOP_COUNT ? traceLoopCount[loop].load(std::memory_order_relaxed) : 0;
+}
+
+uint32_t traceMisses(uint8_t loop) {
+    return loop < TRACE_LOOP_COUNT ? traceMissCount[loop].load(std::memory_order_relaxed) : 0;
+}
+
+uint32_t traceMaxUs(uint8_t point) {
+    return point < TRACE_POINT_COUNT ? traceMaxNs[point].load(std::memory_order_relaxed) / 1000 : 0;
+}
+
+void traceClear() {
+    traceClearedAt.store(traceNext.load(std::memory_order_acquire), std::memory_order_release);
+    
+    for (int i = 0; i < TRACE_LOOP_COUNT; i++) {
+        traceLoopCount[i].store(0, std::memory_order_relaxed);
+        traceMissCount[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < TRACE_POINT_COUNT; i++) {
+        traceMaxNs[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t traceSnapshot(TraceEvent *out, size_t maxEvents) {
+    uint32_t head = traceNext.load(std::memory_order_acquire);
+    uint32_t start = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+    uint32_t cleared = traceClearedAt.load(std::memory_order_acquire);
+    
+    if ((int32_t)(cleared - start) > 0) start = cleared;
+    if (head - start > maxEvents) start = head - maxEvents;
+    
+    size_t count = 0;
+    for (uint32_t i = start; i != head; i++) {
+        const TraceSlot &slot = traceRing[i & (TRACE_RING_SIZE - 1)];
+        
+        // Запис ще йде або слот уже перезаписаний
+        uint32_t before = slot.seq.load(std::memory_order_acquire);
+        if (before != i + 1) continue;
+        
+        TraceEvent event = slot.event;
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != before) continue;
+        
+        out[count++] = event;
+    }
+    
+    return count;
+}
+
+// ========================================
+// ЕКСПОРТ (Chrome trace-event JSON)
+// ========================================
+
+// Етапи генерації
+#define TRACE_STAGE_HEADER  0
+#define TRACE_STAGE_META    1
+#define TRACE_STAGE_EVENTS  2
+#define TRACE_STAGE_FOOTER  3
+#define TRACE_STAGE_DONE    4
+
+// Імена потоків у метаданих: tid = TraceEvent::task
+static const char* const traceTaskNames[3] = {"Other", "Control_Task", "UI_Task"};
+
+TraceExporter::TraceExporter()
+    : _events(new (std::nothrow) TraceEvent[TRACE_RING_SIZE]), _count(0), _next(0),
+      _stage(TRACE_STAGE_HEADER), _baseUs(0), _cpuMhz(ESP.getCpuFreqMHz()),
+      _lineLen(0), _linePos(0) {
+    // Без пам'яті під знімок - віддаємо порожній список подій
+    if (_events != NULL) _count = traceSnapshot(_events, TRACE_RING_SIZE);
+    if (_cpuMhz == 0) _cpuMhz = 240;
+    
+    // Події лежать у порядку завершення - шукаємо найраніший початок
+    if (_count > 0) {
+        _baseUs = _events[0].startUs;
+        for (size_t i = 1; i < _count; i++) {
+            if ((int32_t)(_events[i].startUs - _baseUs) < 0) _baseUs = _events[i].startUs;
+        }
+    }
+}
+
+TraceExporter::~TraceExporter() {
+    delete[] _events;
+}
+
+size_t TraceExporter::fill() {
+    int len = 0;
+    
+    switch (_stage) {
+        case TRACE_STAGE_HEADER:
+            len = snprintf(_line, sizeof(_line),
+                "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"firmware\":\"%s\",\"cpu_mhz\":%lu,"
+                "\"control_loops\":%lu,\"control_misses\":%lu,\"ui_loops\":%lu,\"ui_misses\":%lu},"
+                "\"traceEvents\":[\n",
+                FIRMWARE_VERSION, (unsigned long)_cpuMhz,
+                (unsigned long)traceLoops(TRACE_LOOP_CONTROL), (unsigned long)traceMisses(TRACE_LOOP_CONTROL),
+                (unsigned long)traceLoops(TRACE_LOOP_UI), (unsigned long)traceMisses(TRACE_LOOP_UI));
+            _stage = TRACE_STAGE_META;
+            _next = 0;
+            break;
+        
+        case TRACE_STAGE_META: {
+            // pid = ядро, tid = задача. 2 імені процесів + 2x3 імені потоків
+            size_t i = _next++;
+            if (i < 2) {
+                len = snprintf(_line, sizeof(_line),
+                    "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"Core %u\"}}\n",
+                    i == 0 ? "" : ",", (unsigned)i, (unsigned)i);
+            } else {
+                unsigned pid = (i - 2) / 3;
+                unsigned tid = (i - 2) % 3;
+                len = snprintf(_line, sizeof(_line),
+                    ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}\n",
+                    pid, tid, traceTaskNames[tid]);
+            }
+            if (_next >= 8) {
+                _stage = TRACE_STAGE_EVENTS;
+                _next = 0;
+            }
+            break;
+        }
+        
+        case TRACE_STAGE_EVENTS: {
+            if (_next >= _count) {
+                _stage = TRACE_STAGE_FOOTER;
+                return fill();
+            }
+            
+            const TraceEvent &e = _events[_next++];
+            unsigned long ts = e.startUs - _baseUs;
+            const char* name = tracePointNames[e.point];
+            const char* cat = tracePointCats[e.point];
+            
+            if (e.point == TRACE_MISS_CONTROL || e.point == TRACE_MISS_UI) {
+                len = snprintf(_line, sizeof(_line),
+                    ",{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"p\",\"pid\":%u,\"tid\":%u,"
+                    "\"ts\":%lu,\"args\":{\"loop\":\"%s\",\"late_ms\":%u}}\n",
+                    name, cat, e.core, e.task, ts,
+                    e.point == TRACE_MISS_CONTROL ? "control" : "ui", e.arg);
+            } else {
+                // Такти -> мкс з трьома знаками без float, за частотою на момент запису
+                uint32_t ns = traceCyclesToNs(e.cycles, e.mhz);
+                len = snprintf(_line, sizeof(_line),
+                    ",{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,"
+                    "\"ts\":%lu,\"dur\":%lu.%03lu}\n",
+                    name, cat, e.core, e.task, ts,
+                    (unsigned long)(ns / 1000), (unsigned long)(ns % 1000));
+            }
+            break;
+        }
+        
+        case TRACE_STAGE_FOOTER:
+            len = snprintf(_line, sizeof(_line), "]}\n");
+            _stage = TRACE_STAGE_DONE;
+            break;
+        
+        default:
+            return 0;
+    }
+    
+    if (len < 0) len = 0;
+    if (len > (int)sizeof(_line) - 1) len = sizeof(_line) - 1;
+    _lineLen = len;
+    _linePos = 0;
+    return _lineLen;
+}
+
+size_t TraceExporter::read(uint8_t *buf, size_t maxLen) {
+    size_t written = 0;
+    
+    while (written < maxLen) {
+        if (_linePos >= _lineLen && fill() == 0) break;
+        
+        size_t chunk = _lineLen - _linePos;
+        if (chunk > maxLen - written) chunk = maxLen - written;
+        memcpy(buf + written, _line + _linePos, chunk);
+        _linePos += chunk;
+        written += chunk;
+    }
+    
+    return written;
+}
+
+void traceDump(Print &out) {
+    TraceExporter exporter;
+    uint8_t buf[256];
+    size_t len;
+    
+    while ((len = exporter.read(buf, sizeof(buf))) > 0) {
+        out.write(buf, len);
+        // Дамп у Serial триває секунди - не дати watchdog скинути loop()
+        esp_task_wdt_reset();
+    }
+}
+
+#endif // ENABLE_TRACE
@@ -0,0 +1,64 @@
+// Поля форми REST API (curl -d volume=30) -> JSON: ті самі читачі, що й для тіла JSON
+// (obj["value"] | -1), мають бачити ціле цілим, дробове - числом, решту - рядком.
+//   pio test -e native-test -f test_api_form
+
+#include <unity.h>
+#include "config.h"
+#include "network.h"
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void test_integer() {
+    DynamicJsonDocument doc(256);
+    JsonObject obj = doc.to<JsonObject>();
+    apiFormField(obj, "volume", "30");
+    apiFormField(obj, "mode", "0");
+    apiFormField(obj, "delta", "-5");
+
+    TEST_ASSERT_TRUE(obj["volume"].is<int>());
+    TEST_ASSERT_EQUAL(30, obj["volume"] | -1);
+    TEST_ASSERT_EQUAL(0, obj["mode"] | -1);
+    TEST_ASSERT_EQUAL(-5, obj["delta"] | 0);
+    // Як у /api/fleet/order: поточний об'єм - лише якщо поля немає
+    TEST_ASSERT_EQUAL(30, obj["volume"] | (int)VOLUME_DEFAULT);
+}
+
+static void test_fraction() {
+    DynamicJsonDocument doc(256);
+    JsonObject obj = doc.to<JsonObject>();
+    apiFormField(obj, "mlPerSec", "9.5");
+    apiFormField(obj, "target", "1e2");
+    apiFormField(obj, "huge", "99999999999999999999");
+
+    TEST_ASSERT_FALSE(obj["mlPerSec"].is<int>());
+    TEST_ASSERT_EQUAL_FLOAT(9.5f, obj["mlPerSec"] | 0.0f);
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, obj["target"] | 0.0f);
+    // Не влазить у long - лишається числом, а не обрізаним цілим
+    TEST_ASSERT_FALSE(obj["huge"].is<int>());
+    TEST_ASSERT_TRUE(obj["huge"].is<float>());
+}
+
+static void test_text() {
+    DynamicJsonDocument doc(256);
+    JsonObject obj = doc.to<JsonObject>();
+    apiFormField(obj, "recipe", "gt");
+    apiFormField(obj, "shot", "12abc");
+    apiFormField(obj, "empty", "");
+
+    TEST_ASSERT_EQUAL_STRING("gt", obj["recipe"] | "");
+    TEST_ASSERT_EQUAL_STRING("12abc", obj["shot"] | "");
+    TEST_ASSERT_EQUAL(-1, obj["shot"] | -1);
+    TEST_ASSERT_TRUE(obj["empty"].is<const char*>());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_integer);
+    RUN_TEST(test_fraction);
+    RUN_TEST(test_text);
+    return UNITY_END();
+}
@@ -0,0 +1,306 @@
+// Фазинг текстових команд на хості: токенізатор і диспетчер на випадкових, задовгих
+// і зібраних зі словника команд рядках. Задачі FreeRTOS не стартують - обробники
+// працюють з тим самим станом, що й з Serial, годинник ручний.
+//   pio test -e native-test -f test_commands
+
+#include <unity.h>
+#include "Arduino.h"
+#include "sim_hal.h"
+#include "config.h"
+#include "commands.h"
+#include "control.h"
+#include "display.h"
+#include "storage.h"
+#include "hardware.h"
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+extern SystemState g_systemState;
+extern PourMode g_pourMode;
+extern uint16_t g_targetVolume;
+extern uint8_t g_selectedShot;
+extern bool g_glassPresent[GLASS_COUNT];
+
+#define FUZZ_LINES      20000
+#define CANARY          0xA5
+#define CANARY_BYTES    16
+
+static std::mt19937 rng(20240601);
+
+static uint32_t randomBelow(uint32_t n) {
+    return std::uniform_int_distribution<uint32_t>(0, n - 1)(rng);
+}
+
+// Рядок у буфері CMD_LINE_MAX з канарками за ним: токенізатор не пише за '\0'
+struct LineBuffer {
+    char data[CMD_LINE_MAX + CANARY_BYTES];
+
+    void set(const std::string &line) {
+        memset(data, CANARY, sizeof(data));
+        size_t len = line.size() < CMD_LINE_MAX - 1 ? line.size() : CMD_LINE_MAX - 1;
+        memcpy(data, line.data(), len);
+        data[len] = 0;
+    }
+
+    bool canaryIntact() const {
+        for (size_t i = CMD_LINE_MAX; i < sizeof(data); i++) {
+            if ((uint8_t)data[i] != CANARY) return false;
+        }
+        return true;
+    }
+};
+
+static std::string randomBytes(size_t len) {
+    // Розділювачі і лапки частіше за решту - вони і ламають розбір
+    static const char special[] = " \t\r\n\"\"  ";
+    std::string s;
+    for (size_t i = 0; i < len; i++) {
+        char c = randomBelow(3) == 0 ? special[randomBelow(sizeof(special) - 1)] : (char)(1 + randomBelow(255));
+        s.push_back(c);
+    }
+    return s;
+}
+
+// Слова, з яких складаються майже правильні команди
+static const char* const vocabulary[] = {
+    "help", "stats", "heap", "tasks", "reset", "pour", "volume", "mode", "shot", "start",
+    "stop", "pause", "resume", "prime", "clean", "recipe", "pump", "queue", "safety",
+    "power", "manifold", "glass", "trace", "wifi", "ws", "ota", "password",
+    "set", "del", "clear", "off", "manual", "auto", "rinse", "gin", "tonic",
+    "gin:2,tonic:3/lime:1", "a:0", ":", "/", ",", "0", "1", "3", "5", "8", "9", "-1", "25",
+    "2.5", "nan", "1e9", "99999999999999999999", "\"\"", "\"two words\"", "\"unclosed",
+};
+
+static std::string randomCommand() {
+    std::string s;
+    uint32_t words = randomBelow(CMD_ARGS_MAX + 2);
+    for (uint32_t i = 0; i < words; i++) {
+        if (i > 0) s += randomBelow(8) == 0 ? "\t" : " ";
+        if (randomBelow(10) == 0) s += randomBytes(1 + randomBelow(12));
+        else s += vocabulary[randomBelow(sizeof(vocabulary) / sizeof(vocabulary[0]))];
+    }
+    return s;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// ========================================
+// ТОКЕНІЗАТОР
+// ========================================
+
+static int tokenize(LineBuffer &buf, const char *line, char **argv) {
+    buf.set(line);
+    return commandTokenize(buf.data, argv, CMD_ARGS_MAX);
+}
+
+static void test_tokenize_known() {
+    LineBuffer buf;
+    char *argv[CMD_ARGS_MAX];
+
+    TEST_ASSERT_EQUAL(0, tokenize(buf, "", argv));
+    TEST_ASSERT_EQUAL(0, tokenize(buf, " \t\r\n ", argv));
+
+    TEST_ASSERT_EQUAL(4, tokenize(buf, "wifi set \"My Net\" \"my pass\"", argv));
+    TEST_ASSERT_EQUAL_STRING("wifi", argv[0]);
+    TEST_ASSERT_EQUAL_STRING("My Net", argv[2]);
+    TEST_ASSERT_EQUAL_STRING("my pass", argv[3]);
+
+    TEST_ASSERT_EQUAL(2, tokenize(buf, "  volume\t50\r\n", argv));
+    TEST_ASSERT_EQUAL_STRING("50", argv[1]);
+
+    // Порожнє значення в лапках - окремий токен
+    TEST_ASSERT_EQUAL(3, tokenize(buf, "wifi set \"\"", argv));
+    TEST_ASSERT_EQUAL_STRING("", argv[2]);
+
+    TEST_ASSERT_EQUAL(-1, tokenize(buf, "wifi set \"My Net", argv));
+    TEST_ASSERT_EQUAL(CMD_ARGS_MAX, tokenize(buf, "a b c d e f", argv));
+    TEST_ASSERT_EQUAL(-1, tokenize(buf, "a b c d e f g", argv));
+}
+
+static void test_tokenize_random() {
+    LineBuffer buf;
+    char *argv[CMD_ARGS_MAX];
+
+    for (uint32_t n = 0; n < FUZZ_LINES; n++) {
+        std::string line = randomBytes(randomBelow(CMD_LINE_MAX));
+        buf.set(line);
+        size_t len = strlen(buf.data);
+
+        int argc = commandTokenize(buf.data, argv, CMD_ARGS_MAX);
+        TEST_ASSERT_TRUE(argc >= -1 && argc <= CMD_ARGS_MAX);
+        TEST_ASSERT_TRUE(buf.canaryIntact());
+
+        // Токени - всередині рядка і закінчуються в ньому
+        for (int i = 0; i < argc; i++) {
+            TEST_ASSERT_TRUE(argv[i] >= buf.data && argv[i] <= buf.data + len);
+            TEST_ASSERT_TRUE(argv[i] + strlen(argv[i]) <= buf.data + len);
+        }
+    }
+}
+
+static void test_tokenize_oversized() {
+    char *argv[CMD_ARGS_MAX];
+
+    // Один токен на весь буфер
+    LineBuffer buf;
+    buf.set(std::string(CMD_LINE_MAX * 2, 'x'));
+    TEST_ASSERT_EQUAL(1, commandTokenize(buf.data, argv, CMD_ARGS_MAX));
+    TEST_ASSERT_EQUAL(CMD_LINE_MAX - 1, strlen(argv[0]));
+    TEST_ASSERT_TRUE(buf.canaryIntact());
+
+    // Стільки токенів, скільки влізе
+    std::string many;
+    while (many.size() + 2 < CMD_LINE_MAX) many += "a ";
+    buf.set(many);
+    TEST_ASSERT_EQUAL(-1, commandTokenize(buf.data, argv, CMD_ARGS_MAX));
+    TEST_ASSERT_TRUE(buf.canaryIntact());
+
+    // Лапка на останньому байті
+    buf.set(std::string(CMD_LINE_MAX - 2, ' ') + "\"");
+    TEST_ASSERT_EQUAL(-1, commandTokenize(buf.data, argv, CMD_ARGS_MAX));
+}
+
+// ========================================
+// ДИСПЕТЧЕР
+// ========================================
+
+static void checkInvariants() {
+    TEST_ASSERT_TRUE(g_targetVolume >= VOLUME_MIN && g_targetVolume <= VOLUME_MAX);
+    TEST_ASSERT_TRUE(g_selectedShot >= 1 && g_selectedShot <= GLASS_COUNT);
+    TEST_ASSERT_TRUE(g_pourMode == MODE_MANUAL || g_pourMode == MODE_AUTO);
+}
+
+static void test_dispatch_random() {
+    static const CommandSource sources[] = {CMD_SRC_SERIAL, CMD_SRC_WS, CMD_SRC_HTTP};
+    LineBuffer buf;
+    CommandReply reply;
+
+    for (uint32_t n = 0; n < FUZZ_LINES; n++) {
+        buf.set(randomBelow(4) == 0 ? randomBytes(randomBelow(CMD_LINE_MAX)) : randomCommand());
+        reply.clear();
+
+        CommandResult result = commandExecute(buf.data, reply, sources[randomBelow(3)]);
+        TEST_ASSERT_TRUE(result <= CMD_FAILED);
+        TEST_ASSERT_TRUE(reply.length() < CMD_REPLY_MAX);
+        TEST_ASSERT_TRUE(buf.canaryIntact());
+
+        // Розлив чи промивка, що почались, не просуваються без controlTask - зупинити
+        if (g_systemState != STATE_IDLE && g_systemState != STATE_READY) stopPour();
+    }
+
+    commandFlushSetters();
+    checkInvariants();
+}
+
+static void test_dispatch_oversized() {
+    LineBuffer buf;
+    CommandReply reply;
+
+    // Число на весь рядок: нулі попереду, значення в межах
+    std::string volume = "volume " + std::string(CMD_LINE_MAX - 12, '0') + "40";
+    buf.set(volume);
+    TEST_ASSERT_EQUAL(CMD_OK, commandExecute(buf.data, reply, CMD_SRC_SERIAL));
+
+    // Задовге число не переповнює long
+    buf.set("volume " + std::string(CMD_LINE_MAX, '9'));
+    reply.clear();
+    TEST_ASSERT_EQUAL(CMD_BAD_ARGS, commandExecute(buf.data, reply, CMD_SRC_HTTP));
+
+    // Ім'я на весь буфер
+    buf.set(std::string(CMD_LINE_MAX, 'h'));
+    reply.clear();
+    TEST_ASSERT_EQUAL(CMD_UNKNOWN, commandExecute(buf.data, reply, CMD_SRC_WS));
+
+    // Довідка довша за відповідь WebSocket - обрізана з позначкою
+    buf.set("help");
+    reply.clear();
+    TEST_ASSERT_EQUAL(CMD_OK, commandExecute(buf.data, reply, CMD_SRC_WS));
+    TEST_ASSERT_TRUE(reply.truncated());
+    TEST_ASSERT_TRUE(reply.length() < CMD_REPLY_MAX);
+
+    commandFlushSetters();
+    TEST_ASSERT_EQUAL(40, g_targetVolume);
+}
+
+// Сетери відкладаються; читання стану їх не застосовує, розлив - застосовує
+static void test_setters_coalesce() {
+    LineBuffer buf;
+    CommandReply reply;
+    commandFlushSetters();
+    uint32_t applied = commandSettersApplied();
+    uint16_t volume = g_targetVolume == 30 ? 35 : 30;
+
+    buf.set("volume " + std::to_string(volume));
+    TEST_ASSERT_EQUAL(CMD_OK, commandExecute(buf.data, reply, CMD_SRC_WS));
+    buf.set("stats");
+    TEST_ASSERT_EQUAL(CMD_OK, commandExecute(buf.data, reply, CMD_SRC_WS));
+    buf.set("help");
+    TEST_ASSERT_EQUAL(CMD_OK, commandExecute(buf.data, reply, CMD_SRC_WS));
+    TEST_ASSERT_EQUAL(applied, commandSettersApplied());
+
+    buf.set("start");
+    commandExecute(buf.data, reply, CMD_SRC_WS);
+    TEST_ASSERT_EQUAL(applied + 1, commandSettersApplied());
+    TEST_ASSERT_EQUAL(volume, g_targetVolume);
+    stopPour();
+}
+
+// Відмова в розливі - CMD_FAILED, як у pause/resume; об'єм з pour не застосовано
+static void test_start_refused() {
+    LineBuffer buf;
+    CommandReply reply;
+    commandFlushSetters();
+    stopPour();
+    uint16_t volume = g_targetVolume;
+    g_glassPresent[g_selectedShot - 1] = false;
+    
+    buf.set("start");
+    TEST_ASSERT_EQUAL(CMD_FAILED, commandExecute(buf.data, reply, CMD_SRC_HTTP));
+    std::string pour = "pour " + std::to_string(volume == 40 ? 45 : 40);
+    buf.set(pour);
+    TEST_ASSERT_EQUAL(CMD_FAILED, commandExecute(buf.data, reply, CMD_SRC_WS));
+    commandFlushSetters();
+    TEST_ASSERT_EQUAL(volume, g_targetVolume);
+    
+    g_glassPresent[g_selectedShot - 1] = true;
+    buf.set(pour);
+    TEST_ASSERT_EQUAL(CMD_OK, commandExecute(buf.data, reply, CMD_SRC_WS));
+    commandFlushSetters();
+    TEST_ASSERT_EQUAL(volume == 40 ? 45 : 40, g_targetVolume);
+    stopPour();
+}
+
+int main(int argc, char **argv) {
+    char dir[] = "/tmp/gyverdrink-test-XXXXXX";
+    if (!mkdtemp(dir)) return 1;
+    sim::setNvsDir(dir);
+    sim::setManualClock(true);
+    sim::setSerialOutput(false);
+    sim::setIoTrace(false);
+
+    // Рюмки стоять - розлив і промивка з фазингу доходять до обробників
+    for (uint8_t pin : hw::glassPins) sim::setPin(pin, HIGH);
+    initDisplay();
+    initPeripherals();
+    loadSettings();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_tokenize_known);
+    RUN_TEST(test_tokenize_random);
+    RUN_TEST(test_tokenize_oversized);
+    RUN_TEST(test_dispatch_random);
+    RUN_TEST(test_dispatch_oversized);
+    RUN_TEST(test_setters_coalesce);
+    RUN_TEST(test_start_refused);
+    int failures = UNITY_END();
+
+    std::filesystem::remove_all(dir);
+    return failures;
+}
@@ -0,0 +1,165 @@
+// Фільтр аналогових датчиків рюмок на хості: траси середніх кадру (як їх віддає
+// glassTask) проганяються через glassFilterStep(), перевіряються моменти появи і
+// зникнення рюмки, гістерезис і те, що повільна зміна освітлення - не рюмка.
+//   pio test -e native-test -f test_glass_filter
+
+#include <unity.h>
+#include "config.h"
+#include "glass_sensor.h"
+
+#include <random>
+#include <vector>
+
+// Траса - відрізки лінійної зміни рівня, кадр за кадром
+struct TraceSegment {
+    uint16_t from;
+    uint16_t to;
+    uint16_t frames;
+};
+
+// Шум АЦП на середньому кадру: кілька відліків
+#define TRACE_NOISE 12
+
+static std::vector<uint16_t> buildTrace(std::initializer_list<TraceSegment> segments, uint32_t seed = 1) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> noise(-TRACE_NOISE, TRACE_NOISE);
+    std::vector<uint16_t> levels;
+    for (const TraceSegment &s : segments) {
+        for (uint16_t i = 0; i < s.frames; i++) {
+            int level = s.from + ((int)s.to - s.from) * (i + 1) / s.frames + noise(rng);
+            levels.push_back(level < 0 ? 0 : level > 4095 ? 4095 : level);
+        }
+    }
+    return levels;
+}
+
+// Кадри, на яких стан змінився: + поява, - зникнення (номер кадру зі знаком)
+static std::vector<int> replay(const std::vector<uint16_t> &trace, GlassFilter &filter) {
+    std::vector<int> changes;
+    bool present = filter.present;
+    for (size_t i = 0; i < trace.size(); i++) {
+        bool now = glassFilterStep(filter, trace[i]);
+        if (now != present) changes.push_back(now ? (int)i : -(int)i);
+        present = now;
+    }
+    return changes;
+}
+
+static std::vector<int> replay(const std::vector<uint16_t> &trace) {
+    GlassFilter filter;
+    glassFilterReset(filter);
+    return replay(trace, filter);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Порожнє місце, рюмку поставили, простояла, зняли
+static void test_place_and_remove() {
+    std::vector<uint16_t> trace = buildTrace({
+        {320, 320, 200},        // Порожньо, базова лінія встановлюється
+        {320, 1400, 4},         // Рюмку ставлять: фронт за кілька кадрів
+        {1400, 1400, 300},
+        {1400, 330, 3},         // Зняли
+        {330, 330, 200},
+    });
+    std::vector<int> changes = replay(trace);
+
+    TEST_ASSERT_EQUAL(2, changes.size());
+    // Поява - після GLASS_ADC_HOLD_FRAMES кадрів за порогом, не раніше
+    TEST_ASSERT_TRUE(changes[0] >= 200 + GLASS_ADC_HOLD_FRAMES - 1 && changes[0] <= 204 + GLASS_ADC_HOLD_FRAMES);
+    TEST_ASSERT_TRUE(-changes[1] >= 504 + GLASS_ADC_HOLD_FRAMES - 2 && -changes[1] <= 507 + GLASS_ADC_HOLD_FRAMES);
+}
+
+// Рука над датчиком, відблиск: коротші за GLASS_ADC_HOLD_FRAMES кадрів - не рюмка
+static void test_short_spikes_rejected() {
+    std::vector<uint16_t> trace = buildTrace({
+        {300, 300, 200},
+        {1500, 1500, GLASS_ADC_HOLD_FRAMES - 1},
+        {300, 300, 50},
+        {1200, 1200, 1},
+        {300, 300, 50},
+    });
+    TEST_ASSERT_EQUAL(0, replay(trace).size());
+}
+
+// Рівень між порогами: рюмка, що стоїть, не зникає; порожнє місце не стає рюмкою
+static void test_hysteresis() {
+    GlassFilter filter;
+    glassFilterReset(filter);
+
+    // Поставили і рівень просів до +300 (рідина, тінь) - між OFF і ON
+    std::vector<int> changes = replay(buildTrace({
+        {300, 300, 200},
+        {1200, 1200, 20},
+        {300 + (GLASS_ADC_ON_DELTA + GLASS_ADC_OFF_DELTA) / 2, 300 + (GLASS_ADC_ON_DELTA + GLASS_ADC_OFF_DELTA) / 2, 300},
+    }), filter);
+    TEST_ASSERT_EQUAL(1, changes.size());
+    TEST_ASSERT_TRUE(filter.present);
+
+    // Нижче OFF - зникла
+    changes = replay(buildTrace({{300 + GLASS_ADC_OFF_DELTA / 2, 300 + GLASS_ADC_OFF_DELTA / 2, 20}}), filter);
+    TEST_ASSERT_EQUAL(1, changes.size());
+    TEST_ASSERT_FALSE(filter.present);
+}
+
+// Світло в барі повільно змінюється (день -> лампи): базова лінія йде слідом
+static void test_slow_drift_rejected() {
+    GlassFilter filter;
+    glassFilterReset(filter);
+    std::vector<int> changes = replay(buildTrace({
+        {300, 300, 100},
+        {300, 1100, 600},       // +800 за ~8 с при 78 кадрах/с
+        {1100, 1100, 200},
+        {1100, 250, 10},        // Світло вимкнули: вниз - одразу
+        {250, 250, 100},
+    }, 7), filter);
+    TEST_ASSERT_EQUAL(0, changes.size());
+    TEST_ASSERT_INT_WITHIN(TRACE_NOISE * 2, 250, glassFilterBaseline(filter));
+
+    // Після дрейфу рюмка на новій базовій лінії так само помітна
+    changes = replay(buildTrace({{900, 900, 20}}), filter);
+    TEST_ASSERT_EQUAL(1, changes.size());
+    TEST_ASSERT_TRUE(filter.present);
+}
+
+// Під рюмкою базова лінія не повзе вгору: рюмка, що стоїть довго, не зникає
+static void test_baseline_frozen_under_glass() {
+    GlassFilter filter;
+    glassFilterReset(filter);
+    std::vector<int> changes = replay(buildTrace({
+        {300, 300, 200},
+        {1000, 1000, 20000},    // ~4 хв
+    }), filter);
+    TEST_ASSERT_EQUAL(1, changes.size());
+    TEST_ASSERT_TRUE(filter.present);
+    TEST_ASSERT_INT_WITHIN(TRACE_NOISE * 2, 300, glassFilterBaseline(filter));
+}
+
+// Рюмка стояла ще до ввімкнення: не стає базовою лінією
+static void test_glass_at_boot() {
+    GlassFilter filter;
+    glassFilterReset(filter);
+    std::vector<int> changes = replay(buildTrace({
+        {1500, 1500, 100},
+        {310, 310, 100},        // Зняли - порожнє місце
+    }), filter);
+    TEST_ASSERT_EQUAL(2, changes.size());
+    TEST_ASSERT_TRUE(changes[0] < GLASS_ADC_HOLD_FRAMES + 1);
+    TEST_ASSERT_FALSE(filter.present);
+    TEST_ASSERT_INT_WITHIN(TRACE_NOISE * 2, 310, glassFilterBaseline(filter));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_place_and_remove);
+    RUN_TEST(test_short_spikes_rejected);
+    RUN_TEST(test_hysteresis);
+    RUN_TEST(test_slow_drift_rejected);
+    RUN_TEST(test_baseline_frozen_under_glass);
+    RUN_TEST(test_glass_at_boot);
+    return UNITY_END();
+}